@@ -1,6 +1,7 @@
 #pragma once
 
 #include "async.hpp"
+#include "binary.hpp"
 #include "compile_time.hpp"
 #include "cryptid.hpp"
 #include "debug.hpp"
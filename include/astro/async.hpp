@@ -1,6 +1,15 @@
 #pragma once
 
 #include "async/handler.hpp"
+#include "async/futex.hpp"
+#include "async/work_deque.hpp"
+#include "async/mpmc_queue.hpp"
+#include "async/spsc_ring.hpp"
+#include "async/thread_pool.hpp"
 #include "async/executor.hpp"
+#include "async/task.hpp"
+#include "async/generator.hpp"
+#include "async/io_wait.hpp"
+#include "async/reactor.hpp"
 #include "async/process.hpp"
 #include "async/signals.hpp"
\ No newline at end of file
@@ -2,21 +2,24 @@
 
 #include <cstdint>
 #include <functional>
-#include <future>
 #include <mutex>
-#include <thread>
 
 #include "../compile_time/traits.hpp"
 #include "../utils/misc.hpp"
+#include "thread_pool.hpp"
 
 namespace astro::async {
+   /**
+    * @brief Runs a fixed task with varying arguments, asynchronously on a thread_pool or synchronously under a lock.
+    */
    template <typename F>
    class executor {
       public:
          using function_type = decltype(std::function(std::declval<F>()));
 
-         inline executor(F&& task)
+         inline executor(F&& task, thread_pool& pool = thread_pool::shared())
             : _task(std::forward<F>(task)),
+              _pool(&pool),
               _mutex() {
          }
 
@@ -26,10 +29,12 @@ namespace astro::async {
          inline executor& operator=(executor&&) = delete;
          inline ~executor() = default;
 
+         /**
+          * @brief Queues a copy of the task on the pool and returns its future.
+          */
          template <typename... Args>
          inline auto exec(Args&&... args) {
-            std::lock_guard<std::mutex> lock(_mutex);
-            return std::async(std::launch::async, _task, std::forward<Args>(args)...);
+            return _pool->submit(_task, std::forward<Args>(args)...);
          }
 
          template <typename... Args>
@@ -43,6 +48,7 @@ namespace astro::async {
 
       private:
          function_type _task;
+         thread_pool*  _pool;
          std::mutex    _mutex;
    };
 
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+
+#include "../info.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+   #include <immintrin.h>
+#endif
+
+namespace astro::async {
+   /**
+    * @brief Cache line size assumed when padding shared atomics apart.
+    */
+   constexpr static inline std::size_t cache_line_size = 64;
+
+   /**
+    * @brief Spin-wait hint, lets the sibling hyperthread run while this one busy-waits.
+    */
+   static inline void cpu_relax() noexcept {
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+      _mm_pause();
+#elif defined(__aarch64__)
+      asm volatile("yield");
+#endif
+   }
+
+   static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t) && std::atomic<std::uint32_t>::is_always_lock_free,
+                 "futex words must be plain 32-bit atomics");
+} // namespace astro::async
+
+#if ASTRO_OS == ASTRO_WINDOWS_BUILD
+   #include "win/futex_impl.hpp"
+#else
+   #include "unix/futex_impl.hpp"
+#endif
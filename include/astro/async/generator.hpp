@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "task.hpp"
+
+namespace astro::async {
+
+   /**
+    * @brief Synchronous, lazily evaluated sequence produced with co_yield. Yielded values are referenced in place, not
+    * copied, and stay valid until the iterator advances. Frames are allocated like task frames.
+    */
+   template <typename T>
+   class generator {
+      public:
+         using value_type = std::remove_cvref_t<T>;
+         using reference  = std::conditional_t<std::is_reference_v<T>, T, const value_type&>;
+         using pointer    = std::add_pointer_t<reference>;
+
+         struct promise_type : detail::co::frame_alloc {
+               inline generator get_return_object() noexcept {
+                  return generator{std::coroutine_handle<promise_type>::from_promise(*this)};
+               }
+
+               constexpr inline std::suspend_always initial_suspend() const noexcept { return {}; }
+               constexpr inline std::suspend_always final_suspend() const noexcept { return {}; }
+
+               inline std::suspend_always yield_value(std::remove_reference_t<reference>& v) noexcept {
+                  current = std::addressof(v);
+                  return {};
+               }
+
+               inline std::suspend_always yield_value(std::remove_reference_t<reference>&& v) noexcept {
+                  current = std::addressof(v);
+                  return {};
+               }
+
+               constexpr inline void return_void() const noexcept {}
+               inline void           unhandled_exception() noexcept { error = std::current_exception(); }
+
+               // a generator runs synchronously, it has nothing to wait for
+               template <typename U>
+               std::suspend_never await_transform(U&&) = delete;
+
+               pointer            current = nullptr;
+               std::exception_ptr error;
+         };
+
+         class iterator {
+            public:
+               using iterator_category = std::input_iterator_tag;
+               using difference_type   = std::ptrdiff_t;
+               using value_type        = generator::value_type;
+               using reference         = generator::reference;
+               using pointer           = generator::pointer;
+
+               iterator() = default;
+
+               inline explicit iterator(std::coroutine_handle<promise_type> h) noexcept : _handle(h) {}
+
+               inline reference operator*() const noexcept { return static_cast<reference>(*_handle.promise().current); }
+               inline pointer   operator->() const noexcept { return _handle.promise().current; }
+
+               inline iterator& operator++() {
+                  advance(_handle);
+                  return *this;
+               }
+
+               inline void operator++(int) { ++*this; }
+
+               friend inline bool operator==(const iterator& it, std::default_sentinel_t) noexcept {
+                  return !it._handle || it._handle.done();
+               }
+
+            private:
+               std::coroutine_handle<promise_type> _handle = nullptr;
+         };
+
+         generator() = default;
+
+         inline explicit generator(std::coroutine_handle<promise_type> h) noexcept : _handle(h) {}
+
+         generator(const generator&)            = delete;
+         generator& operator=(const generator&) = delete;
+
+         inline generator(generator&& other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+
+         inline generator& operator=(generator&& other) noexcept {
+            if (this != &other) {
+               if (_handle)
+                  _handle.destroy();
+               _handle = std::exchange(other._handle, nullptr);
+            }
+            return *this;
+         }
+
+         inline ~generator() {
+            if (_handle)
+               _handle.destroy();
+         }
+
+         /**
+          * @brief Runs the body up to its first co_yield. Call it once per generator.
+          */
+         inline iterator begin() {
+            if (_handle)
+               advance(_handle);
+            return iterator{_handle};
+         }
+
+         constexpr inline std::default_sentinel_t end() const noexcept { return {}; }
+
+      private:
+         static inline void advance(std::coroutine_handle<promise_type> h) {
+            h.resume();
+            if (h.done() && h.promise().error)
+               std::rethrow_exception(std::exchange(h.promise().error, nullptr));
+         }
+
+         std::coroutine_handle<promise_type> _handle = nullptr;
+   };
+
+} // namespace astro::async
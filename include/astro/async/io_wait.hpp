@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+
+#include <chrono>
+#include <coroutine>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include "../info.hpp"
+#include "thread_pool.hpp"
+
+namespace astro::async {
+   enum class io_event : std::uint8_t { readable = 1, writable = 2 };
+
+   namespace detail::co {
+      using clock = std::chrono::steady_clock;
+
+      struct timer_entry {
+            clock::time_point       deadline;
+            std::coroutine_handle<> handle;
+
+            friend inline bool operator>(const timer_entry& a, const timer_entry& b) noexcept { return a.deadline > b.deadline; }
+      };
+
+      using timer_heap = std::priority_queue<timer_entry, std::vector<timer_entry>, std::greater<>>;
+   } // namespace detail::co
+} // namespace astro::async
+
+#if ASTRO_OS == ASTRO_WINDOWS_BUILD
+   #include "win/io_wait_impl.hpp"
+#else
+   #include "unix/io_wait_impl.hpp"
+#endif
+
+namespace astro::async {
+   /**
+    * @brief Suspends the awaiting coroutine until tp. It resumes on a worker of the shared thread_pool.
+    */
+   inline auto sleep_until(detail::co::clock::time_point tp) noexcept {
+      struct awaiter {
+            inline bool await_ready() const noexcept { return deadline <= detail::co::clock::now(); }
+            inline void await_suspend(std::coroutine_handle<> h) const { io_waiter::shared().add_timer(deadline, h); }
+            constexpr inline void await_resume() const noexcept {}
+
+            detail::co::clock::time_point deadline;
+      };
+      return awaiter{tp};
+   }
+
+   template <typename Rep, typename Period>
+   inline auto sleep_for(std::chrono::duration<Rep, Period> d) noexcept {
+      return sleep_until(detail::co::clock::now() + std::chrono::ceil<detail::co::clock::duration>(d));
+   }
+
+   /**
+    * @brief Suspends the awaiting coroutine until fd is ready for ev, or has failed. It resumes on a worker of the shared
+    * thread_pool.
+    */
+   inline auto wait_for(int fd, io_event ev) noexcept {
+      struct awaiter {
+            constexpr inline bool await_ready() const noexcept { return false; }
+            inline void           await_suspend(std::coroutine_handle<> h) const { io_waiter::shared().add_fd(fd, ev, h); }
+            constexpr inline void await_resume() const noexcept {}
+
+            int      fd;
+            io_event ev;
+      };
+      return awaiter{fd, ev};
+   }
+
+   inline auto readable(int fd) noexcept { return wait_for(fd, io_event::readable); }
+   inline auto writable(int fd) noexcept { return wait_for(fd, io_event::writable); }
+
+} // namespace astro::async
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "../utils/misc.hpp"
+#include "futex.hpp"
+
+namespace astro::async {
+
+   namespace detail::queue {
+      constexpr static inline std::size_t spin_limit = 128;
+
+      /**
+       * @brief Futex parking spot: waiters sleep on an epoch that notify() bumps, but only when someone is asleep.
+       */
+      struct alignas(cache_line_size) signal {
+            template <typename Ready>
+            inline void wait(Ready&& ready) noexcept {
+               for (;;) {
+                  const std::uint32_t e = epoch.load(std::memory_order_acquire);
+                  waiters.fetch_add(1, std::memory_order_relaxed);
+                  // pairs with the fence in notify(): either we see the change or the notifier sees us
+                  std::atomic_thread_fence(std::memory_order_seq_cst);
+                  const bool go = ready();
+                  if (!go)
+                     futex_wait(epoch, e);
+                  waiters.fetch_sub(1, std::memory_order_relaxed);
+                  if (go)
+                     return;
+               }
+            }
+
+            inline void notify(bool all = false) noexcept {
+               std::atomic_thread_fence(std::memory_order_seq_cst);
+               if (waiters.load(std::memory_order_relaxed) != 0) {
+                  epoch.fetch_add(1, std::memory_order_release);
+                  all ? futex_wake_all(epoch) : futex_wake(epoch);
+               }
+            }
+
+            std::atomic<std::uint32_t> epoch   = 0;
+            std::atomic<std::uint32_t> waiters = 0;
+      };
+   } // namespace detail::queue
+
+   /**
+    * @brief Bounded multi-producer, multi-consumer queue (Vyukov's sequence-numbered ring).
+    *
+    * Every slot carries a sequence number that says whether it is free for the producer of a given lap or full for its
+    * consumer, so producers and consumers only contend on their own cursor and the slot they claimed. Slots are padded to
+    * a cache line. The try_ operations never block, push() and pop() spin briefly and then sleep on a futex until the
+    * other side makes progress or the queue is closed.
+    */
+   template <typename T>
+   class mpmc_queue {
+         struct alignas(cache_line_size) slot {
+               std::atomic<std::size_t> seq;
+               alignas(T) unsigned char storage[sizeof(T)];
+
+               inline T* value() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+         };
+
+      public:
+         using value_type = T;
+
+         inline explicit mpmc_queue(std::size_t capacity) {
+            util::check(capacity > 0, "mpmc_queue: capacity must be positive");
+            std::size_t cap = 1;
+            while (cap < capacity)
+               cap <<= 1;
+            _mask  = cap - 1;
+            _slots = std::make_unique<slot[]>(cap);
+            for (std::size_t i = 0; i < cap; ++i)
+               _slots[i].seq.store(i, std::memory_order_relaxed);
+         }
+
+         mpmc_queue(const mpmc_queue&)            = delete;
+         mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+         inline ~mpmc_queue() {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+               const std::size_t end = _enqueue.load(std::memory_order_relaxed);
+               for (std::size_t pos = _dequeue.load(std::memory_order_relaxed); pos != end; ++pos)
+                  _slots[pos & _mask].value()->~T();
+            }
+         }
+
+         inline std::size_t capacity() const noexcept { return _mask + 1; }
+
+         /**
+          * @brief Element count at some recent instant, exact only while no one else is using the queue.
+          */
+         inline std::size_t size_approx() const noexcept {
+            const std::size_t tail = _dequeue.load(std::memory_order_relaxed);
+            const std::size_t head = _enqueue.load(std::memory_order_relaxed);
+            return head > tail ? head - tail : 0;
+         }
+
+         inline bool empty() const noexcept { return size_approx() == 0; }
+
+         /**
+          * @brief Constructs an element in place if there is room. The arguments are left untouched on failure.
+          */
+         template <typename... Args>
+         inline bool try_emplace(Args&&... args) {
+            if (closed())
+               return false;
+            std::size_t pos = _enqueue.load(std::memory_order_relaxed);
+            slot*       s;
+            for (;;) {
+               s                          = &_slots[pos & _mask];
+               const std::size_t   seq    = s->seq.load(std::memory_order_acquire);
+               const std::intptr_t diff   = static_cast<std::intptr_t>(seq - pos);
+               if (diff == 0) {
+                  if (_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                     break;
+               } else if (diff < 0) {
+                  return false;
+               } else {
+                  pos = _enqueue.load(std::memory_order_relaxed);
+               }
+            }
+            ::new (s->storage) T(std::forward<Args>(args)...);
+            s->seq.store(pos + 1, std::memory_order_release);
+            _items.notify();
+            return true;
+         }
+
+         inline bool try_push(const T& v) { return try_emplace(v); }
+         inline bool try_push(T&& v) { return try_emplace(std::move(v)); }
+
+         inline bool try_pop(T& out) {
+            return try_take([&](T&& v) { out = std::move(v); });
+         }
+
+         /**
+          * @brief Copies up to n elements from first with a single claim on the producer cursor, returns how many fit.
+          * Pass a std::move_iterator to move them instead.
+          */
+         template <typename It>
+         inline std::size_t push_n(It first, std::size_t n) {
+            if (closed())
+               return 0;
+            std::size_t pos = _enqueue.load(std::memory_order_relaxed);
+            std::size_t k;
+            do {
+               const std::size_t tail = _dequeue.load(std::memory_order_acquire);
+               const std::size_t used = pos - tail;
+               // a stale pos can trail tail, the failing CAS then refreshes it
+               const std::size_t room = used > capacity() ? capacity() : capacity() - used;
+               k                      = n < room ? n : room;
+               if (k == 0)
+                  return 0;
+            } while (!_enqueue.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed));
+
+            for (std::size_t i = 0; i < k; ++i, ++first) {
+               slot& s = _slots[(pos + i) & _mask];
+               // the consumer of the previous lap has claimed this slot but may still be moving out of it
+               while (s.seq.load(std::memory_order_acquire) != pos + i)
+                  cpu_relax();
+               ::new (s.storage) T(*first);
+               s.seq.store(pos + i + 1, std::memory_order_release);
+            }
+            _items.notify(true);
+            return k;
+         }
+
+         /**
+          * @brief Moves up to n elements to out with a single claim on the consumer cursor, returns how many there were.
+          */
+         template <typename Out>
+         inline std::size_t pop_n(Out out, std::size_t n) {
+            std::size_t pos = _dequeue.load(std::memory_order_relaxed);
+            std::size_t k;
+            do {
+               const std::size_t head  = _enqueue.load(std::memory_order_acquire);
+               const std::size_t avail = head > pos ? head - pos : 0;
+               k                       = n < avail ? n : avail;
+               if (k == 0)
+                  return 0;
+            } while (!_dequeue.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed));
+
+            for (std::size_t i = 0; i < k; ++i, ++out) {
+               slot& s = _slots[(pos + i) & _mask];
+               // the producer has claimed this slot but may still be constructing into it
+               while (s.seq.load(std::memory_order_acquire) != pos + i + 1)
+                  cpu_relax();
+               *out = std::move(*s.value());
+               s.value()->~T();
+               s.seq.store(pos + i + capacity(), std::memory_order_release);
+            }
+            _spaces.notify(true);
+            return k;
+         }
+
+         /**
+          * @brief Blocks until v fits. Returns false, leaving v untouched, if the queue is or becomes closed.
+          */
+         inline bool push(T v) {
+            for (std::size_t spin = 0; spin < detail::queue::spin_limit && !closed(); ++spin) {
+               if (try_emplace(std::move(v)))
+                  return true;
+               cpu_relax();
+            }
+            bool pushed = false;
+            _spaces.wait([&] { return (pushed = try_emplace(std::move(v))) || closed(); });
+            return pushed;
+         }
+
+         /**
+          * @brief Blocks until an element arrives. Returns nullopt once the queue is closed and drained.
+          */
+         inline std::optional<T> pop() {
+            std::optional<T> out;
+            const auto       ready = [&] {
+               return try_take([&](T&& v) { out.emplace(std::move(v)); }) || (closed() && empty());
+            };
+            for (std::size_t spin = 0; spin < detail::queue::spin_limit; ++spin) {
+               if (ready())
+                  return out;
+               cpu_relax();
+            }
+            _items.wait(ready);
+            return out;
+         }
+
+         /**
+          * @brief Fails every later push and wakes all blocked threads, consumers still drain what is left.
+          */
+         inline void close() noexcept {
+            _closed.store(true, std::memory_order_seq_cst);
+            _items.notify(true);
+            _spaces.notify(true);
+         }
+
+         inline bool closed() const noexcept { return _closed.load(std::memory_order_relaxed); }
+
+      private:
+         template <typename Sink>
+         inline bool try_take(Sink&& sink) {
+            std::size_t pos = _dequeue.load(std::memory_order_relaxed);
+            slot*       s;
+            for (;;) {
+               s                        = &_slots[pos & _mask];
+               const std::size_t   seq  = s->seq.load(std::memory_order_acquire);
+               const std::intptr_t diff = static_cast<std::intptr_t>(seq - (pos + 1));
+               if (diff == 0) {
+                  if (_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                     break;
+               } else if (diff < 0) {
+                  return false;
+               } else {
+                  pos = _dequeue.load(std::memory_order_relaxed);
+               }
+            }
+            sink(std::move(*s->value()));
+            s->value()->~T();
+            s->seq.store(pos + capacity(), std::memory_order_release);
+            _spaces.notify();
+            return true;
+         }
+
+         alignas(cache_line_size) std::atomic<std::size_t> _enqueue = 0;
+         alignas(cache_line_size) std::atomic<std::size_t> _dequeue = 0;
+         alignas(cache_line_size) std::unique_ptr<slot[]> _slots;
+         std::size_t                                      _mask   = 0;
+         std::atomic<bool>                                _closed = false;
+         detail::queue::signal                            _items;
+         detail::queue::signal                            _spaces;
+   };
+
+} // namespace astro::async
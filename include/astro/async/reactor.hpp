@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+
+#include <atomic>
+#include <coroutine>
+
+#include "../info.hpp"
+
+namespace astro::async::detail::io {
+   /**
+    * @brief Edge-triggered readiness of one direction of one descriptor.
+    *
+    * Bit 0 of state means ready, the bits above count events, so clearing readiness after EAGAIN can tell whether a new
+    * edge arrived since the caller looked and must not be lost. At most one coroutine waits per direction.
+    */
+   struct readiness {
+         /**
+          * @brief Loop side: records an event and hands back the waiter to resume, if any.
+          */
+         inline std::coroutine_handle<> set() noexcept {
+            std::uint32_t s = state.load(std::memory_order_relaxed);
+            while (!state.compare_exchange_weak(s, (s + 2) | 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {}
+            return std::coroutine_handle<>::from_address(waiter.exchange(nullptr, std::memory_order_seq_cst));
+         }
+
+         inline std::uint32_t snapshot() const noexcept { return state.load(std::memory_order_acquire); }
+         inline bool          ready() const noexcept { return snapshot() & 1; }
+
+         /**
+          * @brief Drops readiness seen in snap, a no-op if another event arrived since.
+          */
+         inline void clear(std::uint32_t snap) noexcept {
+            if (!always)
+               state.compare_exchange_strong(snap, snap & ~1u, std::memory_order_acq_rel, std::memory_order_relaxed);
+         }
+
+         /**
+          * @brief Waiter side: parks h, returns false if readiness arrived meanwhile and h should not suspend.
+          */
+         inline bool suspend(std::coroutine_handle<> h) noexcept {
+            waiter.store(h.address(), std::memory_order_seq_cst);
+            if (state.load(std::memory_order_seq_cst) & 1) {
+               void* expected = h.address();
+               if (waiter.compare_exchange_strong(expected, nullptr, std::memory_order_seq_cst))
+                  return false;
+            }
+            return true;
+         }
+
+         std::atomic<std::uint32_t> state  = 0;
+         std::atomic<void*>         waiter = nullptr;
+         bool                       always = false;
+   };
+
+   struct fd_state {
+         int       fd   = -1;
+         int       slot = -1; // index in the reactor's registered file table, if any
+         readiness in;
+         readiness out;
+   };
+
+   struct ready_awaiter {
+         inline bool await_ready() const noexcept { return r.ready(); }
+         inline bool await_suspend(std::coroutine_handle<> h) noexcept { return r.suspend(h); }
+         constexpr inline void await_resume() const noexcept {}
+
+         readiness& r;
+   };
+} // namespace astro::async::detail::io
+
+namespace astro::async {
+   /**
+    * @brief How a reactor performs offset-based file I/O, fsync and splice. automatic uses io_uring when the kernel
+    * provides it and the plain syscalls otherwise; readiness always comes from epoll.
+    */
+   enum class reactor_backend : std::uint8_t { automatic, epoll };
+} // namespace astro::async
+
+#if ASTRO_OS == ASTRO_WINDOWS_BUILD
+   #include "win/reactor_impl.hpp"
+#else
+   #include "unix/reactor_impl.hpp"
+#endif
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <span>
+#include <utility>
+
+#include "../utils/misc.hpp"
+#include "futex.hpp"
+
+namespace astro::async {
+
+   /**
+    * @brief Wait-free single-producer, single-consumer ring with zero-copy access to its storage.
+    *
+    * Each side keeps a private copy of the other side's index and only reloads the shared one when the copy says the
+    * ring is full (or empty), so in steady state neither thread touches the other's cache line. The producer's writes
+    * become visible in batches: commit() publishes once publish_batch elements are pending, and flush() publishes right
+    * away. A full ring always flushes, so a producer cannot stall on its own unpublished elements.
+    */
+   template <typename T>
+   class spsc_ring {
+      public:
+         using value_type = T;
+
+         inline explicit spsc_ring(std::size_t capacity, std::size_t publish_batch = 1)
+            : _batch(publish_batch ? publish_batch : 1) {
+            util::check(capacity > 0, "spsc_ring: capacity must be positive");
+            std::size_t cap = 1;
+            while (cap < capacity)
+               cap <<= 1;
+            _mask = cap - 1;
+            _data = std::make_unique<T[]>(cap);
+         }
+
+         spsc_ring(const spsc_ring&)            = delete;
+         spsc_ring& operator=(const spsc_ring&) = delete;
+
+         inline std::size_t capacity() const noexcept { return _mask + 1; }
+
+         /**
+          * @brief Element count at some recent instant, exact only while neither side is active.
+          */
+         inline std::size_t size_approx() const noexcept {
+            // the consumer never passes the producer, so reading its index first keeps the difference from wrapping
+            const std::size_t t = _tail.load(std::memory_order_acquire);
+            const std::size_t h = _head.load(std::memory_order_acquire);
+            return h > t ? std::min(h - t, capacity()) : 0;
+         }
+
+         inline bool empty() const noexcept { return size_approx() == 0; }
+
+         /**
+          * @brief Producer: a contiguous writable span of at most n elements, empty when the ring is full. Only the
+          * first k of them become readable, after commit(k).
+          */
+         inline std::span<T> reserve(std::size_t n = std::numeric_limits<std::size_t>::max()) noexcept {
+            std::size_t room = capacity() - (_write - _tail_cache);
+            if (room < n) {
+               _tail_cache = _tail.load(std::memory_order_acquire);
+               room        = capacity() - (_write - _tail_cache);
+               if (room == 0)
+                  flush();
+            }
+            const std::size_t at = _write & _mask;
+            return {_data.get() + at, std::min({n, room, capacity() - at})};
+         }
+
+         /**
+          * @brief Producer: appends the first n elements of the last reserved span, n must not exceed its size.
+          */
+         inline void commit(std::size_t n) noexcept {
+            _write += n;
+            if (_write - _published >= _batch)
+               flush();
+         }
+
+         /**
+          * @brief Producer: makes every committed element visible to the consumer.
+          */
+         inline void flush() noexcept {
+            if (_published != _write) {
+               _published = _write;
+               _head.store(_write, std::memory_order_release);
+            }
+         }
+
+         template <typename U>
+         inline bool try_push(U&& v) {
+            const auto s = reserve(1);
+            if (s.empty())
+               return false;
+            s[0] = std::forward<U>(v);
+            commit(1);
+            return true;
+         }
+
+         /**
+          * @brief Producer: copies as much of in as fits, across the wrap point if needed, and returns the count.
+          */
+         inline std::size_t push_n(std::span<const T> in) {
+            std::size_t done = 0;
+            while (done < in.size()) {
+               const auto s = reserve(in.size() - done);
+               if (s.empty())
+                  break;
+               std::copy_n(in.data() + done, s.size(), s.data());
+               done += s.size();
+               _write += s.size();
+            }
+            if (_write - _published >= _batch)
+               flush();
+            return done;
+         }
+
+         /**
+          * @brief Consumer: a contiguous span of at most n readable elements, empty when nothing is published.
+          */
+         inline std::span<T> peek(std::size_t n = std::numeric_limits<std::size_t>::max()) noexcept {
+            std::size_t avail = _head_cache - _read;
+            if (avail < n) {
+               _head_cache = _head.load(std::memory_order_acquire);
+               avail       = _head_cache - _read;
+            }
+            const std::size_t at = _read & _mask;
+            return {_data.get() + at, std::min({n, avail, capacity() - at})};
+         }
+
+         /**
+          * @brief Consumer: hands the first n elements of the last peeked span back to the producer.
+          */
+         inline void consume(std::size_t n) noexcept {
+            _read += n;
+            _tail.store(_read, std::memory_order_release);
+         }
+
+         inline bool try_pop(T& out) {
+            const auto s = peek(1);
+            if (s.empty())
+               return false;
+            out = std::move(s[0]);
+            consume(1);
+            return true;
+         }
+
+         /**
+          * @brief Consumer: moves up to out.size() elements out, across the wrap point if needed, and returns the count.
+          */
+         inline std::size_t pop_n(std::span<T> out) {
+            std::size_t done = 0;
+            while (done < out.size()) {
+               const auto s = peek(out.size() - done);
+               if (s.empty())
+                  break;
+               std::move(s.begin(), s.end(), out.begin() + done);
+               done  += s.size();
+               _read += s.size();
+            }
+            if (done != 0)
+               _tail.store(_read, std::memory_order_release);
+            return done;
+         }
+
+      private:
+         // producer line: its own index, its view of the consumer and the index it publishes
+         alignas(cache_line_size) std::atomic<std::size_t> _head = 0;
+         std::size_t                                       _write      = 0;
+         std::size_t                                       _published  = 0;
+         std::size_t                                       _tail_cache = 0;
+
+         // consumer line, laid out the same way
+         alignas(cache_line_size) std::atomic<std::size_t> _tail = 0;
+         std::size_t                                       _read       = 0;
+         std::size_t                                       _head_cache = 0;
+
+         // read-only after construction
+         alignas(cache_line_size) std::unique_ptr<T[]> _data;
+         std::size_t                                   _mask  = 0;
+         std::size_t                                   _batch = 1;
+   };
+
+} // namespace astro::async
@@ -0,0 +1,435 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "../memory/arena.hpp"
+#include "futex.hpp"
+#include "thread_pool.hpp"
+
+namespace astro::async {
+   template <typename T = void>
+   class task;
+
+   namespace detail::co {
+      /**
+       * @brief Coroutine frame allocation shared by every promise type here.
+       *
+       * A frame comes from an arena when a frame_scope is active on the calling thread and from the global heap otherwise.
+       * A 16-byte header in front of the frame remembers which, so the frame can be freed from any thread. There are no
+       * placement forms taking the arena as a coroutine parameter: they would have to be templates, and GCC then flags
+       * every frame as freed by a mismatched operator delete.
+       */
+      struct frame_alloc {
+            constexpr static inline std::size_t header = memory::arena::granule;
+
+            static inline void* allocate(std::size_t n, memory::arena* a) {
+               void* p = a ? a->allocate_bytes(n + header) : ::operator new(n + header);
+               *static_cast<memory::arena**>(p) = a;
+               return static_cast<std::byte*>(p) + header;
+            }
+
+            static inline void* operator new(std::size_t n) { return allocate(n, current); }
+
+            static inline void operator delete(void* frame, std::size_t n) noexcept {
+               void* p = static_cast<std::byte*>(frame) - header;
+               if (auto* a = *static_cast<memory::arena**>(p))
+                  a->deallocate_bytes(p, n + header);
+               else
+                  ::operator delete(p, n + header);
+            }
+
+            static inline thread_local memory::arena* current = nullptr;
+      };
+
+      template <typename T>
+      using value_t = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+      struct final_awaiter {
+            constexpr inline bool await_ready() const noexcept { return false; }
+
+            template <typename Promise>
+            inline std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) const noexcept {
+               auto next = h.promise().continuation;
+               return next ? next : std::noop_coroutine();
+            }
+
+            constexpr inline void await_resume() const noexcept {}
+      };
+
+      struct promise_base : frame_alloc {
+            constexpr inline std::suspend_always initial_suspend() const noexcept { return {}; }
+            constexpr inline final_awaiter       final_suspend() const noexcept { return {}; }
+            inline void                          unhandled_exception() noexcept { error = std::current_exception(); }
+
+            std::coroutine_handle<> continuation;
+            std::exception_ptr      error;
+      };
+
+      template <typename T>
+      struct task_promise : promise_base {
+            inline task<T> get_return_object() noexcept;
+
+            template <typename U>
+            inline void return_value(U&& v) {
+               value.emplace(std::forward<U>(v));
+            }
+
+            inline T result() {
+               if (error)
+                  std::rethrow_exception(error);
+               return std::move(*value);
+            }
+
+            std::optional<T> value;
+      };
+
+      template <>
+      struct task_promise<void> : promise_base {
+            inline task<void> get_return_object() noexcept;
+            constexpr inline void return_void() const noexcept {}
+
+            inline void result() const {
+               if (error)
+                  std::rethrow_exception(error);
+            }
+      };
+   } // namespace detail::co
+
+   /**
+    * @brief Routes the frames of coroutines started on this thread to an arena while in scope.
+    */
+   class frame_scope {
+      public:
+         inline explicit frame_scope(memory::arena& a) noexcept : _prev(std::exchange(detail::co::frame_alloc::current, &a)) {}
+
+         frame_scope(const frame_scope&)            = delete;
+         frame_scope& operator=(const frame_scope&) = delete;
+
+         inline ~frame_scope() { detail::co::frame_alloc::current = _prev; }
+
+      private:
+         memory::arena* _prev;
+   };
+
+   /**
+    * @brief Lazily started coroutine producing a T. Awaiting it starts it and resumes the awaiter, by symmetric transfer,
+    * when it finishes. Destroying the task destroys its frame.
+    */
+   template <typename T>
+   class task {
+      public:
+         static_assert(!std::is_reference_v<T>, "task: return a pointer or std::reference_wrapper instead");
+
+         using promise_type = detail::co::task_promise<T>;
+         using handle_type  = std::coroutine_handle<promise_type>;
+
+         task() = default;
+
+         inline explicit task(handle_type h) noexcept : _handle(h) {}
+
+         task(const task&)            = delete;
+         task& operator=(const task&) = delete;
+
+         inline task(task&& other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+
+         inline task& operator=(task&& other) noexcept {
+            if (this != &other) {
+               if (_handle)
+                  _handle.destroy();
+               _handle = std::exchange(other._handle, nullptr);
+            }
+            return *this;
+         }
+
+         inline ~task() {
+            if (_handle)
+               _handle.destroy();
+         }
+
+         inline bool valid() const noexcept { return static_cast<bool>(_handle); }
+         inline bool done() const noexcept { return _handle && _handle.done(); }
+
+         inline auto operator co_await() noexcept {
+            struct awaiter {
+                  inline bool await_ready() const noexcept { return !h || h.done(); }
+
+                  inline std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept {
+                     h.promise().continuation = awaiting;
+                     return h;
+                  }
+
+                  inline T await_resume() const {
+                     util::check(static_cast<bool>(h), "task: awaiting an empty task");
+                     return h.promise().result();
+                  }
+
+                  handle_type h;
+            };
+            return awaiter{_handle};
+         }
+
+      private:
+         handle_type _handle = nullptr;
+   };
+
+   namespace detail::co {
+      template <typename T>
+      inline task<T> task_promise<T>::get_return_object() noexcept {
+         return task<T>{std::coroutine_handle<task_promise<T>>::from_promise(*this)};
+      }
+
+      inline task<void> task_promise<void>::get_return_object() noexcept {
+         return task<void>{std::coroutine_handle<task_promise<void>>::from_promise(*this)};
+      }
+
+      /**
+       * @brief Wrapper that runs a task to completion for a thread blocked in sync_wait. It frees its own frame before
+       * raising the flag, so nothing touches it after the waiter returns.
+       */
+      struct blocking {
+            struct promise_type {
+                  inline blocking get_return_object() noexcept {
+                     return {std::coroutine_handle<promise_type>::from_promise(*this)};
+                  }
+
+                  constexpr inline std::suspend_always initial_suspend() const noexcept { return {}; }
+
+                  inline auto final_suspend() const noexcept {
+                     struct awaiter {
+                           constexpr inline bool await_ready() const noexcept { return false; }
+
+                           inline void await_suspend(std::coroutine_handle<promise_type> h) const noexcept {
+                              auto* flag = h.promise().flag;
+                              h.destroy();
+                              flag->store(1, std::memory_order_release);
+                              futex_wake_all(*flag);
+                           }
+
+                           constexpr inline void await_resume() const noexcept {}
+                     };
+                     return awaiter{};
+                  }
+
+                  constexpr inline void return_void() const noexcept {}
+                  inline void           unhandled_exception() const noexcept { std::terminate(); }
+
+                  std::atomic<std::uint32_t>* flag = nullptr;
+            };
+
+            std::coroutine_handle<promise_type> handle;
+      };
+
+      template <typename T>
+      inline blocking run_blocking(task<T>& t, std::optional<value_t<T>>& out, std::exception_ptr& error) {
+         try {
+            if constexpr (std::is_void_v<T>) {
+               co_await t;
+               out.emplace();
+            } else {
+               out.emplace(co_await t);
+            }
+         } catch (...) {
+            error = std::current_exception();
+         }
+      }
+
+      /**
+       * @brief Fire-and-forget wrapper used by spawn(), its frame frees itself when the task finishes.
+       */
+      struct detached {
+            struct promise_type : frame_alloc {
+                  constexpr inline detached            get_return_object() const noexcept { return {}; }
+                  constexpr inline std::suspend_never initial_suspend() const noexcept { return {}; }
+                  constexpr inline std::suspend_never final_suspend() const noexcept { return {}; }
+                  constexpr inline void               return_void() const noexcept {}
+                  inline void                         unhandled_exception() const noexcept { std::terminate(); }
+            };
+      };
+
+      inline detached run_detached(task<void> t) { co_await t; }
+
+      /**
+       * @brief Counts finished children; the last one to arrive resumes the parent.
+       */
+      struct join_state {
+            std::atomic<std::size_t> count = 0;
+            std::coroutine_handle<>  parent;
+      };
+
+      struct join_task {
+            struct promise_type : frame_alloc {
+                  inline join_task get_return_object() noexcept {
+                     return join_task{std::coroutine_handle<promise_type>::from_promise(*this)};
+                  }
+
+                  constexpr inline std::suspend_always initial_suspend() const noexcept { return {}; }
+
+                  inline auto final_suspend() const noexcept {
+                     struct awaiter {
+                           constexpr inline bool await_ready() const noexcept { return false; }
+
+                           inline std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) const noexcept {
+                              join_state* s = h.promise().state;
+                              if (s->count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                                 return s->parent;
+                              return std::noop_coroutine();
+                           }
+
+                           constexpr inline void await_resume() const noexcept {}
+                     };
+                     return awaiter{};
+                  }
+
+                  constexpr inline void return_void() const noexcept {}
+                  inline void           unhandled_exception() const noexcept { std::terminate(); }
+
+                  join_state* state = nullptr;
+            };
+
+            inline explicit join_task(std::coroutine_handle<promise_type> h) noexcept : handle(h) {}
+
+            join_task(const join_task&) = delete;
+
+            inline join_task(join_task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+            inline ~join_task() {
+               if (handle)
+                  handle.destroy();
+            }
+
+            std::coroutine_handle<promise_type> handle;
+      };
+
+      template <typename T>
+      inline join_task join_one(task<T>& t, std::optional<value_t<T>>& out, std::exception_ptr& error) {
+         try {
+            if constexpr (std::is_void_v<T>) {
+               co_await t;
+               out.emplace();
+            } else {
+               out.emplace(co_await t);
+            }
+         } catch (...) {
+            error = std::current_exception();
+         }
+      }
+
+      /**
+       * @brief Starts every child and suspends the parent until all of them have finished.
+       */
+      struct join_all {
+            constexpr inline bool await_ready() const noexcept { return joins.empty(); }
+
+            inline bool await_suspend(std::coroutine_handle<> parent) noexcept {
+               state.count.store(joins.size() + 1, std::memory_order_relaxed);
+               state.parent = parent;
+               for (auto& j : joins) {
+                  j.handle.promise().state = &state;
+                  j.handle.resume();
+               }
+               // children that finish inline leave the last arrival to us, then there is nothing to wait for
+               return state.count.fetch_sub(1, std::memory_order_acq_rel) != 1;
+            }
+
+            constexpr inline void await_resume() const noexcept {}
+
+            std::vector<join_task>& joins;
+            join_state              state = {};
+      };
+
+      template <typename... Ts, std::size_t... Is>
+      inline task<std::tuple<value_t<Ts>...>> when_all_impl(std::index_sequence<Is...>, task<Ts>... tasks) {
+         std::tuple<std::optional<value_t<Ts>>...> slots;
+         std::exception_ptr                        errors[sizeof...(Ts)];
+         std::vector<join_task>                    joins;
+         joins.reserve(sizeof...(Ts));
+         (joins.push_back(join_one(tasks, std::get<Is>(slots), errors[Is])), ...);
+         co_await join_all{joins};
+         for (auto& e : errors)
+            if (e)
+               std::rethrow_exception(e);
+         co_return std::tuple<value_t<Ts>...>{std::move(*std::get<Is>(slots))...};
+      }
+   } // namespace detail::co
+
+   /**
+    * @brief Blocks the calling thread until t finishes, then returns its result or rethrows its exception.
+    */
+   template <typename T>
+   inline T sync_wait(task<T> t) {
+      std::optional<detail::co::value_t<T>> out;
+      std::exception_ptr                    error;
+      std::atomic<std::uint32_t>            flag = 0;
+
+      auto b                       = detail::co::run_blocking(t, out, error);
+      b.handle.promise().flag      = &flag;
+      b.handle.resume();
+      while (flag.load(std::memory_order_acquire) == 0)
+         futex_wait(flag, 0);
+
+      if (error)
+         std::rethrow_exception(error);
+      if constexpr (!std::is_void_v<T>)
+         return std::move(*out);
+   }
+
+   /**
+    * @brief Starts t and lets it run on its own. An exception escaping it terminates the program.
+    */
+   inline void spawn(task<void> t) { detail::co::run_detached(std::move(t)); }
+
+   /**
+    * @brief Runs every task concurrently, as far as their own awaits allow, and collects their results in order. The
+    * first exception, in argument order, is rethrown once all of them have finished.
+    */
+   template <typename... Ts>
+   inline task<std::tuple<detail::co::value_t<Ts>...>> when_all(task<Ts>... tasks) {
+      return detail::co::when_all_impl(std::index_sequence_for<Ts...>{}, std::move(tasks)...);
+   }
+
+   template <typename T>
+   inline task<std::vector<detail::co::value_t<T>>> when_all(std::vector<task<T>> tasks) {
+      std::vector<std::optional<detail::co::value_t<T>>> slots(tasks.size());
+      std::vector<std::exception_ptr>                    errors(tasks.size());
+      std::vector<detail::co::join_task>                 joins;
+      joins.reserve(tasks.size());
+      for (std::size_t i = 0; i < tasks.size(); ++i)
+         joins.push_back(detail::co::join_one(tasks[i], slots[i], errors[i]));
+      co_await detail::co::join_all{joins};
+      for (auto& e : errors)
+         if (e)
+            std::rethrow_exception(e);
+      std::vector<detail::co::value_t<T>> out;
+      out.reserve(slots.size());
+      for (auto& s : slots)
+         out.push_back(std::move(*s));
+      co_return out;
+   }
+
+   /**
+    * @brief Awaitable that moves the awaiting coroutine onto a worker of pool.
+    */
+   inline auto schedule_on(thread_pool& pool) noexcept {
+      struct awaiter {
+            constexpr inline bool await_ready() const noexcept { return false; }
+            inline void           await_suspend(std::coroutine_handle<> h) const { pool.submit([h] { h.resume(); }); }
+            constexpr inline void await_resume() const noexcept {}
+
+            thread_pool& pool;
+      };
+      return awaiter{pool};
+   }
+
+} // namespace astro::async
@@ -0,0 +1,362 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "../utils/misc.hpp"
+#include "futex.hpp"
+#include "work_deque.hpp"
+
+namespace astro::async {
+   class thread_pool;
+
+   namespace detail::pool {
+      /**
+       * @brief A queued unit of work. One reference belongs to the queue, one to the future.
+       */
+      struct job {
+            virtual ~job()              = default;
+            virtual void run() noexcept = 0;
+
+            inline void release() noexcept {
+               if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                  delete this;
+            }
+
+            std::atomic<std::uint32_t> refs = 2;
+      };
+
+      enum state_word : std::uint32_t { pending = 0, done = 1, waited = 2 };
+
+      template <typename R>
+      struct state : job {
+            using value_type = std::conditional_t<std::is_void_v<R>, std::monostate, R>;
+
+            inline explicit state(thread_pool* p) noexcept : pool(p) {}
+
+            inline void finish() noexcept {
+               if (word.exchange(done, std::memory_order_acq_rel) == waited)
+                  futex_wake_all(word);
+            }
+
+            std::atomic<std::uint32_t> word = pending;
+            thread_pool*               pool;
+            std::optional<value_type>  value;
+            std::exception_ptr         error;
+      };
+
+      template <typename R, typename F, typename... Args>
+      struct bound final : state<R> {
+            template <typename G, typename... As>
+            inline explicit bound(thread_pool* p, G&& g, As&&... as)
+               : state<R>(p),
+                 fn(std::forward<G>(g)),
+                 args(std::forward<As>(as)...) {}
+
+            inline void run() noexcept override {
+               try {
+                  if constexpr (std::is_void_v<R>) {
+                     std::apply(std::move(fn), std::move(args));
+                     this->value.emplace();
+                  } else {
+                     this->value.emplace(std::apply(std::move(fn), std::move(args)));
+                  }
+               } catch (...) {
+                  this->error = std::current_exception();
+               }
+               this->finish();
+               this->release();
+            }
+
+            F                   fn;
+            std::tuple<Args...> args;
+      };
+   } // namespace detail::pool
+
+   /**
+    * @brief Result of thread_pool::submit, one heap block shared with the task instead of std::future's separate state.
+    *
+    * Waiting from a worker of the same pool runs other queued tasks rather than blocking, so nested fan-out cannot
+    * starve a fixed-size pool.
+    */
+   template <typename R>
+   class future {
+      public:
+         future() = default;
+
+         inline explicit future(detail::pool::state<R>* s) noexcept : _state(s) {}
+
+         future(const future&)            = delete;
+         future& operator=(const future&) = delete;
+
+         inline future(future&& other) noexcept : _state(std::exchange(other._state, nullptr)) {}
+
+         inline future& operator=(future&& other) noexcept {
+            if (this != &other) {
+               reset();
+               _state = std::exchange(other._state, nullptr);
+            }
+            return *this;
+         }
+
+         inline ~future() { reset(); }
+
+         inline bool valid() const noexcept { return _state != nullptr; }
+
+         inline bool ready() const noexcept {
+            return _state && _state->word.load(std::memory_order_acquire) == detail::pool::done;
+         }
+
+         void wait() const;
+
+         /**
+          * @brief Waits for the task, then returns its result or rethrows its exception. The future is empty afterwards.
+          */
+         inline R get() {
+            util::check(valid(), "future: get() on an empty future");
+            wait();
+            std::unique_ptr<detail::pool::state<R>, void (*)(detail::pool::state<R>*)> s{
+                  std::exchange(_state, nullptr), [](detail::pool::state<R>* p) { p->release(); }};
+            if (s->error)
+               std::rethrow_exception(s->error);
+            if constexpr (!std::is_void_v<R>)
+               return std::move(*s->value);
+         }
+
+      private:
+         inline void reset() noexcept {
+            if (_state)
+               std::exchange(_state, nullptr)->release();
+         }
+
+         detail::pool::state<R>* _state = nullptr;
+   };
+
+   /**
+    * @brief Fixed-size work-stealing thread pool.
+    *
+    * Each worker owns a Chase-Lev deque: tasks submitted from a worker go to its own deque and are popped newest first,
+    * tasks from outside go through a shared injection queue, and idle workers steal the oldest task from a random victim.
+    * Workers that find nothing spin briefly and then park on a futex, a submission only pays for a wake-up syscall while
+    * someone is parked. The destructor runs every queued task before joining.
+    */
+   class thread_pool {
+         using job = detail::pool::job;
+
+         struct alignas(cache_line_size) worker {
+               work_deque<job*> deque;
+               std::thread      thread;
+               std::uint64_t    seed = 0;
+         };
+
+         constexpr static inline std::size_t spin_limit = 64;
+
+      public:
+         inline explicit thread_pool(std::size_t threads = std::thread::hardware_concurrency())
+            : _size(threads ? threads : 1),
+              _workers(std::make_unique<worker[]>(_size)) {
+            for (std::size_t i = 0; i < _size; ++i)
+               _workers[i].seed = 0x9E3779B97F4A7C15ull * (i + 1);
+            for (std::size_t i = 0; i < _size; ++i)
+               _workers[i].thread = std::thread([this, i] { run_worker(_workers[i]); });
+         }
+
+         thread_pool(const thread_pool&)            = delete;
+         thread_pool& operator=(const thread_pool&) = delete;
+
+         inline ~thread_pool() {
+            _stopping.store(true, std::memory_order_seq_cst);
+            _epoch.fetch_add(1, std::memory_order_release);
+            futex_wake_all(_epoch);
+            for (std::size_t i = 0; i < _size; ++i)
+               _workers[i].thread.join();
+         }
+
+         /**
+          * @brief The process-wide pool, sized to the hardware and created on first use.
+          */
+         static inline thread_pool& shared() {
+            static thread_pool pool;
+            return pool;
+         }
+
+         inline std::size_t size() const noexcept { return _size; }
+
+         /**
+          * @brief Queues f(args...) with decayed copies of its arguments and returns the future of its result.
+          */
+         template <typename F, typename... Args>
+         inline auto submit(F&& f, Args&&... args) {
+            using result_t = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+            using bound_t  = detail::pool::bound<result_t, std::decay_t<F>, std::decay_t<Args>...>;
+            util::check(!_stopping.load(std::memory_order_relaxed), "thread_pool: submit() after shutdown");
+            auto* j = new bound_t(this, std::forward<F>(f), std::forward<Args>(args)...);
+            future<result_t> fut{j};
+            schedule(j);
+            return fut;
+         }
+
+         /**
+          * @brief Runs one queued task on the calling worker of this pool, returns false if there was none or the caller
+          * is not one of its workers.
+          */
+         inline bool try_run_one() {
+            if (_current_pool != this)
+               return false;
+            if (job* j = find_job(*_current_worker)) {
+               j->run();
+               return true;
+            }
+            return false;
+         }
+
+         inline bool on_worker() const noexcept { return _current_pool == this; }
+
+      private:
+         inline void schedule(job* j) {
+            if (_current_pool == this) {
+               _current_worker->deque.push(j);
+            } else {
+               std::lock_guard<std::mutex> lock(_mutex);
+               _injected.push_back(j);
+               _injected_size.store(_injected.size(), std::memory_order_relaxed);
+            }
+            notify();
+         }
+
+         inline void notify() noexcept {
+            // pairs with the fence in park(): either the sleeper sees the new task or we see the sleeper
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_sleepers.load(std::memory_order_relaxed) != 0) {
+               _epoch.fetch_add(1, std::memory_order_release);
+               futex_wake(_epoch);
+            }
+         }
+
+         inline job* take_injected() {
+            if (_injected_size.load(std::memory_order_relaxed) == 0)
+               return nullptr;
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_injected.empty())
+               return nullptr;
+            job* j = _injected.front();
+            _injected.pop_front();
+            _injected_size.store(_injected.size(), std::memory_order_relaxed);
+            return j;
+         }
+
+         inline job* find_job(worker& self) {
+            job* j = nullptr;
+            if (self.deque.pop(j))
+               return j;
+            if ((j = take_injected()))
+               return j;
+
+            std::uint64_t& s = self.seed;
+            s ^= s << 13;
+            s ^= s >> 7;
+            s ^= s << 17;
+            const std::size_t start = static_cast<std::size_t>(s % _size);
+            for (std::size_t i = 0; i < _size; ++i) {
+               worker& victim = _workers[(start + i) % _size];
+               if (&victim != &self && victim.deque.steal(j))
+                  return j;
+            }
+            return nullptr;
+         }
+
+         inline bool has_work() const noexcept {
+            if (_injected_size.load(std::memory_order_relaxed) != 0)
+               return true;
+            for (std::size_t i = 0; i < _size; ++i)
+               if (!_workers[i].deque.empty())
+                  return true;
+            return false;
+         }
+
+         inline void park() noexcept {
+            const std::uint32_t epoch = _epoch.load(std::memory_order_acquire);
+            _sleepers.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!has_work() && !_stopping.load(std::memory_order_relaxed))
+               futex_wait(_epoch, epoch);
+            _sleepers.fetch_sub(1, std::memory_order_relaxed);
+         }
+
+         inline void run_worker(worker& self) {
+            _current_pool   = this;
+            _current_worker = &self;
+            for (;;) {
+               job* j = nullptr;
+               for (std::size_t spin = 0; !j && spin < spin_limit; ++spin) {
+                  if (!(j = find_job(self)))
+                     cpu_relax();
+               }
+               if (j) {
+                  j->run();
+                  continue;
+               }
+               if (_stopping.load(std::memory_order_acquire) && !has_work())
+                  break;
+               park();
+            }
+            _current_pool   = nullptr;
+            _current_worker = nullptr;
+         }
+
+         static inline thread_local thread_pool* _current_pool   = nullptr;
+         static inline thread_local worker*      _current_worker = nullptr;
+
+         std::size_t               _size;
+         std::unique_ptr<worker[]> _workers;
+
+         alignas(cache_line_size) std::mutex _mutex;
+         std::deque<job*>                    _injected;
+         std::atomic<std::size_t>            _injected_size = 0;
+
+         alignas(cache_line_size) std::atomic<std::uint32_t> _epoch    = 0;
+         std::atomic<std::uint32_t>                          _sleepers = 0;
+         std::atomic<bool>                                   _stopping = false;
+   };
+
+   template <typename R>
+   inline void future<R>::wait() const {
+      util::check(valid(), "future: wait() on an empty future");
+      auto& word = _state->word;
+      if (word.load(std::memory_order_acquire) == detail::pool::done)
+         return;
+
+      if (_state->pool && _state->pool->on_worker()) {
+         while (word.load(std::memory_order_acquire) != detail::pool::done) {
+            if (!_state->pool->try_run_one())
+               std::this_thread::yield();
+         }
+         return;
+      }
+
+      for (std::size_t spin = 0; spin < 128; ++spin) {
+         if (word.load(std::memory_order_acquire) == detail::pool::done)
+            return;
+         cpu_relax();
+      }
+      std::uint32_t expected = detail::pool::pending;
+      if (!word.compare_exchange_strong(expected, detail::pool::waited, std::memory_order_acq_rel) && expected == detail::pool::done)
+         return;
+      while (word.load(std::memory_order_acquire) != detail::pool::done)
+         futex_wait(word, detail::pool::waited);
+   }
+
+} // namespace astro::async
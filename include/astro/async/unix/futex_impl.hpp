@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+#include <atomic>
+
+#if defined(__linux__)
+   #include <linux/futex.h>
+   #include <sys/syscall.h>
+   #include <unistd.h>
+#endif
+
+namespace astro::async {
+
+   /**
+    * @brief Blocks while word still holds expected. May return spuriously, callers re-check their condition.
+    */
+   static inline void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected) noexcept {
+#if defined(__linux__)
+      ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+      word.wait(expected, std::memory_order_acquire);
+#endif
+   }
+
+   /**
+    * @brief Wakes at most one thread blocked in futex_wait on word.
+    */
+   static inline void futex_wake(std::atomic<std::uint32_t>& word) noexcept {
+#if defined(__linux__)
+      ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+      word.notify_one();
+#endif
+   }
+
+   /**
+    * @brief Wakes every thread blocked in futex_wait on word.
+    */
+   static inline void futex_wake_all(std::atomic<std::uint32_t>& word) noexcept {
+#if defined(__linux__)
+      ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+#else
+      word.notify_all();
+#endif
+   }
+
+} // namespace astro::async
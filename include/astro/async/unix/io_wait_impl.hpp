@@ -0,0 +1,155 @@
+#pragma once
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+
+#include <chrono>
+#include <coroutine>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../../utils.hpp"
+#include "../thread_pool.hpp"
+
+namespace astro::async {
+
+   /**
+    * @brief Background thread that waits on timers and file descriptors with poll(2) and hands the coroutines waiting on
+    * them to a thread_pool. A self-pipe interrupts the poll whenever a new wait is registered.
+    */
+   class io_waiter {
+         struct fd_wait {
+               int                     fd;
+               short                   events;
+               std::coroutine_handle<> handle;
+         };
+
+      public:
+         inline explicit io_waiter(thread_pool& pool) : _pool(pool) {
+            util::check(::pipe(_wake) == 0, "io_waiter: failed to create the wake pipe");
+            for (int fd : _wake) {
+               ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+               ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+            }
+            _thread = std::thread([this] { run(); });
+         }
+
+         io_waiter(const io_waiter&)            = delete;
+         io_waiter& operator=(const io_waiter&) = delete;
+
+         inline ~io_waiter() {
+            {
+               std::lock_guard<std::mutex> lock(_mutex);
+               _stopping = true;
+            }
+            wake();
+            _thread.join();
+            ::close(_wake[0]);
+            ::close(_wake[1]);
+         }
+
+         static inline io_waiter& shared() {
+            // the pool must outlive the waiter that submits to it
+            static thread_pool& pool = thread_pool::shared();
+            static io_waiter    waiter{pool};
+            return waiter;
+         }
+
+         inline void add_timer(detail::co::clock::time_point deadline, std::coroutine_handle<> h) {
+            bool earliest;
+            {
+               std::lock_guard<std::mutex> lock(_mutex);
+               earliest = _timers.empty() || deadline < _timers.top().deadline;
+               _timers.push({deadline, h});
+            }
+            if (earliest)
+               wake();
+         }
+
+         inline void add_fd(int fd, io_event ev, std::coroutine_handle<> h) {
+            util::check(fd >= 0, "io_waiter: invalid file descriptor");
+            {
+               std::lock_guard<std::mutex> lock(_mutex);
+               _fds.push_back({fd, static_cast<short>(ev == io_event::readable ? POLLIN : POLLOUT), h});
+            }
+            wake();
+         }
+
+      private:
+         inline void wake() noexcept {
+            const char c = 1;
+            // a full pipe already guarantees a wake-up
+            [[maybe_unused]] auto n = ::write(_wake[1], &c, 1);
+         }
+
+         inline int timeout_ms() const noexcept {
+            if (_timers.empty())
+               return -1;
+            const auto left = _timers.top().deadline - detail::co::clock::now();
+            if (left <= detail::co::clock::duration::zero())
+               return 0;
+            const auto ms = std::chrono::ceil<std::chrono::milliseconds>(left).count();
+            return ms > INT_MAX ? INT_MAX : static_cast<int>(ms);
+         }
+
+         inline void run() {
+            std::vector<pollfd>                  polled;
+            std::vector<std::coroutine_handle<>> ready;
+            for (;;) {
+               int timeout;
+               {
+                  std::lock_guard<std::mutex> lock(_mutex);
+                  if (_stopping)
+                     return;
+                  polled.assign(1, pollfd{_wake[0], POLLIN, 0});
+                  for (const auto& w : _fds)
+                     polled.push_back({w.fd, w.events, 0});
+                  timeout = timeout_ms();
+               }
+
+               if (::poll(polled.data(), static_cast<nfds_t>(polled.size()), timeout) < 0 && errno != EINTR)
+                  continue;
+               if (polled[0].revents) {
+                  char buf[64];
+                  while (::read(_wake[0], buf, sizeof(buf)) > 0) {}
+               }
+
+               {
+                  std::lock_guard<std::mutex> lock(_mutex);
+                  const auto                  now = detail::co::clock::now();
+                  while (!_timers.empty() && _timers.top().deadline <= now) {
+                     ready.push_back(_timers.top().handle);
+                     _timers.pop();
+                  }
+                  // waits registered after the poll sit past the polled range and are left alone
+                  for (std::size_t i = polled.size() - 1; i > 0; --i) {
+                     if (polled[i].revents) {
+                        ready.push_back(_fds[i - 1].handle);
+                        _fds[i - 1] = _fds.back();
+                        _fds.pop_back();
+                     }
+                  }
+               }
+
+               for (auto h : ready)
+                  _pool.submit([h] { h.resume(); });
+               ready.clear();
+            }
+         }
+
+         thread_pool&           _pool;
+         int                    _wake[2] = {-1, -1};
+         std::mutex             _mutex;
+         detail::co::timer_heap _timers;
+         std::vector<fd_wait>   _fds;
+         bool                   _stopping = false;
+         std::thread            _thread;
+   };
+
+} // namespace astro::async
@@ -0,0 +1,723 @@
+#pragma once
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../../fs/file.hpp"
+#include "../../fs/file_sink.hpp"
+#include "../../fs/file_source.hpp"
+#include "../../utils.hpp"
+#include "../io_wait.hpp"
+#include "../task.hpp"
+#include "../thread_pool.hpp"
+#include "uring.hpp"
+
+namespace astro::async {
+   class reactor;
+
+   /**
+    * @brief A descriptor registered with a reactor. Deregisters on destruction, the descriptor itself is not closed.
+    */
+   class io_handle {
+      public:
+         io_handle() = default;
+
+         io_handle(const io_handle&)            = delete;
+         io_handle& operator=(const io_handle&) = delete;
+
+         inline io_handle(io_handle&& other) noexcept
+            : _reactor(std::exchange(other._reactor, nullptr)),
+              _state(std::move(other._state)) {}
+
+         inline io_handle& operator=(io_handle&& other) noexcept {
+            if (this != &other) {
+               reset();
+               _reactor = std::exchange(other._reactor, nullptr);
+               _state   = std::move(other._state);
+            }
+            return *this;
+         }
+
+         inline ~io_handle() { reset(); }
+
+         inline int  fd() const noexcept { return _state ? _state->fd : -1; }
+         inline bool valid() const noexcept { return static_cast<bool>(_state); }
+
+         /**
+          * @brief False for descriptors epoll cannot watch, such as regular files, which always count as ready.
+          */
+         inline bool pollable() const noexcept { return _state && !_state->in.always; }
+
+         inline void reset() noexcept;
+
+      private:
+         friend class reactor;
+
+         inline io_handle(reactor* r, std::unique_ptr<detail::io::fd_state> s) noexcept : _reactor(r), _state(std::move(s)) {}
+
+         reactor*                              _reactor = nullptr;
+         std::unique_ptr<detail::io::fd_state> _state;
+   };
+
+   /**
+    * @brief Edge-triggered epoll event loop.
+    *
+    * Each descriptor is registered once for both directions; events only mark it ready, and the coroutine waiting on that
+    * direction is resumed, inline on the loop thread or on a thread_pool when one is given. Timers come from a deadline
+    * heap that bounds the epoll_wait timeout, and other threads wake the loop through an eventfd to post work. Events are
+    * fetched batch_size at a time and all of a batch's readiness is recorded before any waiter runs.
+    *
+    * Offset-based file reads and writes, fsync and splice go through io_uring when the kernel has it. Their submissions
+    * are queued and handed to the kernel with one io_uring_enter per loop iteration, and completions signal the same
+    * eventfd as cross-thread wakeups. Registered files and buffers let the kernel skip per-call lookups and page pinning.
+    * No more operations are in flight than the completion ring holds, later ones wait in order until completions free room.
+    * Without io_uring the same calls use the plain syscalls, so callers never need to know which backend is active.
+    *
+    * Awaiting and posting are safe from any thread, run()/run_once() must only be called from one thread at a time.
+    */
+   class reactor {
+         // filled in by the loop when the submission it was tagged on completes, fill(prep, sqe) prepares the submission
+         struct completion {
+               std::coroutine_handle<> handle;
+               std::int32_t            res  = 0;
+               void*                   prep = nullptr;
+               void (*fill)(void*, io_uring_sqe&) = nullptr;
+         };
+
+         template <typename Prep>
+         struct ring_awaiter {
+               constexpr inline bool await_ready() const noexcept { return false; }
+               inline void           await_suspend(std::coroutine_handle<> h) {
+                  op.handle = h;
+                  op.prep   = &prep;
+                  op.fill   = [](void* p, io_uring_sqe& s) { (*static_cast<Prep*>(p))(s); };
+                  self.enqueue(op);
+               }
+               inline std::int32_t await_resume() const noexcept { return op.res; }
+
+               reactor&   self;
+               Prep       prep;
+               completion op = {};
+         };
+
+         struct timer {
+               detail::co::clock::time_point deadline;
+               std::coroutine_handle<>       handle;
+
+               friend inline bool operator>(const timer& a, const timer& b) noexcept { return a.deadline > b.deadline; }
+         };
+
+      public:
+         // the largest transfer Linux performs in one read or write
+         constexpr static inline std::size_t max_io = 0x7ffff000;
+
+         inline explicit reactor(thread_pool*    pool       = nullptr,
+                                 std::size_t     batch_size = 256,
+                                 reactor_backend backend    = reactor_backend::automatic)
+            : _pool(pool),
+              _events(batch_size ? batch_size : 1) {
+            _epoll = ::epoll_create1(EPOLL_CLOEXEC);
+            util::check(_epoll >= 0, "reactor: epoll_create1 failed");
+            _wake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (_wake < 0)
+               ::close(_epoll);
+            util::check(_wake >= 0, "reactor: eventfd failed");
+            epoll_event ev{};
+            ev.events   = EPOLLIN;
+            ev.data.ptr = nullptr;
+            util::check(::epoll_ctl(_epoll, EPOLL_CTL_ADD, _wake, &ev) == 0, "reactor: failed to register the eventfd");
+
+            if (backend == reactor_backend::automatic) {
+               _ring.emplace(static_cast<unsigned>(_events.size()),
+                             std::initializer_list<std::uint8_t>{IORING_OP_READ, IORING_OP_WRITE, IORING_OP_READ_FIXED,
+                                                                 IORING_OP_WRITE_FIXED, IORING_OP_FSYNC,
+                                                                 IORING_OP_SPLICE});
+               if (!_ring->valid() || _ring->enroll(IORING_REGISTER_EVENTFD, &_wake, 1) != 0)
+                  _ring.reset();
+            }
+         }
+
+         reactor(const reactor&)            = delete;
+         reactor& operator=(const reactor&) = delete;
+
+         inline ~reactor() {
+            ::close(_wake);
+            ::close(_epoll);
+         }
+
+         /**
+          * @brief Registers fd for edge-triggered readiness and makes it non-blocking. Descriptors epoll refuses, like
+          * regular files, are accepted as always ready and left blocking.
+          */
+         inline io_handle add(int fd) {
+            util::check(fd >= 0, "reactor: invalid file descriptor");
+            auto s = std::make_unique<detail::io::fd_state>();
+            s->fd  = fd;
+
+            epoll_event ev{};
+            ev.events   = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+            ev.data.ptr = s.get();
+            if (::epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &ev) == 0) {
+               ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+            } else {
+               util::check(errno == EPERM, "reactor: epoll_ctl failed");
+               s->in.always = s->out.always = true;
+               s->in.state.store(1, std::memory_order_relaxed);
+               s->out.state.store(1, std::memory_order_relaxed);
+            }
+            return io_handle{this, std::move(s)};
+         }
+
+         inline io_handle add(const fs::file& f) { return add(f.native_handle()); }
+         inline io_handle add(const fs::native_file_sink& s) { return add(s.fd); }
+         inline io_handle add(const fs::native_file_source& s) { return add(s.fd); }
+
+         /**
+          * @brief Awaitable that suspends until h is readable, or has hung up or failed.
+          */
+         inline detail::io::ready_awaiter readable(io_handle& h) const {
+            util::check(h.valid(), "reactor: awaiting an empty io_handle");
+            return {h._state->in};
+         }
+
+         /**
+          * @brief Awaitable that suspends until h is writable, or has failed.
+          */
+         inline detail::io::ready_awaiter writable(io_handle& h) const {
+            util::check(h.valid(), "reactor: awaiting an empty io_handle");
+            return {h._state->out};
+         }
+
+         /**
+          * @brief Reads what is available, waiting for readiness first if there is nothing.
+          * @return The number of bytes read, 0 at the end of the stream or -1 on error with errno set.
+          */
+         inline task<std::int64_t> read_some(io_handle& h, std::span<std::uint8_t> buf) {
+            for (;;) {
+               const auto    snap = h._state->in.snapshot();
+               const ssize_t n    = ::read(h.fd(), buf.data(), buf.size());
+               if (n >= 0)
+                  co_return n;
+               if (errno == EINTR)
+                  continue;
+               if (errno != EAGAIN && errno != EWOULDBLOCK)
+                  co_return -1;
+               h._state->in.clear(snap);
+               co_await readable(h);
+            }
+         }
+
+         /**
+          * @brief Writes as much of buf as fits, waiting for readiness first if nothing does.
+          * @return The number of bytes written, or -1 on error with errno set.
+          */
+         inline task<std::int64_t> write_some(io_handle& h, std::span<const std::uint8_t> buf) {
+            for (;;) {
+               const auto    snap = h._state->out.snapshot();
+               const ssize_t n    = ::write(h.fd(), buf.data(), buf.size());
+               if (n >= 0)
+                  co_return n;
+               if (errno == EINTR)
+                  continue;
+               if (errno != EAGAIN && errno != EWOULDBLOCK)
+                  co_return -1;
+               h._state->out.clear(snap);
+               co_await writable(h);
+            }
+         }
+
+         /**
+          * @brief True when file operations go through io_uring rather than direct syscalls.
+          */
+         inline bool uses_uring() const noexcept { return _ring.has_value(); }
+
+         /**
+          * @brief Registers handles with io_uring so their operations skip the per-call descriptor lookup. Replaces any
+          * earlier set, and a handle leaves the set when it is destroyed.
+          * @return False without io_uring, operations then keep using the plain descriptors.
+          */
+         inline bool register_files(std::span<io_handle* const> handles) {
+            if (!_ring)
+               return false;
+            std::lock_guard<std::mutex> lock(_mutex);
+            release_files();
+            std::vector<int> fds;
+            fds.reserve(handles.size());
+            for (io_handle* h : handles) {
+               util::check(h && h->valid(), "reactor: registering an empty io_handle");
+               fds.push_back(h->fd());
+            }
+            if (_ring->enroll(IORING_REGISTER_FILES, fds.data(), static_cast<unsigned>(fds.size())) != 0)
+               return false;
+            for (io_handle* h : handles) {
+               h->_state->slot = static_cast<int>(_files.size());
+               _files.push_back(h->_state.get());
+            }
+            return true;
+         }
+
+         inline void unregister_files() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            release_files();
+         }
+
+         /**
+          * @brief Pins buffers for io_uring; read_at() and write_at() on a span inside one of them use the fixed-buffer
+          * opcodes. Replaces any earlier set, and the memory must stay valid until unregister_buffers() or destruction.
+          * @return False without io_uring or when the kernel refuses to pin them.
+          */
+         inline bool register_buffers(std::span<const std::span<std::uint8_t>> buffers) {
+            if (!_ring)
+               return false;
+            std::lock_guard<std::mutex> lock(_mutex);
+            release_buffers();
+            std::vector<iovec> iov;
+            iov.reserve(buffers.size());
+            for (auto b : buffers)
+               iov.push_back({b.data(), b.size()});
+            if (_ring->enroll(IORING_REGISTER_BUFFERS, iov.data(), static_cast<unsigned>(iov.size())) != 0)
+               return false;
+            _buffers = std::move(iov);
+            return true;
+         }
+
+         inline void unregister_buffers() {
+            std::lock_guard<std::mutex> lock(_mutex);
+            release_buffers();
+         }
+
+         /**
+          * @brief Reads up to buf.size() bytes at offset without moving the file position. Meant for files, streams
+          * should use read_some().
+          * @return The number of bytes read, 0 at the end of the file or -1 on error with errno set.
+          */
+         inline task<std::int64_t> read_at(io_handle& h, std::span<std::uint8_t> buf, std::uint64_t offset) {
+            const std::size_t len = std::min(buf.size(), max_io);
+            if (!_ring) {
+               ssize_t n;
+               while ((n = ::pread(h.fd(), buf.data(), len, static_cast<off_t>(offset))) < 0 && errno == EINTR) {}
+               co_return n;
+            }
+            co_return result(co_await uring_op([&](io_uring_sqe& s) {
+               prep_rw(s, IORING_OP_READ, IORING_OP_READ_FIXED, h, buf.data(), len, offset);
+            }));
+         }
+
+         /**
+          * @brief Writes up to buf.size() bytes at offset without moving the file position. Meant for files, streams
+          * should use write_some().
+          * @return The number of bytes written, or -1 on error with errno set.
+          */
+         inline task<std::int64_t> write_at(io_handle& h, std::span<const std::uint8_t> buf, std::uint64_t offset) {
+            const std::size_t len = std::min(buf.size(), max_io);
+            if (!_ring) {
+               ssize_t n;
+               while ((n = ::pwrite(h.fd(), buf.data(), len, static_cast<off_t>(offset))) < 0 && errno == EINTR) {}
+               co_return n;
+            }
+            co_return result(co_await uring_op([&](io_uring_sqe& s) {
+               prep_rw(s, IORING_OP_WRITE, IORING_OP_WRITE_FIXED, h, buf.data(), len, offset);
+            }));
+         }
+
+         /**
+          * @brief Flushes h to storage, only its data and the metadata needed to read it back when data_only is set.
+          * @return 0, or -1 on error with errno set.
+          */
+         inline task<int> fsync(io_handle& h, bool data_only = false) {
+            if (!_ring) {
+               int r;
+               while ((r = data_only ? ::fdatasync(h.fd()) : ::fsync(h.fd())) < 0 && errno == EINTR) {}
+               co_return r;
+            }
+            co_return static_cast<int>(result(co_await uring_op([&](io_uring_sqe& s) {
+               s.opcode = IORING_OP_FSYNC;
+               target(s, h);
+               s.fsync_flags = data_only ? IORING_FSYNC_DATASYNC : 0;
+            })));
+         }
+
+         /**
+          * @brief Moves up to len bytes from in to out without copying through user space; one of them must be a pipe.
+          * Waits for whichever side is not ready when neither can make progress.
+          * @return The number of bytes moved, 0 at the end of in or -1 on error with errno set.
+          */
+         inline task<std::int64_t> splice(io_handle& in, io_handle& out, std::size_t len) {
+            len = std::min(len, max_io);
+            for (;;) {
+               const auto   in_snap  = in._state->in.snapshot();
+               const auto   out_snap = out._state->out.snapshot();
+               std::int64_t n;
+               if (_ring) {
+                  n = result(co_await uring_op([&](io_uring_sqe& s) {
+                     s.opcode = IORING_OP_SPLICE;
+                     target(s, out);
+                     s.splice_off_in = ~std::uint64_t{0};
+                     s.off           = ~std::uint64_t{0};
+                     s.len           = static_cast<std::uint32_t>(len);
+                     s.splice_flags  = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+                     if (in._state->slot >= 0) {
+                        s.splice_fd_in  = in._state->slot;
+                        s.splice_flags |= SPLICE_F_FD_IN_FIXED;
+                     } else {
+                        s.splice_fd_in = in.fd();
+                     }
+                  }));
+               } else {
+                  while ((n = ::splice(in.fd(), nullptr, out.fd(), nullptr, len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK)) < 0
+                         && errno == EINTR) {}
+               }
+               if (n >= 0 || errno != EAGAIN)
+                  co_return n;
+
+               // the error does not say which side blocked, so ask
+               pollfd fds[2] = {{in.fd(), POLLIN, 0}, {out.fd(), POLLOUT, 0}};
+               ::poll(fds, 2, 0);
+               if (in.pollable() && !(fds[0].revents & (POLLIN | POLLHUP | POLLERR))) {
+                  in._state->in.clear(in_snap);
+                  co_await readable(in);
+               } else if (out.pollable() && !(fds[1].revents & (POLLOUT | POLLERR))) {
+                  out._state->out.clear(out_snap);
+                  co_await writable(out);
+               }
+            }
+         }
+
+         /**
+          * @brief Awaitable that resumes the coroutine once the loop has passed tp.
+          */
+         inline auto sleep_until(detail::co::clock::time_point tp) noexcept {
+            struct awaiter {
+                  inline bool await_ready() const noexcept { return deadline <= detail::co::clock::now(); }
+                  inline void await_suspend(std::coroutine_handle<> h) const { self.add_timer(deadline, h); }
+                  constexpr inline void await_resume() const noexcept {}
+
+                  reactor&                      self;
+                  detail::co::clock::time_point deadline;
+            };
+            return awaiter{*this, tp};
+         }
+
+         template <typename Rep, typename Period>
+         inline auto sleep_for(std::chrono::duration<Rep, Period> d) noexcept {
+            return sleep_until(detail::co::clock::now() + std::chrono::ceil<detail::co::clock::duration>(d));
+         }
+
+         /**
+          * @brief Awaitable that moves the coroutine onto the loop thread.
+          */
+         inline auto schedule() noexcept {
+            struct awaiter {
+                  constexpr inline bool await_ready() const noexcept { return false; }
+                  inline void           await_suspend(std::coroutine_handle<> h) const { self.post([h] { h.resume(); }); }
+                  constexpr inline void await_resume() const noexcept {}
+
+                  reactor& self;
+            };
+            return awaiter{*this};
+         }
+
+         /**
+          * @brief Runs fn on the loop thread during its next iteration. Safe from any thread.
+          */
+         inline void post(std::function<void()> fn) {
+            {
+               std::lock_guard<std::mutex> lock(_mutex);
+               _posted.push_back(std::move(fn));
+            }
+            wake();
+         }
+
+         /**
+          * @brief Waits at most timeout_ms (-1 for no limit) for events, timers or posted work and handles one batch.
+          * @return How many waiters and posted functions ran.
+          */
+         inline std::size_t run_once(int timeout_ms = -1) {
+            _loop_thread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+            int timeout;
+            {
+               std::lock_guard<std::mutex> lock(_mutex);
+               if (_ring) {
+                  unpark();
+                  _ring->submit();
+               }
+               timeout = _posted.empty() && !(_ring && _ring->pending()) ? next_timeout(timeout_ms) : 0;
+            }
+
+            const int n = ::epoll_wait(_epoll, _events.data(), static_cast<int>(_events.size()), timeout);
+            for (int i = 0; i < n; ++i) {
+               const epoll_event& e = _events[i];
+               if (!e.data.ptr) {
+                  std::uint64_t count;
+                  [[maybe_unused]] auto r = ::read(_wake, &count, sizeof(count));
+                  _wake_pending.store(false, std::memory_order_seq_cst);
+                  continue;
+               }
+               auto* s = static_cast<detail::io::fd_state*>(e.data.ptr);
+               if (e.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+                  if (auto h = s->in.set())
+                     _ready.push_back(h);
+               if (e.events & (EPOLLOUT | EPOLLHUP | EPOLLERR))
+                  if (auto h = s->out.set())
+                     _ready.push_back(h);
+            }
+
+            if (_ring) {
+               const std::size_t done = _ring->reap([this](const io_uring_cqe& c) {
+                  auto* op = reinterpret_cast<completion*>(static_cast<std::uintptr_t>(c.user_data));
+                  op->res  = c.res;
+                  _ready.push_back(op->handle);
+               });
+               if (done != 0) {
+                  std::lock_guard<std::mutex> lock(_mutex);
+                  _in_flight -= done;
+                  unpark();
+               }
+            }
+
+            std::vector<std::function<void()>> posted;
+            {
+               std::lock_guard<std::mutex> lock(_mutex);
+               const auto                  now = detail::co::clock::now();
+               while (!_timers.empty() && _timers.front().deadline <= now) {
+                  std::pop_heap(_timers.begin(), _timers.end(), std::greater<>{});
+                  _ready.push_back(_timers.back().handle);
+                  _timers.pop_back();
+               }
+               posted.swap(_posted);
+            }
+
+            const std::size_t ran = _ready.size() + posted.size();
+            for (auto h : _ready)
+               dispatch(h);
+            _ready.clear();
+            for (auto& fn : posted)
+               fn();
+            return ran;
+         }
+
+         /**
+          * @brief Runs the loop on the calling thread until stop().
+          */
+         inline void run() {
+            while (!_stopping.load(std::memory_order_acquire))
+               run_once();
+            _stopping.store(false, std::memory_order_relaxed);
+         }
+
+         /**
+          * @brief Makes run() return after its current iteration. Safe from any thread.
+          */
+         inline void stop() noexcept {
+            _stopping.store(true, std::memory_order_release);
+            wake();
+         }
+
+         inline bool on_loop_thread() const noexcept {
+            return _loop_thread.load(std::memory_order_relaxed) == std::this_thread::get_id();
+         }
+
+      private:
+         friend class io_handle;
+
+         inline void deregister(int fd) noexcept { ::epoll_ctl(_epoll, EPOLL_CTL_DEL, fd, nullptr); }
+
+         inline void forget_file(int slot) noexcept {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _files[slot] = nullptr;
+            int                   none = -1;
+            io_uring_files_update update{};
+            update.offset = static_cast<unsigned>(slot);
+            update.fds    = reinterpret_cast<std::uintptr_t>(&none);
+            _ring->enroll(IORING_REGISTER_FILES_UPDATE, &update, 1);
+         }
+
+         // both expect _mutex to be held
+         inline void release_files() noexcept {
+            if (_files.empty())
+               return;
+            for (auto* s : _files)
+               if (s)
+                  s->slot = -1;
+            _files.clear();
+            _ring->enroll(IORING_UNREGISTER_FILES, nullptr, 0);
+         }
+
+         inline void release_buffers() noexcept {
+            if (_buffers.empty())
+               return;
+            _buffers.clear();
+            _ring->enroll(IORING_UNREGISTER_BUFFERS, nullptr, 0);
+         }
+
+         template <typename Prep>
+         inline ring_awaiter<std::decay_t<Prep>> uring_op(Prep&& prep) {
+            return {*this, std::forward<Prep>(prep)};
+         }
+
+         // queues one submission; the loop hands it to the kernel together with everything else queued meanwhile
+         inline void enqueue(completion& op) {
+            {
+               std::lock_guard<std::mutex> lock(_mutex);
+               // with the completion or submission ring full the operation waits, in order, for the loop to make room
+               if (!_parked.empty() || !place(op))
+                  _parked.push_back(&op);
+            }
+            if (!on_loop_thread())
+               wake();
+         }
+
+         // the rest expect _mutex to be held
+         inline bool place(completion& op) {
+            if (_in_flight >= _ring->cq_entries())
+               return false;
+            io_uring_sqe* sqe = _ring->get_sqe();
+            if (!sqe)
+               return false;
+            op.fill(op.prep, *sqe);
+            sqe->user_data = reinterpret_cast<std::uintptr_t>(&op);
+            ++_in_flight;
+            return true;
+         }
+
+         // loop thread only, submitting here keeps io_uring_enter off the awaiting threads
+         inline void unpark() {
+            while (!_parked.empty()) {
+               if (place(*_parked.front()))
+                  _parked.pop_front();
+               else if (_in_flight >= _ring->cq_entries() || _ring->submit() <= 0)
+                  return;
+            }
+         }
+
+         inline void target(io_uring_sqe& s, const io_handle& h) const noexcept {
+            if (h._state->slot >= 0) {
+               s.fd     = h._state->slot;
+               s.flags |= IOSQE_FIXED_FILE;
+            } else {
+               s.fd = h.fd();
+            }
+         }
+
+         inline void prep_rw(io_uring_sqe&    s,
+                             std::uint8_t     op,
+                             std::uint8_t     fixed_op,
+                             const io_handle& h,
+                             const void*      data,
+                             std::size_t      len,
+                             std::uint64_t    offset) const noexcept {
+            s.opcode = op;
+            target(s, h);
+            s.addr = reinterpret_cast<std::uintptr_t>(data);
+            s.len  = static_cast<std::uint32_t>(len);
+            s.off  = offset;
+            const auto* p = static_cast<const std::uint8_t*>(data);
+            for (std::size_t i = 0; i < _buffers.size(); ++i) {
+               const auto* base = static_cast<const std::uint8_t*>(_buffers[i].iov_base);
+               if (p >= base && p + len <= base + _buffers[i].iov_len) {
+                  s.opcode    = fixed_op;
+                  s.buf_index = static_cast<std::uint16_t>(i);
+                  break;
+               }
+            }
+         }
+
+         static inline std::int64_t result(std::int32_t res) noexcept {
+            if (res < 0) {
+               errno = -res;
+               return -1;
+            }
+            return res;
+         }
+
+         inline void wake() noexcept {
+            if (!_wake_pending.exchange(true, std::memory_order_seq_cst)) {
+               const std::uint64_t one = 1;
+               [[maybe_unused]] auto r = ::write(_wake, &one, sizeof(one));
+            }
+         }
+
+         inline void add_timer(detail::co::clock::time_point deadline, std::coroutine_handle<> h) {
+            bool earliest;
+            {
+               std::lock_guard<std::mutex> lock(_mutex);
+               earliest = _timers.empty() || deadline < _timers.front().deadline;
+               _timers.push_back({deadline, h});
+               std::push_heap(_timers.begin(), _timers.end(), std::greater<>{});
+            }
+            if (earliest && !on_loop_thread())
+               wake();
+         }
+
+         inline int next_timeout(int limit) const noexcept {
+            if (_timers.empty())
+               return limit;
+            const auto left = _timers.front().deadline - detail::co::clock::now();
+            if (left <= detail::co::clock::duration::zero())
+               return 0;
+            const auto ms = std::chrono::ceil<std::chrono::milliseconds>(left).count();
+            const int  t  = ms > INT_MAX ? INT_MAX : static_cast<int>(ms);
+            return limit < 0 || t < limit ? t : limit;
+         }
+
+         inline void dispatch(std::coroutine_handle<> h) {
+            if (_pool)
+               _pool->submit([h] { h.resume(); });
+            else
+               h.resume();
+         }
+
+         thread_pool*                         _pool;
+         int                                  _epoll = -1;
+         int                                  _wake  = -1;
+         std::vector<epoll_event>             _events;
+         std::vector<std::coroutine_handle<>> _ready;
+         std::atomic<bool>                    _wake_pending = false;
+         std::atomic<bool>                    _stopping     = false;
+         std::atomic<std::thread::id>         _loop_thread;
+
+         std::mutex                         _mutex;
+         std::vector<timer>                 _timers;
+         std::vector<std::function<void()>> _posted;
+
+         // submissions and registrations may come from any thread and take _mutex, only the loop reaps completions
+         std::optional<detail::io::uring>   _ring;
+         std::vector<detail::io::fd_state*> _files;
+         std::vector<iovec>                 _buffers;
+         std::deque<completion*>            _parked;
+         std::size_t                        _in_flight = 0;
+   };
+
+   inline void io_handle::reset() noexcept {
+      if (_state && _reactor && _state->slot >= 0)
+         _reactor->forget_file(_state->slot);
+      if (_state && _reactor && !_state->in.always)
+         _reactor->deregister(_state->fd);
+      _state.reset();
+      _reactor = nullptr;
+   }
+
+} // namespace astro::async
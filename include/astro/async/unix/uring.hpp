@@ -0,0 +1,222 @@
+#pragma once
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <atomic>
+#include <initializer_list>
+#include <utility>
+
+namespace astro::async::detail::io {
+
+   /**
+    * @brief Minimal io_uring over the raw syscalls: one submission and one completion ring mapped into the process.
+    *
+    * Setup failing for any reason (old kernel, seccomp, missing opcodes) leaves the ring invalid and callers use their
+    * non-uring path. Submission queue entries are produced by one thread at a time and completions are reaped by one
+    * thread; the caller provides that exclusion.
+    */
+   class uring {
+      public:
+         uring() = default;
+
+         inline explicit uring(unsigned entries, std::initializer_list<std::uint8_t> required_ops) noexcept {
+            io_uring_params p{};
+            p.flags = IORING_SETUP_CLAMP;
+            _fd     = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+            if (_fd < 0)
+               return;
+            if (!map(p) || !supports(required_ops)) {
+               release();
+               return;
+            }
+         }
+
+         uring(const uring&)            = delete;
+         uring& operator=(const uring&) = delete;
+
+         inline ~uring() { release(); }
+
+         inline bool valid() const noexcept { return _fd >= 0; }
+         inline int  fd() const noexcept { return _fd; }
+
+         /**
+          * @brief Completion ring slots. Keeping no more operations in flight than this means completions never overflow.
+          */
+         inline unsigned cq_entries() const noexcept { return _cq_entries; }
+
+         /**
+          * @brief The next free submission entry, zeroed, or nullptr when the ring is full until submit().
+          */
+         inline io_uring_sqe* get_sqe() noexcept {
+            const unsigned head = std::atomic_ref<unsigned>(*_sq_head).load(std::memory_order_acquire);
+            if (_sq_tail - head >= _sq_entries)
+               return nullptr;
+            io_uring_sqe* sqe = &_sqes[_sq_tail & _sq_mask];
+            std::memset(sqe, 0, sizeof(*sqe));
+            ++_sq_tail;
+            return sqe;
+         }
+
+         /**
+          * @brief Entries filled since the last submit().
+          */
+         inline unsigned pending() const noexcept { return _sq_tail - _sq_flushed; }
+
+         /**
+          * @brief Hands every pending entry to the kernel in one io_uring_enter.
+          * @return The number the kernel took, or -errno. EAGAIN and EBUSY leave the entries pending.
+          */
+         inline int submit() noexcept {
+            if (pending() == 0)
+               return 0;
+            std::atomic_ref<unsigned>(*_sq_ktail).store(_sq_tail, std::memory_order_release);
+            for (;;) {
+               const long n = ::syscall(__NR_io_uring_enter, _fd, pending(), 0u, 0u, nullptr, 0u);
+               if (n >= 0) {
+                  _sq_flushed += static_cast<unsigned>(n);
+                  return static_cast<int>(n);
+               }
+               if (errno != EINTR)
+                  return -errno;
+            }
+         }
+
+         /**
+          * @brief Calls fn on every available completion and returns how many there were.
+          *
+          * Completions the kernel held back because the ring was full are flushed into it and reaped as well.
+          */
+         template <typename F>
+         inline std::size_t reap(F&& fn) {
+            std::atomic_ref<unsigned> khead(*_cq_head);
+            std::size_t               n = 0;
+            for (;;) {
+               unsigned       head = khead.load(std::memory_order_relaxed);
+               const unsigned tail = std::atomic_ref<unsigned>(*_cq_tail).load(std::memory_order_acquire);
+               n                  += tail - head;
+               for (; head != tail; ++head)
+                  fn(_cqes[head & _cq_mask]);
+               khead.store(head, std::memory_order_release);
+               if (!(std::atomic_ref<unsigned>(*_sq_flags).load(std::memory_order_acquire) & IORING_SQ_CQ_OVERFLOW))
+                  return n;
+               // only an enter asking for events moves the overflow backlog into the ring
+               while (::syscall(__NR_io_uring_enter, _fd, 0u, 0u, IORING_ENTER_GETEVENTS, nullptr, 0u) < 0)
+                  if (errno != EINTR)
+                     return n;
+            }
+         }
+
+         /**
+          * @brief io_uring_register, returning 0 or -errno.
+          */
+         inline int enroll(unsigned opcode, const void* arg, unsigned n) noexcept {
+            const long r = ::syscall(__NR_io_uring_register, _fd, opcode, arg, n);
+            return r < 0 ? -errno : 0;
+         }
+
+      private:
+         inline bool map(const io_uring_params& p) noexcept {
+            _sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+            _cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+            if (p.features & IORING_FEAT_SINGLE_MMAP)
+               _sq_size = _cq_size = _sq_size > _cq_size ? _sq_size : _cq_size;
+
+            _sq_ring = ::mmap(nullptr, _sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+            if (_sq_ring == MAP_FAILED) {
+               _sq_ring = nullptr;
+               return false;
+            }
+            if (p.features & IORING_FEAT_SINGLE_MMAP) {
+               _cq_ring = _sq_ring;
+            } else {
+               _cq_ring = ::mmap(nullptr, _cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd,
+                                 IORING_OFF_CQ_RING);
+               if (_cq_ring == MAP_FAILED) {
+                  _cq_ring = nullptr;
+                  return false;
+               }
+            }
+            _sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+            void* sqes = ::mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd,
+                                IORING_OFF_SQES);
+            if (sqes == MAP_FAILED)
+               return false;
+            _sqes = static_cast<io_uring_sqe*>(sqes);
+
+            auto* sq    = static_cast<std::byte*>(_sq_ring);
+            auto* cq    = static_cast<std::byte*>(_cq_ring);
+            _sq_head    = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+            _sq_flags   = reinterpret_cast<unsigned*>(sq + p.sq_off.flags);
+            _sq_ktail   = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+            _sq_mask    = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+            _sq_entries = p.sq_entries;
+            _cq_head    = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+            _cq_tail    = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+            _cq_mask    = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+            _cq_entries = p.cq_entries;
+            _cqes       = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+            // entries are always used in order, so the indirection array is fixed to the identity
+            auto* array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+            for (unsigned i = 0; i < p.sq_entries; ++i)
+               array[i] = i;
+            _sq_tail = _sq_flushed = *_sq_ktail;
+            return true;
+         }
+
+         inline bool supports(std::initializer_list<std::uint8_t> ops) noexcept {
+            constexpr std::size_t max_ops = 256;
+            alignas(io_uring_probe) std::byte buf[sizeof(io_uring_probe) + max_ops * sizeof(io_uring_probe_op)] = {};
+            auto* probe = reinterpret_cast<io_uring_probe*>(buf);
+            if (enroll(IORING_REGISTER_PROBE, probe, max_ops) != 0)
+               return false;
+            for (std::uint8_t op : ops)
+               if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+                  return false;
+            return true;
+         }
+
+         inline void release() noexcept {
+            if (_sqes)
+               ::munmap(_sqes, _sqes_size);
+            if (_cq_ring && _cq_ring != _sq_ring)
+               ::munmap(_cq_ring, _cq_size);
+            if (_sq_ring)
+               ::munmap(_sq_ring, _sq_size);
+            if (_fd >= 0)
+               ::close(_fd);
+            _sqes    = nullptr;
+            _sq_ring = _cq_ring = nullptr;
+            _fd      = -1;
+         }
+
+         int           _fd         = -1;
+         void*         _sq_ring    = nullptr;
+         void*         _cq_ring    = nullptr;
+         std::size_t   _sq_size    = 0;
+         std::size_t   _cq_size    = 0;
+         std::size_t   _sqes_size  = 0;
+         io_uring_sqe* _sqes       = nullptr;
+         io_uring_cqe* _cqes       = nullptr;
+         unsigned*     _sq_head    = nullptr;
+         unsigned*     _sq_ktail   = nullptr;
+         unsigned*     _sq_flags   = nullptr;
+         unsigned*     _cq_head    = nullptr;
+         unsigned*     _cq_tail    = nullptr;
+         unsigned      _sq_mask    = 0;
+         unsigned      _sq_entries = 0;
+         unsigned      _cq_mask    = 0;
+         unsigned      _cq_entries = 0;
+         unsigned      _sq_tail    = 0;
+         unsigned      _sq_flushed = 0;
+   };
+
+} // namespace astro::async::detail::io
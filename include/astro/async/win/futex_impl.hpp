@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+#include <windows.h>
+
+#include <atomic>
+
+#pragma comment(lib, "Synchronization.lib")
+
+namespace astro::async {
+
+   /**
+    * @brief Blocks while word still holds expected. May return spuriously, callers re-check their condition.
+    */
+   static inline void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected) noexcept {
+      ::WaitOnAddress(reinterpret_cast<volatile void*>(&word), &expected, sizeof(expected), INFINITE);
+   }
+
+   /**
+    * @brief Wakes at most one thread blocked in futex_wait on word.
+    */
+   static inline void futex_wake(std::atomic<std::uint32_t>& word) noexcept { ::WakeByAddressSingle(reinterpret_cast<void*>(&word)); }
+
+   /**
+    * @brief Wakes every thread blocked in futex_wait on word.
+    */
+   static inline void futex_wake_all(std::atomic<std::uint32_t>& word) noexcept { ::WakeByAddressAll(reinterpret_cast<void*>(&word)); }
+
+} // namespace astro::async
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../../utils.hpp"
+#include "../thread_pool.hpp"
+
+namespace astro::async {
+
+   /**
+    * @brief Background thread that waits on timers and hands the coroutines waiting on them to a thread_pool. Waiting
+    * on file descriptors is not supported on Windows.
+    */
+   class io_waiter {
+      public:
+         inline explicit io_waiter(thread_pool& pool) : _pool(pool) { _thread = std::thread([this] { run(); }); }
+
+         io_waiter(const io_waiter&)            = delete;
+         io_waiter& operator=(const io_waiter&) = delete;
+
+         inline ~io_waiter() {
+            {
+               std::lock_guard<std::mutex> lock(_mutex);
+               _stopping = true;
+            }
+            _cv.notify_one();
+            _thread.join();
+         }
+
+         static inline io_waiter& shared() {
+            // the pool must outlive the waiter that submits to it
+            static thread_pool& pool = thread_pool::shared();
+            static io_waiter    waiter{pool};
+            return waiter;
+         }
+
+         inline void add_timer(detail::co::clock::time_point deadline, std::coroutine_handle<> h) {
+            {
+               std::lock_guard<std::mutex> lock(_mutex);
+               _timers.push({deadline, h});
+            }
+            _cv.notify_one();
+         }
+
+         inline void add_fd(int, io_event, std::coroutine_handle<>) {
+            util::check(false, "io_waiter: waiting on file descriptors is not supported on Windows");
+         }
+
+      private:
+         inline void run() {
+            std::vector<std::coroutine_handle<>> ready;
+            std::unique_lock<std::mutex>         lock(_mutex);
+            while (!_stopping) {
+               if (_timers.empty())
+                  _cv.wait(lock);
+               else
+                  _cv.wait_until(lock, _timers.top().deadline);
+               const auto now = detail::co::clock::now();
+               while (!_timers.empty() && _timers.top().deadline <= now) {
+                  ready.push_back(_timers.top().handle);
+                  _timers.pop();
+               }
+               lock.unlock();
+               for (auto h : ready)
+                  _pool.submit([h] { h.resume(); });
+               ready.clear();
+               lock.lock();
+            }
+         }
+
+         thread_pool&            _pool;
+         std::mutex              _mutex;
+         std::condition_variable _cv;
+         detail::co::timer_heap  _timers;
+         bool                    _stopping = false;
+         std::thread             _thread;
+   };
+
+} // namespace astro::async
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+#include "../../utils.hpp"
+#include "../thread_pool.hpp"
+
+namespace astro::async {
+
+   /**
+    * @brief The epoll reactor has no Windows backend yet, constructing one fails. Use io_wait's timers instead.
+    */
+   class reactor {
+      public:
+         inline explicit reactor(thread_pool* = nullptr, std::size_t = 256, reactor_backend = reactor_backend::automatic) {
+            util::check(false, "reactor: epoll is not available on Windows");
+         }
+
+         reactor(const reactor&)            = delete;
+         reactor& operator=(const reactor&) = delete;
+   };
+
+} // namespace astro::async
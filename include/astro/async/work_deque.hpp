@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "futex.hpp"
+
+namespace astro::async {
+
+   /**
+    * @brief Chase-Lev work-stealing deque (the weak-memory formulation of Lê et al., PPoPP 2013).
+    *
+    * The owning thread pushes and pops at the bottom without contention, any other thread steals from the top. The ring
+    * grows on demand, retired rings are kept until the deque dies because a concurrent thief may still be reading one.
+    * T must be trivially copyable and small enough to be lock-free, in practice a pointer.
+    */
+   template <typename T>
+   class work_deque {
+         static_assert(std::is_trivially_copyable_v<T> && std::atomic<T>::is_always_lock_free);
+
+         struct ring {
+               inline explicit ring(std::int64_t capacity)
+                  : mask(capacity - 1),
+                    slots(new std::atomic<T>[static_cast<std::size_t>(capacity)]) {}
+
+               inline T    get(std::int64_t i) const noexcept { return slots[i & mask].load(std::memory_order_relaxed); }
+               inline void put(std::int64_t i, T v) noexcept { slots[i & mask].store(v, std::memory_order_relaxed); }
+               inline std::int64_t capacity() const noexcept { return mask + 1; }
+
+               std::int64_t                     mask;
+               std::unique_ptr<std::atomic<T>[]> slots;
+         };
+
+      public:
+         inline explicit work_deque(std::size_t capacity = 256) {
+            std::int64_t cap = 2;
+            while (cap < static_cast<std::int64_t>(capacity))
+               cap <<= 1;
+            _rings.push_back(std::make_unique<ring>(cap));
+            _ring.store(_rings.back().get(), std::memory_order_relaxed);
+         }
+
+         work_deque(const work_deque&)            = delete;
+         work_deque& operator=(const work_deque&) = delete;
+
+         /**
+          * @brief Owner only: pushes v at the bottom.
+          */
+         inline void push(T v) {
+            const std::int64_t b = _bottom.load(std::memory_order_relaxed);
+            const std::int64_t t = _top.load(std::memory_order_acquire);
+            ring*              r = _ring.load(std::memory_order_relaxed);
+            if (b - t > r->capacity() - 1)
+               r = grow(r, t, b);
+            r->put(b, v);
+            // a release store rather than the paper's fence plus relaxed store, same cost and visible to tsan
+            _bottom.store(b + 1, std::memory_order_release);
+         }
+
+         /**
+          * @brief Owner only: pops the most recently pushed value, or returns false when the deque is empty.
+          */
+         inline bool pop(T& out) noexcept {
+            const std::int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+            ring*              r = _ring.load(std::memory_order_relaxed);
+            _bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::int64_t t = _top.load(std::memory_order_relaxed);
+            if (t > b) {
+               _bottom.store(b + 1, std::memory_order_relaxed);
+               return false;
+            }
+            out = r->get(b);
+            if (t == b) {
+               // the last element, race the thieves for it
+               const bool won = _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+               _bottom.store(b + 1, std::memory_order_relaxed);
+               return won;
+            }
+            return true;
+         }
+
+         /**
+          * @brief Any thread: takes the oldest value, or returns false when the deque is empty or another thief won.
+          */
+         inline bool steal(T& out) noexcept {
+            std::int64_t t = _top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const std::int64_t b = _bottom.load(std::memory_order_acquire);
+            if (t >= b)
+               return false;
+            // acquire stands in for consume, it pairs with the release store of a grown ring
+            const ring* r = _ring.load(std::memory_order_acquire);
+            const T     v = r->get(t);
+            if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+               return false;
+            out = v;
+            return true;
+         }
+
+         /**
+          * @brief Approximate element count, exact only when called by the owner with no thieves running.
+          */
+         inline std::size_t size() const noexcept {
+            const std::int64_t b = _bottom.load(std::memory_order_relaxed);
+            const std::int64_t t = _top.load(std::memory_order_relaxed);
+            return b > t ? static_cast<std::size_t>(b - t) : 0;
+         }
+
+         inline bool empty() const noexcept { return size() == 0; }
+
+      private:
+         inline ring* grow(ring* old, std::int64_t t, std::int64_t b) {
+            auto next = std::make_unique<ring>(old->capacity() * 2);
+            for (std::int64_t i = t; i < b; ++i)
+               next->put(i, old->get(i));
+            ring* r = next.get();
+            _rings.push_back(std::move(next));
+            _ring.store(r, std::memory_order_release);
+            return r;
+         }
+
+         alignas(cache_line_size) std::atomic<std::int64_t> _top    = 0;
+         alignas(cache_line_size) std::atomic<std::int64_t> _bottom = 0;
+         std::atomic<ring*>                                 _ring   = nullptr;
+         std::vector<std::unique_ptr<ring>>                 _rings;
+   };
+
+} // namespace astro::async
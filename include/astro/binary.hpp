@@ -0,0 +1,6 @@
+#pragma once
+
+#include "binary/base64.hpp"
+#include "binary/base85.hpp"
+#include "binary/codec.hpp"
+#include "binary/hex.hpp"
\ No newline at end of file
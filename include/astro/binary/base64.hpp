@@ -0,0 +1,267 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <array>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__AVX2__)
+   #include <immintrin.h>
+#elif defined(__SSSE3__)
+   #include <tmmintrin.h>
+#endif
+
+#include "codec.hpp"
+
+namespace astro::encode {
+
+   enum class base64_alphabet : std::uint8_t {
+      standard, // RFC 4648 section 4, '+' and '/'
+      url       // RFC 4648 section 5, '-' and '_'
+   };
+
+   namespace detail {
+      constexpr static inline std::string_view base64_standard_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+      constexpr static inline std::string_view base64_url_chars      = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+      constexpr static inline auto base64_standard_table = make_decode_table(base64_standard_chars);
+      constexpr static inline auto base64_url_table      = make_decode_table(base64_url_chars);
+
+#if defined(__SSSE3__)
+      /**
+       * @brief Spreads 12 bytes over the 16 lanes as 6-bit indices (W. Muła's multiply-shift method).
+       */
+      static inline __m128i base64_split(__m128i in) noexcept {
+         in              = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+         const __m128i a = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+         const __m128i b = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+         return _mm_or_si128(a, b);
+      }
+
+      /**
+       * @brief Maps 6-bit indices to characters by adding a per-range offset picked with a shuffle.
+       */
+      static inline __m128i base64_chars_of(__m128i idx, char c62, char c63) noexcept {
+         const __m128i lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                           '0' - 52, '0' - 52, static_cast<char>(c62 - 62), static_cast<char>(c63 - 63), 'A', 0, 0);
+         __m128i       sel  = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+         sel                = _mm_or_si128(sel, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), idx), _mm_set1_epi8(13)));
+         return _mm_add_epi8(_mm_shuffle_epi8(lut, sel), idx);
+      }
+
+      /**
+       * @brief Turns 16 characters into 6-bit values, false if any is outside the alphabet.
+       */
+      static inline bool base64_values_of(__m128i in, char c62, char c63, __m128i& out) noexcept {
+         const auto range = [&](char lo, char hi) {
+            return _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8(lo - 1)), _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), in));
+         };
+         const __m128i upper = range('A', 'Z');
+         const __m128i lower = range('a', 'z');
+         const __m128i digit = range('0', '9');
+         const __m128i e62   = _mm_cmpeq_epi8(in, _mm_set1_epi8(c62));
+         const __m128i e63   = _mm_cmpeq_epi8(in, _mm_set1_epi8(c63));
+         const __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, _mm_or_si128(e62, e63)));
+         if (_mm_movemask_epi8(valid) != 0xFFFF)
+            return false;
+         __m128i shift = _mm_and_si128(upper, _mm_set1_epi8(-65));
+         shift         = _mm_or_si128(shift, _mm_and_si128(lower, _mm_set1_epi8(-71)));
+         shift         = _mm_or_si128(shift, _mm_and_si128(digit, _mm_set1_epi8(4)));
+         shift         = _mm_or_si128(shift, _mm_and_si128(e62, _mm_set1_epi8(static_cast<char>(62 - c62))));
+         shift         = _mm_or_si128(shift, _mm_and_si128(e63, _mm_set1_epi8(static_cast<char>(63 - c63))));
+         out           = _mm_add_epi8(in, shift);
+         return true;
+      }
+
+      /**
+       * @brief Packs 16 6-bit values into 12 bytes at the bottom of the register.
+       */
+      static inline __m128i base64_join(__m128i v) noexcept {
+         v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+         v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+         return _mm_shuffle_epi8(v, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+      }
+#endif
+
+#if defined(__AVX2__)
+      static inline __m256i base64_split(__m256i in) noexcept {
+         in              = _mm256_shuffle_epi8(in, _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                                                    1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+         const __m256i a = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+         const __m256i b = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+         return _mm256_or_si256(a, b);
+      }
+
+      static inline __m256i base64_chars_of(__m256i idx, char c62, char c63) noexcept {
+         const __m256i lut = _mm256_broadcastsi128_si256(
+               _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                             '0' - 52, static_cast<char>(c62 - 62), static_cast<char>(c63 - 63), 'A', 0, 0));
+         __m256i sel = _mm256_subs_epu8(idx, _mm256_set1_epi8(51));
+         sel         = _mm256_or_si256(sel, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), idx), _mm256_set1_epi8(13)));
+         return _mm256_add_epi8(_mm256_shuffle_epi8(lut, sel), idx);
+      }
+
+      static inline bool base64_values_of(__m256i in, char c62, char c63, __m256i& out) noexcept {
+         const auto range = [&](char lo, char hi) {
+            return _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8(lo - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), in));
+         };
+         const __m256i upper = range('A', 'Z');
+         const __m256i lower = range('a', 'z');
+         const __m256i digit = range('0', '9');
+         const __m256i e62   = _mm256_cmpeq_epi8(in, _mm256_set1_epi8(c62));
+         const __m256i e63   = _mm256_cmpeq_epi8(in, _mm256_set1_epi8(c63));
+         const __m256i valid = _mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(digit, _mm256_or_si256(e62, e63)));
+         if (_mm256_movemask_epi8(valid) != -1)
+            return false;
+         __m256i shift = _mm256_and_si256(upper, _mm256_set1_epi8(-65));
+         shift         = _mm256_or_si256(shift, _mm256_and_si256(lower, _mm256_set1_epi8(-71)));
+         shift         = _mm256_or_si256(shift, _mm256_and_si256(digit, _mm256_set1_epi8(4)));
+         shift         = _mm256_or_si256(shift, _mm256_and_si256(e62, _mm256_set1_epi8(static_cast<char>(62 - c62))));
+         shift         = _mm256_or_si256(shift, _mm256_and_si256(e63, _mm256_set1_epi8(static_cast<char>(63 - c63))));
+         out           = _mm256_add_epi8(in, shift);
+         return true;
+      }
+
+      /**
+       * @brief Packs 32 6-bit values into 24 bytes at the bottom of the register.
+       */
+      static inline __m256i base64_join(__m256i v) noexcept {
+         v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+         v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+         v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                                     2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+         return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+      }
+#endif
+   } // namespace detail
+
+   /**
+    * @brief Base64 as in RFC 4648, with SSSE3 / AVX2 kernels for the bulk of the data.
+    *
+    * Decoding is strict: characters outside the alphabet, misplaced padding and non-zero trailing bits all throw.
+    * Padding is optional when decoding.
+    */
+   struct base64 {
+      base64_alphabet alphabet = base64_alphabet::standard;
+      bool            pad      = true;
+
+      constexpr inline std::size_t max_encoded_size(std::size_t n) const noexcept { return (n + 2) / 3 * 4; }
+      constexpr inline std::size_t max_decoded_size(std::size_t n) const noexcept { return (n + 3) / 4 * 3; }
+
+      inline coded encode(std::span<const std::uint8_t> in, char* out, bool last = true) const noexcept {
+         const std::string_view chars = this->chars();
+         const std::uint8_t*    p     = in.data();
+         const std::size_t      n     = in.size();
+         std::size_t            i = 0, o = 0;
+#if defined(__AVX2__)
+         for (; n - i >= 32; i += 24, o += 32) {
+            const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 12));
+            const __m256i v  = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + o), detail::base64_chars_of(detail::base64_split(v), chars[62], chars[63]));
+         }
+#endif
+#if defined(__SSSE3__)
+         for (; n - i >= 16; i += 12, o += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), detail::base64_chars_of(detail::base64_split(v), chars[62], chars[63]));
+         }
+#endif
+         for (; n - i >= 3; i += 3, o += 4) {
+            const std::uint32_t v = (std::uint32_t{p[i]} << 16) | (std::uint32_t{p[i + 1]} << 8) | p[i + 2];
+            out[o]                = chars[v >> 18];
+            out[o + 1]            = chars[(v >> 12) & 63];
+            out[o + 2]            = chars[(v >> 6) & 63];
+            out[o + 3]            = chars[v & 63];
+         }
+         if (!last || i == n)
+            return {i, o};
+
+         const std::uint32_t v = (std::uint32_t{p[i]} << 16) | (n - i == 2 ? std::uint32_t{p[i + 1]} << 8 : 0);
+         out[o++]              = chars[v >> 18];
+         out[o++]              = chars[(v >> 12) & 63];
+         if (n - i == 2)
+            out[o++] = chars[(v >> 6) & 63];
+         else if (pad)
+            out[o++] = '=';
+         if (pad)
+            out[o++] = '=';
+         return {n, o};
+      }
+
+      inline coded decode(std::string_view in, std::uint8_t* out, bool last = true) const {
+         const auto&       table = alphabet == base64_alphabet::url ? detail::base64_url_table : detail::base64_standard_table;
+         const std::size_t end   = last ? in.size() : in.size() / 4 * 4;
+
+         std::size_t pads = 0;
+         if (end != 0 && in[end - 1] == '=')
+            pads = end >= 2 && in[end - 2] == '=' ? 2 : 1;
+         util::check(pads == 0 || end % 4 == 0, "base64: misplaced padding");
+         const std::size_t body = end - pads;
+         const std::size_t full = body / 4 * 4;
+
+         const char*  p = in.data();
+         std::size_t  i = 0, o = 0;
+#if defined(__AVX2__) || defined(__SSSE3__)
+         // the SIMD paths classify the two alphabet-specific characters directly
+         const std::string_view chars = this->chars();
+#endif
+#if defined(__AVX2__)
+         for (; full - i >= 48; i += 32, o += 24) {
+            __m256i v;
+            util::check(detail::base64_values_of(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)), chars[62], chars[63], v),
+                        "base64: invalid character");
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + o), detail::base64_join(v));
+         }
+#endif
+#if defined(__SSSE3__)
+         for (; full - i >= 24; i += 16, o += 12) {
+            __m128i v;
+            util::check(detail::base64_values_of(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)), chars[62], chars[63], v),
+                        "base64: invalid character");
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + o), detail::base64_join(v));
+         }
+#endif
+         const auto digit = [&](std::size_t k) {
+            const std::uint8_t d = table[static_cast<std::uint8_t>(p[k])];
+            util::check(d != detail::invalid_digit, "base64: invalid character");
+            return std::uint32_t{d};
+         };
+         for (; i < full; i += 4, o += 3) {
+            const std::uint32_t v = (digit(i) << 18) | (digit(i + 1) << 12) | (digit(i + 2) << 6) | digit(i + 3);
+            out[o]                = static_cast<std::uint8_t>(v >> 16);
+            out[o + 1]            = static_cast<std::uint8_t>(v >> 8);
+            out[o + 2]            = static_cast<std::uint8_t>(v);
+         }
+
+         const std::size_t tail = body - full;
+         util::check(tail != 1, "base64: truncated input");
+         if (tail != 0) {
+            std::uint32_t v = (digit(i) << 18) | (digit(i + 1) << 12) | (tail == 3 ? digit(i + 2) << 6 : 0);
+            util::check((v & (tail == 3 ? 0xFF : 0xFFFF)) == 0, "base64: non-zero trailing bits");
+            out[o++] = static_cast<std::uint8_t>(v >> 16);
+            if (tail == 3)
+               out[o++] = static_cast<std::uint8_t>(v >> 8);
+         }
+         return {end, o};
+      }
+
+      constexpr inline std::string_view chars() const noexcept {
+         return alphabet == base64_alphabet::url ? detail::base64_url_chars : detail::base64_standard_chars;
+      }
+   };
+
+   static inline std::string to_base64(std::span<const std::uint8_t> in, base64_alphabet alphabet = base64_alphabet::standard) {
+      return encode_all(base64{alphabet, alphabet == base64_alphabet::standard}, in);
+   }
+
+   static inline std::vector<std::uint8_t> from_base64(std::string_view in, base64_alphabet alphabet = base64_alphabet::standard) {
+      return decode_all(base64{alphabet}, in);
+   }
+
+} // namespace astro::encode
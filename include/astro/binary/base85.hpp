@@ -1,7 +1,170 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
 #include "../utils.hpp"
+#include "codec.hpp"
 
 namespace astro::encode {
 
-} // namespace astro::encode
\ No newline at end of file
+   namespace detail {
+      constexpr static inline std::string_view z85_chars =
+            "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ.-:+=^!/*?&<>()[]{}@%$#";
+
+      constexpr static inline auto z85_table = make_decode_table(z85_chars);
+
+      constexpr static inline std::array<std::uint8_t, 256> make_ascii85_table() {
+         std::array<std::uint8_t, 256> t{};
+         t.fill(invalid_digit);
+         for (std::size_t i = 0; i < 85; ++i)
+            t['!' + i] = static_cast<std::uint8_t>(i);
+         return t;
+      }
+
+      constexpr static inline auto ascii85_table = make_ascii85_table();
+
+      constexpr static inline std::uint32_t load_be32(const std::uint8_t* p) noexcept {
+         return (std::uint32_t{p[0]} << 24) | (std::uint32_t{p[1]} << 16) | (std::uint32_t{p[2]} << 8) | p[3];
+      }
+
+      constexpr static inline void store_be32(std::uint8_t* p, std::uint32_t v) noexcept {
+         p[0] = static_cast<std::uint8_t>(v >> 24);
+         p[1] = static_cast<std::uint8_t>(v >> 16);
+         p[2] = static_cast<std::uint8_t>(v >> 8);
+         p[3] = static_cast<std::uint8_t>(v);
+      }
+
+      /**
+       * @brief Writes the five base 85 digits of v, most significant first, through the digit alphabet.
+       */
+      template <typename Digit>
+      constexpr static inline void base85_digits(std::uint32_t v, char* out, Digit&& digit) noexcept {
+         // the divisions by the constant 85 compile to multiply-shifts
+         for (int k = 4; k >= 0; --k) {
+            out[k] = digit(v % 85);
+            v     /= 85;
+         }
+      }
+
+      /**
+       * @brief Reads five digits back into a 32-bit group, throwing on bad digits or overflow.
+       */
+      static inline std::uint32_t base85_group(const char* in, const std::array<std::uint8_t, 256>& table, const char* what) {
+         std::uint64_t v = 0;
+         for (int k = 0; k < 5; ++k) {
+            const std::uint8_t d = table[static_cast<std::uint8_t>(in[k])];
+            util::check(d != invalid_digit, what);
+            v = v * 85 + d;
+         }
+         util::check(v <= UINT32_MAX, what);
+         return static_cast<std::uint32_t>(v);
+      }
+   } // namespace detail
+
+   /**
+    * @brief ZeroMQ's Z85 (RFC 32), four bytes to five printable characters. Inputs must be a multiple of four bytes.
+    */
+   struct z85 {
+      constexpr inline std::size_t max_encoded_size(std::size_t n) const noexcept { return n / 4 * 5; }
+      constexpr inline std::size_t max_decoded_size(std::size_t n) const noexcept { return n / 5 * 4; }
+
+      inline coded encode(std::span<const std::uint8_t> in, char* out, bool last = true) const {
+         util::check(!last || in.size() % 4 == 0, "z85: size must be a multiple of 4");
+         const std::size_t n = in.size() / 4;
+         for (std::size_t g = 0; g < n; ++g)
+            detail::base85_digits(detail::load_be32(in.data() + 4 * g), out + 5 * g, [](std::uint32_t d) { return detail::z85_chars[d]; });
+         return {4 * n, 5 * n};
+      }
+
+      inline coded decode(std::string_view in, std::uint8_t* out, bool last = true) const {
+         util::check(!last || in.size() % 5 == 0, "z85: size must be a multiple of 5");
+         const std::size_t n = in.size() / 5;
+         for (std::size_t g = 0; g < n; ++g)
+            detail::store_be32(out + 4 * g, detail::base85_group(in.data() + 5 * g, detail::z85_table, "z85: invalid input"));
+         return {5 * n, 4 * n};
+      }
+   };
+
+   /**
+    * @brief Adobe's Ascii85 without the <~ ~> delimiters: 'z' abbreviates a zero group and a short final group is allowed.
+    */
+   struct ascii85 {
+      constexpr inline std::size_t max_encoded_size(std::size_t n) const noexcept { return (n + 3) / 4 * 5; }
+      constexpr inline std::size_t max_decoded_size(std::size_t n) const noexcept { return n * 4; }
+
+      inline coded encode(std::span<const std::uint8_t> in, char* out, bool last = true) const noexcept {
+         const auto        digit = [](std::uint32_t d) { return static_cast<char>('!' + d); };
+         const std::size_t full  = in.size() / 4 * 4;
+         std::size_t       i = 0, o = 0;
+         for (; i < full; i += 4) {
+            const std::uint32_t v = detail::load_be32(in.data() + i);
+            if (v == 0) {
+               out[o++] = 'z';
+            } else {
+               detail::base85_digits(v, out + o, digit);
+               o += 5;
+            }
+         }
+         if (!last || i == in.size())
+            return {i, o};
+
+         // a short group is zero padded, encoded, and cut to one more digit than it has bytes
+         std::uint8_t      tail[4] = {};
+         const std::size_t k       = in.size() - i;
+         for (std::size_t j = 0; j < k; ++j)
+            tail[j] = in[i + j];
+         char digits[5];
+         detail::base85_digits(detail::load_be32(tail), digits, digit);
+         for (std::size_t j = 0; j <= k; ++j)
+            out[o++] = digits[j];
+         return {in.size(), o};
+      }
+
+      inline coded decode(std::string_view in, std::uint8_t* out, bool last = true) const {
+         std::size_t i = 0, o = 0;
+         while (i < in.size()) {
+            if (in[i] == 'z') {
+               detail::store_be32(out + o, 0);
+               ++i;
+               o += 4;
+               continue;
+            }
+            if (in.size() - i < 5)
+               break;
+            detail::store_be32(out + o, detail::base85_group(in.data() + i, detail::ascii85_table, "ascii85: invalid input"));
+            i += 5;
+            o += 4;
+         }
+         if (!last || i == in.size())
+            return {i, o};
+
+         // a short final group is padded with the highest digit, 'u'
+         const std::size_t k = in.size() - i;
+         util::check(k >= 2, "ascii85: truncated input");
+         char group[5] = {'u', 'u', 'u', 'u', 'u'};
+         for (std::size_t j = 0; j < k; ++j)
+            group[j] = in[i + j];
+         std::uint8_t bytes[4];
+         detail::store_be32(bytes, detail::base85_group(group, detail::ascii85_table, "ascii85: invalid input"));
+         for (std::size_t j = 0; j + 1 < k; ++j)
+            out[o++] = bytes[j];
+         return {in.size(), o};
+      }
+   };
+
+   static inline std::string to_z85(std::span<const std::uint8_t> in) { return encode_all(z85{}, in); }
+
+   static inline std::vector<std::uint8_t> from_z85(std::string_view in) { return decode_all(z85{}, in); }
+
+   static inline std::string to_ascii85(std::span<const std::uint8_t> in) { return encode_all(ascii85{}, in); }
+
+   static inline std::vector<std::uint8_t> from_ascii85(std::string_view in) { return decode_all(ascii85{}, in); }
+
+} // namespace astro::encode
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <concepts>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../utils/misc.hpp"
+
+namespace astro::encode {
+
+   namespace detail {
+      constexpr static inline std::uint8_t invalid_digit = 0xFF;
+
+      /**
+       * @brief A character to digit table for an alphabet, invalid_digit for everything outside it.
+       */
+      constexpr static inline std::array<std::uint8_t, 256> make_decode_table(std::string_view chars) {
+         std::array<std::uint8_t, 256> t{};
+         t.fill(invalid_digit);
+         for (std::size_t i = 0; i < chars.size(); ++i)
+            t[static_cast<std::uint8_t>(chars[i])] = static_cast<std::uint8_t>(i);
+         return t;
+      }
+   } // namespace detail
+
+   /**
+    * @brief How much of the input a codec call consumed and how much output it produced.
+    */
+   struct coded {
+      std::size_t read    = 0;
+      std::size_t written = 0;
+   };
+
+   /**
+    * @brief A binary-to-text codec: encode/decode consume whole groups, plus the tail when last is set.
+    *
+    * Output buffers need max_encoded_size / max_decoded_size of the input size. Decoding throws on any invalid input.
+    */
+   template <typename C>
+   concept codec_type = requires(const C& c, std::span<const std::uint8_t> raw, std::string_view text, char* co, std::uint8_t* bo) {
+      { c.max_encoded_size(std::size_t{}) } -> std::same_as<std::size_t>;
+      { c.max_decoded_size(std::size_t{}) } -> std::same_as<std::size_t>;
+      { c.encode(raw, co, true) } -> std::same_as<coded>;
+      { c.decode(text, bo, true) } -> std::same_as<coded>;
+   };
+
+   template <codec_type C>
+   static inline std::string encode_all(const C& c, std::span<const std::uint8_t> in) {
+      std::string out(c.max_encoded_size(in.size()), '\0');
+      out.resize(c.encode(in, out.data(), true).written);
+      return out;
+   }
+
+   template <codec_type C>
+   static inline std::vector<std::uint8_t> decode_all(const C& c, std::string_view in) {
+      std::vector<std::uint8_t> out(c.max_decoded_size(in.size()));
+      out.resize(c.decode(in, out.data(), true).written);
+      return out;
+   }
+
+   /**
+    * @brief Encodes data arriving in pieces, holding back the bytes of a partial group until more arrive or finish().
+    */
+   template <codec_type C>
+   class stream_encoder {
+      public:
+         explicit stream_encoder(C codec = {})
+            : _codec(codec) {}
+
+         inline void update(std::span<const std::uint8_t> in, std::string& out) {
+            _pending.insert(_pending.end(), in.begin(), in.end());
+            run(out, false);
+         }
+
+         inline void finish(std::string& out) { run(out, true); }
+
+      private:
+         inline void run(std::string& out, bool last) {
+            const std::size_t at = out.size();
+            out.resize(at + _codec.max_encoded_size(_pending.size()));
+            const coded r = _codec.encode(_pending, out.data() + at, last);
+            out.resize(at + r.written);
+            _pending.erase(_pending.begin(), _pending.begin() + r.read);
+         }
+
+         C                         _codec;
+         std::vector<std::uint8_t> _pending;
+   };
+
+   /**
+    * @brief Decodes text arriving in pieces, the counterpart of stream_encoder.
+    */
+   template <codec_type C>
+   class stream_decoder {
+      public:
+         explicit stream_decoder(C codec = {})
+            : _codec(codec) {}
+
+         inline void update(std::string_view in, std::vector<std::uint8_t>& out) {
+            _pending.append(in);
+            run(out, false);
+         }
+
+         inline void finish(std::vector<std::uint8_t>& out) { run(out, true); }
+
+      private:
+         inline void run(std::vector<std::uint8_t>& out, bool last) {
+            const std::size_t at = out.size();
+            out.resize(at + _codec.max_decoded_size(_pending.size()));
+            const coded r = _codec.decode(_pending, out.data() + at, last);
+            out.resize(at + r.written);
+            _pending.erase(0, r.read);
+         }
+
+         C           _codec;
+         std::string _pending;
+   };
+
+} // namespace astro::encode
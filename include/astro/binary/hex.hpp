@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__AVX2__)
+   #include <immintrin.h>
+#elif defined(__SSSE3__)
+   #include <tmmintrin.h>
+#endif
+
+#include "codec.hpp"
+
+namespace astro::encode {
+
+   namespace detail {
+      constexpr static inline std::string_view hex_lower_chars = "0123456789abcdef";
+      constexpr static inline std::string_view hex_upper_chars = "0123456789ABCDEF";
+
+      constexpr static inline std::uint8_t hex_value(char c) noexcept {
+         if (c >= '0' && c <= '9')
+            return static_cast<std::uint8_t>(c - '0');
+         c = static_cast<char>(c | 0x20);
+         if (c >= 'a' && c <= 'f')
+            return static_cast<std::uint8_t>(c - 'a' + 10);
+         return 0xFF;
+      }
+
+#if defined(__SSSE3__)
+      /**
+       * @brief Turns 16 hex digits of either case into nibble values, false if any is not a hex digit.
+       */
+      static inline bool hex_values_of(__m128i in, __m128i& out) noexcept {
+         const __m128i folded = _mm_or_si128(in, _mm_set1_epi8(0x20));
+         const __m128i digit  = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('0' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), in));
+         const __m128i alpha  = _mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('f' + 1), folded));
+         if (_mm_movemask_epi8(_mm_or_si128(digit, alpha)) != 0xFFFF)
+            return false;
+         out = _mm_or_si128(_mm_and_si128(digit, _mm_sub_epi8(in, _mm_set1_epi8('0'))),
+                            _mm_and_si128(alpha, _mm_sub_epi8(folded, _mm_set1_epi8('a' - 10))));
+         return true;
+      }
+#endif
+
+#if defined(__AVX2__)
+      static inline bool hex_values_of(__m256i in, __m256i& out) noexcept {
+         const __m256i folded = _mm256_or_si256(in, _mm256_set1_epi8(0x20));
+         const __m256i digit  = _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), in));
+         const __m256i alpha  = _mm256_and_si256(_mm256_cmpgt_epi8(folded, _mm256_set1_epi8('a' - 1)),
+                                                 _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), folded));
+         if (_mm256_movemask_epi8(_mm256_or_si256(digit, alpha)) != -1)
+            return false;
+         out = _mm256_or_si256(_mm256_and_si256(digit, _mm256_sub_epi8(in, _mm256_set1_epi8('0'))),
+                               _mm256_and_si256(alpha, _mm256_sub_epi8(folded, _mm256_set1_epi8('a' - 10))));
+         return true;
+      }
+#endif
+   } // namespace detail
+
+   /**
+    * @brief Base16, two digits per byte, high nibble first. Either case is accepted when decoding.
+    */
+   struct hex {
+      bool upper = false;
+
+      constexpr inline std::size_t max_encoded_size(std::size_t n) const noexcept { return n * 2; }
+      constexpr inline std::size_t max_decoded_size(std::size_t n) const noexcept { return n / 2; }
+
+      inline coded encode(std::span<const std::uint8_t> in, char* out, bool = true) const noexcept {
+         const std::string_view chars = upper ? detail::hex_upper_chars : detail::hex_lower_chars;
+         const std::uint8_t*    p     = in.data();
+         const std::size_t      n     = in.size();
+         std::size_t            i     = 0;
+#if defined(__AVX2__)
+         const __m256i lut256 = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(chars.data())));
+         for (; n - i >= 32; i += 32) {
+            const __m256i v  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+            const __m256i hi = _mm256_shuffle_epi8(lut256, _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F)));
+            const __m256i lo = _mm256_shuffle_epi8(lut256, _mm256_and_si256(v, _mm256_set1_epi8(0x0F)));
+            // the unpacks work per 128-bit lane, so the halves are put back in order afterwards
+            const __m256i a = _mm256_unpacklo_epi8(hi, lo);
+            const __m256i b = _mm256_unpackhi_epi8(hi, lo);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i), _mm256_permute2x128_si256(a, b, 0x20));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 2 * i + 32), _mm256_permute2x128_si256(a, b, 0x31));
+         }
+#endif
+#if defined(__SSSE3__)
+         const __m128i lut = _mm_loadu_si128(reinterpret_cast<const __m128i*>(chars.data()));
+         for (; n - i >= 16; i += 16) {
+            const __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            const __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F)));
+            const __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(v, _mm_set1_epi8(0x0F)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+         }
+#endif
+         for (; i < n; ++i) {
+            out[2 * i]     = chars[p[i] >> 4];
+            out[2 * i + 1] = chars[p[i] & 0x0F];
+         }
+         return {n, 2 * n};
+      }
+
+      inline coded decode(std::string_view in, std::uint8_t* out, bool last = true) const {
+         util::check(!last || in.size() % 2 == 0, "hex: odd number of digits");
+         const char*       p = in.data();
+         const std::size_t n = in.size() / 2;
+         std::size_t       i = 0;
+#if defined(__AVX2__)
+         for (; n - i >= 32; i += 32) {
+            __m256i a, b;
+            util::check(detail::hex_values_of(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 2 * i)), a) &&
+                        detail::hex_values_of(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 2 * i + 32)), b),
+                        "hex: invalid digit");
+            // pairs of nibbles become 16-bit high * 16 + low, then pack to bytes and undo the per-lane interleave
+            a = _mm256_maddubs_epi16(a, _mm256_set1_epi16(0x0110));
+            b = _mm256_maddubs_epi16(b, _mm256_set1_epi16(0x0110));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+         }
+#endif
+#if defined(__SSSE3__)
+         for (; n - i >= 16; i += 16) {
+            __m128i a, b;
+            util::check(detail::hex_values_of(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 2 * i)), a) &&
+                        detail::hex_values_of(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 2 * i + 16)), b),
+                        "hex: invalid digit");
+            a = _mm_maddubs_epi16(a, _mm_set1_epi16(0x0110));
+            b = _mm_maddubs_epi16(b, _mm_set1_epi16(0x0110));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(a, b));
+         }
+#endif
+         for (; i < n; ++i) {
+            const std::uint8_t hi = detail::hex_value(p[2 * i]);
+            const std::uint8_t lo = detail::hex_value(p[2 * i + 1]);
+            util::check(hi < 16 && lo < 16, "hex: invalid digit");
+            out[i] = static_cast<std::uint8_t>(hi << 4 | lo);
+         }
+         return {2 * n, n};
+      }
+   };
+
+   static inline std::string to_hex(std::span<const std::uint8_t> in, bool upper = false) { return encode_all(hex{upper}, in); }
+
+   static inline std::vector<std::uint8_t> from_hex(std::string_view in) { return decode_all(hex{}, in); }
+
+} // namespace astro::encode
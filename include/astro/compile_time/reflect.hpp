@@ -1,7 +1,14 @@
 #pragma once
 
+#include <cstdint>
+
+#include <array>
+#include <string_view>
+#include <tuple>
+
 #include "string.hpp"
 #include "meta.hpp"
+#include "preprocess.hpp"
 
 namespace astro::ct {
    struct none_t {};
@@ -61,5 +68,16 @@ namespace astro::ct {
       constexpr inline auto reflected_addrs() noexcept {                     \
          return std::array{ASTRO_FOREACH(ASTRO_REF, "ignore", __VA_ARGS__)}; \
       }                                                                      \
+      constexpr inline auto reflected_tie() noexcept {                       \
+         return std::tie(__VA_ARGS__);                                       \
+      }                                                                      \
+      constexpr inline auto reflected_tie() const noexcept {                 \
+         return std::tie(__VA_ARGS__);                                       \
+      }                                                                      \
       using reflected_member_types = std::tuple<ASTRO_FOREACH(ASTRO_DECL, "ignore", __VA_ARGS__)>;
 
+#define ASTRO_REFL_TAGS(...)                                                 \
+   public:                                                                   \
+      constexpr static inline auto reflected_tags() noexcept {               \
+         return std::to_array<std::uint32_t>({__VA_ARGS__});                 \
+      }
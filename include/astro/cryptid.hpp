@@ -1,3 +1,10 @@
 #pragma once
 
+#include "cryptid/blake3.hpp"
+#include "cryptid/bloom_filter.hpp"
+#include "cryptid/city_hash.hpp"
+#include "cryptid/consistent_hash.hpp"
+#include "cryptid/count_min.hpp"
+#include "cryptid/cuckoo_filter.hpp"
+#include "cryptid/hyperloglog.hpp"
 #include "cryptid/uint128.hpp"
\ No newline at end of file
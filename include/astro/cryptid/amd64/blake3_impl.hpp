@@ -0,0 +1,253 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace astro::cryptid::detail::b3 {
+#if defined(__SSE4_1__)
+   #define ASTRO_BLAKE3_SSE41 1
+
+   struct sse41_lanes {
+      using vec_t = __m128i;
+      constexpr static inline std::size_t width = 4;
+
+      static inline vec_t add(vec_t a, vec_t b) noexcept { return _mm_add_epi32(a, b); }
+      static inline vec_t xor_(vec_t a, vec_t b) noexcept { return _mm_xor_si128(a, b); }
+      static inline vec_t set1(std::uint32_t x) noexcept { return _mm_set1_epi32(static_cast<std::int32_t>(x)); }
+      static inline vec_t load(const std::uint32_t* p) noexcept { return _mm_loadu_si128(reinterpret_cast<const vec_t*>(p)); }
+      static inline vec_t loadu(const std::uint8_t* p) noexcept { return _mm_loadu_si128(reinterpret_cast<const vec_t*>(p)); }
+      static inline void storeu(vec_t v, std::uint8_t* p) noexcept { _mm_storeu_si128(reinterpret_cast<vec_t*>(p), v); }
+
+      static inline vec_t rot16(vec_t x) noexcept {
+         return _mm_shuffle_epi8(x, _mm_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2));
+      }
+      static inline vec_t rot12(vec_t x) noexcept { return _mm_or_si128(_mm_srli_epi32(x, 12), _mm_slli_epi32(x, 20)); }
+      static inline vec_t rot8(vec_t x) noexcept {
+         return _mm_shuffle_epi8(x, _mm_set_epi8(12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1));
+      }
+      static inline vec_t rot7(vec_t x) noexcept { return _mm_or_si128(_mm_srli_epi32(x, 7), _mm_slli_epi32(x, 25)); }
+
+      static inline void transpose(vec_t v[4]) noexcept {
+         vec_t ab_01 = _mm_unpacklo_epi32(v[0], v[1]);
+         vec_t ab_23 = _mm_unpackhi_epi32(v[0], v[1]);
+         vec_t cd_01 = _mm_unpacklo_epi32(v[2], v[3]);
+         vec_t cd_23 = _mm_unpackhi_epi32(v[2], v[3]);
+         v[0] = _mm_unpacklo_epi64(ab_01, cd_01);
+         v[1] = _mm_unpackhi_epi64(ab_01, cd_01);
+         v[2] = _mm_unpacklo_epi64(ab_23, cd_23);
+         v[3] = _mm_unpackhi_epi64(ab_23, cd_23);
+      }
+
+      static inline void load_msg(const std::uint8_t* const* inputs, std::size_t off, vec_t m[16]) noexcept {
+         for (std::size_t q = 0; q < 4; ++q)
+            for (std::size_t lane = 0; lane < width; ++lane)
+               m[q*4 + lane] = loadu(inputs[lane] + off + q*16);
+         for (std::size_t q = 0; q < 4; ++q)
+            transpose(m + q*4);
+      }
+
+      static inline void store_cvs(vec_t h[8], std::uint8_t* out) noexcept {
+         transpose(h);
+         transpose(h + 4);
+         for (std::size_t lane = 0; lane < width; ++lane) {
+            storeu(h[lane],     out + lane*32);
+            storeu(h[lane + 4], out + lane*32 + 16);
+         }
+      }
+   };
+#endif
+
+#if defined(__AVX2__)
+   #define ASTRO_BLAKE3_AVX2 1
+
+   struct avx2_lanes {
+      using vec_t = __m256i;
+      constexpr static inline std::size_t width = 8;
+
+      static inline vec_t add(vec_t a, vec_t b) noexcept { return _mm256_add_epi32(a, b); }
+      static inline vec_t xor_(vec_t a, vec_t b) noexcept { return _mm256_xor_si256(a, b); }
+      static inline vec_t set1(std::uint32_t x) noexcept { return _mm256_set1_epi32(static_cast<std::int32_t>(x)); }
+      static inline vec_t load(const std::uint32_t* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const vec_t*>(p)); }
+      static inline vec_t loadu(const std::uint8_t* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const vec_t*>(p)); }
+      static inline void storeu(vec_t v, std::uint8_t* p) noexcept { _mm256_storeu_si256(reinterpret_cast<vec_t*>(p), v); }
+
+      static inline vec_t rot16(vec_t x) noexcept {
+         return _mm256_shuffle_epi8(x, _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+                                                       13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2));
+      }
+      static inline vec_t rot12(vec_t x) noexcept { return _mm256_or_si256(_mm256_srli_epi32(x, 12), _mm256_slli_epi32(x, 20)); }
+      static inline vec_t rot8(vec_t x) noexcept {
+         return _mm256_shuffle_epi8(x, _mm256_set_epi8(12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1,
+                                                       12, 15, 14, 13, 8, 11, 10, 9, 4, 7, 6, 5, 0, 3, 2, 1));
+      }
+      static inline vec_t rot7(vec_t x) noexcept { return _mm256_or_si256(_mm256_srli_epi32(x, 7), _mm256_slli_epi32(x, 25)); }
+
+      static inline void transpose(vec_t v[8]) noexcept {
+         vec_t ab_0145 = _mm256_unpacklo_epi32(v[0], v[1]);
+         vec_t ab_2367 = _mm256_unpackhi_epi32(v[0], v[1]);
+         vec_t cd_0145 = _mm256_unpacklo_epi32(v[2], v[3]);
+         vec_t cd_2367 = _mm256_unpackhi_epi32(v[2], v[3]);
+         vec_t ef_0145 = _mm256_unpacklo_epi32(v[4], v[5]);
+         vec_t ef_2367 = _mm256_unpackhi_epi32(v[4], v[5]);
+         vec_t gh_0145 = _mm256_unpacklo_epi32(v[6], v[7]);
+         vec_t gh_2367 = _mm256_unpackhi_epi32(v[6], v[7]);
+
+         vec_t abcd_04 = _mm256_unpacklo_epi64(ab_0145, cd_0145);
+         vec_t abcd_15 = _mm256_unpackhi_epi64(ab_0145, cd_0145);
+         vec_t abcd_26 = _mm256_unpacklo_epi64(ab_2367, cd_2367);
+         vec_t abcd_37 = _mm256_unpackhi_epi64(ab_2367, cd_2367);
+         vec_t efgh_04 = _mm256_unpacklo_epi64(ef_0145, gh_0145);
+         vec_t efgh_15 = _mm256_unpackhi_epi64(ef_0145, gh_0145);
+         vec_t efgh_26 = _mm256_unpacklo_epi64(ef_2367, gh_2367);
+         vec_t efgh_37 = _mm256_unpackhi_epi64(ef_2367, gh_2367);
+
+         v[0] = _mm256_permute2x128_si256(abcd_04, efgh_04, 0x20);
+         v[1] = _mm256_permute2x128_si256(abcd_15, efgh_15, 0x20);
+         v[2] = _mm256_permute2x128_si256(abcd_26, efgh_26, 0x20);
+         v[3] = _mm256_permute2x128_si256(abcd_37, efgh_37, 0x20);
+         v[4] = _mm256_permute2x128_si256(abcd_04, efgh_04, 0x31);
+         v[5] = _mm256_permute2x128_si256(abcd_15, efgh_15, 0x31);
+         v[6] = _mm256_permute2x128_si256(abcd_26, efgh_26, 0x31);
+         v[7] = _mm256_permute2x128_si256(abcd_37, efgh_37, 0x31);
+      }
+
+      static inline void load_msg(const std::uint8_t* const* inputs, std::size_t off, vec_t m[16]) noexcept {
+         for (std::size_t lane = 0; lane < width; ++lane) {
+            m[lane]     = loadu(inputs[lane] + off);
+            m[lane + 8] = loadu(inputs[lane] + off + 32);
+         }
+         transpose(m);
+         transpose(m + 8);
+      }
+
+      static inline void store_cvs(vec_t h[8], std::uint8_t* out) noexcept {
+         transpose(h);
+         for (std::size_t lane = 0; lane < width; ++lane)
+            storeu(h[lane], out + lane*32);
+      }
+   };
+#endif
+
+   template <typename L>
+   static inline void round_lanes(typename L::vec_t v[16], const typename L::vec_t m[16], std::size_t r) noexcept {
+      const auto& sc = msg_schedule[r];
+      // columns
+      v[0] = L::add(L::add(v[0], m[sc[0]]), v[4]);
+      v[1] = L::add(L::add(v[1], m[sc[2]]), v[5]);
+      v[2] = L::add(L::add(v[2], m[sc[4]]), v[6]);
+      v[3] = L::add(L::add(v[3], m[sc[6]]), v[7]);
+      v[12] = L::rot16(L::xor_(v[12], v[0]));
+      v[13] = L::rot16(L::xor_(v[13], v[1]));
+      v[14] = L::rot16(L::xor_(v[14], v[2]));
+      v[15] = L::rot16(L::xor_(v[15], v[3]));
+      v[8]  = L::add(v[8],  v[12]);
+      v[9]  = L::add(v[9],  v[13]);
+      v[10] = L::add(v[10], v[14]);
+      v[11] = L::add(v[11], v[15]);
+      v[4] = L::rot12(L::xor_(v[4], v[8]));
+      v[5] = L::rot12(L::xor_(v[5], v[9]));
+      v[6] = L::rot12(L::xor_(v[6], v[10]));
+      v[7] = L::rot12(L::xor_(v[7], v[11]));
+      v[0] = L::add(L::add(v[0], m[sc[1]]), v[4]);
+      v[1] = L::add(L::add(v[1], m[sc[3]]), v[5]);
+      v[2] = L::add(L::add(v[2], m[sc[5]]), v[6]);
+      v[3] = L::add(L::add(v[3], m[sc[7]]), v[7]);
+      v[12] = L::rot8(L::xor_(v[12], v[0]));
+      v[13] = L::rot8(L::xor_(v[13], v[1]));
+      v[14] = L::rot8(L::xor_(v[14], v[2]));
+      v[15] = L::rot8(L::xor_(v[15], v[3]));
+      v[8]  = L::add(v[8],  v[12]);
+      v[9]  = L::add(v[9],  v[13]);
+      v[10] = L::add(v[10], v[14]);
+      v[11] = L::add(v[11], v[15]);
+      v[4] = L::rot7(L::xor_(v[4], v[8]));
+      v[5] = L::rot7(L::xor_(v[5], v[9]));
+      v[6] = L::rot7(L::xor_(v[6], v[10]));
+      v[7] = L::rot7(L::xor_(v[7], v[11]));
+
+      // diagonals
+      v[0] = L::add(L::add(v[0], m[sc[8]]),  v[5]);
+      v[1] = L::add(L::add(v[1], m[sc[10]]), v[6]);
+      v[2] = L::add(L::add(v[2], m[sc[12]]), v[7]);
+      v[3] = L::add(L::add(v[3], m[sc[14]]), v[4]);
+      v[15] = L::rot16(L::xor_(v[15], v[0]));
+      v[12] = L::rot16(L::xor_(v[12], v[1]));
+      v[13] = L::rot16(L::xor_(v[13], v[2]));
+      v[14] = L::rot16(L::xor_(v[14], v[3]));
+      v[10] = L::add(v[10], v[15]);
+      v[11] = L::add(v[11], v[12]);
+      v[8]  = L::add(v[8],  v[13]);
+      v[9]  = L::add(v[9],  v[14]);
+      v[5] = L::rot12(L::xor_(v[5], v[10]));
+      v[6] = L::rot12(L::xor_(v[6], v[11]));
+      v[7] = L::rot12(L::xor_(v[7], v[8]));
+      v[4] = L::rot12(L::xor_(v[4], v[9]));
+      v[0] = L::add(L::add(v[0], m[sc[9]]),  v[5]);
+      v[1] = L::add(L::add(v[1], m[sc[11]]), v[6]);
+      v[2] = L::add(L::add(v[2], m[sc[13]]), v[7]);
+      v[3] = L::add(L::add(v[3], m[sc[15]]), v[4]);
+      v[15] = L::rot8(L::xor_(v[15], v[0]));
+      v[12] = L::rot8(L::xor_(v[12], v[1]));
+      v[13] = L::rot8(L::xor_(v[13], v[2]));
+      v[14] = L::rot8(L::xor_(v[14], v[3]));
+      v[10] = L::add(v[10], v[15]);
+      v[11] = L::add(v[11], v[12]);
+      v[8]  = L::add(v[8],  v[13]);
+      v[9]  = L::add(v[9],  v[14]);
+      v[5] = L::rot7(L::xor_(v[5], v[10]));
+      v[6] = L::rot7(L::xor_(v[6], v[11]));
+      v[7] = L::rot7(L::xor_(v[7], v[8]));
+      v[4] = L::rot7(L::xor_(v[4], v[9]));
+   }
+
+   /**
+    * @brief Compresses `L::width` inputs of `blocks` blocks each in lock step, one input per vector lane.
+    */
+   template <typename L>
+   static inline void hash_lanes(const std::uint8_t* const* inputs, std::size_t blocks, const std::uint32_t key[8], std::uint64_t counter,
+                                 bool increment_counter, std::uint8_t flags, std::uint8_t flags_start, std::uint8_t flags_end,
+                                 std::uint8_t* out) noexcept {
+      using vec_t = typename L::vec_t;
+
+      vec_t h[8];
+      for (std::size_t i = 0; i < 8; ++i)
+         h[i] = L::set1(key[i]);
+
+      alignas(32) std::uint32_t lo[L::width];
+      alignas(32) std::uint32_t hi[L::width];
+      for (std::size_t lane = 0; lane < L::width; ++lane) {
+         std::uint64_t c = counter + (increment_counter ? lane : 0);
+         lo[lane] = static_cast<std::uint32_t>(c);
+         hi[lane] = static_cast<std::uint32_t>(c >> 32);
+      }
+      const vec_t counter_lo = L::load(lo);
+      const vec_t counter_hi = L::load(hi);
+
+      std::uint8_t block_flags = flags | flags_start;
+      for (std::size_t block = 0; block < blocks; ++block) {
+         if (block + 1 == blocks)
+            block_flags |= flags_end;
+
+         vec_t m[16];
+         L::load_msg(inputs, block * block_len, m);
+
+         vec_t v[16] = {
+            h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+            L::set1(iv[0]), L::set1(iv[1]), L::set1(iv[2]), L::set1(iv[3]),
+            counter_lo, counter_hi, L::set1(static_cast<std::uint32_t>(block_len)), L::set1(block_flags)
+         };
+
+         for (std::size_t r = 0; r < 7; ++r)
+            round_lanes<L>(v, m, r);
+
+         for (std::size_t i = 0; i < 8; ++i)
+            h[i] = L::xor_(v[i], v[i+8]);
+
+         block_flags = flags;
+      }
+
+      L::store_cvs(h, out);
+   }
+} // namespace astro::cryptid::detail::b3
@@ -0,0 +1,647 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <span>
+#include <string_view>
+#include <thread>
+
+#include "../async/thread_pool.hpp"
+#include "../info/build_info.hpp"
+
+namespace astro::cryptid::detail::b3 {
+   constexpr static inline std::size_t out_len   = 32;
+   constexpr static inline std::size_t key_len   = 32;
+   constexpr static inline std::size_t block_len = 64;
+   constexpr static inline std::size_t chunk_len = 1024;
+   constexpr static inline std::size_t max_depth = 54;
+
+   enum flag : std::uint8_t {
+      chunk_start         = 1 << 0,
+      chunk_end           = 1 << 1,
+      parent              = 1 << 2,
+      root                = 1 << 3,
+      keyed_hash          = 1 << 4,
+      derive_key_context  = 1 << 5,
+      derive_key_material = 1 << 6
+   };
+
+   constexpr static inline std::array<std::uint32_t, 8> iv = {
+      0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+   };
+
+   constexpr static inline std::array<std::uint8_t, 16> msg_permutation = {
+      2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8
+   };
+
+   consteval static inline auto make_msg_schedule() noexcept {
+      std::array<std::array<std::uint8_t, 16>, 7> sched = {};
+      for (std::uint8_t i = 0; i < 16; ++i)
+         sched[0][i] = i;
+      for (std::size_t r = 1; r < sched.size(); ++r)
+         for (std::size_t i = 0; i < 16; ++i)
+            sched[r][i] = sched[r-1][msg_permutation[i]];
+      return sched;
+   }
+
+   /**
+    * @brief The message word schedule for each of the seven rounds, derived from the permutation.
+    */
+   constexpr static inline auto msg_schedule = make_msg_schedule();
+} // namespace astro::cryptid::detail::b3
+
+#if ASTRO_ARCH == ASTRO_AMD64_ARCH && (defined(__AVX2__) || defined(__SSE4_1__))
+   #include "amd64/blake3_impl.hpp"
+#endif
+
+namespace astro::cryptid::detail::b3 {
+   #if defined(ASTRO_BLAKE3_AVX2)
+      constexpr static inline std::size_t simd_degree = 8;
+   #elif defined(ASTRO_BLAKE3_SSE41)
+      constexpr static inline std::size_t simd_degree = 4;
+   #else
+      constexpr static inline std::size_t simd_degree = 1;
+   #endif
+
+   constexpr static inline std::size_t simd_degree_or_2 = simd_degree < 2 ? 2 : simd_degree;
+
+   /**
+    * @brief Subtrees smaller than this are never handed to another thread.
+    */
+   constexpr static inline std::size_t parallel_min_len = 128 * chunk_len;
+
+   static inline std::uint32_t load32(const std::uint8_t* p) noexcept {
+      return static_cast<std::uint32_t>(p[0])       | (static_cast<std::uint32_t>(p[1]) << 8) |
+            (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+   }
+
+   static inline void store32(std::uint8_t* p, std::uint32_t w) noexcept {
+      p[0] = static_cast<std::uint8_t>(w);
+      p[1] = static_cast<std::uint8_t>(w >> 8);
+      p[2] = static_cast<std::uint8_t>(w >> 16);
+      p[3] = static_cast<std::uint8_t>(w >> 24);
+   }
+
+   static inline void load_key_words(const std::uint8_t* key, std::uint32_t out[8]) noexcept {
+      for (std::size_t i = 0; i < 8; ++i)
+         out[i] = load32(key + i*4);
+   }
+
+   static inline void store_cv_words(std::uint8_t* out, const std::uint32_t cv[8]) noexcept {
+      for (std::size_t i = 0; i < 8; ++i)
+         store32(out + i*4, cv[i]);
+   }
+
+   static inline void g(std::uint32_t* s, std::size_t a, std::size_t b, std::size_t c, std::size_t d, std::uint32_t x, std::uint32_t y) noexcept {
+      s[a] = s[a] + s[b] + x;
+      s[d] = std::rotr(s[d] ^ s[a], 16);
+      s[c] = s[c] + s[d];
+      s[b] = std::rotr(s[b] ^ s[c], 12);
+      s[a] = s[a] + s[b] + y;
+      s[d] = std::rotr(s[d] ^ s[a], 8);
+      s[c] = s[c] + s[d];
+      s[b] = std::rotr(s[b] ^ s[c], 7);
+   }
+
+   static inline void round_fn(std::uint32_t s[16], const std::uint32_t m[16], std::size_t r) noexcept {
+      const auto& sc = msg_schedule[r];
+      g(s, 0, 4,  8, 12, m[sc[0]],  m[sc[1]]);
+      g(s, 1, 5,  9, 13, m[sc[2]],  m[sc[3]]);
+      g(s, 2, 6, 10, 14, m[sc[4]],  m[sc[5]]);
+      g(s, 3, 7, 11, 15, m[sc[6]],  m[sc[7]]);
+      g(s, 0, 5, 10, 15, m[sc[8]],  m[sc[9]]);
+      g(s, 1, 6, 11, 12, m[sc[10]], m[sc[11]]);
+      g(s, 2, 7,  8, 13, m[sc[12]], m[sc[13]]);
+      g(s, 3, 4,  9, 14, m[sc[14]], m[sc[15]]);
+   }
+
+   static inline void compress_pre(std::uint32_t s[16], const std::uint32_t cv[8], const std::uint8_t block[block_len],
+                                   std::uint8_t blen, std::uint64_t counter, std::uint8_t flags) noexcept {
+      std::uint32_t m[16];
+      for (std::size_t i = 0; i < 16; ++i)
+         m[i] = load32(block + i*4);
+
+      for (std::size_t i = 0; i < 8; ++i)
+         s[i] = cv[i];
+      s[8]  = iv[0];
+      s[9]  = iv[1];
+      s[10] = iv[2];
+      s[11] = iv[3];
+      s[12] = static_cast<std::uint32_t>(counter);
+      s[13] = static_cast<std::uint32_t>(counter >> 32);
+      s[14] = blen;
+      s[15] = flags;
+
+      for (std::size_t r = 0; r < 7; ++r)
+         round_fn(s, m, r);
+   }
+
+   static inline void compress_in_place(std::uint32_t cv[8], const std::uint8_t block[block_len], std::uint8_t blen,
+                                        std::uint64_t counter, std::uint8_t flags) noexcept {
+      std::uint32_t s[16];
+      compress_pre(s, cv, block, blen, counter, flags);
+      for (std::size_t i = 0; i < 8; ++i)
+         cv[i] = s[i] ^ s[i+8];
+   }
+
+   static inline void compress_xof(const std::uint32_t cv[8], const std::uint8_t block[block_len], std::uint8_t blen,
+                                   std::uint64_t counter, std::uint8_t flags, std::uint8_t out[64]) noexcept {
+      std::uint32_t s[16];
+      compress_pre(s, cv, block, blen, counter, flags);
+      for (std::size_t i = 0; i < 8; ++i) {
+         store32(out + i*4,      s[i] ^ s[i+8]);
+         store32(out + (i+8)*4,  s[i+8] ^ cv[i]);
+      }
+   }
+
+   static inline void hash_one_portable(const std::uint8_t* input, std::size_t blocks, const std::uint32_t key[8], std::uint64_t counter,
+                                        std::uint8_t flags, std::uint8_t flags_start, std::uint8_t flags_end, std::uint8_t out[out_len]) noexcept {
+      std::uint32_t cv[8];
+      std::copy_n(key, 8, cv);
+      std::uint8_t block_flags = flags | flags_start;
+      for (; blocks > 0; --blocks, input += block_len) {
+         if (blocks == 1)
+            block_flags |= flags_end;
+         compress_in_place(cv, input, block_len, counter, block_flags);
+         block_flags = flags;
+      }
+      store_cv_words(out, cv);
+   }
+
+   /**
+    * @brief Compresses `num_inputs` independent inputs of `blocks` blocks each, writing one chaining value per input.
+    *        Wide SIMD kernels are used for as many inputs as possible, with the portable path handling the tail.
+    */
+   static inline void hash_many(const std::uint8_t* const* inputs, std::size_t num_inputs, std::size_t blocks, const std::uint32_t key[8],
+                                std::uint64_t counter, bool increment_counter, std::uint8_t flags, std::uint8_t flags_start,
+                                std::uint8_t flags_end, std::uint8_t* out) noexcept {
+      #if defined(ASTRO_BLAKE3_AVX2)
+         while (num_inputs >= avx2_lanes::width) {
+            hash_lanes<avx2_lanes>(inputs, blocks, key, counter, increment_counter, flags, flags_start, flags_end, out);
+            if (increment_counter)
+               counter += avx2_lanes::width;
+            inputs     += avx2_lanes::width;
+            num_inputs -= avx2_lanes::width;
+            out        += avx2_lanes::width * out_len;
+         }
+      #endif
+      #if defined(ASTRO_BLAKE3_SSE41)
+         while (num_inputs >= sse41_lanes::width) {
+            hash_lanes<sse41_lanes>(inputs, blocks, key, counter, increment_counter, flags, flags_start, flags_end, out);
+            if (increment_counter)
+               counter += sse41_lanes::width;
+            inputs     += sse41_lanes::width;
+            num_inputs -= sse41_lanes::width;
+            out        += sse41_lanes::width * out_len;
+         }
+      #endif
+      for (; num_inputs > 0; --num_inputs, ++inputs, out += out_len) {
+         hash_one_portable(*inputs, blocks, key, counter, flags, flags_start, flags_end, out);
+         if (increment_counter)
+            ++counter;
+      }
+   }
+
+   struct output {
+      std::uint32_t cv[8];
+      std::uint8_t  block[block_len];
+      std::uint8_t  blen;
+      std::uint64_t counter;
+      std::uint8_t  flags;
+
+      inline void chaining_value(std::uint8_t out[out_len]) const noexcept {
+         std::uint32_t tmp[8];
+         std::copy_n(cv, 8, tmp);
+         compress_in_place(tmp, block, blen, counter, flags);
+         store_cv_words(out, tmp);
+      }
+
+      inline void root_bytes(std::uint64_t seek, std::uint8_t* out, std::size_t len) const noexcept {
+         std::uint64_t output_block_counter = seek / 64;
+         std::size_t   offset_within_block  = seek % 64;
+         std::uint8_t  wide[64];
+         while (len > 0) {
+            compress_xof(cv, block, blen, output_block_counter, flags | root, wide);
+            std::size_t available = 64 - offset_within_block;
+            std::size_t n         = std::min(len, available);
+            std::memcpy(out, wide + offset_within_block, n);
+            out += n;
+            len -= n;
+            ++output_block_counter;
+            offset_within_block = 0;
+         }
+      }
+   };
+
+   static inline output parent_output(const std::uint8_t block[block_len], const std::uint32_t key[8], std::uint8_t flags) noexcept {
+      output o;
+      std::copy_n(key, 8, o.cv);
+      std::memcpy(o.block, block, block_len);
+      o.blen      = block_len;
+      o.counter   = 0;
+      o.flags     = flags | parent;
+      return o;
+   }
+
+   struct chunk_state {
+      std::uint32_t cv[8];
+      std::uint64_t chunk_counter;
+      std::uint8_t  buf[block_len];
+      std::uint8_t  buf_len;
+      std::uint8_t  blocks_compressed;
+      std::uint8_t  flags;
+
+      inline void init(const std::uint32_t key[8], std::uint8_t f) noexcept {
+         std::copy_n(key, 8, cv);
+         chunk_counter     = 0;
+         std::memset(buf, 0, block_len);
+         buf_len           = 0;
+         blocks_compressed = 0;
+         flags             = f;
+      }
+
+      inline void reset(const std::uint32_t key[8], std::uint64_t counter) noexcept {
+         init(key, flags);
+         chunk_counter = counter;
+      }
+
+      inline std::size_t len() const noexcept { return block_len * static_cast<std::size_t>(blocks_compressed) + buf_len; }
+
+      inline std::uint8_t start_flag() const noexcept { return blocks_compressed == 0 ? chunk_start : 0; }
+
+      inline std::size_t fill_buf(const std::uint8_t* input, std::size_t input_len) noexcept {
+         std::size_t take = std::min(block_len - buf_len, input_len);
+         std::memcpy(buf + buf_len, input, take);
+         buf_len += static_cast<std::uint8_t>(take);
+         return take;
+      }
+
+      inline void update(const std::uint8_t* input, std::size_t input_len) noexcept {
+         if (buf_len > 0) {
+            std::size_t take = fill_buf(input, input_len);
+            input     += take;
+            input_len -= take;
+            if (input_len > 0) {
+               compress_in_place(cv, buf, block_len, chunk_counter, flags | start_flag());
+               ++blocks_compressed;
+               buf_len = 0;
+               std::memset(buf, 0, block_len);
+            }
+         }
+
+         while (input_len > block_len) {
+            compress_in_place(cv, input, block_len, chunk_counter, flags | start_flag());
+            ++blocks_compressed;
+            input     += block_len;
+            input_len -= block_len;
+         }
+
+         fill_buf(input, input_len);
+      }
+
+      inline output to_output() const noexcept {
+         output o;
+         std::copy_n(cv, 8, o.cv);
+         std::memcpy(o.block, buf, block_len);
+         o.blen      = buf_len;
+         o.counter   = chunk_counter;
+         o.flags     = flags | start_flag() | chunk_end;
+         return o;
+      }
+   };
+
+   static inline std::size_t left_len(std::size_t content_len) noexcept {
+      std::size_t full_chunks = (content_len - 1) / chunk_len;
+      return std::bit_floor(full_chunks) * chunk_len;
+   }
+
+   static inline std::size_t compress_chunks_parallel(const std::uint8_t* input, std::size_t input_len, const std::uint32_t key[8],
+                                                      std::uint64_t chunk_counter, std::uint8_t flags, std::uint8_t* out) noexcept {
+      const std::uint8_t* chunks[simd_degree];
+      std::size_t         n = 0;
+      while (input_len - n * chunk_len >= chunk_len) {
+         chunks[n] = input + n * chunk_len;
+         ++n;
+      }
+
+      hash_many(chunks, n, chunk_len / block_len, key, chunk_counter, true, flags, chunk_start, chunk_end, out);
+
+      std::size_t consumed = n * chunk_len;
+      if (input_len > consumed) {
+         chunk_state cs;
+         cs.init(key, flags);
+         cs.chunk_counter = chunk_counter + n;
+         cs.update(input + consumed, input_len - consumed);
+         cs.to_output().chaining_value(out + n * out_len);
+         return n + 1;
+      }
+      return n;
+   }
+
+   static inline std::size_t compress_parents_parallel(const std::uint8_t* child_cvs, std::size_t num_cvs, const std::uint32_t key[8],
+                                                       std::uint8_t flags, std::uint8_t* out) noexcept {
+      const std::uint8_t* parents[simd_degree_or_2];
+      std::size_t         n = 0;
+      while (num_cvs - 2 * n >= 2) {
+         parents[n] = child_cvs + 2 * n * out_len;
+         ++n;
+      }
+
+      hash_many(parents, n, 1, key, 0, false, flags | parent, 0, 0, out);
+
+      if (num_cvs > 2 * n) {
+         std::memcpy(out + n * out_len, child_cvs + 2 * n * out_len, out_len);
+         return n + 1;
+      }
+      return n;
+   }
+
+   /**
+    * @brief Recursively compresses a subtree to at most `simd_degree_or_2` chaining values.
+    *        When `threads` > 1 the left half is submitted to `pool` and the budget is split between both halves.
+    */
+   static inline std::size_t compress_subtree_wide(const std::uint8_t* input, std::size_t input_len, const std::uint32_t key[8],
+                                                   std::uint64_t chunk_counter, std::uint8_t flags, std::uint8_t* out, std::size_t threads,
+                                                   async::thread_pool* pool) {
+      if (input_len <= simd_degree * chunk_len)
+         return compress_chunks_parallel(input, input_len, key, chunk_counter, flags, out);
+
+      std::size_t         llen          = left_len(input_len);
+      std::size_t         rlen          = input_len - llen;
+      const std::uint8_t* right_input   = input + llen;
+      std::uint64_t       right_counter = chunk_counter + llen / chunk_len;
+
+      std::uint8_t cv_array[2 * simd_degree_or_2 * out_len];
+      std::size_t  degree = (llen > chunk_len && simd_degree == 1) ? 2 : simd_degree;
+      std::uint8_t* right_cvs = cv_array + degree * out_len;
+
+      std::size_t left_n  = 0;
+      std::size_t right_n = 0;
+      if (threads > 1 && pool && rlen >= parallel_min_len) {
+         std::size_t left_threads = threads / 2;
+         auto        left         = pool->submit([&]() {
+            left_n = compress_subtree_wide(input, llen, key, chunk_counter, flags, cv_array, left_threads, pool);
+         });
+         right_n = compress_subtree_wide(right_input, rlen, key, right_counter, flags, right_cvs, threads - left_threads, pool);
+         left.get();
+      } else {
+         left_n  = compress_subtree_wide(input, llen, key, chunk_counter, flags, cv_array, 1, nullptr);
+         right_n = compress_subtree_wide(right_input, rlen, key, right_counter, flags, right_cvs, 1, nullptr);
+      }
+
+      if (left_n == 1) {
+         std::memcpy(out, cv_array, 2 * out_len);
+         return 2;
+      }
+
+      return compress_parents_parallel(cv_array, left_n + right_n, key, flags, out);
+   }
+
+   static inline void compress_subtree_to_parent_node(const std::uint8_t* input, std::size_t input_len, const std::uint32_t key[8],
+                                                      std::uint64_t chunk_counter, std::uint8_t flags, std::uint8_t out[2 * out_len],
+                                                      std::size_t threads, async::thread_pool* pool) {
+      std::uint8_t cv_array[simd_degree_or_2 * out_len];
+      std::size_t  num_cvs = compress_subtree_wide(input, input_len, key, chunk_counter, flags, cv_array, threads, pool);
+
+      std::uint8_t out_array[simd_degree_or_2 * out_len / 2];
+      while (num_cvs > 2) {
+         num_cvs = compress_parents_parallel(cv_array, num_cvs, key, flags, out_array);
+         std::memcpy(cv_array, out_array, num_cvs * out_len);
+      }
+      std::memcpy(out, cv_array, 2 * out_len);
+   }
+} // namespace astro::cryptid::detail::b3
+
+namespace astro::cryptid {
+
+   /**
+    * @brief An incremental BLAKE3 hasher.
+    *
+    * Produces output identical to the reference implementation for the hash, keyed hash and key derivation modes.
+    * Whole chunks are compressed several at a time with the widest SIMD kernel the target was compiled for (AVX2 or SSE4.1),
+    * and `update_parallel` additionally splits large inputs by subtree across a thread pool.
+    */
+   class blake3 {
+      public:
+         constexpr static inline std::size_t digest_size = detail::b3::out_len;
+         constexpr static inline std::size_t key_size    = detail::b3::key_len;
+         constexpr static inline std::size_t block_size  = detail::b3::block_len;
+         constexpr static inline std::size_t chunk_size  = detail::b3::chunk_len;
+
+         using digest_t = std::array<std::uint8_t, digest_size>;
+         using key_t    = std::array<std::uint8_t, key_size>;
+
+         inline blake3() noexcept { init(detail::b3::iv.data(), 0); }
+
+         /**
+          * @brief Creates a hasher in keyed hash mode.
+          * @param key The 32 byte key.
+          */
+         inline explicit blake3(const key_t& key) noexcept {
+            std::uint32_t kw[8];
+            detail::b3::load_key_words(key.data(), kw);
+            init(kw, detail::b3::keyed_hash);
+         }
+
+         blake3(const blake3&) = default;
+         blake3(blake3&&) = default;
+         blake3& operator=(const blake3&) = default;
+         blake3& operator=(blake3&&) = default;
+         ~blake3() = default;
+
+         /**
+          * @brief Creates a hasher in key derivation mode, the context string should be hardcoded and globally unique.
+          * @param context The application context string.
+          * @return The hasher to feed the key material into.
+          */
+         static inline blake3 derive_key(std::string_view context) noexcept {
+            blake3 ctx_hasher;
+            ctx_hasher.init(detail::b3::iv.data(), detail::b3::derive_key_context);
+            ctx_hasher.update(context.data(), context.size());
+            digest_t ctx_key = ctx_hasher.finalize();
+
+            blake3 h;
+            std::uint32_t kw[8];
+            detail::b3::load_key_words(ctx_key.data(), kw);
+            h.init(kw, detail::b3::derive_key_material);
+            return h;
+         }
+
+         /**
+          * @brief Adds more input to the hash state.
+          * @param data The input bytes.
+          * @param n The number of bytes.
+          * @return A reference to this hasher.
+          */
+         inline blake3& update(const void* data, std::size_t n) noexcept {
+            update_impl(static_cast<const std::uint8_t*>(data), n, 1, nullptr);
+            return *this;
+         }
+
+         inline blake3& update(std::span<const std::uint8_t> data) noexcept { return update(data.data(), data.size()); }
+
+         inline blake3& update(std::string_view data) noexcept { return update(data.data(), data.size()); }
+
+         /**
+          * @brief Adds more input to the hash state, hashing large subtrees as up to `threads` tasks on `pool`.
+          * @param data The input bytes, e.g. the contents of a memory mapped file.
+          * @param threads The maximum number of subtrees hashed at once, the calling thread takes one of them.
+          * @param pool The pool the other subtrees are submitted to.
+          * @return A reference to this hasher.
+          */
+         inline blake3& update_parallel(std::span<const std::uint8_t> data,
+                                        std::size_t                   threads = std::thread::hardware_concurrency(),
+                                        async::thread_pool&           pool    = async::thread_pool::shared()) {
+            update_impl(data.data(), data.size(), std::max<std::size_t>(threads, 1), &pool);
+            return *this;
+         }
+
+         /**
+          * @brief Produces the default length digest, the hasher state is left untouched so more input can follow.
+          * @return The 32 byte digest.
+          */
+         inline digest_t finalize() const noexcept {
+            digest_t d;
+            finalize(d, 0);
+            return d;
+         }
+
+         /**
+          * @brief Produces extended output (XOF) starting at the given byte offset of the output stream.
+          * @param out The output buffer to fill.
+          * @param seek The offset into the output stream.
+          */
+         inline void finalize(std::span<std::uint8_t> out, std::uint64_t seek = 0) const noexcept {
+            if (out.empty())
+               return;
+            root_output().root_bytes(seek, out.data(), out.size());
+         }
+
+         /**
+          * @brief Resets the hasher to its initial state, keeping the key and mode.
+          */
+         inline void reset() noexcept {
+            _chunk.reset(_key, 0);
+            _cv_stack_len = 0;
+         }
+
+         static inline digest_t hash(std::span<const std::uint8_t> data) noexcept { return blake3{}.update(data).finalize(); }
+
+         static inline digest_t hash(std::string_view data) noexcept { return blake3{}.update(data).finalize(); }
+
+         static inline digest_t hash_parallel(std::span<const std::uint8_t> data,
+                                              std::size_t                   threads = std::thread::hardware_concurrency(),
+                                              async::thread_pool&           pool    = async::thread_pool::shared()) {
+            return blake3{}.update_parallel(data, threads, pool).finalize();
+         }
+
+      private:
+         inline void init(const std::uint32_t key[8], std::uint8_t flags) noexcept {
+            std::copy_n(key, 8, _key);
+            _chunk.init(key, flags);
+            _cv_stack_len = 0;
+         }
+
+         inline void merge_cv_stack(std::uint64_t total_len) noexcept {
+            std::size_t post_merge_stack_len = static_cast<std::size_t>(std::popcount(total_len));
+            while (_cv_stack_len > post_merge_stack_len) {
+               std::uint8_t* parent_node = _cv_stack + (_cv_stack_len - 2) * detail::b3::out_len;
+               detail::b3::parent_output(parent_node, _key, _chunk.flags).chaining_value(parent_node);
+               --_cv_stack_len;
+            }
+         }
+
+         inline void push_cv(const std::uint8_t new_cv[detail::b3::out_len], std::uint64_t chunk_counter) noexcept {
+            merge_cv_stack(chunk_counter);
+            std::memcpy(_cv_stack + _cv_stack_len * detail::b3::out_len, new_cv, detail::b3::out_len);
+            ++_cv_stack_len;
+         }
+
+         inline void update_impl(const std::uint8_t* input, std::size_t input_len, std::size_t threads, async::thread_pool* pool) {
+            using namespace detail::b3;
+
+            if (_chunk.len() > 0) {
+               std::size_t take = std::min(chunk_len - _chunk.len(), input_len);
+               _chunk.update(input, take);
+               input     += take;
+               input_len -= take;
+               if (input_len == 0)
+                  return;
+
+               std::uint8_t cv[out_len];
+               _chunk.to_output().chaining_value(cv);
+               push_cv(cv, _chunk.chunk_counter);
+               _chunk.reset(_key, _chunk.chunk_counter + 1);
+            }
+
+            while (input_len > chunk_len) {
+               std::uint64_t subtree_len   = std::bit_floor(static_cast<std::uint64_t>(input_len));
+               std::uint64_t count_so_far  = _chunk.chunk_counter * chunk_len;
+               while (((subtree_len - 1) & count_so_far) != 0)
+                  subtree_len /= 2;
+               std::uint64_t subtree_chunks = subtree_len / chunk_len;
+
+               if (subtree_len <= chunk_len) {
+                  chunk_state cs;
+                  cs.init(_key, _chunk.flags);
+                  cs.chunk_counter = _chunk.chunk_counter;
+                  cs.update(input, static_cast<std::size_t>(subtree_len));
+                  std::uint8_t cv[out_len];
+                  cs.to_output().chaining_value(cv);
+                  push_cv(cv, cs.chunk_counter);
+               } else {
+                  std::uint8_t cv_pair[2 * out_len];
+                  compress_subtree_to_parent_node(input, static_cast<std::size_t>(subtree_len), _key, _chunk.chunk_counter,
+                                                  _chunk.flags, cv_pair, threads, pool);
+                  push_cv(cv_pair, _chunk.chunk_counter);
+                  push_cv(cv_pair + out_len, _chunk.chunk_counter + subtree_chunks / 2);
+               }
+               _chunk.chunk_counter += subtree_chunks;
+               input     += subtree_len;
+               input_len -= static_cast<std::size_t>(subtree_len);
+            }
+
+            if (input_len > 0) {
+               _chunk.update(input, input_len);
+               merge_cv_stack(_chunk.chunk_counter);
+            }
+         }
+
+         inline detail::b3::output root_output() const noexcept {
+            using namespace detail::b3;
+
+            if (_cv_stack_len == 0)
+               return _chunk.to_output();
+
+            output      o;
+            std::size_t cvs_remaining;
+            if (_chunk.len() > 0) {
+               cvs_remaining = _cv_stack_len;
+               o             = _chunk.to_output();
+            } else {
+               cvs_remaining = _cv_stack_len - 2;
+               o             = parent_output(_cv_stack + cvs_remaining * out_len, _key, _chunk.flags);
+            }
+
+            while (cvs_remaining > 0) {
+               --cvs_remaining;
+               std::uint8_t parent_block[block_len];
+               std::memcpy(parent_block, _cv_stack + cvs_remaining * out_len, out_len);
+               o.chaining_value(parent_block + out_len);
+               o = parent_output(parent_block, _key, _chunk.flags);
+            }
+            return o;
+         }
+
+         std::uint32_t          _key[8];
+         detail::b3::chunk_state _chunk;
+         std::uint8_t           _cv_stack_len = 0;
+         std::uint8_t           _cv_stack[(detail::b3::max_depth + 1) * detail::b3::out_len];
+   };
+
+} // namespace astro::cryptid
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+#if defined(__AVX2__)
+   #include <immintrin.h>
+#endif
+
+#include "../serial/alpha.hpp"
+#include "../utils/misc.hpp"
+#include "city_hash.hpp"
+
+namespace astro::cryptid {
+
+   /**
+    * @brief Split-block Bloom filter.
+    *
+    * Every key maps to a single 256-bit block and sets one bit in each of its eight 32-bit words, so a probe touches exactly
+    * one cache line. The high 32 bits of the hash pick the block and the low 32 bits pick the bits.
+    */
+   template <hasher_type Hasher = city_hash>
+   class blocked_bloom_filter {
+      public:
+         struct alignas(32) block_t {
+            std::uint32_t words[8];
+         };
+
+         constexpr static inline std::size_t block_bits = sizeof(block_t) * 8;
+         constexpr static inline std::size_t batch_size = 16;
+
+         constexpr static inline std::uint32_t salts[8] = {0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+                                                           0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u};
+
+         blocked_bloom_filter() = default;
+
+         /**
+          * @brief Sizes the filter for an expected number of keys and a target false positive rate.
+          * @param expected The expected number of keys.
+          * @param fpp The target false positive probability.
+          */
+         explicit inline blocked_bloom_filter(std::size_t expected, double fpp = 0.01)
+            : _blocks(blocks_for(expected, fpp)) {}
+
+         /**
+          * @brief Creates a filter with an explicit number of blocks.
+          */
+         static inline blocked_bloom_filter with_blocks(std::size_t nblocks) {
+            blocked_bloom_filter f;
+            f._blocks.resize(std::max<std::size_t>(nblocks, 1));
+            return f;
+         }
+
+         template <typename K>
+         inline void insert(const K& key) noexcept { insert_hash(hash_key<Hasher>(key)); }
+
+         template <typename K>
+         inline bool contains(const K& key) const noexcept { return contains_hash(hash_key<Hasher>(key)); }
+
+         inline void insert_hash(std::uint64_t h) noexcept {
+            set_mask(_blocks[block_index(h)], static_cast<std::uint32_t>(h));
+         }
+
+         inline bool contains_hash(std::uint64_t h) const noexcept {
+            return test_mask(_blocks[block_index(h)], static_cast<std::uint32_t>(h));
+         }
+
+         /**
+          * @brief Queries a batch of keys, prefetching each group of blocks before testing them.
+          * @param keys The keys to look up.
+          * @param out One result per key.
+          * @return The number of keys that may be present.
+          */
+         template <typename K>
+         inline std::size_t contains_n(std::span<const K> keys, std::span<bool> out) const noexcept {
+            std::uint64_t hashes[batch_size];
+            std::size_t   hits = 0;
+            for (std::size_t i = 0; i < keys.size(); i += batch_size) {
+               const std::size_t n = std::min(batch_size, keys.size() - i);
+               for (std::size_t j = 0; j < n; ++j) {
+                  hashes[j] = hash_key<Hasher>(keys[i + j]);
+                  ASTRO_PREFETCH(&_blocks[block_index(hashes[j])]);
+               }
+               hits += test_batch(std::span<const std::uint64_t>{hashes, n}, out.subspan(i, n));
+            }
+            return hits;
+         }
+
+         /**
+          * @brief Queries a batch of precomputed hashes.
+          */
+         inline std::size_t contains_hash_n(std::span<const std::uint64_t> hashes, std::span<bool> out) const noexcept {
+            std::size_t hits = 0;
+            for (std::size_t i = 0; i < hashes.size(); i += batch_size) {
+               const std::size_t n = std::min(batch_size, hashes.size() - i);
+               for (std::size_t j = 0; j < n; ++j)
+                  ASTRO_PREFETCH(&_blocks[block_index(hashes[i + j])]);
+               hits += test_batch(hashes.subspan(i, n), out.subspan(i, n));
+            }
+            return hits;
+         }
+
+         /**
+          * @brief Unions another filter of the same shape into this one.
+          */
+         inline void merge(const blocked_bloom_filter& other) {
+            util::check(other._blocks.size() == _blocks.size(), "blocked_bloom_filter::merge: block count mismatch");
+            for (std::size_t i = 0; i < _blocks.size(); ++i)
+               for (std::size_t w = 0; w < 8; ++w)
+                  _blocks[i].words[w] |= other._blocks[i].words[w];
+         }
+
+         inline void clear() noexcept { std::fill(_blocks.begin(), _blocks.end(), block_t{}); }
+
+         inline std::size_t block_count() const noexcept { return _blocks.size(); }
+         inline std::size_t size_bytes() const noexcept { return _blocks.size() * sizeof(block_t); }
+
+         inline std::span<const block_t> blocks() const noexcept { return _blocks; }
+         inline std::span<block_t> blocks() noexcept { return _blocks; }
+
+      private:
+         static inline std::size_t blocks_for(std::size_t expected, double fpp) noexcept {
+            fpp = std::clamp(fpp, 1e-9, 0.5);
+            // blocking costs roughly 10% over a classic filter at the same rate
+            const double bits_per_key = -std::log(fpp) / (std::log(2.0) * std::log(2.0)) * 1.1;
+            const auto   bits         = static_cast<std::size_t>(std::ceil(std::max<std::size_t>(expected, 1) * bits_per_key));
+            return std::max<std::size_t>((bits + block_bits - 1) / block_bits, 1);
+         }
+
+         inline std::size_t block_index(std::uint64_t h) const noexcept {
+            return fast_range32(static_cast<std::uint32_t>(h >> 32), static_cast<std::uint32_t>(_blocks.size()));
+         }
+
+         inline std::size_t test_batch(std::span<const std::uint64_t> hashes, std::span<bool> out) const noexcept {
+            std::size_t hits = 0;
+            for (std::size_t j = 0; j < hashes.size(); ++j) {
+               out[j] = contains_hash(hashes[j]);
+               hits  += out[j];
+            }
+            return hits;
+         }
+
+#if defined(__AVX2__)
+         static inline __m256i make_mask(std::uint32_t key) noexcept {
+            const __m256i s = _mm256_load_si256(reinterpret_cast<const __m256i*>(aligned_salts.words));
+            const __m256i k = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(key)), s), 27);
+            return _mm256_sllv_epi32(_mm256_set1_epi32(1), k);
+         }
+
+         static inline void set_mask(block_t& b, std::uint32_t key) noexcept {
+            auto* p = reinterpret_cast<__m256i*>(b.words);
+            _mm256_store_si256(p, _mm256_or_si256(_mm256_load_si256(p), make_mask(key)));
+         }
+
+         static inline bool test_mask(const block_t& b, std::uint32_t key) noexcept {
+            return _mm256_testc_si256(_mm256_load_si256(reinterpret_cast<const __m256i*>(b.words)), make_mask(key));
+         }
+
+         constexpr static inline block_t aligned_salts = {{salts[0], salts[1], salts[2], salts[3],
+                                                           salts[4], salts[5], salts[6], salts[7]}};
+#else
+         static inline void set_mask(block_t& b, std::uint32_t key) noexcept {
+            for (std::size_t i = 0; i < 8; ++i)
+               b.words[i] |= 1u << ((key * salts[i]) >> 27);
+         }
+
+         static inline bool test_mask(const block_t& b, std::uint32_t key) noexcept {
+            std::uint32_t missing = 0;
+            for (std::size_t i = 0; i < 8; ++i) {
+               const std::uint32_t bit = 1u << ((key * salts[i]) >> 27);
+               missing |= (b.words[i] & bit) ^ bit;
+            }
+            return missing == 0;
+         }
+#endif
+
+         std::vector<block_t> _blocks = std::vector<block_t>(1);
+   };
+
+   template <typename T>
+   constexpr static inline bool is_blocked_bloom_filter_v = false;
+
+   template <typename H>
+   constexpr static inline bool is_blocked_bloom_filter_v<blocked_bloom_filter<H>> = true;
+
+   template <typename T>
+   concept blocked_bloom_filter_type = is_blocked_bloom_filter_v<T>;
+
+} // namespace astro::cryptid
+
+namespace astro::serial {
+   template <typename H>
+   static inline void serialize(alpha& a, const cryptid::blocked_bloom_filter<H>& f) {
+      const std::uint64_t n = f.block_count();
+      a.write(&n, sizeof(n));
+      a.write(f.blocks().data(), f.size_bytes());
+   }
+
+   template <cryptid::blocked_bloom_filter_type F>
+   static inline F deserialize(alpha& a) {
+      std::uint64_t n = 0;
+      a.read(&n, sizeof(n));
+      util::check(n > 0 && n <= a.remaining() / sizeof(typename F::block_t), "blocked_bloom_filter: truncated input");
+      auto f = F::with_blocks(n);
+      a.read(f.blocks().data(), f.size_bytes());
+      return f;
+   }
+} // namespace astro::serial
@@ -1,9 +1,18 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 
+#include <bit>
 #include <concepts>
+#include <span>
+#include <string_view>
 #include <type_traits>
+#include <utility>
+
+#include "../utils/misc.hpp"
+#include "ops.hpp"
 
 namespace astro::cryptid {
 
@@ -14,59 +23,243 @@ namespace astro::cryptid {
    template <typename T>
    concept bits_tag_type = std::is_same_v<T, bits_32_tag> || std::is_same_v<T, bits_64_tag> || std::is_same_v<T, bits_128_tag>;
 
+   /**
+    * @brief Keys that can be hashed by their object representation.
+    */
+   template <typename T>
+   concept hashable_bytes_type = std::is_trivially_copyable_v<T> && std::has_unique_object_representations_v<T>;
+
+   /**
+    * @brief Keys that expose a contiguous run of bytes (strings, string_views, spans of bytes).
+    */
+   template <typename T>
+   concept hashable_range_type = requires(const T& v) {
+      { v.data() };
+      { v.size() } -> std::convertible_to<std::size_t>;
+   } && hashable_bytes_type<std::remove_cvref_t<decltype(*std::declval<const T&>().data())>>;
 
+   /**
+    * @brief CityHash64, a fast non-cryptographic 64-bit hash.
+    *
+    * This is the CityHash v1.1 64-bit algorithm, and is the default hash used by the cryptid filters and sketches.
+    */
    struct city_hash {
       constexpr static inline auto seed = 0x9e3779b9;
+
+      constexpr static inline std::uint64_t k0 = 0xc3a5c85c97cb3127ull;
+      constexpr static inline std::uint64_t k1 = 0xb492b66fbe98f273ull;
+      constexpr static inline std::uint64_t k2 = 0x9ae16a3b2f90404full;
+
+      /**
+       * @brief Hashes a run of bytes.
+       * @param data The bytes to hash.
+       * @param len The number of bytes.
+       * @return The 64-bit hash.
+       */
+      static inline std::uint64_t hash64(const void* data, std::size_t len) noexcept {
+         const auto* s = static_cast<const std::uint8_t*>(data);
+         if (len <= 32) {
+            if (len <= 16)
+               return hash_len_0_to_16(s, len);
+            return hash_len_17_to_32(s, len);
+         } else if (len <= 64) {
+            return hash_len_33_to_64(s, len);
+         }
+
+         std::uint64_t x = fetch64(s + len - 40);
+         std::uint64_t y = fetch64(s + len - 16) + fetch64(s + len - 56);
+         std::uint64_t z = hash_len_16(fetch64(s + len - 48) + len, fetch64(s + len - 24));
+         auto v = weak_hash_len_32_with_seeds(s + len - 64, len, z);
+         auto w = weak_hash_len_32_with_seeds(s + len - 32, y + k1, x);
+         x = x * k1 + fetch64(s);
+
+         len = (len - 1) & ~static_cast<std::size_t>(63);
+         do {
+            x = std::rotr(x + y + v.first + fetch64(s + 8), 37) * k1;
+            y = std::rotr(y + v.second + fetch64(s + 48), 42) * k1;
+            x ^= w.second;
+            y += v.first + fetch64(s + 40);
+            z = std::rotr(z + w.first, 33) * k1;
+            v = weak_hash_len_32_with_seeds(s, v.second * k1, x + w.first);
+            w = weak_hash_len_32_with_seeds(s + 32, z + w.second, y + fetch64(s + 16));
+            std::swap(z, x);
+            s   += 64;
+            len -= 64;
+         } while (len != 0);
+
+         return hash_len_16(hash_len_16(v.first, w.first) + shift_mix(y) * k1 + z,
+                            hash_len_16(v.second, w.second) + x);
+      }
+
+      /**
+       * @brief Hashes a run of bytes with a seed.
+       * @param data The bytes to hash.
+       * @param len The number of bytes.
+       * @param s The seed.
+       * @return The 64-bit hash.
+       */
+      static inline std::uint64_t hash64(const void* data, std::size_t len, std::uint64_t s) noexcept {
+         return hash_len_16(hash64(data, len) - k2, s);
+      }
+
+      template <hashable_range_type R>
+      static inline std::uint64_t hash64(const R& r) noexcept {
+         return hash64(r.data(), r.size() * sizeof(*r.data()));
+      }
+
+      template <hashable_bytes_type T>
+      requires (!hashable_range_type<T>)
+      static inline std::uint64_t hash64(const T& v) noexcept {
+         return hash64(&v, sizeof(T));
+      }
+
+      static inline std::uint64_t hash64(const char* s) noexcept {
+         return hash64(std::string_view{s});
+      }
+
+      /**
+       * @brief Finalizes a 128-bit value down to 64 bits, also usable as a cheap mixer for two words.
+       */
+      constexpr static inline std::uint64_t hash_len_16(std::uint64_t u, std::uint64_t v) noexcept {
+         constexpr std::uint64_t mul = 0x9ddfea08eb382d69ull;
+         std::uint64_t a = (u ^ v) * mul;
+         a ^= (a >> 47);
+         std::uint64_t b = (v ^ a) * mul;
+         b ^= (b >> 47);
+         return b * mul;
+      }
+
+      private:
+         static inline std::uint64_t fetch64(const std::uint8_t* p) noexcept {
+            std::uint64_t r;
+            std::memcpy(&r, p, sizeof(r));
+            if constexpr (std::endian::native == std::endian::big)
+               r = util::bswap64(r);
+            return r;
+         }
+
+         static inline std::uint32_t fetch32(const std::uint8_t* p) noexcept {
+            std::uint32_t r;
+            std::memcpy(&r, p, sizeof(r));
+            if constexpr (std::endian::native == std::endian::big)
+               r = util::bswap32(r);
+            return r;
+         }
+
+         constexpr static inline std::uint64_t shift_mix(std::uint64_t v) noexcept { return v ^ (v >> 47); }
+
+         constexpr static inline std::uint64_t hash_len_16(std::uint64_t u, std::uint64_t v, std::uint64_t mul) noexcept {
+            std::uint64_t a = (u ^ v) * mul;
+            a ^= (a >> 47);
+            std::uint64_t b = (v ^ a) * mul;
+            b ^= (b >> 47);
+            return b * mul;
+         }
+
+         static inline std::uint64_t hash_len_0_to_16(const std::uint8_t* s, std::size_t len) noexcept {
+            if (len >= 8) {
+               std::uint64_t mul = k2 + len * 2;
+               std::uint64_t a   = fetch64(s) + k2;
+               std::uint64_t b   = fetch64(s + len - 8);
+               std::uint64_t c   = std::rotr(b, 37) * mul + a;
+               std::uint64_t d   = (std::rotr(a, 25) + b) * mul;
+               return hash_len_16(c, d, mul);
+            }
+            if (len >= 4) {
+               std::uint64_t mul = k2 + len * 2;
+               std::uint64_t a   = fetch32(s);
+               return hash_len_16(len + (a << 3), fetch32(s + len - 4), mul);
+            }
+            if (len > 0) {
+               std::uint8_t  a = s[0];
+               std::uint8_t  b = s[len >> 1];
+               std::uint8_t  c = s[len - 1];
+               std::uint32_t y = static_cast<std::uint32_t>(a) + (static_cast<std::uint32_t>(b) << 8);
+               std::uint32_t z = static_cast<std::uint32_t>(len) + (static_cast<std::uint32_t>(c) << 2);
+               return shift_mix(y * k2 ^ z * k0) * k2;
+            }
+            return k2;
+         }
+
+         static inline std::uint64_t hash_len_17_to_32(const std::uint8_t* s, std::size_t len) noexcept {
+            std::uint64_t mul = k2 + len * 2;
+            std::uint64_t a   = fetch64(s) * k1;
+            std::uint64_t b   = fetch64(s + 8);
+            std::uint64_t c   = fetch64(s + len - 8) * mul;
+            std::uint64_t d   = fetch64(s + len - 16) * k2;
+            return hash_len_16(std::rotr(a + b, 43) + std::rotr(c, 30) + d, a + std::rotr(b + k2, 18) + c, mul);
+         }
+
+         static inline std::pair<std::uint64_t, std::uint64_t> weak_hash_len_32_with_seeds(std::uint64_t w, std::uint64_t x, std::uint64_t y,
+                                                                                          std::uint64_t z, std::uint64_t a, std::uint64_t b) noexcept {
+            a += w;
+            b = std::rotr(b + a + z, 21);
+            std::uint64_t c = a;
+            a += x;
+            a += y;
+            b += std::rotr(a, 44);
+            return {a + z, b + c};
+         }
+
+         static inline std::pair<std::uint64_t, std::uint64_t> weak_hash_len_32_with_seeds(const std::uint8_t* s, std::uint64_t a, std::uint64_t b) noexcept {
+            return weak_hash_len_32_with_seeds(fetch64(s), fetch64(s + 8), fetch64(s + 16), fetch64(s + 24), a, b);
+         }
+
+         static inline std::uint64_t hash_len_33_to_64(const std::uint8_t* s, std::size_t len) noexcept {
+            std::uint64_t mul = k2 + len * 2;
+            std::uint64_t a   = fetch64(s) * k2;
+            std::uint64_t b   = fetch64(s + 8);
+            std::uint64_t c   = fetch64(s + len - 24);
+            std::uint64_t d   = fetch64(s + len - 32);
+            std::uint64_t e   = fetch64(s + 16) * k2;
+            std::uint64_t f   = fetch64(s + 24) * 9;
+            std::uint64_t g   = fetch64(s + len - 8);
+            std::uint64_t h   = fetch64(s + len - 16) * mul;
+            std::uint64_t u   = std::rotr(a + g, 43) + (std::rotr(b, 30) + c) * 9;
+            std::uint64_t v   = ((a + g) ^ d) + f + 1;
+            std::uint64_t w   = util::bswap64((u + v) * mul) + h;
+            std::uint64_t x   = std::rotr(e + f, 42) + c;
+            std::uint64_t y   = (util::bswap64((v + w) * mul) + g) * mul;
+            std::uint64_t z   = e + f + c;
+            a = util::bswap64((x + z) * mul + y) + b;
+            b = shift_mix((z + a) * mul + d + h) * mul;
+            return b + x;
+         }
    };
 
-} // namespace astro::cryptid
+   /**
+    * @brief Hashers usable by the cryptid filters and sketches.
+    */
+   template <typename H>
+   concept hasher_type = requires(const void* p, std::size_t n) {
+      { H::hash64(p, n) } -> std::convertible_to<std::uint64_t>;
+   };
 
-#if 0
-#pragma once
-#include <cstdint>
-#include "uint128.hpp" // Assuming this header contains definitions for uint128_t type
+   /**
+    * @brief Hashes any key supported by the hasher, the common entry point for the filters and sketches.
+    */
+   template <hasher_type Hasher, typename K>
+   static inline std::uint64_t hash_key(const K& key) noexcept {
+      if constexpr (requires { Hasher::hash64(key); })
+         return Hasher::hash64(key);
+      else if constexpr (hashable_range_type<K>)
+         return Hasher::hash64(key.data(), key.size() * sizeof(*key.data()));
+      else
+         return Hasher::hash64(&key, sizeof(K));
+   }
+
+   /**
+    * @brief Maps a 32-bit value uniformly onto [0, n) without a division (Lemire's fast range).
+    */
+   constexpr static inline std::uint32_t fast_range32(std::uint32_t x, std::uint32_t n) noexcept {
+      return static_cast<std::uint32_t>((static_cast<std::uint64_t>(x) * n) >> 32);
+   }
+
+   /**
+    * @brief Maps a 64-bit value uniformly onto [0, n) without a division.
+    */
+   constexpr static inline std::uint64_t fast_range64(std::uint64_t x, std::uint64_t n) noexcept {
+      return mul_64x64(x, n).high;
+   }
 
-namespace astro::cryptid {
-    template <>
-    struct city_hash {
-        constexpr static inline auto seed = 0x9e3779b9; // Seed value used in the CityHash algorithm
-        static uint64_t hash(T value) noexcept {
-            uint64_t data = value;
-            uint64_t hash1, hash2, hash3, hash4, hash5, hash6, hash7, hash8;
-
-            hash1 = city_hash::combine(city_hash::rotl32(data & 0xffffffff, 18), data >> 32);
-            hash2 = city_hash::combine(city_hash::rotl32((data >> 16) & 0xffffffff, 35), (data >> 48));
-            hash3 = city_hash::combine(city_hash::rotl32((data >> 32) & 0xffffffff, 13), data >> 16);
-            hash4 = city_hash::combine(city_hash::rotl32((data >> 48) & 0xffffffff, 42), (data >> 32));
-
-            hash5 = city_hash::mix32(hash1 ^ seed);
-            hash6 = city_hash::mix32(hash2 ^ seed);
-            hash7 = city_hash::mix32(hash3 ^ seed);
-            hash8 = city_hash::mix32(hash4 ^ seed);
-
-            return city_hash::finalize(city_hash::combine(hash5, hash6), city_hash::combine(hash7, hash8));
-        }
-
-    private:
-        constexpr static inline uint64_t rotate(uint64_t value, unsigned int count) noexcept {
-            return (value << count) | (value >> (64 - count));
-        }
-
-        constexpr static inline uint64_t combine(uint64_t a, uint64_t B) noexcept {
-            return rotate(A + B, 13) + rotate(B, 6);
-        }
-
-        constexpr static inline uint32_t mix32(uint32_t A, uint32_t B) noexcept {
-            return ((A << 13) | (A >> 19)) + ((B << 8) | (B >> 24));
-        }
-
-        constexpr static inline uint64_t finalize(uint64_t hash1, uint64_t hash2) noexcept {
-            hash1 ^= hash2;
-            hash2 += 0x9e3779b9; // Seed value used in the CityHash algorithm
-            hash1 = ((hash1 << 18) | (hash1 >> 46)) + ((hash2 << 5) | (hash2 >> 59));
-            hash2 ^= hash1;
-            return hash1 + hash2;
-        }
-    };
 } // namespace astro::cryptid
-#endif
\ No newline at end of file
@@ -0,0 +1,350 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#if defined(__AVX2__)
+   #include <immintrin.h>
+#endif
+
+#include "../utils/misc.hpp"
+#include "city_hash.hpp"
+#include "uint128.hpp"
+
+namespace astro::cryptid {
+
+   /**
+    * @brief Jump consistent hash (Lamping and Veach).
+    * @param key The key hash.
+    * @param buckets The number of buckets.
+    * @return A bucket in [0, buckets), only 1/n of the keys move when growing from n - 1 to n buckets.
+    */
+   constexpr static inline std::int32_t jump_hash(std::uint64_t key, std::int32_t buckets) noexcept {
+      std::int64_t b = -1, j = 0;
+      while (j < buckets) {
+         b   = j;
+         key = key * 2862933555777941757ull + 1;
+         j   = static_cast<std::int64_t>((b + 1) * (static_cast<double>(1ll << 31) / static_cast<double>((key >> 33) + 1)));
+      }
+      return static_cast<std::int32_t>(b);
+   }
+
+   /**
+    * @brief Jump consistent hash of any key supported by the hasher.
+    */
+   template <hasher_type Hasher = city_hash, typename K>
+   static inline std::int32_t jump_hash_key(const K& key, std::int32_t buckets) noexcept {
+      return jump_hash(hash_key<Hasher>(key), buckets);
+   }
+
+   namespace detail {
+      // murmur3 finalizer, the per-node score is mix64(key ^ node seed)
+      constexpr static inline std::uint64_t mix64(std::uint64_t x) noexcept {
+         x ^= x >> 33;
+         x *= 0xff51afd7ed558ccdull;
+         x ^= x >> 33;
+         x *= 0xc4ceb9fe1a85ec53ull;
+         x ^= x >> 33;
+         return x;
+      }
+
+#if defined(__AVX2__)
+      static inline __m256i mullo64(__m256i a, __m256i b) noexcept {
+         const __m256i lo    = _mm256_mul_epu32(a, b);
+         const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                                _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+         return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+      }
+
+      static inline __m256i mix64(__m256i x) noexcept {
+         x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+         x = mullo64(x, _mm256_set1_epi64x(static_cast<long long>(0xff51afd7ed558ccdull)));
+         x = _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+         x = mullo64(x, _mm256_set1_epi64x(static_cast<long long>(0xc4ceb9fe1a85ec53ull)));
+         return _mm256_xor_si256(x, _mm256_srli_epi64(x, 33));
+      }
+#endif
+   } // namespace detail
+
+   /**
+    * @brief Rendezvous (highest random weight) hashing over a set of nodes.
+    *
+    * Every node scores every key and the highest score wins, so adding a node only moves the keys it now wins. Node seeds are
+    * kept in a flat array and scored four at a time with AVX2.
+    */
+   template <hasher_type Hasher = city_hash>
+   class rendezvous_hash {
+      public:
+         rendezvous_hash() = default;
+
+         inline explicit rendezvous_hash(std::span<const uint128> nodes) {
+            for (const auto& n : nodes)
+               add(n);
+         }
+
+         inline void add(const uint128& node) {
+            _nodes.push_back(node);
+            _seeds.push_back(hash_key<Hasher>(node));
+         }
+
+         /**
+          * @brief Removes a node, the remaining nodes keep their keys.
+          * @return false if the node was not present.
+          */
+         inline bool remove(const uint128& node) {
+            auto it = std::find(_nodes.begin(), _nodes.end(), node);
+            if (it == _nodes.end())
+               return false;
+            const auto i = static_cast<std::size_t>(it - _nodes.begin());
+            _nodes.erase(it);
+            _seeds.erase(_seeds.begin() + static_cast<std::ptrdiff_t>(i));
+            return true;
+         }
+
+         template <typename K>
+         inline const uint128& route(const K& key) const {
+            return _nodes[route_index(hash_key<Hasher>(key))];
+         }
+
+         /**
+          * @brief The index of the winning node for a key hash, ties go to the lower index.
+          */
+         inline std::size_t route_index(std::uint64_t h) const {
+            util::check(!_seeds.empty(), "rendezvous_hash: no nodes");
+            std::size_t   best       = 0;
+            std::uint64_t best_score = 0;
+            std::size_t   i          = 0;
+#if defined(__AVX2__)
+            if (_seeds.size() >= 4) {
+               // unsigned compares by flipping the sign bit, lanes keep their first maximum
+               const __m256i sign = _mm256_set1_epi64x(static_cast<long long>(0x8000000000000000ull));
+               const __m256i key  = _mm256_set1_epi64x(static_cast<long long>(h));
+               const __m256i step = _mm256_set1_epi64x(4);
+               auto score = [&](std::size_t at) {
+                  const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_seeds.data() + at));
+                  return _mm256_xor_si256(detail::mix64(_mm256_xor_si256(s, key)), sign);
+               };
+               __m256i idx  = _mm256_setr_epi64x(0, 1, 2, 3);
+               __m256i maxi = idx;
+               __m256i maxv = score(0);
+               for (i = 4; i + 4 <= _seeds.size(); i += 4) {
+                  idx              = _mm256_add_epi64(idx, step);
+                  const __m256i sc = score(i);
+                  const __m256i gt = _mm256_cmpgt_epi64(sc, maxv);
+                  maxv             = _mm256_blendv_epi8(maxv, sc, gt);
+                  maxi             = _mm256_blendv_epi8(maxi, idx, gt);
+               }
+               alignas(32) std::uint64_t scores[4], indices[4];
+               _mm256_store_si256(reinterpret_cast<__m256i*>(scores), _mm256_xor_si256(maxv, sign));
+               _mm256_store_si256(reinterpret_cast<__m256i*>(indices), maxi);
+               best       = indices[0];
+               best_score = scores[0];
+               for (std::size_t l = 1; l < 4; ++l) {
+                  if (scores[l] > best_score || (scores[l] == best_score && indices[l] < best)) {
+                     best       = indices[l];
+                     best_score = scores[l];
+                  }
+               }
+            }
+#endif
+            for (; i < _seeds.size(); ++i) {
+               const auto sc = detail::mix64(_seeds[i] ^ h);
+               if (i == 0 || sc > best_score) {
+                  best       = i;
+                  best_score = sc;
+               }
+            }
+            return best;
+         }
+
+         /**
+          * @brief Ranks the nodes for a key, the first entries are the preferred replicas.
+          * @param key The key.
+          * @param out Receives the indices of the top out.size() nodes, best first.
+          */
+         template <typename K>
+         inline void rank(const K& key, std::span<std::size_t> out) const {
+            const std::uint64_t h = hash_key<Hasher>(key);
+            std::vector<std::size_t> order(_seeds.size());
+            std::iota(order.begin(), order.end(), std::size_t{0});
+            const std::size_t k = std::min(out.size(), order.size());
+            std::partial_sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(k), order.end(), [&](std::size_t a, std::size_t b) {
+               const auto sa = detail::mix64(_seeds[a] ^ h), sb = detail::mix64(_seeds[b] ^ h);
+               return sa > sb || (sa == sb && a < b);
+            });
+            std::copy_n(order.begin(), k, out.begin());
+         }
+
+         inline std::size_t size() const noexcept { return _nodes.size(); }
+         inline std::span<const uint128> nodes() const noexcept { return _nodes; }
+
+      private:
+         std::vector<uint128>       _nodes = {};
+         std::vector<std::uint64_t> _seeds = {};
+   };
+
+   /**
+    * @brief Consistent hash ring with bounded loads (Mirrokni, Thorup and Zadimoghaddam).
+    *
+    * Each node owns a number of virtual points on a 64-bit ring. A key goes to the first node clockwise from its hash whose
+    * load is below ceil((1 + epsilon) * average), which caps the hottest node while moving few keys when nodes change.
+    *
+    * Node indices are stable: a removed node leaves a tombstone in nodes() so the indices assign() already handed out keep
+    * naming the same node, and a node added again gets a fresh index.
+    */
+   template <hasher_type Hasher = city_hash>
+   class bounded_load_ring {
+      public:
+         constexpr static inline std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+         /**
+          * @brief Creates an empty ring.
+          * @param epsilon The allowed load above the average.
+          * @param vnodes The number of ring points per node.
+          */
+         explicit inline bounded_load_ring(double epsilon = 0.25, std::size_t vnodes = 100)
+            : _epsilon(epsilon), _vnodes(std::max<std::size_t>(vnodes, 1)) {
+            util::check(epsilon > 0, "bounded_load_ring: epsilon must be positive");
+         }
+
+         inline void add(const uint128& node) {
+            util::check(find(node) == npos, "bounded_load_ring: duplicate node");
+            _nodes.push_back(node);
+            _loads.push_back(0);
+            _alive.push_back(true);
+            ++_live;
+            rebuild();
+         }
+
+         /**
+          * @brief Removes a node, its keys must be reassigned by the caller. Releasing them afterwards is a no-op.
+          */
+         inline bool remove(const uint128& node) {
+            const std::size_t i = find(node);
+            if (i == npos)
+               return false;
+            _total    -= _loads[i];
+            _loads[i]  = 0;
+            _alive[i]  = false;
+            --_live;
+            rebuild();
+            return true;
+         }
+
+         /**
+          * @brief The node owning a key on the plain ring, ignoring loads.
+          */
+         template <typename K>
+         inline const uint128& lookup(const K& key) const {
+            util::check(_live != 0, "bounded_load_ring: no nodes");
+            return _nodes[_owners[successor(hash_key<Hasher>(key))]];
+         }
+
+         /**
+          * @brief Places a key on the first node clockwise with spare capacity and counts it against that node.
+          * @return The index of the node in nodes().
+          */
+         template <typename K>
+         inline std::size_t assign(const K& key) {
+            util::check(_live != 0, "bounded_load_ring: no nodes");
+            const std::uint64_t cap = capacity();
+            std::size_t         p   = successor(hash_key<Hasher>(key));
+            for (std::size_t n = 0; n < _points.size(); ++n, p = p + 1 == _points.size() ? 0 : p + 1) {
+               const auto owner = _owners[p];
+               if (_loads[owner] < cap) {
+                  ++_loads[owner];
+                  ++_total;
+                  return owner;
+               }
+            }
+            return npos; // unreachable, the capacity always leaves room for one more key
+         }
+
+         /**
+          * @brief Releases a key previously assigned to a node.
+          */
+         inline void release(std::size_t node) noexcept {
+            if (node < _loads.size() && _alive[node] && _loads[node] > 0) {
+               --_loads[node];
+               --_total;
+            }
+         }
+
+         /**
+          * @brief The per-node load cap for the next assignment.
+          */
+         inline std::uint64_t capacity() const noexcept {
+            if (_live == 0)
+               return 0;
+            return static_cast<std::uint64_t>(std::ceil((1.0 + _epsilon) * static_cast<double>(_total + 1) / static_cast<double>(_live)));
+         }
+
+         inline std::size_t size() const noexcept { return _live; }
+         inline std::uint64_t total_load() const noexcept { return _total; }
+
+         /**
+          * @brief Every node ever added, by index, including removed ones; see alive().
+          */
+         inline std::span<const uint128> nodes() const noexcept { return _nodes; }
+         inline bool alive(std::size_t node) const noexcept { return node < _alive.size() && _alive[node]; }
+         inline std::span<const std::uint64_t> loads() const noexcept { return _loads; }
+
+      private:
+         inline std::size_t find(const uint128& node) const noexcept {
+            for (std::size_t i = 0; i < _nodes.size(); ++i)
+               if (_alive[i] && _nodes[i] == node)
+                  return i;
+            return npos;
+         }
+
+         inline void rebuild() {
+            std::vector<std::pair<std::uint64_t, std::uint32_t>> pts;
+            pts.reserve(_live * _vnodes);
+            for (std::size_t n = 0; n < _nodes.size(); ++n) {
+               if (!_alive[n])
+                  continue;
+               const std::uint64_t seed = hash_key<Hasher>(_nodes[n]);
+               for (std::size_t v = 0; v < _vnodes; ++v)
+                  pts.emplace_back(city_hash::hash_len_16(seed, v), static_cast<std::uint32_t>(n));
+            }
+            std::sort(pts.begin(), pts.end());
+            _points.resize(pts.size());
+            _owners.resize(pts.size());
+            for (std::size_t i = 0; i < pts.size(); ++i) {
+               _points[i] = pts[i].first;
+               _owners[i] = pts[i].second;
+            }
+         }
+
+         // branch-free lower bound over the sorted ring points, wrapping past the last point
+         inline std::size_t successor(std::uint64_t h) const noexcept {
+            const std::uint64_t* base = _points.data();
+            std::size_t          len  = _points.size();
+            while (len > 1) {
+               const std::size_t half = len / 2;
+               base += (base[half] < h) ? half : 0;
+               len  -= half;
+            }
+            const std::size_t i = static_cast<std::size_t>(base - _points.data()) + (*base < h);
+            return i == _points.size() ? 0 : i;
+         }
+
+         double                     _epsilon;
+         std::size_t                _vnodes;
+         std::uint64_t              _total  = 0;
+         std::size_t                _live   = 0;
+         std::vector<uint128>       _nodes  = {};
+         std::vector<bool>          _alive  = {};
+         std::vector<std::uint64_t> _loads  = {};
+         std::vector<std::uint64_t> _points = {};
+         std::vector<std::uint32_t> _owners = {};
+   };
+
+} // namespace astro::cryptid
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <concepts>
+#include <limits>
+#include <span>
+#include <vector>
+
+#if defined(__AVX2__)
+   #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+   #include <emmintrin.h>
+#endif
+
+#include "../serial/alpha.hpp"
+#include "../utils/misc.hpp"
+#include "city_hash.hpp"
+
+namespace astro::cryptid {
+
+   namespace detail {
+      /**
+       * @brief Element-wise sum of two counter arrays into the first.
+       */
+      template <std::unsigned_integral C>
+      static inline void add_counters(C* dst, const C* src, std::size_t n) noexcept {
+         std::size_t i = 0;
+#if defined(__AVX2__)
+         if constexpr (sizeof(C) == 4 || sizeof(C) == 8) {
+            constexpr std::size_t lanes = 32 / sizeof(C);
+            for (; i + lanes <= n; i += lanes) {
+               const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+               const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+               const __m256i r = sizeof(C) == 4 ? _mm256_add_epi32(a, b) : _mm256_add_epi64(a, b);
+               _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), r);
+            }
+         }
+#elif defined(__SSE2__) || defined(_M_X64)
+         if constexpr (sizeof(C) == 4 || sizeof(C) == 8) {
+            constexpr std::size_t lanes = 16 / sizeof(C);
+            for (; i + lanes <= n; i += lanes) {
+               const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+               const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+               const __m128i r = sizeof(C) == 4 ? _mm_add_epi32(a, b) : _mm_add_epi64(a, b);
+               _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), r);
+            }
+         }
+#endif
+         for (; i < n; ++i)
+            dst[i] += src[i];
+      }
+   } // namespace detail
+
+   /**
+    * @brief Count-Min frequency sketch.
+    *
+    * Counters are laid out row by row, each row indexed by a Kirsch-Mitzenmacher combination of the two halves of one 64-bit
+    * hash. Estimates never undercount and overcount by at most epsilon * total with probability 1 - delta.
+    */
+   template <hasher_type Hasher = city_hash, std::unsigned_integral Counter = std::uint32_t>
+   class count_min_sketch {
+      public:
+         using counter_t = Counter;
+
+         /**
+          * @brief Sizes the sketch from its error bounds.
+          * @param epsilon The relative overcount bound.
+          * @param delta The probability of exceeding it.
+          */
+         explicit inline count_min_sketch(double epsilon = 0.001, double delta = 0.01)
+            : count_min_sketch(dims_t{static_cast<std::size_t>(std::ceil(std::exp(1.0) / std::clamp(epsilon, 1e-9, 1.0))),
+                                      static_cast<std::size_t>(std::ceil(std::log(1.0 / std::clamp(delta, 1e-12, 0.5))))}) {}
+
+         /**
+          * @brief Creates a sketch with explicit dimensions.
+          */
+         static inline count_min_sketch with_dimensions(std::size_t width, std::size_t depth) {
+            return count_min_sketch{dims_t{width, depth}};
+         }
+
+         template <typename K>
+         inline void insert(const K& key, counter_t n = 1) noexcept { insert_hash(hash_key<Hasher>(key), n); }
+
+         template <typename K>
+         inline counter_t estimate(const K& key) const noexcept { return estimate_hash(hash_key<Hasher>(key)); }
+
+         inline void insert_hash(std::uint64_t h, counter_t n = 1) noexcept {
+            for (std::size_t r = 0; r < _depth; ++r)
+               _counters[r * _width + column(h, r)] += n;
+            _total += n;
+         }
+
+         /**
+          * @brief Adds to a key using conservative update, raising each counter no further than the new estimate.
+          */
+         template <typename K>
+         inline void insert_conservative(const K& key, counter_t n = 1) noexcept {
+            const std::uint64_t h   = hash_key<Hasher>(key);
+            const counter_t     est = estimate_hash(h) + n;
+            for (std::size_t r = 0; r < _depth; ++r) {
+               auto& c = _counters[r * _width + column(h, r)];
+               c       = std::max(c, est);
+            }
+            _total += n;
+         }
+
+         inline counter_t estimate_hash(std::uint64_t h) const noexcept {
+            counter_t m = std::numeric_limits<counter_t>::max();
+            for (std::size_t r = 0; r < _depth; ++r)
+               m = std::min(m, _counters[r * _width + column(h, r)]);
+            return m;
+         }
+
+         /**
+          * @brief Adds the counts of another sketch with the same dimensions into this one.
+          */
+         inline void merge(const count_min_sketch& other) {
+            util::check(other._width == _width && other._depth == _depth, "count_min_sketch::merge: dimension mismatch");
+            detail::add_counters(_counters.data(), other._counters.data(), _counters.size());
+            _total += other._total;
+         }
+
+         inline void clear() noexcept {
+            std::fill(_counters.begin(), _counters.end(), counter_t{0});
+            _total = 0;
+         }
+
+         inline std::size_t width() const noexcept { return _width; }
+         inline std::size_t depth() const noexcept { return _depth; }
+         inline std::uint64_t total() const noexcept { return _total; }
+         inline std::size_t size_bytes() const noexcept { return _counters.size() * sizeof(counter_t); }
+         inline std::span<const counter_t> counters() const noexcept { return _counters; }
+
+         /**
+          * @brief Writes the sketch to an archive.
+          */
+         inline void write_to(serial::alpha& a) const {
+            const std::uint64_t hdr[3] = {_width, _depth, _total};
+            a.write(hdr, sizeof(hdr));
+            a.write(_counters.data(), size_bytes());
+         }
+
+         /**
+          * @brief Reads a sketch written by write_to.
+          */
+         static inline count_min_sketch read_from(serial::alpha& a) {
+            std::uint64_t hdr[3] = {};
+            a.read(hdr, sizeof(hdr));
+            util::check(hdr[0] > 0 && hdr[1] > 0 && hdr[1] <= a.remaining() / sizeof(counter_t) / hdr[0],
+                        "count_min_sketch: malformed input");
+            auto s = with_dimensions(hdr[0], hdr[1]);
+            a.read(s._counters.data(), s.size_bytes());
+            s._total = hdr[2];
+            return s;
+         }
+
+      private:
+         struct dims_t {
+            std::size_t width;
+            std::size_t depth;
+         };
+
+         explicit inline count_min_sketch(dims_t d)
+            : _width(std::max<std::size_t>(d.width, 1)), _depth(std::max<std::size_t>(d.depth, 1)), _counters(_width * _depth) {
+            util::check(_width <= std::numeric_limits<std::uint32_t>::max(), "count_min_sketch: width out of range");
+         }
+
+         inline std::size_t column(std::uint64_t h, std::size_t row) const noexcept {
+            const auto h1 = static_cast<std::uint32_t>(h);
+            const auto h2 = static_cast<std::uint32_t>(h >> 32);
+            return fast_range32(h1 + static_cast<std::uint32_t>(row) * h2, static_cast<std::uint32_t>(_width));
+         }
+
+         std::size_t            _width;
+         std::size_t            _depth;
+         std::vector<counter_t> _counters;
+         std::uint64_t          _total = 0;
+   };
+
+   template <typename T>
+   constexpr static inline bool is_count_min_sketch_v = false;
+
+   template <typename H, typename C>
+   constexpr static inline bool is_count_min_sketch_v<count_min_sketch<H, C>> = true;
+
+   template <typename T>
+   concept count_min_sketch_type = is_count_min_sketch_v<T>;
+
+} // namespace astro::cryptid
+
+namespace astro::serial {
+   template <typename H, typename C>
+   static inline void serialize(alpha& a, const cryptid::count_min_sketch<H, C>& s) {
+      s.write_to(a);
+   }
+
+   template <cryptid::count_min_sketch_type S>
+   static inline S deserialize(alpha& a) {
+      return S::read_from(a);
+   }
+} // namespace astro::serial
@@ -0,0 +1,337 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <bit>
+#include <span>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+   #include <emmintrin.h>
+#endif
+
+#include "../serial/alpha.hpp"
+#include "../utils/misc.hpp"
+#include "city_hash.hpp"
+
+namespace astro::cryptid {
+
+   /**
+    * @brief Cuckoo filter with four 16-bit fingerprints per bucket.
+    *
+    * A bucket is a single 64-bit word, so each of the two candidate buckets lies within one cache line. The alternate bucket
+    * is derived from the fingerprint alone (partial-key cuckoo hashing), which allows deletion and lets the two lines be
+    * fetched independently.
+    */
+   template <hasher_type Hasher = city_hash>
+   class cuckoo_filter {
+      public:
+         using bucket_t      = std::uint64_t;
+         using fingerprint_t = std::uint16_t;
+
+         constexpr static inline std::size_t slots_per_bucket = 4;
+         constexpr static inline std::size_t max_kicks        = 500;
+         constexpr static inline std::size_t batch_size       = 16;
+
+         cuckoo_filter() = default;
+
+         /**
+          * @brief Sizes the filter for a number of keys at a 95% load factor.
+          * @param capacity The expected number of keys.
+          */
+         explicit inline cuckoo_filter(std::size_t capacity)
+            : _buckets(buckets_for(capacity)), _mask(_buckets.size() - 1) {}
+
+         /**
+          * @brief Creates a filter with an explicit number of buckets (rounded up to a power of two).
+          */
+         static inline cuckoo_filter with_buckets(std::size_t nbuckets) {
+            cuckoo_filter f;
+            f._buckets.assign(std::bit_ceil(std::max<std::size_t>(nbuckets, 1)), 0);
+            f._mask = f._buckets.size() - 1;
+            return f;
+         }
+
+         /**
+          * @brief Inserts a key.
+          * @return false if the filter is full, in which case the key was not stored. The insert that fills it parks the
+          * fingerprint it could not place in a victim slot and still succeeds.
+          */
+         template <typename K>
+         inline bool insert(const K& key) noexcept { return insert_hash(hash_key<Hasher>(key)); }
+
+         template <typename K>
+         inline bool contains(const K& key) const noexcept { return contains_hash(hash_key<Hasher>(key)); }
+
+         /**
+          * @brief Removes one copy of a key, it must have been inserted before.
+          * @return true if a matching fingerprint was removed.
+          */
+         template <typename K>
+         inline bool erase(const K& key) noexcept { return erase_hash(hash_key<Hasher>(key)); }
+
+         inline bool insert_hash(std::uint64_t h) noexcept {
+            if (_victim_used)
+               return false;
+
+            auto        fp = fingerprint(h);
+            std::size_t i1 = index(h);
+            std::size_t i2 = alt_index(i1, fp);
+            if (try_put(i1, fp) || try_put(i2, fp)) {
+               ++_count;
+               return true;
+            }
+
+            std::size_t i = (next_random() & 1) ? i1 : i2;
+            for (std::size_t k = 0; k < max_kicks; ++k) {
+               const std::size_t slot = next_random() & (slots_per_bucket - 1);
+               const auto        old  = get(i, slot);
+               set(i, slot, fp);
+               fp = old;
+               i  = alt_index(i, fp);
+               if (try_put(i, fp)) {
+                  ++_count;
+                  return true;
+               }
+            }
+
+            _victim_used  = true;
+            _victim_index = i;
+            _victim_fp    = fp;
+            ++_count;
+            return true;
+         }
+
+         inline bool contains_hash(std::uint64_t h) const noexcept {
+            const auto        fp = fingerprint(h);
+            const std::size_t i1 = index(h);
+            const std::size_t i2 = alt_index(i1, fp);
+            if (_victim_used && _victim_fp == fp && (_victim_index == i1 || _victim_index == i2))
+               return true;
+            return match_either(_buckets[i1], _buckets[i2], fp);
+         }
+
+         inline bool erase_hash(std::uint64_t h) noexcept {
+            const auto        fp = fingerprint(h);
+            const std::size_t i1 = index(h);
+            const std::size_t i2 = alt_index(i1, fp);
+            if (_victim_used && _victim_fp == fp && (_victim_index == i1 || _victim_index == i2)) {
+               _victim_used = false;
+               --_count;
+               return true;
+            }
+            if (!try_remove(i1, fp) && !try_remove(i2, fp))
+               return false;
+            --_count;
+            if (_victim_used) {
+               // the freed slot gives the evicted fingerprint somewhere to go
+               _victim_used = false;
+               --_count;
+               insert_fingerprint(_victim_index, _victim_fp);
+            }
+            return true;
+         }
+
+         /**
+          * @brief Queries a batch of keys, prefetching both candidate buckets of each group before testing them.
+          * @param keys The keys to look up.
+          * @param out One result per key.
+          * @return The number of keys that may be present.
+          */
+         template <typename K>
+         inline std::size_t contains_n(std::span<const K> keys, std::span<bool> out) const noexcept {
+            std::uint64_t hashes[batch_size];
+            std::size_t   hits = 0;
+            for (std::size_t i = 0; i < keys.size(); i += batch_size) {
+               const std::size_t n = std::min(batch_size, keys.size() - i);
+               for (std::size_t j = 0; j < n; ++j) {
+                  hashes[j] = hash_key<Hasher>(keys[i + j]);
+                  prefetch(hashes[j]);
+               }
+               for (std::size_t j = 0; j < n; ++j) {
+                  out[i + j] = contains_hash(hashes[j]);
+                  hits      += out[i + j];
+               }
+            }
+            return hits;
+         }
+
+         /**
+          * @brief Queries a batch of precomputed hashes.
+          */
+         inline std::size_t contains_hash_n(std::span<const std::uint64_t> hashes, std::span<bool> out) const noexcept {
+            std::size_t hits = 0;
+            for (std::size_t i = 0; i < hashes.size(); i += batch_size) {
+               const std::size_t n = std::min(batch_size, hashes.size() - i);
+               for (std::size_t j = 0; j < n; ++j)
+                  prefetch(hashes[i + j]);
+               for (std::size_t j = 0; j < n; ++j) {
+                  out[i + j] = contains_hash(hashes[i + j]);
+                  hits      += out[i + j];
+               }
+            }
+            return hits;
+         }
+
+         inline void clear() noexcept {
+            std::fill(_buckets.begin(), _buckets.end(), bucket_t{0});
+            _count       = 0;
+            _victim_used = false;
+         }
+
+         inline std::size_t size() const noexcept { return _count; }
+         inline std::size_t bucket_count() const noexcept { return _buckets.size(); }
+         inline std::size_t capacity() const noexcept { return _buckets.size() * slots_per_bucket; }
+         inline double load_factor() const noexcept { return static_cast<double>(_count) / capacity(); }
+
+         inline std::span<const bucket_t> buckets() const noexcept { return _buckets; }
+
+         /**
+          * @brief Writes the table and the victim slot to an archive.
+          */
+         inline void write_to(serial::alpha& a) const {
+            const std::uint64_t hdr[4] = {_buckets.size(), _count, _victim_index,
+                                          (static_cast<std::uint64_t>(_victim_used) << 16) | _victim_fp};
+            a.write(hdr, sizeof(hdr));
+            a.write(_buckets.data(), _buckets.size() * sizeof(bucket_t));
+         }
+
+         /**
+          * @brief Reads a filter written by write_to.
+          */
+         static inline cuckoo_filter read_from(serial::alpha& a) {
+            std::uint64_t hdr[4] = {};
+            a.read(hdr, sizeof(hdr));
+            util::check(std::has_single_bit(hdr[0]) && hdr[0] <= a.remaining() / sizeof(bucket_t) && hdr[2] < hdr[0],
+                        "cuckoo_filter: malformed input");
+            auto f = with_buckets(hdr[0]);
+            a.read(f._buckets.data(), f._buckets.size() * sizeof(bucket_t));
+            f._count        = hdr[1];
+            f._victim_index = hdr[2];
+            f._victim_fp    = static_cast<fingerprint_t>(hdr[3]);
+            f._victim_used  = (hdr[3] >> 16) & 1;
+            return f;
+         }
+
+      private:
+         constexpr static inline bucket_t lanes_lo = 0x0001000100010001ull;
+         constexpr static inline bucket_t lanes_hi = 0x8000800080008000ull;
+
+         static inline std::size_t buckets_for(std::size_t capacity) noexcept {
+            const std::size_t n = (std::max<std::size_t>(capacity, 1) * 100 + 95 * slots_per_bucket - 1) / (95 * slots_per_bucket);
+            return std::bit_ceil(n);
+         }
+
+         constexpr static inline fingerprint_t fingerprint(std::uint64_t h) noexcept {
+            const auto fp = static_cast<fingerprint_t>(h);
+            return fp == 0 ? fingerprint_t{1} : fp;
+         }
+
+         inline std::size_t index(std::uint64_t h) const noexcept { return static_cast<std::size_t>(h >> 32) & _mask; }
+
+         inline std::size_t alt_index(std::size_t i, fingerprint_t fp) const noexcept {
+            return (i ^ static_cast<std::size_t>(fp * 0x5bd1e995u)) & _mask;
+         }
+
+         inline void prefetch(std::uint64_t h) const noexcept {
+            const std::size_t i1 = index(h);
+            ASTRO_PREFETCH(&_buckets[i1]);
+            ASTRO_PREFETCH(&_buckets[alt_index(i1, fingerprint(h))]);
+         }
+
+         constexpr static inline bool has_zero_lane(bucket_t x) noexcept {
+            return ((x - lanes_lo) & ~x & lanes_hi) != 0;
+         }
+
+         static inline bool match_either(bucket_t a, bucket_t b, fingerprint_t fp) noexcept {
+#if defined(__SSE2__) || defined(_M_X64)
+            const __m128i v = _mm_set_epi64x(static_cast<long long>(b), static_cast<long long>(a));
+            const __m128i f = _mm_set1_epi16(static_cast<short>(fp));
+            return _mm_movemask_epi8(_mm_cmpeq_epi16(v, f)) != 0;
+#else
+            const bucket_t f = lanes_lo * fp;
+            return has_zero_lane(a ^ f) || has_zero_lane(b ^ f);
+#endif
+         }
+
+         inline fingerprint_t get(std::size_t i, std::size_t slot) const noexcept {
+            return static_cast<fingerprint_t>(_buckets[i] >> (slot * 16));
+         }
+
+         inline void set(std::size_t i, std::size_t slot, fingerprint_t fp) noexcept {
+            const std::size_t shift = slot * 16;
+            _buckets[i] = (_buckets[i] & ~(bucket_t{0xffff} << shift)) | (static_cast<bucket_t>(fp) << shift);
+         }
+
+         inline bool try_put(std::size_t i, fingerprint_t fp) noexcept {
+            for (std::size_t s = 0; s < slots_per_bucket; ++s) {
+               if (get(i, s) == 0) {
+                  set(i, s, fp);
+                  return true;
+               }
+            }
+            return false;
+         }
+
+         inline bool try_remove(std::size_t i, fingerprint_t fp) noexcept {
+            for (std::size_t s = 0; s < slots_per_bucket; ++s) {
+               if (get(i, s) == fp) {
+                  set(i, s, 0);
+                  return true;
+               }
+            }
+            return false;
+         }
+
+         inline void insert_fingerprint(std::size_t i, fingerprint_t fp) noexcept {
+            if (try_put(i, fp) || try_put(alt_index(i, fp), fp)) {
+               ++_count;
+               return;
+            }
+            _victim_used  = true;
+            _victim_index = i;
+            _victim_fp    = fp;
+            ++_count;
+         }
+
+         inline std::uint64_t next_random() noexcept {
+            _rng ^= _rng << 13;
+            _rng ^= _rng >> 7;
+            _rng ^= _rng << 17;
+            return _rng;
+         }
+
+         std::vector<bucket_t> _buckets      = std::vector<bucket_t>(1);
+         std::size_t           _mask         = 0;
+         std::size_t           _count        = 0;
+         std::size_t           _victim_index = 0;
+         fingerprint_t         _victim_fp    = 0;
+         bool                  _victim_used  = false;
+         std::uint64_t         _rng          = 0x2545f4914f6cdd1dull;
+   };
+
+   template <typename T>
+   constexpr static inline bool is_cuckoo_filter_v = false;
+
+   template <typename H>
+   constexpr static inline bool is_cuckoo_filter_v<cuckoo_filter<H>> = true;
+
+   template <typename T>
+   concept cuckoo_filter_type = is_cuckoo_filter_v<T>;
+
+} // namespace astro::cryptid
+
+namespace astro::serial {
+   template <typename H>
+   static inline void serialize(alpha& a, const cryptid::cuckoo_filter<H>& f) {
+      f.write_to(a);
+   }
+
+   template <cryptid::cuckoo_filter_type F>
+   static inline F deserialize(alpha& a) {
+      return F::read_from(a);
+   }
+} // namespace astro::serial
@@ -0,0 +1,326 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <vector>
+
+#if defined(__AVX2__)
+   #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+   #include <emmintrin.h>
+#endif
+
+#include "../serial/alpha.hpp"
+#include "../utils/misc.hpp"
+#include "city_hash.hpp"
+
+namespace astro::cryptid {
+
+   namespace detail {
+      /**
+       * @brief Element-wise max of two register arrays into the first.
+       */
+      static inline void max_registers(std::uint8_t* dst, const std::uint8_t* src, std::size_t n) noexcept {
+         std::size_t i = 0;
+#if defined(__AVX2__)
+         for (; i + 32 <= n; i += 32) {
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+            const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_max_epu8(a, b));
+         }
+#elif defined(__SSE2__) || defined(_M_X64)
+         for (; i + 16 <= n; i += 16) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_max_epu8(a, b));
+         }
+#endif
+         for (; i < n; ++i)
+            dst[i] = std::max(dst[i], src[i]);
+      }
+   } // namespace detail
+
+   /**
+    * @brief HyperLogLog++ distinct counter.
+    *
+    * Small sets are kept as a sparse list of (index, rank) pairs at 25 bits of index precision and switch to a dense array of
+    * 2^p one-byte registers once the list would outgrow it. Estimates use Ertl's improved raw estimator, which covers the
+    * small and large ranges without empirical bias tables.
+    *
+    * Const members never modify the sketch, so any number of threads may read one concurrently; writes need exclusion.
+    */
+   template <hasher_type Hasher = city_hash>
+   class hyperloglog {
+      public:
+         constexpr static inline std::uint8_t min_precision    = 4;
+         constexpr static inline std::uint8_t max_precision    = 18;
+         constexpr static inline std::uint8_t sparse_precision = 25;
+
+         /**
+          * @brief Creates an empty sketch.
+          * @param precision The number of index bits, the standard error is about 1.04 / sqrt(2^precision).
+          */
+         explicit inline hyperloglog(std::uint8_t precision = 14)
+            : _p(precision) {
+            util::check(precision >= min_precision && precision <= max_precision, "hyperloglog: precision out of range");
+         }
+
+         template <typename K>
+         inline void insert(const K& key) { insert_hash(hash_key<Hasher>(key)); }
+
+         inline void insert_hash(std::uint64_t h) {
+            if (_sparse) {
+               _buffer.push_back(encode_sparse(h));
+               if (_buffer.size() >= buffer_limit())
+                  flush();
+               return;
+            }
+            const std::size_t idx  = h >> (64 - _p);
+            const auto        rank = rank_of(h << _p, 64 - _p);
+            _registers[idx]        = std::max(_registers[idx], rank);
+         }
+
+         /**
+          * @brief Combines another sketch of the same precision into this one.
+          */
+         inline void merge(const hyperloglog& other) {
+            util::check(other._p == _p, "hyperloglog::merge: precision mismatch");
+            if (other._sparse) {
+               const auto entries = other.sparse_entries();
+               if (_sparse) {
+                  _buffer.insert(_buffer.end(), entries.begin(), entries.end());
+                  flush();
+               } else {
+                  for (auto e : entries)
+                     apply_sparse(e);
+               }
+               return;
+            }
+            if (_sparse)
+               to_dense();
+            detail::max_registers(_registers.data(), other._registers.data(), _registers.size());
+         }
+
+         /**
+          * @brief Estimates the number of distinct keys inserted.
+          */
+         inline double estimate() const {
+            if (_sparse) {
+               // linear counting over the 2^25 sparse registers
+               const double m = static_cast<double>(std::uint64_t{1} << sparse_precision);
+               const double n = static_cast<double>(_buffer.empty() ? _list.size() : sparse_entries().size());
+               return m * std::log(m / (m - n));
+            }
+
+            const std::size_t q = 64 - _p;
+            std::uint32_t     hist[66] = {};
+            for (auto r : _registers)
+               ++hist[r];
+
+            const double m = static_cast<double>(_registers.size());
+            double       z = m * tau(1.0 - hist[q + 1] / m);
+            for (std::size_t k = q; k >= 1; --k)
+               z = 0.5 * (z + hist[k]);
+            z += m * sigma(hist[0] / m);
+            return (0.5 / std::log(2.0)) * m * m / z;
+         }
+
+         inline std::uint64_t count() const { return static_cast<std::uint64_t>(std::llround(estimate())); }
+
+         inline void clear() {
+            _sparse = true;
+            _list.clear();
+            _buffer.clear();
+            _registers.clear();
+         }
+
+         inline std::uint8_t precision() const noexcept { return _p; }
+         inline bool is_sparse() const noexcept { return _sparse; }
+         inline std::size_t size_bytes() const noexcept {
+            return _sparse ? (_list.size() + _buffer.size()) * sizeof(std::uint32_t) : _registers.size();
+         }
+
+         /**
+          * @brief The dense registers, forcing the dense representation.
+          */
+         inline std::span<const std::uint8_t> registers() {
+            if (_sparse)
+               to_dense();
+            return _registers;
+         }
+
+         /**
+          * @brief Writes the sketch to an archive in its current representation.
+          */
+         inline void write_to(serial::alpha& a) const {
+            const auto          entries = _sparse ? sparse_entries() : std::vector<std::uint32_t>{};
+            const std::uint8_t  hdr[2]  = {_p, static_cast<std::uint8_t>(_sparse)};
+            const std::uint64_t n       = _sparse ? entries.size() : _registers.size();
+            a.write(hdr, sizeof(hdr));
+            a.write(&n, sizeof(n));
+            if (_sparse)
+               a.write(entries.data(), n * sizeof(std::uint32_t));
+            else
+               a.write(_registers.data(), n);
+         }
+
+         /**
+          * @brief Reads a sketch written by write_to.
+          */
+         static inline hyperloglog read_from(serial::alpha& a) {
+            std::uint8_t  hdr[2] = {};
+            std::uint64_t n      = 0;
+            a.read(hdr, sizeof(hdr));
+            a.read(&n, sizeof(n));
+            hyperloglog h{hdr[0]};
+            h._sparse = hdr[1] != 0;
+            const std::size_t width = h._sparse ? sizeof(std::uint32_t) : 1;
+            util::check(n <= a.remaining() / width && (h._sparse || n == (std::size_t{1} << h._p)),
+                        "hyperloglog: malformed input");
+            if (h._sparse) {
+               h._list.resize(n);
+               a.read(h._list.data(), n * sizeof(std::uint32_t));
+            } else {
+               h._registers.resize(n);
+               a.read(h._registers.data(), n);
+            }
+            return h;
+         }
+
+      private:
+         // a sparse entry is the 25-bit index above a 6-bit rank taken from the remaining 39 bits
+         constexpr static inline std::uint32_t rank_bits = 6;
+
+         constexpr static inline std::uint8_t rank_of(std::uint64_t w, std::size_t bits) noexcept {
+            return static_cast<std::uint8_t>(std::min<std::size_t>(std::countl_zero(w), bits) + 1);
+         }
+
+         constexpr static inline std::uint32_t encode_sparse(std::uint64_t h) noexcept {
+            const auto idx  = static_cast<std::uint32_t>(h >> (64 - sparse_precision));
+            const auto rank = rank_of(h << sparse_precision, 64 - sparse_precision);
+            return (idx << rank_bits) | rank;
+         }
+
+         inline std::size_t buffer_limit() const noexcept { return std::max<std::size_t>((std::size_t{1} << _p) / 16, 64); }
+
+         inline void apply_sparse(std::uint32_t e) {
+            const std::uint32_t sidx  = e >> rank_bits;
+            const std::uint32_t srank = e & ((1u << rank_bits) - 1);
+            const std::size_t   shift = sparse_precision - _p;
+            const std::size_t   idx   = sidx >> shift;
+            const std::uint32_t low   = sidx & ((1u << shift) - 1);
+            // the bits between p and 25 came from the hash, so the dense rank is either found there or continues into srank
+            const auto rank = low != 0 ? static_cast<std::uint8_t>(std::countl_zero(low) - (32 - shift) + 1)
+                                       : static_cast<std::uint8_t>(shift + srank);
+            _registers[idx] = std::max(_registers[idx], rank);
+         }
+
+         /**
+          * @brief The sorted list with the insert buffer folded in, one entry per index holding its highest rank.
+          */
+         inline std::vector<std::uint32_t> sparse_entries() const {
+            if (_buffer.empty())
+               return _list;
+            auto by_index = [](std::uint32_t a, std::uint32_t b) { return (a >> rank_bits) < (b >> rank_bits); };
+            std::vector<std::uint32_t> pending = _buffer;
+            std::sort(pending.begin(), pending.end());
+            std::vector<std::uint32_t> merged;
+            merged.reserve(_list.size() + pending.size());
+            std::merge(_list.begin(), _list.end(), pending.begin(), pending.end(), std::back_inserter(merged));
+            // entries sort by index then rank, so the last entry of each index holds the max rank
+            std::size_t out = 0;
+            for (std::size_t i = 0; i < merged.size(); ++i) {
+               if (i + 1 < merged.size() && !by_index(merged[i], merged[i + 1]))
+                  continue;
+               merged[out++] = merged[i];
+            }
+            merged.resize(out);
+            return merged;
+         }
+
+         // may switch the sketch to dense, callers must check _sparse again afterwards
+         inline void flush() {
+            if (_buffer.empty())
+               return;
+            _list = sparse_entries();
+            _buffer.clear();
+            if (_list.size() * sizeof(std::uint32_t) >= (std::size_t{1} << _p))
+               to_dense();
+         }
+
+         inline void to_dense() {
+            _registers.assign(std::size_t{1} << _p, 0);
+            _sparse = false;
+            for (auto e : _list)
+               apply_sparse(e);
+            for (auto e : _buffer)
+               apply_sparse(e);
+            _list.clear();
+            _list.shrink_to_fit();
+            _buffer.clear();
+            _buffer.shrink_to_fit();
+         }
+
+         static inline double sigma(double x) noexcept {
+            if (x == 1.0)
+               return std::numeric_limits<double>::infinity();
+            double y = 1.0, z = x, prev;
+            do {
+               x   *= x;
+               prev = z;
+               z   += x * y;
+               y   += y;
+            } while (z != prev);
+            return z;
+         }
+
+         static inline double tau(double x) noexcept {
+            if (x == 0.0 || x == 1.0)
+               return 0.0;
+            double y = 1.0, z = 1.0 - x, prev;
+            do {
+               x    = std::sqrt(x);
+               prev = z;
+               y   *= 0.5;
+               z   -= (1.0 - x) * (1.0 - x) * y;
+            } while (z != prev);
+            return z / 3.0;
+         }
+
+         std::uint8_t               _p;
+         bool                       _sparse    = true;
+         std::vector<std::uint32_t> _list      = {};
+         std::vector<std::uint32_t> _buffer    = {};
+         std::vector<std::uint8_t>  _registers = {};
+   };
+
+   template <typename T>
+   constexpr static inline bool is_hyperloglog_v = false;
+
+   template <typename H>
+   constexpr static inline bool is_hyperloglog_v<hyperloglog<H>> = true;
+
+   template <typename T>
+   concept hyperloglog_type = is_hyperloglog_v<T>;
+
+} // namespace astro::cryptid
+
+namespace astro::serial {
+   template <typename H>
+   static inline void serialize(alpha& a, const cryptid::hyperloglog<H>& h) {
+      h.write_to(a);
+   }
+
+   template <cryptid::hyperloglog_type H>
+   static inline H deserialize(alpha& a) {
+      return H::read_from(a);
+   }
+} // namespace astro::serial
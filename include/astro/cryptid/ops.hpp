@@ -3,6 +3,11 @@
 #include <cstdint>
 
 #include <compare>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+   #include <intrin.h>
+#endif
 
 namespace astro::cryptid {
    struct m64 {
@@ -52,5 +57,52 @@ namespace astro::cryptid {
          m64 high = sub_m64(a.high, b.high);
          return {low, high};
       }
+
+      constexpr static inline m128 mul_64x64(uint64_t a, uint64_t b) noexcept {
+         #if defined(__SIZEOF_INT128__)
+            if (!std::is_constant_evaluated()) {
+               unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+               return {static_cast<uint64_t>(r), static_cast<uint64_t>(r >> 64)};
+            }
+         #endif
+         uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+         uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+         uint64_t lo_lo = a_lo * b_lo;
+         uint64_t hi_lo = a_hi * b_lo;
+         uint64_t lo_hi = a_lo * b_hi;
+         uint64_t hi_hi = a_hi * b_hi;
+         uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+         return {(cross << 32) | (lo_lo & 0xFFFFFFFF), hi_hi + (hi_lo >> 32) + (cross >> 32)};
+      }
+
+      /**
+       * @brief Divides the 128-bit value high:low by d, requires high < d so the quotient fits in 64 bits.
+       */
+      constexpr static inline uint64_t div_128_64(uint64_t high, uint64_t low, uint64_t d, uint64_t& rem) noexcept {
+         if (!std::is_constant_evaluated()) {
+            #if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+               uint64_t q;
+               __asm__("divq %[d]" : "=a"(q), "=d"(rem) : [d] "r"(d), "a"(low), "d"(high));
+               return q;
+            #elif defined(_MSC_VER) && defined(_M_X64)
+               return _udiv128(high, low, d, &rem);
+            #elif defined(__SIZEOF_INT128__)
+               unsigned __int128 n = (static_cast<unsigned __int128>(high) << 64) | low;
+               rem = static_cast<uint64_t>(n % d);
+               return static_cast<uint64_t>(n / d);
+            #endif
+         }
+         uint64_t q = 0;
+         for (int i = 63; i >= 0; --i) {
+            const bool carry = high >> 63;
+            high = (high << 1) | ((low >> i) & 1);
+            if (carry || high >= d) {
+               high -= d;
+               q    |= uint64_t{1} << i;
+            }
+         }
+         rem = high;
+         return q;
+      }
    }
 } // namespace astro::cryptid
\ No newline at end of file
@@ -1,9 +1,22 @@
 #pragma once
 
+#include <cstring>
+
+#include <algorithm>
 #include <array>
 #include <bit>
-#include <iomanip>
-#include <sstream>
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if __has_include(<format>)
+   #include <format>
+#endif
+
+#if defined(__SSSE3__)
+   #include <tmmintrin.h>
+#endif
 
 //#include "../utils.hpp"
 
@@ -83,7 +96,13 @@ namespace astro::cryptid {
          constexpr inline std::uint64_t* data() noexcept { return &_value.low; }
          constexpr inline const std::uint64_t* data() const noexcept { return &_value.low; }
 
-         auto operator<=>(const uint128&) const noexcept = default;
+         constexpr inline bool operator==(const uint128&) const noexcept = default;
+
+         constexpr inline std::strong_ordering operator<=>(const uint128& other) const noexcept {
+            if (_value.high != other._value.high)
+               return _value.high <=> other._value.high;
+            return _value.low <=> other._value.low;
+         }
 
          constexpr inline uint128& operator+=(const uint128& other) noexcept {
             _value = add_m128(_value, other._value);
@@ -121,85 +140,167 @@ namespace astro::cryptid {
             return {sub_m128(_value, {other, 0})};
          }
 
-         constexpr inline uint128 operator*=(const uint128& other) noexcept {
-            uint64_t cross1 = _value.high * other._value.low;
-            uint64_t cross2 = _value.low * other._value.high;
-
-            _value.low *= other._value.low;
-            _value.high *= other._value.high;
-            _value.high += (cross1 >> 32) + (cross2 >> 32);
-
-            uint64_t carry = (cross1 & 0xFFFFFFFF) + (cross2 & 0xFFFFFFFF);
-            if (carry >> 32) {
-               _value.high += carry >> 32;
-            }
-
+         constexpr inline uint128& operator*=(const uint128& other) noexcept {
+            m128 r  = mul_64x64(_value.low, other._value.low);
+            r.high += _value.low * other._value.high + _value.high * other._value.low;
+            _value  = r;
             return *this;
          }
 
-         constexpr inline uint128 operator*=(uint64_t other) noexcept {
-            uint64_t cross1 = _value.high * other;
-
-            _value.low *= other;
-            _value.high += (cross1 >> 32);
-
-            uint64_t carry = (cross1 & 0xFFFFFFFF);
-            if (carry >> 32) {
-               _value.high += carry >> 32;
-            }
-
+         constexpr inline uint128& operator*=(uint64_t other) noexcept {
+            m128 r  = mul_64x64(_value.low, other);
+            r.high += _value.high * other;
+            _value  = r;
             return *this;
          }
 
-
          constexpr inline uint128 operator*(const uint128& other) const noexcept {
             uint128 result = *this;
             result *= other;
             return result;
          }
 
-         constexpr inline uint128 operator/=(const uint128& other) {
-            if (other == uint128{0,0}) {
-               throw std::runtime_error("Division by zero");
-            }
+         constexpr inline uint128 operator*(uint64_t other) const noexcept {
+            uint128 result = *this;
+            result *= other;
+            return result;
+         }
 
-            uint128 quotient = {0, 0};
-            uint128 remainder = {0, 0};
-            uint128 dividend = *this;
-
-            for (int i = 127; i >= 0; --i) {
-               remainder._value.high = (remainder._value.high << 1) | (remainder._value.low >> 63);
-               remainder._value.low = (remainder._value.low << 1) | ((dividend._value.high >> i) & 1);
-               if (remainder._value.high > other._value.high || (remainder._value.high == other._value.high && remainder._value.low >= other._value.low)) {
-                  remainder -= other;
-                  if (i >= 64) {
-                     quotient._value.high |= 1ull << (i - 64);
-                  } else {
-                     quotient._value.low |= 1ull << i;
-                  }
-               }
-            }
+         constexpr inline uint128& operator/=(const uint128& other) {
+            uint128 rem;
+            *this = divmod(*this, other, rem);
+            return *this;
+         }
+
+         constexpr inline uint128 operator/(const uint128& other) const {
+            uint128 rem;
+            return divmod(*this, other, rem);
+         }
 
-            *this = quotient;
+         constexpr inline uint128& operator%=(const uint128& other) {
+            divmod(*this, other, *this);
             return *this;
          }
 
+         constexpr inline uint128 operator%(const uint128& other) const {
+            uint128 rem;
+            divmod(*this, other, rem);
+            return rem;
+         }
 
-         constexpr inline uint128 operator/(const uint128& other) const noexcept {
-            uint128 result = *this;
-            result /= other;
-            return result;
+         constexpr inline uint128 operator<<(unsigned n) const noexcept {
+            if (n >= 128)
+               return {0, 0};
+            if (n >= 64)
+               return {0, _value.low << (n - 64)};
+            if (n == 0)
+               return *this;
+            return {_value.low << n, (_value.high << n) | (_value.low >> (64 - n))};
+         }
+
+         constexpr inline uint128 operator>>(unsigned n) const noexcept {
+            if (n >= 128)
+               return {0, 0};
+            if (n >= 64)
+               return {_value.high >> (n - 64), 0};
+            if (n == 0)
+               return *this;
+            return {(_value.low >> n) | (_value.high << (64 - n)), _value.high >> n};
+         }
+
+         constexpr inline uint128& operator<<=(unsigned n) noexcept { return *this = *this << n; }
+         constexpr inline uint128& operator>>=(unsigned n) noexcept { return *this = *this >> n; }
+
+         constexpr inline uint128 operator&(const uint128& o) const noexcept { return {_value.low & o._value.low, _value.high & o._value.high}; }
+         constexpr inline uint128 operator|(const uint128& o) const noexcept { return {_value.low | o._value.low, _value.high | o._value.high}; }
+         constexpr inline uint128 operator^(const uint128& o) const noexcept { return {_value.low ^ o._value.low, _value.high ^ o._value.high}; }
+
+         constexpr inline int countl_zero() const noexcept {
+            return _value.high != 0 ? std::countl_zero(_value.high) : 64 + std::countl_zero(_value.low);
          }
 
-         constexpr inline uint128 operator%(const uint128& other) const noexcept {
-            return { _value.low % other._value.low, _value.high % other._value.high };
+         /**
+          * @brief Divides by a 64-bit divisor.
+          * @param n The dividend.
+          * @param d The divisor, must not be zero.
+          * @param rem Receives the remainder.
+          * @return The quotient.
+          */
+         constexpr static inline uint128 divmod(const uint128& n, std::uint64_t d, std::uint64_t& rem) noexcept {
+            const std::uint64_t qh = n._value.high / d;
+            const std::uint64_t ql = div_128_64(n._value.high % d, n._value.low, d, rem);
+            return {ql, qh};
          }
 
-         std::string to_string() const noexcept {
-            std::ostringstream oss;
-            oss << "0x" << std::hex << std::setw(16) << std::setfill('0') << _value.high 
-                << std::setw(16) << std::setfill('0') << _value.low;
-            return oss.str();
+         /**
+          * @brief Divides by a 128-bit divisor.
+          * @param n The dividend.
+          * @param d The divisor.
+          * @param rem Receives the remainder.
+          * @return The quotient.
+          */
+         constexpr static inline uint128 divmod(uint128 n, const uint128& d, uint128& rem) {
+            if (d == uint128{0, 0})
+               throw std::runtime_error("Division by zero");
+            if (d._value.high == 0) {
+               std::uint64_t r = 0;
+               const auto    q = divmod(n, d._value.low, r);
+               rem = {r, 0};
+               return q;
+            }
+            if (n < d) {
+               rem = n;
+               return {0, 0};
+            }
+            // the quotient is below 2^64 here, so at most 64 shift-subtract steps
+            const int shift = d.countl_zero() - n.countl_zero();
+            uint128   dd    = d << static_cast<unsigned>(shift);
+            uint64_t  q     = 0;
+            for (int i = shift; i >= 0; --i) {
+               q <<= 1;
+               if (n >= dd) {
+                  n -= dd;
+                  q |= 1;
+               }
+               dd >>= 1;
+            }
+            rem = n;
+            return {q, 0};
+         }
+
+         /**
+          * @brief Formats as "0x" followed by all 32 hex digits.
+          */
+         std::string to_string() const {
+            std::string s(34, '0');
+            s[1] = 'x';
+            to_hex32(s.data() + 2, false);
+            return s;
+         }
+
+         /**
+          * @brief Writes all 32 hex digits, most significant first.
+          */
+         constexpr inline void to_hex32(char* out, bool upper) const noexcept {
+#if defined(__SSSE3__)
+            if (!std::is_constant_evaluated()) {
+               const __m128i v    = _mm_shuffle_epi8(_mm_set_epi64x(static_cast<long long>(_value.high), static_cast<long long>(_value.low)),
+                                                     _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+               const __m128i mask = _mm_set1_epi8(0x0f);
+               const __m128i lut  = upper ? _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F')
+                                          : _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+               const __m128i hi   = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+               const __m128i lo   = _mm_shuffle_epi8(lut, _mm_and_si128(v, mask));
+               _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(hi, lo));
+               _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16), _mm_unpackhi_epi8(hi, lo));
+               return;
+            }
+#endif
+            const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+            for (int i = 0; i < 16; ++i) {
+               out[i]      = digits[(_value.high >> (60 - 4 * i)) & 0xf];
+               out[i + 16] = digits[(_value.low >> (60 - 4 * i)) & 0xf];
+            }
          }
 
       private:
@@ -207,37 +308,180 @@ namespace astro::cryptid {
    }; 
 
    using uint128_t = uint128;
+
+   namespace detail {
+      constexpr static inline char digit_pairs[201] =
+         "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+         "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+         "8081828384858687888990919293949596979899";
+
+      constexpr static inline std::uint64_t pow10_19 = 10000000000000000000ull;
+
+      // writes exactly 19 digits, zero padded
+      constexpr static inline void write_19_digits(char* out, std::uint64_t v) noexcept {
+         for (int i = 17; i >= 1; i -= 2) {
+            const auto d = (v % 100) * 2;
+            v           /= 100;
+            out[i]       = digit_pairs[d];
+            out[i + 1]   = digit_pairs[d + 1];
+         }
+         out[0] = static_cast<char>('0' + v);
+      }
+
+      constexpr static inline int hex_value(char c) noexcept {
+         if (c >= '0' && c <= '9')
+            return c - '0';
+         if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+         if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+         return -1;
+      }
+
+      // v = v * m + a, returns false on overflow and leaves v unspecified
+      constexpr static inline bool mul_add(uint128& v, std::uint64_t m, std::uint64_t a) noexcept {
+         const m128 lo = mul_64x64(v.low(), m);
+         const m128 hi = mul_64x64(v.high(), m);
+         if (hi.high != 0)
+            return false;
+         const std::uint64_t high = lo.high + hi.low;
+         if (high < lo.high)
+            return false;
+         const std::uint64_t low = lo.low + a;
+         const std::uint64_t top = high + (low < lo.low);
+         if (top < high)
+            return false;
+         v = uint128{low, top};
+         return true;
+      }
+   } // namespace detail
+
+   /**
+    * @brief Formats a uint128 in base 10 or 16, following std::to_chars.
+    * @return errc::value_too_large if the buffer is too small, errc::invalid_argument for other bases.
+    */
+   constexpr static inline std::to_chars_result to_chars(char* first, char* last, const uint128& v, int base = 10) noexcept {
+      if (base == 16) {
+         const int ndigits = v == uint128{0, 0} ? 1 : (128 - v.countl_zero() + 3) / 4;
+         if (last - first < ndigits)
+            return {last, std::errc::value_too_large};
+         char buf[32];
+         v.to_hex32(buf, false);
+         for (int i = 0; i < ndigits; ++i)
+            first[i] = buf[32 - ndigits + i];
+         return {first + ndigits, std::errc{}};
+      }
+      if (base != 10)
+         return {first, std::errc::invalid_argument};
+
+      // split into at most three base 10^19 limbs, the top one is below 10^19
+      std::uint64_t limbs[3] = {};
+      int           n        = 0;
+      uint128       q        = v;
+      while (q.high() != 0) {
+         q = uint128::divmod(q, detail::pow10_19, limbs[n++]);
+      }
+      std::uint64_t top = q.low();
+      if (top >= detail::pow10_19) {
+         limbs[n++] = top % detail::pow10_19;
+         top       /= detail::pow10_19;
+      }
+
+      char  head[20];
+      char* head_end = head;
+      if (top == 0 && n == 0) {
+         *head_end++ = '0';
+      } else if (top != 0) {
+         char tmp[20];
+         int  len = 0;
+         for (; top != 0; top /= 10)
+            tmp[len++] = static_cast<char>('0' + top % 10);
+         while (len > 0)
+            *head_end++ = tmp[--len];
+      }
+
+      const auto total = static_cast<std::ptrdiff_t>((head_end - head) + n * 19);
+      if (last - first < total)
+         return {last, std::errc::value_too_large};
+      char* out = first;
+      for (const char* h = head; h != head_end; ++h)
+         *out++ = *h;
+      while (n > 0) {
+         detail::write_19_digits(out, limbs[--n]);
+         out += 19;
+      }
+      return {out, std::errc{}};
+   }
+
+   /**
+    * @brief Parses a uint128 in base 10 or 16, following std::from_chars (no sign or prefix).
+    * @return errc::result_out_of_range if the value does not fit, errc::invalid_argument if there are no digits.
+    */
+   constexpr static inline std::from_chars_result from_chars(const char* first, const char* last, uint128& v, int base = 10) noexcept {
+      if (base != 10 && base != 16)
+         return {first, std::errc::invalid_argument};
+
+      const char* p = first;
+      uint128     r = {0, 0};
+      bool        overflow = false;
+      if (base == 16) {
+         int used = 0;
+         for (; p != last && detail::hex_value(*p) >= 0; ++p) {
+            const int d = detail::hex_value(*p);
+            if (used == 0 && d == 0)
+               continue;
+            if (++used > 32)
+               overflow = true;
+            else
+               r = (r << 4) | uint128{static_cast<std::uint64_t>(d), 0};
+         }
+      } else {
+         // accumulate 19 digits at a time in a 64-bit chunk, then fold into the result
+         while (p != last && *p >= '0' && *p <= '9') {
+            std::uint64_t chunk = 0, scale = 1;
+            for (int i = 0; i < 19 && p != last && *p >= '0' && *p <= '9'; ++i, ++p) {
+               chunk  = chunk * 10 + static_cast<std::uint64_t>(*p - '0');
+               scale *= 10;
+            }
+            overflow = overflow || !detail::mul_add(r, scale, chunk);
+         }
+      }
+
+      if (p == first)
+         return {first, std::errc::invalid_argument};
+      if (overflow)
+         return {p, std::errc::result_out_of_range};
+      v = r;
+      return {p, std::errc{}};
+   }
 } // namespace astro::cryptid
 
 namespace astro::literals {
+   /**
+    * @brief 128-bit integer literal, hexadecimal with a 0x prefix and decimal otherwise, digit separators are allowed.
+    */
    consteval static inline astro::cryptid::uint128_t operator""_ui128(const char* x) {
-      uint64_t high = 0;
-      uint64_t low = 0;
-      bool high_set = true;
-      int shift = 0;
-
-      for (int i = 2; x[i] != '\0'; ++i) {
-         uint8_t value;
-         if ('0' <= x[i] && x[i] <= '9')
-            value = x[i] - '0';
-         else if ('A' <= x[i] && x[i] <= 'F')
-            value = x[i] - 'A' + 10;
-         else if ('a' <= x[i] && x[i] <= 'f')
-            value = x[i] - 'a' + 10;
-         
-         if (high_set) {
-            high = (high << 4) | value;
-            shift += 4;
-            if (shift == 64) {
-               high_set = false;
-               shift = 0;
-            }
-         } else {
-            low = (low << 4) | value;
-         }
+      int base = 10;
+      if (x[0] == '0' && (x[1] == 'x' || x[1] == 'X')) {
+         base = 16;
+         x   += 2;
+      }
+
+      char digits[160] = {};
+      int  n           = 0;
+      for (; *x != '\0'; ++x) {
+         if (*x == '\'')
+            continue;
+         if (n == 160)
+            throw "uint128 literal is too long";
+         digits[n++] = *x;
       }
 
-      return {low, high};
+      astro::cryptid::uint128_t v = {0, 0};
+      const auto res = astro::cryptid::from_chars(digits, digits + n, v, base);
+      if (res.ec != std::errc{} || res.ptr != digits + n)
+         throw "invalid or out of range uint128 literal";
+      return v;
    }
 
    consteval static inline astro::cryptid::low_value operator""_low(unsigned long long v) noexcept {
@@ -247,4 +491,48 @@ namespace astro::literals {
    consteval static inline astro::cryptid::high_value operator""_high(unsigned long long v) noexcept {
       return {static_cast<std::uint64_t>(v)};
    }
-}
\ No newline at end of file
+}
+
+#if defined(__cpp_lib_format)
+/**
+ * @brief Formats a uint128 with std::format, the spec is an optional '#' followed by 'd' (default), 'x' or 'X'.
+ */
+template <>
+struct std::formatter<astro::cryptid::uint128, char> {
+   bool alt  = false;
+   char type = 'd';
+
+   constexpr auto parse(std::format_parse_context& ctx) {
+      auto it = ctx.begin();
+      if (it != ctx.end() && *it == '#') {
+         alt = true;
+         ++it;
+      }
+      if (it != ctx.end() && (*it == 'd' || *it == 'x' || *it == 'X'))
+         type = *it++;
+      if (it != ctx.end() && *it != '}')
+         throw std::format_error("invalid format spec for uint128");
+      return it;
+   }
+
+   template <typename FormatContext>
+   auto format(const astro::cryptid::uint128& v, FormatContext& ctx) const {
+      char  buf[42];
+      char* p = buf;
+      if (type == 'd') {
+         p = astro::cryptid::to_chars(buf, buf + sizeof(buf), v, 10).ptr;
+      } else {
+         if (alt) {
+            *p++ = '0';
+            *p++ = type;
+         }
+         char hex[32];
+         v.to_hex32(hex, type == 'X');
+         const int ndigits = v == astro::cryptid::uint128{0, 0} ? 1 : (128 - v.countl_zero() + 3) / 4;
+         for (int i = 32 - ndigits; i < 32; ++i)
+            *p++ = hex[i];
+      }
+      return std::copy(buf, p, ctx.out());
+   }
+};
+#endif
@@ -3,4 +3,5 @@
 #include "fs/file.hpp"
 #include "fs/file_mode.hpp"
 #include "fs/file_sink.hpp"
+#include "fs/file_source.hpp"
 #include "fs/file_ops.hpp"
\ No newline at end of file
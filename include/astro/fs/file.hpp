@@ -62,6 +62,11 @@ namespace astro::fs {
             return is_fd_open(_file);
          }
 
+         /**
+          * @brief The underlying descriptor or handle, still owned by the file.
+          */
+         inline file_type native_handle() const noexcept { return _file; }
+
          inline operator FILE*() {
             auto fd = to_cfile(_file, _mode);
             util::check(fd, "Failed to create cfile from file: " + _path.string());
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "../info.hpp"
+
+#if ASTRO_OS == ASTRO_WINDOWS_BUILD
+#include "win/native_file_source.hpp"
+#else
+#include "unix/native_file_source.hpp"
+#endif
@@ -6,6 +6,10 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <span>
 
 namespace astro::fs {
 
@@ -17,6 +21,15 @@ namespace astro::fs {
          return ::write(fd, s.data(), s.size());
       }
 
+      inline int64_t writev_impl(std::span<const std::string_view> parts) noexcept {
+         constexpr std::size_t max_parts = 64;
+         iovec                 iov[max_parts];
+         const std::size_t     n = std::min(parts.size(), max_parts);
+         for (std::size_t i = 0; i < n; ++i)
+            iov[i] = iovec{const_cast<char*>(parts[i].data()), parts[i].size()};
+         return ::writev(fd, iov, static_cast<int>(n));
+      }
+
       int32_t fd = -1;
    };
 
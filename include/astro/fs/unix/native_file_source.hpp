@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+
+#include <span>
+
+#include <unistd.h>
+
+namespace astro::fs {
+
+   /**
+    * @brief Reads from a file descriptor, the counterpart of native_file_sink.
+    */
+   struct native_file_source {
+      native_file_source(int32_t fd) noexcept
+         : fd(fd) {}
+
+      /**
+       * @brief Reads up to buf.size() bytes.
+       * @return The number of bytes read, 0 at the end of the file or -1 on error.
+       */
+      inline int64_t read_some(std::span<std::uint8_t> buf) noexcept {
+         for (;;) {
+            const ssize_t n = ::read(fd, buf.data(), buf.size());
+            if (n >= 0 || errno != EINTR)
+               return n;
+         }
+      }
+
+      int32_t fd = -1;
+   };
+
+} // namespace astro::fs
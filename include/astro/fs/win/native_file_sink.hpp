@@ -16,7 +16,7 @@ namespace astro::fs {
          DWORD result = 0;
          if (handle == INVALID_HANDLE_VALUE)
             return -1;
-         if (::WriteFile(handle, s.data(), static_cast<DWORD>(s.size()), &result, nullptr))
+         if (!::WriteFile(handle, s.data(), static_cast<DWORD>(s.size()), &result, nullptr))
             return -1;
          else
             return result;
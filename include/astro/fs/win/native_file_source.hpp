@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+#include <algorithm>
+#include <span>
+
+#define NOMINMAX
+#include <windows.h>
+#undef NOMINMAX
+
+namespace astro::fs {
+
+   /**
+    * @brief Reads from a file handle, the counterpart of native_file_sink.
+    */
+   struct native_file_source {
+      native_file_source(HANDLE handle) noexcept
+         : handle(handle) {}
+
+      /**
+       * @brief Reads up to buf.size() bytes.
+       * @return The number of bytes read, 0 at the end of the file or -1 on error.
+       */
+      inline int64_t read_some(std::span<std::uint8_t> buf) noexcept {
+         DWORD result = 0;
+         if (handle == INVALID_HANDLE_VALUE)
+            return -1;
+         const auto n = static_cast<DWORD>(std::min<std::size_t>(buf.size(), 1u << 30));
+         if (!::ReadFile(handle, buf.data(), n, &result, nullptr))
+            return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+         return result;
+      }
+
+      HANDLE handle = INVALID_HANDLE_VALUE;
+   };
+
+} // namespace astro::fs
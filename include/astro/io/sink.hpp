@@ -2,6 +2,7 @@
 
 #include <cstdio>
 
+#include <span>
 #include <string_view>
 
 #include "../utils/misc.hpp"
@@ -19,6 +20,27 @@ namespace astro::io {
       constexpr inline int32_t write(std::string_view s) noexcept {
          return static_cast<Derived*>(this)->write_impl(s);
       }
+
+      /**
+       * @brief Writes several buffers in order, in a single call when the sink supports gather writes.
+       * @return The number of bytes written, which may stop short like write, or -1 on error.
+       */
+      inline int64_t writev(std::span<const std::string_view> parts) noexcept {
+         if constexpr (requires(Derived& d) { d.writev_impl(parts); }) {
+            return static_cast<Derived*>(this)->writev_impl(parts);
+         } else {
+            int64_t total = 0;
+            for (const auto p : parts) {
+               const int32_t n = write(p);
+               if (n < 0)
+                  return total == 0 ? -1 : total;
+               total += n;
+               if (static_cast<std::size_t>(n) < p.size())
+                  break;
+            }
+            return total;
+         }
+      }
    };
 
 } // namespace astro::io
\ No newline at end of file
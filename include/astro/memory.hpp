@@ -1,6 +1,8 @@
 #pragma once
 
 #include "memory/allocator.hpp"
+#include "memory/arena.hpp"
 #include "memory/tagged_ptr.hpp"
 #include "memory/mapper.hpp"
+#include "memory/mapped_file.hpp"
 #include "memory/modes.hpp"
\ No newline at end of file
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <array>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <utility>
+
+#include "../utils.hpp"
+#include "allocator.hpp"
+
+namespace astro::memory {
+
+   /**
+    * @brief Chunked bump allocator that recycles small allocations by size class.
+    *
+    * Memory is carved out of blocks that go back to the system only on reset() or destruction. allocate_bytes() and
+    * deallocate_bytes() round sizes up to 16 bytes and keep freed allocations up to max_recycled bytes on a free list per
+    * size class, so a steady stream of same-sized objects (coroutine frames, list nodes) stops reaching the system
+    * allocator. Bigger requests go straight to operator new. The typed allocator_base interface only bumps and never
+    * recycles.
+    *
+    * The arena belongs to the thread that created it. Other threads may free into it: those frees land on a lock-free
+    * list that the owner drains on its next allocation.
+    */
+   class arena : public allocator_base<arena> {
+         struct block {
+               block*      next;
+               std::size_t size;
+         };
+
+         struct free_node {
+               free_node*  next;
+               std::size_t size;
+         };
+
+      public:
+         constexpr static inline std::size_t granule      = 16;
+         constexpr static inline std::size_t max_recycled = 4096;
+
+         inline explicit arena(std::size_t block_size = 64 * 1024)
+            : _block_size(block_size < 1024 ? 1024 : block_size),
+              _owner(std::this_thread::get_id()) {}
+
+         arena(const arena&)            = delete;
+         arena& operator=(const arena&) = delete;
+
+         inline ~arena() { reset(); }
+
+         /**
+          * @brief At least n bytes aligned to granule.
+          */
+         inline void* allocate_bytes(std::size_t n) {
+            n = round(n);
+            if (n > max_recycled)
+               return ::operator new(n, std::align_val_t{granule});
+            auto& head = _free[n / granule];
+            if (!head)
+               drain_remote();
+            if (free_node* f = head) {
+               head = f->next;
+               return f;
+            }
+            return bump(n);
+         }
+
+         /**
+          * @brief Returns memory from allocate_bytes(n), with the same n. Safe to call from any thread.
+          */
+         inline void deallocate_bytes(void* p, std::size_t n) noexcept {
+            n = round(n);
+            if (n > max_recycled) {
+               ::operator delete(p, std::align_val_t{granule});
+               return;
+            }
+            auto* f = static_cast<free_node*>(p);
+            if (std::this_thread::get_id() == _owner) {
+               f->next            = _free[n / granule];
+               _free[n / granule] = f;
+               return;
+            }
+            f->size = n;
+            f->next = _remote.load(std::memory_order_relaxed);
+            while (!_remote.compare_exchange_weak(f->next, f, std::memory_order_release, std::memory_order_relaxed)) {}
+         }
+
+         /**
+          * @brief Releases every block at once. Everything allocated from the arena becomes invalid.
+          */
+         inline void reset() noexcept {
+            while (_blocks) {
+               block* next = _blocks->next;
+               ::operator delete(static_cast<void*>(_blocks), _blocks->size, std::align_val_t{granule});
+               _blocks = next;
+            }
+            _cur = _end = nullptr;
+            _reserved   = 0;
+            _free.fill(nullptr);
+            _remote.store(nullptr, std::memory_order_relaxed);
+         }
+
+         /**
+          * @brief Bytes held in blocks, used or not.
+          */
+         inline std::size_t reserved() const noexcept { return _reserved; }
+
+         template <class T>
+         inline T* allocate_impl(std::size_t n) {
+            static_assert(alignof(T) <= granule, "arena: over-aligned types are not supported");
+            return static_cast<T*>(bump(round(n * sizeof(T))));
+         }
+
+         template <class T>
+         constexpr inline void deallocate_impl(T*) noexcept {}
+
+      private:
+         constexpr static inline std::size_t round(std::size_t n) noexcept {
+            return n ? (n + granule - 1) & ~(granule - 1) : granule;
+         }
+
+         inline void* bump(std::size_t n) {
+            if (static_cast<std::size_t>(_end - _cur) < n) {
+               constexpr std::size_t header = round(sizeof(block));
+               const std::size_t     size   = header + (n > _block_size ? n : _block_size);
+               auto*                 b      = static_cast<block*>(::operator new(size, std::align_val_t{granule}));
+               b->next    = _blocks;
+               b->size    = size;
+               _blocks    = b;
+               _reserved += size;
+               _cur       = reinterpret_cast<std::byte*>(b) + header;
+               _end       = reinterpret_cast<std::byte*>(b) + size;
+            }
+            void* p = _cur;
+            _cur   += n;
+            return p;
+         }
+
+         inline void drain_remote() noexcept {
+            free_node* f = _remote.exchange(nullptr, std::memory_order_acquire);
+            while (f) {
+               free_node* next          = f->next;
+               f->next                  = _free[f->size / granule];
+               _free[f->size / granule] = f;
+               f                        = next;
+            }
+         }
+
+         std::size_t                                        _block_size;
+         std::thread::id                                    _owner;
+         block*                                             _blocks   = nullptr;
+         std::byte*                                         _cur      = nullptr;
+         std::byte*                                         _end      = nullptr;
+         std::size_t                                        _reserved = 0;
+         std::array<free_node*, max_recycled / granule + 1> _free     = {};
+         std::atomic<free_node*>                            _remote   = nullptr;
+   };
+
+} // namespace astro::memory
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "../info.hpp"
+
+#if ASTRO_OS == ASTRO_WINDOWS_BUILD
+   #include "win/mapped_file_impl.hpp"
+#else
+   #include "unix/mapped_file_impl.hpp"
+#endif
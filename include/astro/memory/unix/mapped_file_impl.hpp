@@ -0,0 +1,126 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <filesystem>
+#include <span>
+#include <utility>
+
+#include "../../utils.hpp"
+#include "../modes.hpp"
+
+namespace astro::memory {
+
+   /**
+    * @brief Read-only or shared writable mapping of a whole file.
+    *
+    * The file descriptor is closed as soon as the mapping exists, the bytes stay valid until the mapped_file is closed or
+    * destroyed.
+    */
+   class mapped_file {
+      public:
+         using byte_t = std::uint8_t;
+         using path_t = std::filesystem::path;
+
+         mapped_file() = default;
+
+         explicit inline mapped_file(const path_t& path, access_mode mode = access_mode::read) { open(path, mode); }
+
+         mapped_file(const mapped_file&)            = delete;
+         mapped_file& operator=(const mapped_file&) = delete;
+
+         inline mapped_file(mapped_file&& other) noexcept { *this = std::move(other); }
+
+         inline mapped_file& operator=(mapped_file&& other) noexcept {
+            if (this != &other) {
+               close();
+               _data     = std::exchange(other._data, nullptr);
+               _size     = std::exchange(other._size, 0);
+               _writable = std::exchange(other._writable, false);
+               _open     = std::exchange(other._open, false);
+            }
+            return *this;
+         }
+
+         inline ~mapped_file() { close(); }
+
+         /**
+          * @brief Maps the file, write access maps it shared so stores reach the file.
+          */
+         inline void open(const path_t& path, access_mode mode = access_mode::read) {
+            close();
+            const bool writable = (static_cast<std::uint8_t>(mode) & static_cast<std::uint8_t>(access_mode::write)) != 0;
+            const int  fd       = ::open(path.c_str(), (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+            util::check(fd >= 0, "mapped_file: failed to open " + path.string());
+
+            struct stat st{};
+            if (::fstat(fd, &st) != 0) {
+               ::close(fd);
+               util::check(false, "mapped_file: failed to stat " + path.string());
+            }
+
+            void* addr = nullptr;
+            if (st.st_size > 0) {
+               addr = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                             MAP_SHARED, fd, 0);
+            }
+            ::close(fd);
+            util::check(addr != MAP_FAILED, "mapped_file: failed to map " + path.string());
+
+            _data     = static_cast<byte_t*>(addr);
+            _size     = static_cast<std::size_t>(st.st_size);
+            _writable = writable;
+            _open     = true;
+         }
+
+         inline void close() noexcept {
+            if (_data != nullptr)
+               ::munmap(_data, _size);
+            _data     = nullptr;
+            _size     = 0;
+            _writable = false;
+            _open     = false;
+         }
+
+         /**
+          * @brief Flushes writes through to the file.
+          */
+         inline void sync() {
+            if (_data != nullptr && _writable)
+               util::check(::msync(_data, _size, MS_SYNC) == 0, "mapped_file: failed to sync");
+         }
+
+         /**
+          * @brief Hints that the mapping will be read front to back.
+          */
+         inline void advise_sequential() noexcept {
+            if (_data != nullptr)
+               ::madvise(_data, _size, MADV_SEQUENTIAL);
+         }
+
+         inline bool is_open() const noexcept { return _open; }
+         inline bool is_writable() const noexcept { return _writable; }
+         inline bool empty() const noexcept { return _size == 0; }
+         inline std::size_t size() const noexcept { return _size; }
+         inline const byte_t* data() const noexcept { return _data; }
+
+         inline std::span<const byte_t> bytes() const noexcept ASTRO_LIFETIMEBOUND { return {_data, _size}; }
+
+         inline std::span<byte_t> writable_bytes() ASTRO_LIFETIMEBOUND {
+            util::check(_writable, "mapped_file: mapping is read-only");
+            return {_data, _size};
+         }
+
+      private:
+         byte_t*     _data     = nullptr;
+         std::size_t _size     = 0;
+         bool        _writable = false;
+         bool        _open     = false;
+   };
+} // namespace astro::memory
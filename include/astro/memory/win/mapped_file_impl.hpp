@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <windows.h>
+
+#include <filesystem>
+#include <span>
+#include <utility>
+
+#include "../../utils.hpp"
+#include "../modes.hpp"
+
+namespace astro::memory {
+
+   /**
+    * @brief Read-only or shared writable mapping of a whole file.
+    *
+    * The file and mapping handles are closed as soon as the view exists, the bytes stay valid until the mapped_file is
+    * closed or destroyed.
+    */
+   class mapped_file {
+      public:
+         using byte_t = std::uint8_t;
+         using path_t = std::filesystem::path;
+
+         mapped_file() = default;
+
+         explicit inline mapped_file(const path_t& path, access_mode mode = access_mode::read) { open(path, mode); }
+
+         mapped_file(const mapped_file&)            = delete;
+         mapped_file& operator=(const mapped_file&) = delete;
+
+         inline mapped_file(mapped_file&& other) noexcept { *this = std::move(other); }
+
+         inline mapped_file& operator=(mapped_file&& other) noexcept {
+            if (this != &other) {
+               close();
+               _data     = std::exchange(other._data, nullptr);
+               _size     = std::exchange(other._size, 0);
+               _writable = std::exchange(other._writable, false);
+               _open     = std::exchange(other._open, false);
+            }
+            return *this;
+         }
+
+         inline ~mapped_file() { close(); }
+
+         inline void open(const path_t& path, access_mode mode = access_mode::read) {
+            close();
+            const bool writable = (static_cast<std::uint8_t>(mode) & static_cast<std::uint8_t>(access_mode::write)) != 0;
+            HANDLE     file     = CreateFileW(path.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                                              FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            util::check(file != INVALID_HANDLE_VALUE, "mapped_file: failed to open " + path.string());
+
+            LARGE_INTEGER sz{};
+            if (!GetFileSizeEx(file, &sz)) {
+               CloseHandle(file);
+               util::check(false, "mapped_file: failed to stat " + path.string());
+            }
+
+            void* addr = nullptr;
+            if (sz.QuadPart > 0) {
+               HANDLE mapping = CreateFileMappingW(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+               if (mapping != nullptr) {
+                  addr = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+                  CloseHandle(mapping);
+               }
+               if (addr == nullptr) {
+                  CloseHandle(file);
+                  util::check(false, "mapped_file: failed to map " + path.string());
+               }
+            }
+            CloseHandle(file);
+
+            _data     = static_cast<byte_t*>(addr);
+            _size     = static_cast<std::size_t>(sz.QuadPart);
+            _writable = writable;
+            _open     = true;
+         }
+
+         inline void close() noexcept {
+            if (_data != nullptr)
+               UnmapViewOfFile(_data);
+            _data     = nullptr;
+            _size     = 0;
+            _writable = false;
+            _open     = false;
+         }
+
+         inline void sync() {
+            if (_data != nullptr && _writable)
+               util::check(FlushViewOfFile(_data, _size) != 0, "mapped_file: failed to sync");
+         }
+
+         inline void advise_sequential() noexcept {
+            if (_data != nullptr) {
+               WIN32_MEMORY_RANGE_ENTRY range{_data, _size};
+               PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+            }
+         }
+
+         inline bool is_open() const noexcept { return _open; }
+         inline bool is_writable() const noexcept { return _writable; }
+         inline bool empty() const noexcept { return _size == 0; }
+         inline std::size_t size() const noexcept { return _size; }
+         inline const byte_t* data() const noexcept { return _data; }
+
+         inline std::span<const byte_t> bytes() const noexcept ASTRO_LIFETIMEBOUND { return {_data, _size}; }
+
+         inline std::span<byte_t> writable_bytes() ASTRO_LIFETIMEBOUND {
+            util::check(_writable, "mapped_file: mapping is read-only");
+            return {_data, _size};
+         }
+
+      private:
+         byte_t*     _data     = nullptr;
+         std::size_t _size     = 0;
+         bool        _writable = false;
+         bool        _open     = false;
+   };
+} // namespace astro::memory
@@ -1,4 +1,12 @@
 #pragma once
 
 #include "serial/alpha.hpp"
-#include "serial/proto.hpp"
\ No newline at end of file
+#include "serial/archive.hpp"
+#include "serial/columnar.hpp"
+#include "serial/intpack.hpp"
+#include "serial/json.hpp"
+#include "serial/lz.hpp"
+#include "serial/proto.hpp"
+#include "serial/reflect.hpp"
+#include "serial/stream.hpp"
+#include "serial/varint.hpp"
\ No newline at end of file
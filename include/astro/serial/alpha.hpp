@@ -1,9 +1,11 @@
 #pragma once
 
 #include <cstdint>
+
 #include <memory>
-#include <vector>
 #include <span>
+#include <type_traits>
+#include <vector>
 
 #include "serializer.hpp"
 
@@ -20,9 +22,17 @@ namespace astro::serial {
          alpha& operator=(const alpha&) = default;
          alpha& operator=(alpha&&) = default;
 
+         /**
+          * @brief Like push, but measures the value first so the buffer grows at most once and the writes skip bounds checks.
+          *
+          * Types with their own serialize overload are pushed as usual.
+          */
          template <typename T>
          constexpr inline void pack(T&& v) {
-           serialize(*this, std::forward<T>(v));
+            if constexpr (requires { serialize_sized(*this, v); })
+               serialize_sized(*this, v);
+            else
+               serialize(*this, std::forward<T>(v));
          }
 
          template <typename T>
@@ -35,6 +45,14 @@ namespace astro::serial {
             return deserialize<T>(*this);
          }
 
+         /**
+          * @brief Deserializes a view type (std::string_view or std::span<const T>) that points into this buffer.
+          */
+         template <typename T>
+         inline T borrow() ASTRO_LIFETIMEBOUND {
+            return deserialize<T>(*this);
+         }
+
          template <typename T>
          constexpr inline std::span<T> view() {
             return std::span<T>(reinterpret_cast<T*>(begin()), size()/sizeof(T));
@@ -42,27 +60,66 @@ namespace astro::serial {
    };
 
    template <util::numeric_type N>
-   constexpr static inline void serialize(alpha& a, N val) noexcept {
+   constexpr static inline void serialize(alpha& a, N val) {
       a.write(&val, sizeof(N));
    }
 
    template <util::numeric_type N>
-   constexpr static inline N deserialize(alpha& a) noexcept {
+   constexpr static inline N deserialize(alpha& a) {
       N val;
       a.read(&val, sizeof(N));
       return val;
    }
 
+   /**
+    * @brief Strings carry a uint32 length prefix, deserializing a std::string_view borrows the bytes.
+    */
    template <util::string_type S>
-   constexpr static inline void serialize(alpha& a, const S& val) noexcept {
+   static inline void serialize(alpha& a, const S& val) {
+      util::check(val.size() <= UINT32_MAX, "serial: string too long");
+      const auto len = static_cast<std::uint32_t>(val.size());
+      a.write(&len, sizeof(len));
       a.write(val.data(), val.size());
    }
 
    template <util::string_type S>
-   constexpr static inline S deserialize(alpha& a) noexcept {
-      S val;
-      val.resize(a.size());
-      a.read(val.data(), val.size());
-      return val;
+   static inline S deserialize(alpha& a) {
+      std::uint32_t len = 0;
+      a.read(&len, sizeof(len));
+      const auto bytes = a.read_view(len);
+      return S(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+   }
+
+   /**
+    * @brief Spans of trivially copyable elements, borrowable back as std::span<const T>.
+    */
+   template <typename S>
+   concept span_type = std::is_same_v<S, std::span<typename S::element_type>> &&
+                       std::is_trivially_copyable_v<typename S::element_type>;
+
+   /**
+    * @brief A uint32 count, zero padding up to the element alignment, then the elements.
+    */
+   template <span_type S>
+   static inline void serialize(alpha& a, S val) {
+      util::check(val.size() <= UINT32_MAX, "serial: span too long");
+      const auto len = static_cast<std::uint32_t>(val.size());
+      a.write(&len, sizeof(len));
+      a.write_padding(alignof(typename S::element_type));
+      a.write(val.data(), val.size_bytes());
+   }
+
+   template <span_type S>
+   requires std::is_const_v<typename S::element_type>
+   static inline S deserialize(alpha& a) {
+      using T           = typename S::element_type;
+      std::uint32_t len = 0;
+      a.read(&len, sizeof(len));
+      a.skip_padding(alignof(T));
+      util::check(len <= a.remaining() / sizeof(T), "serial: span length exceeds the remaining input");
+      const auto bytes = a.read_view(len * sizeof(T));
+      // the offset is aligned, the buffer itself must be too
+      util::check(reinterpret_cast<std::uintptr_t>(bytes.data()) % alignof(T) == 0, "serial: borrowed span is misaligned");
+      return S(reinterpret_cast<T*>(bytes.data()), len);
    }
 } // namespace astro::serial
\ No newline at end of file
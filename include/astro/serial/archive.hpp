@@ -0,0 +1,431 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <bit>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../memory/mapped_file.hpp"
+#include "../utils.hpp"
+#include "alpha.hpp"
+#include "stream.hpp"
+
+namespace astro::serial {
+
+   struct archive_options {
+      /** @brief A sync marker goes in front of every this many records, recovery resumes at the next one after damage. */
+      std::uint32_t sync_interval = 1024;
+      /** @brief Records are batched until this many bytes are buffered, larger records bypass the buffer. */
+      std::size_t chunk_size = 64 * 1024;
+   };
+
+   namespace detail::arc {
+      constexpr static inline char          file_magic[8]  = {'A', 'S', 'T', 'R', 'O', 'A', 'R', 'C'};
+      constexpr static inline char          sync_magic[8]  = {'A', 'S', 'T', 'R', 'O', 'S', 'Y', 'N'};
+      constexpr static inline char          index_magic[8] = {'A', 'S', 'T', 'R', 'O', 'I', 'D', 'X'};
+      constexpr static inline std::uint32_t version        = 1;
+      constexpr static inline std::uint32_t sync_length    = UINT32_MAX;
+      constexpr static inline std::uint64_t lost           = UINT64_MAX;
+
+      struct file_header {
+         char          magic[8];
+         std::uint32_t version;
+         std::uint32_t sync_interval;
+      };
+
+      /**
+       * @brief Precedes every payload. index is the low 32 bits of the record number, a check for recovery scans.
+       */
+      struct record_header {
+         std::uint32_t length;
+         std::uint32_t index;
+      };
+
+      /**
+       * @brief Written in place of a record header, length is sync_length.
+       */
+      struct sync_marker {
+         std::uint32_t length;
+         std::uint32_t next;
+         char          magic[8];
+      };
+
+      struct hash_slot {
+         std::uint64_t key;
+         std::uint64_t record; // record number + 1, 0 for an empty slot
+      };
+
+      /**
+       * @brief The last bytes of a closed archive, locating the offset index and the key index.
+       */
+      struct footer {
+         std::uint64_t count;
+         std::uint64_t index_offset;
+         std::uint64_t hash_offset;
+         std::uint64_t hash_slots;
+         char          magic[8];
+      };
+
+      static_assert(sizeof(file_header) == 16 && sizeof(record_header) == 8 && sizeof(sync_marker) == 16 &&
+                    sizeof(hash_slot) == 16 && sizeof(footer) == 40);
+
+      constexpr static inline std::size_t padded(std::size_t n) noexcept { return (n + 7) & ~std::size_t{7}; }
+
+      constexpr static inline std::size_t slot_of(std::uint64_t key, std::size_t slots) noexcept {
+         // fibonacci hashing, slots is a power of two of at least 2
+         return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> (64 - std::countr_zero(slots)));
+      }
+
+      template <typename T>
+      static inline T load(std::span<const std::uint8_t> b, std::size_t at) noexcept {
+         T v;
+         std::memcpy(&v, b.data() + at, sizeof(T));
+         return v;
+      }
+   } // namespace detail::arc
+
+   /**
+    * @brief Appends records to a sink and finishes with an offset index, so archive_reader can fetch any record in O(1).
+    *
+    * The layout is a 16 byte header, then each record as a length and record number followed by its alpha encoding
+    * padded to 8 bytes, with a sync marker before every sync_interval records. close() appends the record offsets, a
+    * hash table from keys to record numbers when keys were given, and a fixed size footer. The sink is borrowed.
+    */
+   template <byte_sink_type Sink>
+   class archive_writer {
+      public:
+         explicit archive_writer(Sink& sink, archive_options opts = {})
+            : _sink(sink), _opts(opts) {
+            util::check(_opts.sync_interval != 0, "archive: sync interval must be positive");
+            _chunk.reserve(_opts.chunk_size);
+            detail::arc::file_header h{};
+            std::memcpy(h.magic, detail::arc::file_magic, sizeof(h.magic));
+            h.version       = detail::arc::version;
+            h.sync_interval = _opts.sync_interval;
+            put(&h, sizeof(h));
+         }
+
+         archive_writer(const archive_writer&)            = delete;
+         archive_writer& operator=(const archive_writer&) = delete;
+
+         /**
+          * @brief Closes the archive, errors are dropped, call close() to see them.
+          */
+         ~archive_writer() {
+            try {
+               close();
+            } catch (...) {
+            }
+         }
+
+         /**
+          * @return The record number.
+          */
+         template <typename T>
+         inline std::uint64_t push(T&& v) {
+            _record.clear();
+            serialize(_record, std::forward<T>(v));
+            return push_bytes(_record.bytes());
+         }
+
+         /**
+          * @brief Appends a record that archive_reader::find can look up by key, a repeated key resolves to the last one.
+          */
+         template <typename T>
+         inline std::uint64_t push(std::uint64_t key, T&& v) {
+            const std::uint64_t n = push(std::forward<T>(v));
+            _keys.push_back({key, n + 1});
+            return n;
+         }
+
+         inline std::uint64_t push_bytes(std::span<const std::uint8_t> payload) {
+            util::check(!_closed, "archive: push after close");
+            util::check(payload.size() < detail::arc::sync_length, "archive: record too long");
+
+            const std::uint64_t n = _offsets.size();
+            if (n != 0 && n % _opts.sync_interval == 0) {
+               detail::arc::sync_marker m{detail::arc::sync_length, static_cast<std::uint32_t>(n), {}};
+               std::memcpy(m.magic, detail::arc::sync_magic, sizeof(m.magic));
+               put(&m, sizeof(m));
+            }
+
+            _offsets.push_back(_offset);
+            const detail::arc::record_header h{static_cast<std::uint32_t>(payload.size()), static_cast<std::uint32_t>(n)};
+            const std::size_t                pad = detail::arc::padded(payload.size()) - payload.size();
+            if (payload.size() >= _opts.chunk_size) {
+               // gather the buffered bytes, the header and the payload into one call
+               constexpr std::uint8_t zeros[8] = {};
+               _chunk.write(&h, sizeof(h));
+               const std::string_view parts[] = {detail::as_chars(_chunk.bytes()), detail::as_chars(payload),
+                                                 detail::as_chars({zeros, pad})};
+               detail::write_all(_sink, parts);
+               _offset += sizeof(h) + payload.size() + pad;
+               _chunk.clear();
+               return n;
+            }
+            put(&h, sizeof(h));
+            put(payload.data(), payload.size());
+            put_zeros(pad);
+            return n;
+         }
+
+         inline std::uint64_t push_bytes(std::uint64_t key, std::span<const std::uint8_t> payload) {
+            const std::uint64_t n = push_bytes(payload);
+            _keys.push_back({key, n + 1});
+            return n;
+         }
+
+         /**
+          * @brief Writes the buffered records to the sink, the archive stays open.
+          */
+         inline void flush() {
+            if (_chunk.size() == 0)
+               return;
+            const std::string_view part = detail::as_chars(_chunk.bytes());
+            detail::write_all(_sink, {&part, 1});
+            _chunk.clear();
+         }
+
+         /**
+          * @brief Appends the indexes and the footer, later pushes throw.
+          */
+         inline void close() {
+            if (_closed)
+               return;
+            _closed = true;
+
+            detail::arc::footer f{};
+            f.count        = _offsets.size();
+            f.index_offset = _offset;
+            put(_offsets.data(), _offsets.size() * sizeof(std::uint64_t));
+
+            if (!_keys.empty()) {
+               const std::size_t                   slots = std::bit_ceil(std::max<std::size_t>(2, 2 * _keys.size()));
+               std::vector<detail::arc::hash_slot> table(slots);
+               for (const auto& k : _keys) {
+                  std::size_t s = detail::arc::slot_of(k.key, slots);
+                  while (table[s].record != 0 && table[s].key != k.key)
+                     s = (s + 1) & (slots - 1);
+                  table[s] = k;
+               }
+               f.hash_offset = _offset;
+               f.hash_slots  = slots;
+               put(table.data(), table.size() * sizeof(detail::arc::hash_slot));
+            }
+
+            std::memcpy(f.magic, detail::arc::index_magic, sizeof(f.magic));
+            put(&f, sizeof(f));
+            flush();
+         }
+
+         /**
+          * @brief Records pushed so far.
+          */
+         inline std::uint64_t size() const noexcept { return _offsets.size(); }
+
+         /**
+          * @brief Bytes of archive produced so far, buffered ones included.
+          */
+         inline std::uint64_t bytes_written() const noexcept { return _offset; }
+
+      private:
+         inline void put(const void* p, std::size_t n) {
+            // big writes (the offset index) go through the buffer a chunk at a time
+            const auto* b = static_cast<const std::uint8_t*>(p);
+            while (n != 0) {
+               const std::size_t k = std::min(n, std::max(_opts.chunk_size, _chunk.size() + 1) - _chunk.size());
+               _chunk.write(b, k);
+               _offset += k;
+               b       += k;
+               n       -= k;
+               if (_chunk.size() >= _opts.chunk_size)
+                  flush();
+            }
+         }
+
+         inline void put_zeros(std::size_t n) {
+            constexpr std::uint8_t zeros[8] = {};
+            put(zeros, n);
+         }
+
+         Sink&                               _sink;
+         archive_options                     _opts;
+         alpha                               _record;
+         alpha                               _chunk;
+         std::uint64_t                       _offset = 0;
+         std::vector<std::uint64_t>          _offsets;
+         std::vector<detail::arc::hash_slot> _keys;
+         bool                                _closed = false;
+   };
+
+   /**
+    * @brief Random access to an archive_writer's records through a memory map.
+    *
+    * Record N and key lookups read the trailing indexes and go straight to the record. An archive without a footer, e.g.
+    * from a writer that died, is scanned once on open instead; records in a damaged stretch are skipped up to the next
+    * sync marker and reading them throws.
+    */
+   class archive_reader {
+      public:
+         archive_reader() = default;
+
+         explicit inline archive_reader(const std::filesystem::path& path)
+            : _file(path) {
+            open(_file.bytes());
+         }
+
+         /**
+          * @brief Reads an archive that is already in memory, the bytes are borrowed.
+          */
+         explicit inline archive_reader(std::span<const std::uint8_t> bytes) { open(bytes); }
+
+         /**
+          * @brief The number of records, including any lost to damage.
+          */
+         inline std::size_t size() const noexcept { return _offsets.size(); }
+
+         /**
+          * @brief Whether the footer was found, false when the records were located by scanning.
+          */
+         inline bool indexed() const noexcept { return _indexed; }
+
+         inline bool has_keys() const noexcept { return !_slots.empty(); }
+
+         /**
+          * @brief The encoded bytes of record n, borrowed from the map and 8 byte aligned.
+          */
+         inline std::span<const std::uint8_t> bytes(std::size_t n) const {
+            util::check(n < _offsets.size(), "archive: record out of range");
+            const std::uint64_t at = _offsets[n];
+            util::check(at != detail::arc::lost, "archive: record lost to damage");
+            util::check(at <= _data.size() - sizeof(detail::arc::record_header), "archive: corrupt offset index");
+            const auto h = detail::arc::load<detail::arc::record_header>(_data, at);
+            util::check(h.index == static_cast<std::uint32_t>(n) && h.length <= _data.size() - at - sizeof(h),
+                        "archive: corrupt record header");
+            return _data.subspan(at + sizeof(h), h.length);
+         }
+
+         template <typename T>
+         inline T get(std::size_t n) const {
+            alpha a{bytes(n)};
+            T     v = a.pop<T>();
+            util::check(a.remaining() == 0, "archive: record not fully consumed");
+            return v;
+         }
+
+         /**
+          * @brief The record number stored under key.
+          */
+         inline std::optional<std::size_t> find(std::uint64_t key) const {
+            util::check(has_keys(), "archive: no key index");
+            const std::size_t slots = _slots.size() / sizeof(detail::arc::hash_slot);
+            std::size_t       s     = detail::arc::slot_of(key, slots);
+            for (std::size_t probes = 0; probes < slots; ++probes, s = (s + 1) & (slots - 1)) {
+               const auto slot = detail::arc::load<detail::arc::hash_slot>(_slots, s * sizeof(detail::arc::hash_slot));
+               if (slot.record == 0)
+                  return std::nullopt;
+               if (slot.key == key)
+                  return static_cast<std::size_t>(slot.record - 1);
+            }
+            return std::nullopt;
+         }
+
+         template <typename T>
+         inline std::optional<T> lookup(std::uint64_t key) const {
+            const auto n = find(key);
+            if (!n)
+               return std::nullopt;
+            return get<T>(*n);
+         }
+
+      private:
+         inline void open(std::span<const std::uint8_t> data) {
+            using namespace detail::arc;
+            _data = data;
+            util::check(data.size() >= sizeof(file_header), "archive: truncated header");
+            const auto h = load<file_header>(data, 0);
+            util::check(std::memcmp(h.magic, file_magic, sizeof(h.magic)) == 0, "archive: not an archive");
+            util::check(h.version == version, "archive: unsupported version");
+
+            if (data.size() >= sizeof(file_header) + sizeof(footer)) {
+               const std::size_t end = data.size() - sizeof(footer);
+               const auto        f   = load<footer>(data, end);
+               if (std::memcmp(f.magic, index_magic, sizeof(f.magic)) == 0) {
+                  const std::uint64_t index_end = f.hash_slots != 0 ? f.hash_offset : end;
+                  util::check(index_end <= end && f.index_offset >= sizeof(file_header) && f.index_offset % 8 == 0 &&
+                                    f.index_offset <= index_end &&
+                                    f.count == (index_end - f.index_offset) / sizeof(std::uint64_t) &&
+                                    (f.hash_slots == 0 || (f.hash_slots >= 2 && std::has_single_bit(f.hash_slots) &&
+                                                           f.hash_slots == (end - f.hash_offset) / sizeof(hash_slot))),
+                              "archive: corrupt footer");
+                  // records are padded to 8 bytes so the index is aligned if the bytes are
+                  util::check(reinterpret_cast<std::uintptr_t>(data.data()) % 8 == 0, "archive: bytes must be 8 byte aligned");
+                  _offsets = {reinterpret_cast<const std::uint64_t*>(data.data() + f.index_offset), f.count};
+                  if (f.hash_slots != 0)
+                     _slots = data.subspan(f.hash_offset, f.hash_slots * sizeof(hash_slot));
+                  _indexed = true;
+                  return;
+               }
+            }
+            recover();
+         }
+
+         /**
+          * @brief Rebuilds the offset index by walking the records, resynchronizing at sync markers after damage.
+          */
+         inline void recover() {
+            using namespace detail::arc;
+            std::size_t   at = sizeof(file_header);
+            std::uint64_t n  = 0;
+            while (at + sizeof(record_header) <= _data.size()) {
+               const auto h = load<record_header>(_data, at);
+               if (h.length == sync_length && at + sizeof(sync_marker) <= _data.size() &&
+                   std::memcmp(_data.data() + at + 8, sync_magic, sizeof(sync_magic)) == 0 &&
+                   h.index == static_cast<std::uint32_t>(n)) {
+                  at += sizeof(sync_marker);
+                  continue;
+               }
+               if (h.length != sync_length && h.index == static_cast<std::uint32_t>(n) &&
+                   h.length <= _data.size() - at - sizeof(h)) {
+                  _recovered.push_back(at);
+                  at += sizeof(h) + padded(h.length);
+                  ++n;
+                  continue;
+               }
+               // damage: look for the next marker at or beyond the expected one, each lost record took at least a header
+               bool              found = false;
+               const std::size_t from  = at;
+               for (at += 8; at + sizeof(sync_marker) <= _data.size(); at += 8) {
+                  const auto m = load<sync_marker>(_data, at);
+                  if (m.length == sync_length && std::memcmp(m.magic, sync_magic, sizeof(m.magic)) == 0 && m.next > n &&
+                      m.next - n <= (at - from) / sizeof(record_header)) {
+                     _recovered.resize(m.next, lost);
+                     n     = m.next;
+                     at   += sizeof(sync_marker);
+                     found = true;
+                     break;
+                  }
+               }
+               if (!found)
+                  break;
+            }
+            _offsets = _recovered;
+         }
+
+         memory::mapped_file           _file;
+         std::span<const std::uint8_t> _data;
+         std::span<const std::uint64_t> _offsets;
+         std::span<const std::uint8_t> _slots;
+         std::vector<std::uint64_t>    _recovered;
+         bool                          _indexed = false;
+   };
+
+} // namespace astro::serial
@@ -0,0 +1,437 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <initializer_list>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+   #include <emmintrin.h>
+#endif
+
+#include "alpha.hpp"
+#include "intpack.hpp"
+#include "reflect.hpp"
+#include "varint.hpp"
+
+namespace astro::serial {
+
+   /**
+    * @brief How a single column is laid out.
+    *
+    * plain is the values back to back, aligned to the element type. delta_packed stores zigzag deltas between consecutive
+    * values, bit packed with one width per block of 128. strings is a delta_packed length column followed by the bytes.
+    * generic falls back to the row codec for every value of the column.
+    */
+   enum class column_encoding : std::uint8_t { plain = 0, delta_packed = 1, strings = 2, generic = 3 };
+
+   namespace detail {
+      template <typename M>
+      concept integer_column = (std::integral<M> && !std::is_same_v<M, bool>) || std::is_enum_v<M> || varint_type<M>;
+
+      template <typename M>
+      concept string_column = is_basic_string<M>::value || std::is_same_v<M, std::string_view>;
+
+      template <typename M>
+      struct column_int {
+         using type = M;
+      };
+
+      template <typename M>
+      requires std::is_enum_v<M>
+      struct column_int<M> {
+         using type = std::underlying_type_t<M>;
+      };
+
+      template <varint_type M>
+      struct column_int<M> {
+         using type = typename M::value_type;
+      };
+
+      template <typename M>
+      using column_uint_t = std::make_unsigned_t<typename column_int<M>::type>;
+
+      template <typename M>
+      constexpr static inline column_uint_t<M> to_column_uint(const M& v) noexcept {
+         if constexpr (varint_type<M>)
+            return static_cast<column_uint_t<M>>(v.value);
+         else
+            return static_cast<column_uint_t<M>>(v);
+      }
+
+      template <typename M>
+      constexpr static inline M from_column_uint(column_uint_t<M> v) noexcept {
+         using I = typename column_int<M>::type;
+         if constexpr (varint_type<M>)
+            return M{static_cast<I>(v)};
+         else
+            return static_cast<M>(static_cast<I>(v));
+      }
+
+      template <std::unsigned_integral U>
+      constexpr static inline U delta_zigzag(U cur, U prev) noexcept {
+         return zigzag_encode(static_cast<std::make_signed_t<U>>(static_cast<U>(cur - prev)));
+      }
+
+      template <std::unsigned_integral U>
+      constexpr static inline U zigzag_delta(U zz) noexcept {
+         return static_cast<U>(zigzag_decode<std::make_signed_t<U>>(zz));
+      }
+
+      /**
+       * @brief The delta_packed size of a column, used to choose between it and plain.
+       */
+      template <std::unsigned_integral U>
+      static inline std::size_t delta_packed_size(std::span<const U> vals) noexcept {
+         std::size_t total = 0;
+         U           prev  = 0;
+         for (std::size_t b = 0; b < vals.size(); b += pack_block) {
+            const std::size_t n    = std::min(pack_block, vals.size() - b);
+            std::uint64_t     mask = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+               mask |= delta_zigzag(vals[b + i], prev);
+               prev  = vals[b + i];
+            }
+            total += 1 + (n * bit_width_of(mask) + 7) / 8;
+         }
+         return total;
+      }
+
+      template <std::unsigned_integral U>
+      static inline void write_delta_packed(serializer_base& a, std::span<const U> vals) {
+         std::uint64_t zz[pack_block];
+         U             prev = 0;
+         for (std::size_t b = 0; b < vals.size(); b += pack_block) {
+            const std::size_t n    = std::min(pack_block, vals.size() - b);
+            std::uint64_t     mask = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+               zz[i]  = delta_zigzag(vals[b + i], prev);
+               mask  |= zz[i];
+               prev   = vals[b + i];
+            }
+            const auto w = static_cast<std::uint8_t>(bit_width_of(mask));
+            a.write(&w, 1);
+            bit_writer bw{a};
+            for (std::size_t i = 0; i < n; ++i)
+               bw.put(zz[i], w);
+            bw.flush();
+         }
+      }
+
+      template <std::unsigned_integral U>
+      static inline void read_delta_packed(std::span<const std::uint8_t> in, U* out, std::size_t count) {
+         std::size_t p    = 0;
+         U           prev = 0;
+         for (std::size_t b = 0; b < count; b += pack_block) {
+            const std::size_t n = std::min(pack_block, count - b);
+            util::check(p < in.size(), "columnar: truncated column");
+            const std::size_t w     = in[p++];
+            const std::size_t bytes = (n * w + 7) / 8;
+            util::check(w <= sizeof(U) * 8 && bytes <= in.size() - p, "columnar: malformed column");
+            bit_reader br{in.subspan(p, bytes)};
+            for (std::size_t i = 0; i < n; ++i)
+               out[b + i] = zigzag_delta(static_cast<U>(br.get(w)));
+            prefix_sum(out + b, n, prev);
+            prev  = out[b + n - 1];
+            p    += bytes;
+         }
+      }
+
+      template <typename M>
+      constexpr static inline bool plain_column = !string_column<M> && is_dense<M>();
+
+      template <typename M>
+      static inline column_encoding choose_encoding(std::span<const column_uint_t<M>> ints) noexcept {
+         return delta_packed_size(ints) < ints.size() * sizeof(M) ? column_encoding::delta_packed : column_encoding::plain;
+      }
+
+      template <reflected_type T, std::size_t I>
+      using member_t = std::remove_cvref_t<std::tuple_element_t<I, typename T::reflected_member_types>>;
+
+      template <reflected_type T, std::size_t I>
+      static inline const member_t<T, I>& member(const T& row) noexcept {
+         return std::get<I>(row.reflected_tie());
+      }
+
+      template <reflected_type T, std::size_t I>
+      static inline member_t<T, I>& member(T& row) noexcept {
+         return std::get<I>(row.reflected_tie());
+      }
+
+      /**
+       * @brief Writes one column and returns its encoding.
+       */
+      template <reflected_type T, std::size_t I>
+      static inline column_encoding encode_column(serializer_base& a, std::span<const T> rows) {
+         using M = member_t<T, I>;
+         if constexpr (integer_column<M>) {
+            std::vector<column_uint_t<M>> ints(rows.size());
+            for (std::size_t r = 0; r < rows.size(); ++r)
+               ints[r] = to_column_uint(member<T, I>(rows[r]));
+            if constexpr (is_dense<M>()) {
+               if (choose_encoding<M>(ints) == column_encoding::plain) {
+                  a.write_padding(alignof(M));
+                  a.write(ints.data(), ints.size() * sizeof(M));
+                  return column_encoding::plain;
+               }
+            }
+            write_delta_packed<column_uint_t<M>>(a, ints);
+            return column_encoding::delta_packed;
+         } else if constexpr (string_column<M>) {
+            std::vector<std::uint32_t> lens(rows.size());
+            for (std::size_t r = 0; r < rows.size(); ++r) {
+               const auto& s = member<T, I>(rows[r]);
+               util::check(s.size() <= UINT32_MAX, "columnar: string too long");
+               lens[r] = static_cast<std::uint32_t>(s.size());
+            }
+            write_delta_packed<std::uint32_t>(a, lens);
+            for (const auto& row : rows) {
+               const auto& s = member<T, I>(row);
+               a.write(s.data(), s.size());
+            }
+            return column_encoding::strings;
+         } else if constexpr (plain_column<M>) {
+            a.write_padding(alignof(M));
+            for (const auto& row : rows)
+               a.write(&member<T, I>(row), sizeof(M));
+            return column_encoding::plain;
+         } else {
+            for (const auto& row : rows)
+               write_value(a, member<T, I>(row));
+            return column_encoding::generic;
+         }
+      }
+
+      /**
+       * @brief Decodes one column, store(r, value) receives each row's value.
+       * @param buf The archive bytes up to the end of the column, padding is relative to its start.
+       * @param off Where the column starts in buf.
+       */
+      template <typename M, typename Store>
+      static inline void decode_column(std::span<const std::uint8_t> buf, std::size_t off, column_encoding enc, std::size_t n,
+                                       Store&& store) {
+         const std::span<const std::uint8_t> in  = buf.subspan(off);
+         const std::size_t                   pad = (alignof(M) - off % alignof(M)) % alignof(M);
+         switch (enc) {
+            case column_encoding::plain:
+               if constexpr (plain_column<M>) {
+                  util::check(pad <= in.size() && n <= (in.size() - pad) / sizeof(M), "columnar: truncated column");
+                  for (std::size_t r = 0; r < n; ++r) {
+                     M v;
+                     std::memcpy(&v, in.data() + pad + r * sizeof(M), sizeof(M));
+                     store(r, std::move(v));
+                  }
+                  return;
+               }
+               break;
+            case column_encoding::delta_packed:
+               if constexpr (integer_column<M>) {
+                  std::vector<column_uint_t<M>> ints(n);
+                  read_delta_packed(in, ints.data(), n);
+                  for (std::size_t r = 0; r < n; ++r)
+                     store(r, from_column_uint<M>(ints[r]));
+                  return;
+               }
+               break;
+            case column_encoding::strings:
+               if constexpr (string_column<M>) {
+                  std::vector<std::uint32_t> lens(n);
+                  // the length column ends where its blocks end
+                  std::size_t p = 0;
+                  for (std::size_t b = 0; b < n; b += pack_block) {
+                     util::check(p < in.size(), "columnar: truncated column");
+                     p += 1 + (std::min(pack_block, n - b) * in[p] + 7) / 8;
+                  }
+                  util::check(p <= in.size(), "columnar: truncated column");
+                  read_delta_packed(in.first(p), lens.data(), n);
+                  const auto  rest = in.subspan(p);
+                  std::size_t at   = 0;
+                  for (std::size_t r = 0; r < n; ++r) {
+                     util::check(lens[r] <= rest.size() - at, "columnar: truncated column");
+                     store(r, M(reinterpret_cast<const char*>(rest.data() + at), lens[r]));
+                     at += lens[r];
+                  }
+                  return;
+               }
+               break;
+            case column_encoding::generic: {
+               // nested arrays pad relative to the archive, so the cursor keeps the absolute offset
+               serializer_base sub{buf};
+               sub.pos(static_cast<serializer_base::pos_t>(off));
+               for (std::size_t r = 0; r < n; ++r)
+                  store(r, read_value<M>(sub));
+               return;
+            }
+            default:
+               break;
+         }
+         util::check(false, "columnar: unexpected column encoding");
+      }
+
+      /**
+       * @brief The most rows a column of len bytes can hold, so a header row count is checked before anything is allocated.
+       */
+      template <typename M>
+      static inline std::size_t max_column_rows(column_encoding enc, std::size_t len) noexcept {
+         switch (enc) {
+            case column_encoding::plain:
+               return len / sizeof(M);
+            case column_encoding::delta_packed:
+            case column_encoding::strings:
+               // every block of pack_block rows starts with its width byte
+               return len > SIZE_MAX / pack_block ? SIZE_MAX : len * pack_block;
+            default:
+               return min_size<M>() == 0 ? SIZE_MAX : len / min_size<M>();
+         }
+      }
+
+      struct column_header {
+         std::uint32_t                rows = 0;
+         std::vector<column_encoding> encodings;
+         std::vector<std::size_t>     offsets;
+         std::vector<std::size_t>     lengths;
+         std::size_t                  end = 0;
+      };
+
+      static inline column_header read_column_header(serializer_base& a, std::size_t expected) {
+         column_header h;
+         std::uint16_t cols = 0;
+         a.read(&h.rows, sizeof(h.rows));
+         a.read(&cols, sizeof(cols));
+         util::check(cols == expected, "columnar: column count does not match the type");
+         h.encodings.resize(cols);
+         h.offsets.resize(cols);
+         h.lengths.resize(cols);
+         std::size_t at = static_cast<std::size_t>(a.pos()) + cols * (1 + sizeof(std::uint64_t));
+         for (std::size_t c = 0; c < cols; ++c) {
+            std::uint64_t len = 0;
+            a.read(&h.encodings[c], 1);
+            a.read(&len, sizeof(len));
+            util::check(len <= a.size(), "columnar: malformed directory");
+            h.offsets[c]  = at;
+            h.lengths[c]  = static_cast<std::size_t>(len);
+            at           += h.lengths[c];
+         }
+         util::check(at <= a.size(), "columnar: truncated input");
+         h.end = at;
+         return h;
+      }
+   } // namespace detail
+
+   /**
+    * @brief Writes rows as one column per reflected member, with a directory of column encodings and byte lengths up front so
+    * readers can skip the columns they do not need.
+    */
+   template <reflected_type T>
+   static inline void write_columns(serializer_base& a, std::span<const T> rows) {
+      constexpr std::size_t cols = std::tuple_size_v<typename T::reflected_member_types>;
+      static_assert(cols <= UINT16_MAX, "columnar: too many columns");
+      util::check(rows.size() <= UINT32_MAX, "columnar: too many rows");
+      const auto          n = static_cast<std::uint32_t>(rows.size());
+      const std::uint16_t c = cols;
+      a.write(&n, sizeof(n));
+      a.write(&c, sizeof(c));
+
+      const auto         dir                              = a.pos();
+      const std::uint8_t blank[1 + sizeof(std::uint64_t)] = {};
+      for (std::size_t i = 0; i < cols; ++i)
+         a.write(blank, sizeof(blank));
+
+      [&]<std::size_t... I>(std::index_sequence<I...>) {
+         ([&] {
+            const auto          start = a.pos();
+            const auto          enc   = detail::encode_column<T, I>(a, rows);
+            const std::uint64_t len   = static_cast<std::uint64_t>(a.pos() - start);
+            const auto          entry = dir + static_cast<serializer_base::pos_t>(I * sizeof(blank));
+            a.write(entry, &enc, 1);
+            a.write(entry + 1, &len, sizeof(len));
+         }(), ...);
+      }(std::make_index_sequence<cols>{});
+   }
+
+   /**
+    * @brief Decodes a single column without materializing the rows.
+    */
+   template <reflected_type T, std::size_t I>
+   static inline std::vector<detail::member_t<T, I>> read_column(serializer_base& a) {
+      using M        = detail::member_t<T, I>;
+      const auto     h = detail::read_column_header(a, std::tuple_size_v<typename T::reflected_member_types>);
+      util::check(h.rows <= detail::max_column_rows<M>(h.encodings[I], h.lengths[I]), "columnar: row count exceeds the column");
+      std::vector<M> out(h.rows);
+      detail::decode_column<M>({a.data(), h.offsets[I] + h.lengths[I]}, h.offsets[I], h.encodings[I], h.rows,
+                               [&](std::size_t r, M&& v) { out[r] = std::move(v); });
+      a.pos(static_cast<serializer_base::pos_t>(h.end));
+      return out;
+   }
+
+   /**
+    * @brief Decodes rows written by write_columns.
+    * @param fields Member names to decode, the others keep their default value. Empty decodes every column.
+    */
+   template <reflected_type T>
+   static inline std::vector<T> read_columns(serializer_base& a, std::initializer_list<std::string_view> fields = {}) {
+      constexpr std::size_t cols  = std::tuple_size_v<typename T::reflected_member_types>;
+      constexpr auto        names = T::reflected_names();
+      std::array<bool, cols> wanted{};
+      for (std::size_t i = 0; i < cols; ++i)
+         wanted[i] = fields.size() == 0 || std::find(fields.begin(), fields.end(), names[i]) != fields.end();
+      for (const auto f : fields)
+         util::check(std::find(names.begin(), names.end(), f) != names.end(), "columnar: unknown field");
+
+      const auto h = detail::read_column_header(a, cols);
+      [&]<std::size_t... I>(std::index_sequence<I...>) {
+         util::check(((h.rows <= detail::max_column_rows<detail::member_t<T, I>>(h.encodings[I], h.lengths[I])) && ...),
+                     "columnar: row count exceeds the column");
+      }(std::make_index_sequence<cols>{});
+      std::vector<T> rows(h.rows);
+      [&]<std::size_t... I>(std::index_sequence<I...>) {
+         ([&] {
+            using M = detail::member_t<T, I>;
+            if (!wanted[I])
+               return;
+            detail::decode_column<M>({a.data(), h.offsets[I] + h.lengths[I]}, h.offsets[I], h.encodings[I], h.rows,
+                                     [&](std::size_t r, M&& v) { detail::member<T, I>(rows[r]) = std::move(v); });
+         }(), ...);
+      }(std::make_index_sequence<cols>{});
+      a.pos(static_cast<serializer_base::pos_t>(h.end));
+      return rows;
+   }
+
+   /**
+    * @brief Tags a vector of reflected rows for columnar serialization through alpha.
+    */
+   template <reflected_type T>
+   struct columnar {
+      std::vector<T> rows;
+   };
+
+   template <typename C>
+   constexpr static inline bool is_columnar_v = false;
+
+   template <typename T>
+   constexpr static inline bool is_columnar_v<columnar<T>> = true;
+
+   template <typename C>
+   concept columnar_type = is_columnar_v<C>;
+
+   template <typename T>
+   static inline void serialize(alpha& a, const columnar<T>& c) {
+      write_columns<T>(a, c.rows);
+   }
+
+   template <columnar_type C>
+   static inline C deserialize(alpha& a) {
+      using T = std::remove_cvref_t<decltype(std::declval<C>().rows[0])>;
+      return C{read_columns<T>(a)};
+   }
+} // namespace astro::serial
@@ -0,0 +1,578 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+   #include <emmintrin.h>
+#endif
+
+#include "serializer.hpp"
+#include "varint.hpp"
+
+namespace astro::serial {
+
+   /**
+    * @brief How an integer column is transformed before bit packing.
+    *
+    * bitpack stores the values as they are, frame_of_reference subtracts the block minimum, delta stores zigzag
+    * differences between neighbours and delta_of_delta the zigzag differences between neighbouring deltas, which
+    * is near zero for regularly spaced timestamps.
+    */
+   enum class int_codec : std::uint8_t { bitpack = 0, frame_of_reference = 1, delta = 2, delta_of_delta = 3 };
+
+   template <typename T>
+   concept packable_int = std::integral<T> && !std::is_same_v<T, bool>;
+
+   namespace detail {
+      constexpr static inline std::size_t pack_block = 128;
+
+      constexpr static inline std::size_t bit_width_of(std::uint64_t v) noexcept { return static_cast<std::size_t>(std::bit_width(v)); }
+
+      struct bit_writer {
+         serializer_base& a;
+         std::uint64_t    acc  = 0;
+         std::size_t      bits = 0;
+
+         inline void put(std::uint64_t v, std::size_t w) {
+            if (w == 0)
+               return;
+            acc |= v << bits;
+            if (bits + w >= 64) {
+               a.write(&acc, sizeof(acc));
+               acc  = bits == 0 ? 0 : v >> (64 - bits);
+               bits = bits + w - 64;
+            } else {
+               bits += w;
+            }
+         }
+
+         inline void flush() {
+            if (bits != 0)
+               a.write(&acc, (bits + 7) / 8);
+            acc  = 0;
+            bits = 0;
+         }
+      };
+
+      struct bit_reader {
+         std::span<const std::uint8_t> in;
+         std::size_t                   pos = 0;
+
+         inline std::uint64_t load(std::size_t byte) const noexcept {
+            std::uint64_t v = 0;
+            if (byte < in.size())
+               std::memcpy(&v, in.data() + byte, std::min<std::size_t>(8, in.size() - byte));
+            return v;
+         }
+
+         inline std::uint64_t get(std::size_t w) noexcept {
+            if (w == 0)
+               return 0;
+            const std::size_t byte  = pos >> 3;
+            const std::size_t shift = pos & 7;
+            std::uint64_t     v     = load(byte) >> shift;
+            if (shift + w > 64)
+               v |= load(byte + 8) << (64 - shift);
+            pos += w;
+            return w == 64 ? v : v & ((std::uint64_t{1} << w) - 1);
+         }
+      };
+
+      /**
+       * @brief Running sum in place, starting from prev. 32 and 64-bit lanes add within a register in log steps.
+       */
+      template <std::unsigned_integral U>
+      static inline void prefix_sum(U* data, std::size_t n, U prev) noexcept {
+         std::size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+         if constexpr (sizeof(U) == 4) {
+            __m128i run = _mm_set1_epi32(static_cast<int>(prev));
+            for (; i + 4 <= n; i += 4) {
+               __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+               x         = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+               x         = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+               x         = _mm_add_epi32(x, run);
+               _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), x);
+               run = _mm_shuffle_epi32(x, 0xff);
+            }
+         } else if constexpr (sizeof(U) == 8) {
+            __m128i run = _mm_set1_epi64x(static_cast<long long>(prev));
+            for (; i + 2 <= n; i += 2) {
+               __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+               x         = _mm_add_epi64(x, _mm_slli_si128(x, 8));
+               x         = _mm_add_epi64(x, run);
+               _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), x);
+               run = _mm_shuffle_epi32(x, 0xee);
+            }
+         }
+         if (i != 0)
+            prev = data[i - 1];
+#endif
+         for (; i < n; ++i) {
+            prev    = static_cast<U>(prev + data[i]);
+            data[i] = prev;
+         }
+      }
+
+
+      /**
+       * @brief BP128 layout: 128 values of at most W bits in 4W words per lane, value i in lane i % 4.
+       *
+       * Every lane packs its 32 values back to back, so one SIMD shift and or handles four values and the
+       * offsets are compile-time constants once the width is known.
+       */
+      template <unsigned W>
+      static inline void bp128_pack(const std::uint32_t* in, std::uint8_t* out) noexcept {
+         if constexpr (W != 0) {
+#if defined(__SSE2__) || defined(_M_X64)
+            auto* o   = reinterpret_cast<__m128i*>(out);
+            __m128i acc = _mm_setzero_si128();
+            [&]<std::size_t... K>(std::index_sequence<K...>) {
+               (
+                     [&] {
+                        constexpr unsigned shift = (K * W) % 32;
+                        const __m128i      v     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 4 * K));
+                        acc                      = shift == 0 ? v : _mm_or_si128(acc, _mm_slli_epi32(v, shift));
+                        if constexpr (shift + W >= 32) {
+                           _mm_storeu_si128(o + (K * W) / 32, acc);
+                           if constexpr (shift + W > 32)
+                              acc = _mm_srli_epi32(v, 32 - shift);
+                        }
+                     }(),
+                     ...);
+            }(std::make_index_sequence<32>{});
+#else
+            for (std::size_t lane = 0; lane < 4; ++lane) {
+               std::uint32_t acc = 0;
+               for (std::size_t k = 0; k < 32; ++k) {
+                  const unsigned      shift = (k * W) % 32;
+                  const std::uint32_t v     = in[4 * k + lane];
+                  acc                       = shift == 0 ? v : acc | (v << shift);
+                  if (shift + W >= 32) {
+                     std::memcpy(out + ((k * W) / 32 * 4 + lane) * 4, &acc, 4);
+                     if (shift + W > 32)
+                        acc = v >> ((32 - shift) & 31);
+                  }
+               }
+            }
+#endif
+         }
+      }
+
+      template <unsigned W>
+      static inline void bp128_unpack(const std::uint8_t* in, std::uint32_t* out) noexcept {
+         if constexpr (W == 0) {
+            std::memset(out, 0, pack_block * 4);
+         } else {
+#if defined(__SSE2__) || defined(_M_X64)
+            const auto*   ip   = reinterpret_cast<const __m128i*>(in);
+            const __m128i mask = _mm_set1_epi32(static_cast<int>(W == 32 ? ~0u : (1u << W) - 1));
+            [&]<std::size_t... K>(std::index_sequence<K...>) {
+               (
+                     [&] {
+                        constexpr unsigned start = K * W;
+                        constexpr unsigned shift = start % 32;
+                        __m128i            v     = _mm_srli_epi32(_mm_loadu_si128(ip + start / 32), shift);
+                        if constexpr (shift + W > 32)
+                           v = _mm_or_si128(v, _mm_slli_epi32(_mm_loadu_si128(ip + start / 32 + 1), 32 - shift));
+                        if constexpr (W != 32)
+                           v = _mm_and_si128(v, mask);
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * K), v);
+                     }(),
+                     ...);
+            }(std::make_index_sequence<32>{});
+#else
+            const std::uint32_t mask = W == 32 ? ~0u : (1u << W) - 1;
+            for (std::size_t lane = 0; lane < 4; ++lane) {
+               for (std::size_t k = 0; k < 32; ++k) {
+                  const unsigned start = static_cast<unsigned>(k * W);
+                  const unsigned shift = start % 32;
+                  std::uint32_t  lo, hi = 0;
+                  std::memcpy(&lo, in + (start / 32 * 4 + lane) * 4, 4);
+                  if (shift + W > 32)
+                     std::memcpy(&hi, in + ((start / 32 + 1) * 4 + lane) * 4, 4);
+                  std::uint32_t v = lo >> shift;
+                  if (shift + W > 32)
+                     v |= hi << (32 - shift);
+                  out[4 * k + lane] = v & mask;
+               }
+            }
+#endif
+         }
+      }
+
+      using bp128_pack_fn   = void (*)(const std::uint32_t*, std::uint8_t*) noexcept;
+      using bp128_unpack_fn = void (*)(const std::uint8_t*, std::uint32_t*) noexcept;
+
+      constexpr static inline auto bp128_packers = []<std::size_t... W>(std::index_sequence<W...>) {
+         return std::array<bp128_pack_fn, sizeof...(W)>{&bp128_pack<W>...};
+      }(std::make_index_sequence<33>{});
+
+      constexpr static inline auto bp128_unpackers = []<std::size_t... W>(std::index_sequence<W...>) {
+         return std::array<bp128_unpack_fn, sizeof...(W)>{&bp128_unpack<W>...};
+      }(std::make_index_sequence<33>{});
+
+      /**
+       * @brief One value out of a BP128 block without unpacking the rest.
+       */
+      static inline std::uint32_t bp128_get(const std::uint8_t* in, unsigned w, std::size_t i) noexcept {
+         if (w == 0)
+            return 0;
+         const std::size_t lane  = i % 4;
+         const std::size_t start = i / 4 * w;
+         const std::size_t shift = start % 32;
+         std::uint32_t     lo, hi = 0;
+         std::memcpy(&lo, in + (start / 32 * 4 + lane) * 4, 4);
+         std::uint64_t v = lo >> shift;
+         if (shift + w > 32) {
+            std::memcpy(&hi, in + ((start / 32 + 1) * 4 + lane) * 4, 4);
+            v |= std::uint64_t{hi} << (32 - shift);
+         }
+         return static_cast<std::uint32_t>(w == 32 ? v : v & ((1u << w) - 1));
+      }
+
+      /**
+       * @brief Undoes zigzag_encode in place, treating the values as signed at the width of U.
+       */
+      template <std::unsigned_integral U>
+      static inline void unzigzag(U* data, std::size_t n) noexcept {
+         std::size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+         const __m128i one = sizeof(U) == 4 ? _mm_set1_epi32(1) : _mm_set1_epi64x(1);
+         for (; i + 16 / sizeof(U) <= n; i += 16 / sizeof(U)) {
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i       r;
+            if constexpr (sizeof(U) == 4)
+               r = _mm_xor_si128(_mm_srli_epi32(x, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(x, one)));
+            else
+               r = _mm_xor_si128(_mm_srli_epi64(x, 1), _mm_sub_epi64(_mm_setzero_si128(), _mm_and_si128(x, one)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), r);
+         }
+#endif
+         for (; i < n; ++i)
+            data[i] = static_cast<U>((data[i] >> 1) ^ (~(data[i] & 1) + 1));
+      }
+
+      template <std::unsigned_integral U>
+      static inline void add_base(U* data, std::size_t n, U base) noexcept {
+         std::size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+         const __m128i b = sizeof(U) == 4 ? _mm_set1_epi32(static_cast<int>(base)) : _mm_set1_epi64x(static_cast<long long>(base));
+         for (; i + 16 / sizeof(U) <= n; i += 16 / sizeof(U)) {
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), sizeof(U) == 4 ? _mm_add_epi32(x, b) : _mm_add_epi64(x, b));
+         }
+#endif
+         for (; i < n; ++i)
+            data[i] = static_cast<U>(data[i] + base);
+      }
+
+      /**
+       * @brief The integer the codecs compute with, 32 bits for everything up to int32.
+       */
+      template <packable_int T>
+      using int_work_t = std::conditional_t<(sizeof(T) <= 4), std::uint32_t, std::uint64_t>;
+
+      constexpr static inline std::size_t int_header_size = 12;
+
+      constexpr static inline std::size_t int_ref_count(int_codec c) noexcept {
+         return c == int_codec::bitpack ? 0 : c == int_codec::delta_of_delta ? 2 : 1;
+      }
+   } // namespace detail
+
+   /**
+    * @brief Writes an integer column in blocks of 128, each bit packed at its own width.
+    *
+    * The layout is a 12 byte header (codec, value size, count, payload size), the offset of every block in the payload
+    * and the blocks. A block is its bit width, the LEB128 references it needs (minimum, previous value, previous delta)
+    * and the values, BP128 packed when they fit 32 bits. Blocks only depend on their own references, so any block can
+    * be decoded on its own.
+    */
+   template <packable_int T>
+   static inline void write_ints(serializer_base& a, std::span<const T> vals, int_codec codec) {
+      using U                  = std::make_unsigned_t<T>;
+      using S                  = std::make_signed_t<T>;
+      util::check(vals.size() <= UINT32_MAX, "intpack: too many values");
+
+      const std::size_t           blocks = (vals.size() + detail::pack_block - 1) / detail::pack_block;
+      std::vector<std::uint32_t>  offsets(blocks);
+      const auto                  at     = a.pos();
+      const std::uint8_t          hdr[4] = {static_cast<std::uint8_t>(codec), static_cast<std::uint8_t>(sizeof(T)), 0, 0};
+      const auto                  count  = static_cast<std::uint32_t>(vals.size());
+      std::uint32_t               bytes  = 0;
+      a.write(hdr, sizeof(hdr));
+      a.write(&count, sizeof(count));
+      a.write(&bytes, sizeof(bytes));
+      a.write(offsets.data(), offsets.size() * sizeof(std::uint32_t));
+      const auto start = a.pos();
+
+      U prev   = vals.empty() ? U{0} : static_cast<U>(vals[0]);
+      U prev_d = 0;
+      alignas(16) std::uint32_t narrow[detail::pack_block];
+      std::uint64_t             x[detail::pack_block];
+      for (std::size_t b = 0; b < blocks; ++b) {
+         const std::size_t first = b * detail::pack_block;
+         const std::size_t n     = std::min(detail::pack_block, vals.size() - first);
+         const auto        block = vals.subspan(first, n);
+         util::check(static_cast<std::uint64_t>(a.pos() - start) <= UINT32_MAX, "intpack: column too large");
+         offsets[b] = static_cast<std::uint32_t>(a.pos() - start);
+
+         std::uint64_t refs[2] = {};
+         switch (codec) {
+            case int_codec::bitpack:
+               for (std::size_t i = 0; i < n; ++i)
+                  x[i] = static_cast<U>(block[i]);
+               break;
+            case int_codec::frame_of_reference: {
+               const U lo = static_cast<U>(*std::min_element(block.begin(), block.end()));
+               refs[0]    = lo;
+               for (std::size_t i = 0; i < n; ++i)
+                  x[i] = static_cast<U>(static_cast<U>(block[i]) - lo);
+               break;
+            }
+            case int_codec::delta:
+               refs[0] = prev;
+               for (std::size_t i = 0; i < n; ++i) {
+                  x[i] = zigzag_encode(static_cast<S>(static_cast<U>(static_cast<U>(block[i]) - prev)));
+                  prev = static_cast<U>(block[i]);
+               }
+               break;
+            case int_codec::delta_of_delta:
+               refs[0] = prev;
+               refs[1] = prev_d;
+               for (std::size_t i = 0; i < n; ++i) {
+                  const U d = static_cast<U>(static_cast<U>(block[i]) - prev);
+                  x[i]      = zigzag_encode(static_cast<S>(static_cast<U>(d - prev_d)));
+                  prev      = static_cast<U>(block[i]);
+                  prev_d    = d;
+               }
+               break;
+            default:
+               util::check(false, "intpack: unknown codec");
+         }
+
+         std::uint64_t mask = 0;
+         for (std::size_t i = 0; i < n; ++i)
+            mask |= x[i];
+         const auto w = static_cast<std::uint8_t>(detail::bit_width_of(mask));
+         a.write(&w, 1);
+         for (std::size_t r = 0; r < detail::int_ref_count(codec); ++r)
+            write_varint(a, refs[r]);
+
+         if (w <= 32) {
+            for (std::size_t i = 0; i < detail::pack_block; ++i)
+               narrow[i] = i < n ? static_cast<std::uint32_t>(x[i]) : 0;
+            std::uint8_t packed[detail::pack_block * 4];
+            detail::bp128_packers[w](narrow, packed);
+            a.write(packed, 16 * w);
+         } else {
+            detail::bit_writer out{a};
+            for (std::size_t i = 0; i < n; ++i)
+               out.put(x[i], w);
+            out.flush();
+         }
+      }
+
+      util::check(static_cast<std::uint64_t>(a.pos() - start) <= UINT32_MAX, "intpack: column too large");
+      bytes = static_cast<std::uint32_t>(a.pos() - start);
+      a.write(at + 8, &bytes, sizeof(bytes));
+      if (!offsets.empty())
+         a.write(at + detail::int_header_size, offsets.data(), offsets.size() * sizeof(std::uint32_t));
+   }
+
+   /**
+    * @brief A read-only view of a column written by write_ints, decoding whole blocks or single values on demand.
+    */
+   template <packable_int T>
+   class packed_ints {
+      public:
+         packed_ints() = default;
+
+         /**
+          * @brief Parses the header, bytes must start at it and hold the whole column.
+          */
+         explicit packed_ints(std::span<const std::uint8_t> bytes) {
+            util::check(bytes.size() >= detail::int_header_size, "intpack: truncated header");
+            std::uint32_t payload = 0;
+            _codec                = static_cast<int_codec>(bytes[0]);
+            std::memcpy(&_count, bytes.data() + 4, sizeof(_count));
+            std::memcpy(&payload, bytes.data() + 8, sizeof(payload));
+            util::check(bytes[0] <= static_cast<std::uint8_t>(int_codec::delta_of_delta), "intpack: unknown codec");
+            util::check(bytes[1] == sizeof(T), "intpack: value size mismatch");
+            const std::size_t dir = block_count() * sizeof(std::uint32_t);
+            util::check(bytes.size() - detail::int_header_size >= dir &&
+                              bytes.size() - detail::int_header_size - dir >= payload,
+                        "intpack: truncated column");
+            _offsets = bytes.subspan(detail::int_header_size, dir);
+            _payload = bytes.subspan(detail::int_header_size + dir, payload);
+            _bytes   = bytes.first(detail::int_header_size + dir + payload);
+         }
+
+         /**
+          * @brief Borrows the column at the archive's cursor and moves past it.
+          */
+         static inline packed_ints read(serializer_base& a ASTRO_LIFETIMEBOUND) {
+            std::uint8_t hdr[detail::int_header_size];
+            a.read(a.pos(), hdr, sizeof(hdr));
+            std::uint32_t count, payload;
+            std::memcpy(&count, hdr + 4, sizeof(count));
+            std::memcpy(&payload, hdr + 8, sizeof(payload));
+            const std::size_t blocks = (std::size_t{count} + detail::pack_block - 1) / detail::pack_block;
+            return packed_ints{a.read_view(detail::int_header_size + blocks * sizeof(std::uint32_t) + payload)};
+         }
+
+         inline std::size_t size() const noexcept { return _count; }
+         inline bool empty() const noexcept { return _count == 0; }
+         inline int_codec codec() const noexcept { return _codec; }
+         inline std::size_t block_count() const noexcept { return (std::size_t{_count} + detail::pack_block - 1) / detail::pack_block; }
+         inline std::span<const std::uint8_t> bytes() const noexcept { return _bytes; }
+
+         /**
+          * @brief Decodes block b (values 128 * b onward) into out, which needs room for the whole block.
+          */
+         inline void decode_block(std::size_t b, std::span<T> out) const {
+            util::check(b < block_count(), "intpack: block out of range");
+            const std::size_t n = std::min(detail::pack_block, _count - b * detail::pack_block);
+            util::check(out.size() >= n, "intpack: output too small");
+            decode_into(b, n, out.data());
+         }
+
+         inline void decode(std::span<T> out) const {
+            util::check(out.size() >= _count, "intpack: output too small");
+            for (std::size_t b = 0; b < block_count(); ++b)
+               decode_into(b, std::min(detail::pack_block, _count - b * detail::pack_block), out.data() + b * detail::pack_block);
+         }
+
+         inline std::vector<T> decode() const {
+            std::vector<T> out(_count);
+            decode(out);
+            return out;
+         }
+
+         /**
+          * @brief Value i, read in place for bitpack and frame_of_reference, through its block for the delta codecs.
+          */
+         inline T operator[](std::size_t i) const {
+            util::check(i < _count, "intpack: index out of range");
+            const std::size_t b = i / detail::pack_block;
+            const std::size_t k = i % detail::pack_block;
+            if (_codec == int_codec::bitpack || _codec == int_codec::frame_of_reference) {
+               const block_info blk = block(b);
+               if (blk.width <= 32) {
+                  const std::uint64_t v = detail::bp128_get(blk.data, blk.width, k);
+                  return static_cast<T>(static_cast<std::make_unsigned_t<T>>(v + blk.refs[0]));
+               }
+            }
+            T tmp[detail::pack_block];
+            decode_into(b, std::min(detail::pack_block, _count - b * detail::pack_block), tmp);
+            return tmp[k];
+         }
+
+      private:
+         using W = detail::int_work_t<T>;
+
+         struct block_info {
+            unsigned            width   = 0;
+            std::uint64_t       refs[2] = {};
+            const std::uint8_t* data    = nullptr;
+         };
+
+         inline block_info block(std::size_t b) const {
+            std::uint32_t off;
+            std::memcpy(&off, _offsets.data() + b * sizeof(off), sizeof(off));
+            util::check(off < _payload.size(), "intpack: bad block offset");
+            const std::uint8_t* p   = _payload.data() + off;
+            const std::uint8_t* end = _payload.data() + _payload.size();
+            block_info          blk;
+            blk.width = *p++;
+            util::check(blk.width <= sizeof(T) * 8, "intpack: bad block width");
+            for (std::size_t r = 0; r < detail::int_ref_count(_codec); ++r)
+               p += decode_varint(p, static_cast<std::size_t>(end - p), blk.refs[r]);
+            const std::size_t n     = std::min(detail::pack_block, _count - b * detail::pack_block);
+            const std::size_t bytes = blk.width <= 32 ? 16 * blk.width : (n * blk.width + 7) / 8;
+            util::check(bytes <= static_cast<std::size_t>(end - p), "intpack: truncated block");
+            blk.data = p;
+            return blk;
+         }
+
+         inline void decode_into(std::size_t b, std::size_t n, T* out) const {
+            const block_info blk = block(b);
+
+            // full blocks of 32-bit values decode in place, everything else goes through a scratch block
+            alignas(16) W scratch[detail::pack_block];
+            W*            v = (sizeof(T) == sizeof(W) && n == detail::pack_block) ? reinterpret_cast<W*>(out) : scratch;
+
+            if (blk.width <= 32) {
+               if constexpr (sizeof(W) == 4) {
+                  detail::bp128_unpackers[blk.width](blk.data, v);
+               } else {
+                  alignas(16) std::uint32_t narrow[detail::pack_block];
+                  detail::bp128_unpackers[blk.width](blk.data, narrow);
+                  widen(narrow, v, n);
+               }
+            } else {
+               detail::bit_reader in{{blk.data, (n * blk.width + 7) / 8}};
+               for (std::size_t i = 0; i < n; ++i)
+                  v[i] = static_cast<W>(in.get(blk.width));
+            }
+
+            switch (_codec) {
+               case int_codec::bitpack:
+                  break;
+               case int_codec::frame_of_reference:
+                  detail::add_base(v, n, static_cast<W>(blk.refs[0]));
+                  break;
+               case int_codec::delta:
+                  detail::unzigzag(v, n);
+                  detail::prefix_sum(v, n, static_cast<W>(blk.refs[0]));
+                  break;
+               case int_codec::delta_of_delta:
+                  detail::unzigzag(v, n);
+                  detail::prefix_sum(v, n, static_cast<W>(blk.refs[1]));
+                  detail::prefix_sum(v, n, static_cast<W>(blk.refs[0]));
+                  break;
+            }
+
+            if (v == scratch) {
+               for (std::size_t i = 0; i < n; ++i)
+                  out[i] = static_cast<T>(static_cast<std::make_unsigned_t<T>>(v[i]));
+            }
+         }
+
+         static inline void widen(const std::uint32_t* in, std::uint64_t* out, std::size_t n) noexcept {
+            std::size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+            for (; i + 4 <= n; i += 4) {
+               const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+               _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi32(x, _mm_setzero_si128()));
+               _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 2), _mm_unpackhi_epi32(x, _mm_setzero_si128()));
+            }
+#endif
+            for (; i < n; ++i)
+               out[i] = in[i];
+         }
+
+         int_codec                     _codec = int_codec::bitpack;
+         std::uint32_t                 _count = 0;
+         std::span<const std::uint8_t> _offsets;
+         std::span<const std::uint8_t> _payload;
+         std::span<const std::uint8_t> _bytes;
+   };
+
+   template <packable_int T>
+   static inline std::vector<T> read_ints(serializer_base& a) {
+      return packed_ints<T>::read(a).decode();
+   }
+
+} // namespace astro::serial
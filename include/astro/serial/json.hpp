@@ -0,0 +1,816 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+   #include <emmintrin.h>
+#endif
+#if defined(__AVX2__) || defined(__PCLMUL__)
+   #include <immintrin.h>
+#endif
+
+#include "../compile_time/meta.hpp"
+#include "../utils.hpp"
+#include "reflect.hpp"
+#include "varint.hpp"
+
+namespace astro::serial {
+
+   namespace detail::js {
+      template <typename T>
+      concept string_type = (is_basic_string<T>::value && sizeof(typename T::value_type) == 1) ||
+                            std::is_same_v<T, std::string_view>;
+
+      template <typename T>
+      concept number_type = (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>) || std::is_enum_v<T> ||
+                            varint_type<T> || fixed_type<T>;
+
+      template <typename T>
+      concept key_type = string_type<T> || (number_type<T> && !std::is_floating_point_v<T>);
+
+      template <typename T>
+      constexpr static inline bool is_json();
+
+      template <typename... Ts>
+      constexpr static inline bool all_json(std::type_identity<std::tuple<Ts...>>) {
+         return (is_json<std::remove_cvref_t<Ts>>() && ...);
+      }
+
+      /**
+       * @brief Whether T maps onto JSON: numbers, bools, strings, optionals (null), fixed-size tuples and arrays,
+       * sequences and sets (arrays), maps with string or integer keys and reflected types (objects).
+       */
+      template <typename T>
+      constexpr static inline bool is_json() {
+         if constexpr (std::is_same_v<T, bool> || number_type<T> || string_type<T>)
+            return true;
+         else if constexpr (reflected_type<T>)
+            return all_json(std::type_identity<typename T::reflected_member_types>{});
+         else if constexpr (is_optional<T>::value)
+            return is_json<typename T::value_type>();
+         else if constexpr (is_pair<T>::value)
+            return is_json<std::remove_const_t<typename T::first_type>>() && is_json<typename T::second_type>();
+         else if constexpr (is_tuple<T>::value)
+            return all_json(std::type_identity<T>{});
+         else if constexpr (is_std_array<T>::value)
+            return is_json<typename T::value_type>();
+         else if constexpr (map_type<T>)
+            return key_type<std::remove_const_t<typename T::key_type>> && is_json<typename T::mapped_type>();
+         else if constexpr (set_type<T>)
+            return is_json<typename T::key_type>();
+         else if constexpr (sequence_type<T>)
+            return is_json<typename T::value_type>();
+         else
+            return false;
+      }
+
+      template <typename T>
+      concept json_type = is_json<T>();
+
+      constexpr static inline bool is_ws(char c) noexcept { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+      /**
+       * @brief Length of the prefix of p that can go in a JSON string as is: no '"', '\\' or control characters.
+       */
+      static inline std::size_t plain_prefix(const char* p, std::size_t n) noexcept {
+         std::size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+         const __m128i quote = _mm_set1_epi8('"');
+         const __m128i slash = _mm_set1_epi8('\\');
+         const __m128i ctl   = _mm_set1_epi8(0x1F);
+         for (; i + 16 <= n; i += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            // max(v, 0x1F) == 0x1F exactly for the unsigned bytes below 0x20
+            const __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, slash)),
+                                           _mm_cmpeq_epi8(_mm_max_epu8(v, ctl), ctl));
+            if (const int bits = _mm_movemask_epi8(m))
+               return i + static_cast<std::size_t>(std::countr_zero(static_cast<unsigned>(bits)));
+         }
+#endif
+         for (; i < n; ++i) {
+            const auto c = static_cast<unsigned char>(p[i]);
+            if (c == '"' || c == '\\' || c < 0x20)
+               return i;
+         }
+         return n;
+      }
+
+      /**
+       * @brief Quoted keys for every field, each stored as ,"name": so the first field just drops the comma.
+       */
+      template <reflected_type T>
+      struct field_keys {
+         constexpr static auto        names = T::reflected_names();
+         constexpr static std::size_t count = names.size();
+
+         constexpr static auto offsets = [] {
+            std::array<std::size_t, count + 1> o{};
+            for (std::size_t i = 0; i < count; ++i)
+               o[i + 1] = o[i] + names[i].size() + 4;
+            return o;
+         }();
+
+         constexpr static auto text = [] {
+            std::array<char, offsets[count]> t{};
+            std::size_t                       at = 0;
+            for (const std::string_view n : names) {
+               t[at++] = ',';
+               t[at++] = '"';
+               for (const char c : n)
+                  t[at++] = c;
+               t[at++] = '"';
+               t[at++] = ':';
+            }
+            return t;
+         }();
+
+         constexpr static inline std::string_view key(std::size_t i) noexcept {
+            return {text.data() + offsets[i] + (i == 0), offsets[i + 1] - offsets[i] - (i == 0)};
+         }
+      };
+
+      constexpr static inline std::uint32_t key_hash(std::string_view s, std::uint32_t seed) noexcept {
+         std::uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+         for (const char c : s) {
+            h ^= static_cast<std::uint8_t>(c);
+            h *= 16777619u;
+         }
+         return h ^ (h >> 15);
+      }
+
+      /**
+       * @brief Perfect hash from field names to field indices, the seed is searched for at compile time.
+       *
+       * The table is sparse enough (at least 4n slots, n^2/4 for larger structs) that a seed turns up within a few tries.
+       */
+      template <reflected_type T>
+      struct field_index {
+         constexpr static auto        names = T::reflected_names();
+         constexpr static std::size_t count = names.size();
+         constexpr static std::size_t slots = std::bit_ceil(std::max<std::size_t>({4, 4 * count, count * count / 4}));
+         static_assert(count < 0xFFFF, "json: too many fields");
+
+         constexpr static std::uint32_t seed = [] {
+            for (std::uint32_t s = 0;; ++s) {
+               std::array<bool, slots> used{};
+               bool                    ok = true;
+               for (const std::string_view n : names) {
+                  const std::size_t h = key_hash(n, s) & (slots - 1);
+                  if (used[h]) {
+                     ok = false;
+                     break;
+                  }
+                  used[h] = true;
+               }
+               if (ok)
+                  return s;
+            }
+         }();
+
+         constexpr static auto table = [] {
+            std::array<std::uint16_t, slots> t{};
+            t.fill(0xFFFF);
+            for (std::size_t i = 0; i < count; ++i)
+               t[key_hash(names[i], seed) & (slots - 1)] = static_cast<std::uint16_t>(i);
+            return t;
+         }();
+
+         /**
+          * @brief The field named key, or count when there is none.
+          */
+         static inline std::size_t find(std::string_view key) noexcept {
+            const std::uint16_t i = table[key_hash(key, seed) & (slots - 1)];
+            return i != 0xFFFF && names[i] == key ? i : count;
+         }
+      };
+
+      //
+      // writer
+      //
+
+      static inline void write_string(std::string& out, std::string_view s) {
+         constexpr std::string_view hex = "0123456789abcdef";
+         out.push_back('"');
+         for (;;) {
+            const std::size_t k = plain_prefix(s.data(), s.size());
+            out.append(s.data(), k);
+            if (k == s.size())
+               break;
+            const auto c = static_cast<unsigned char>(s[k]);
+            switch (c) {
+               case '"': out.append("\\\""); break;
+               case '\\': out.append("\\\\"); break;
+               case '\b': out.append("\\b"); break;
+               case '\f': out.append("\\f"); break;
+               case '\n': out.append("\\n"); break;
+               case '\r': out.append("\\r"); break;
+               case '\t': out.append("\\t"); break;
+               default: {
+                  const char u[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15]};
+                  out.append(u, 6);
+               }
+            }
+            s.remove_prefix(k + 1);
+         }
+         out.push_back('"');
+      }
+
+      template <number_type T>
+      static inline void write_number(std::string& out, T v) {
+         if constexpr (varint_type<T> || fixed_type<T>)
+            write_number(out, v.value);
+         else if constexpr (std::is_enum_v<T>)
+            write_number(out, static_cast<std::underlying_type_t<T>>(v));
+         else {
+            if constexpr (std::is_floating_point_v<T>)
+               util::check(std::isfinite(v), "json: numbers must be finite");
+            char buf[32];
+            // floats use the shortest form that reads back to the same value
+            const auto r = std::to_chars(buf, buf + sizeof(buf), v);
+            out.append(buf, r.ptr);
+         }
+      }
+
+      template <typename T>
+      static inline void write_value(std::string& out, const T& v);
+
+      template <typename R>
+      static inline void write_array(std::string& out, const R& r) {
+         out.push_back('[');
+         bool first = true;
+         for (const auto& e : r) {
+            if (!first)
+               out.push_back(',');
+            first = false;
+            write_value(out, e);
+         }
+         out.push_back(']');
+      }
+
+      template <typename T>
+      static inline void write_value(std::string& out, const T& v) {
+         if constexpr (std::is_same_v<T, bool>)
+            out.append(v ? "true" : "false");
+         else if constexpr (number_type<T>)
+            write_number(out, v);
+         else if constexpr (string_type<T>)
+            write_string(out, v);
+         else if constexpr (reflected_type<T>) {
+            using keys = field_keys<T>;
+            const auto t = v.reflected_tie();
+            out.push_back('{');
+            [&]<std::size_t... I>(std::index_sequence<I...>) {
+               ((out.append(keys::key(I)), write_value(out, std::get<I>(t))), ...);
+            }(std::make_index_sequence<keys::count>{});
+            out.push_back('}');
+         } else if constexpr (is_optional<T>::value) {
+            if (v)
+               write_value(out, *v);
+            else
+               out.append("null");
+         } else if constexpr (is_pair<T>::value || is_tuple<T>::value) {
+            out.push_back('[');
+            std::apply(
+                  [&](const auto&... e) {
+                     bool first = true;
+                     ((first ? void() : out.push_back(','), first = false, write_value(out, e)), ...);
+                  },
+                  v);
+            out.push_back(']');
+         } else if constexpr (map_type<T>) {
+            out.push_back('{');
+            bool first = true;
+            for (const auto& [k, e] : v) {
+               if (!first)
+                  out.push_back(',');
+               first = false;
+               if constexpr (string_type<std::remove_cvref_t<decltype(k)>>)
+                  write_string(out, k);
+               else {
+                  // object keys are strings, numbers go in quotes
+                  out.push_back('"');
+                  write_number(out, k);
+                  out.push_back('"');
+               }
+               out.push_back(':');
+               write_value(out, e);
+            }
+            out.push_back('}');
+         } else
+            write_array(out, v);
+      }
+
+      //
+      // stage 1: structural index
+      //
+
+      /**
+       * @brief Per-byte class bitmasks of a 64 byte block.
+       */
+      struct block_masks {
+         std::uint64_t quote;
+         std::uint64_t backslash;
+         std::uint64_t op;
+         std::uint64_t ws;
+      };
+
+      // c | 0x20 folds '[' and ']' onto '{' and '}', and leaves ':' and ',' alone
+      static inline block_masks classify(const char* p) noexcept {
+         block_masks b;
+#if defined(__AVX2__)
+         const __m256i lo   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+         const __m256i hi   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+         const auto    eq   = [](__m256i v, char c) { return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)); };
+         const auto    bits = [&](auto&& f) {
+            return static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(f(lo)))) |
+                   (static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(f(hi)))) << 32);
+         };
+         const __m256i fold = _mm256_set1_epi8(0x20);
+         b.quote            = bits([&](__m256i v) { return eq(v, '"'); });
+         b.backslash        = bits([&](__m256i v) { return eq(v, '\\'); });
+         b.op               = bits([&](__m256i v) {
+            const __m256i f = _mm256_or_si256(v, fold);
+            return _mm256_or_si256(_mm256_or_si256(eq(f, '{'), eq(f, '}')), _mm256_or_si256(eq(f, ':'), eq(f, ',')));
+         });
+         b.ws               = bits([&](__m256i v) {
+            return _mm256_or_si256(_mm256_or_si256(eq(v, ' '), eq(v, '\t')), _mm256_or_si256(eq(v, '\n'), eq(v, '\r')));
+         });
+#elif defined(__SSE2__) || defined(_M_X64)
+         __m128i v[4];
+         for (int k = 0; k < 4; ++k)
+            v[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * k));
+         const auto eq   = [](__m128i x, char c) { return _mm_cmpeq_epi8(x, _mm_set1_epi8(c)); };
+         const auto bits = [&](auto&& f) {
+            std::uint64_t m = 0;
+            for (int k = 0; k < 4; ++k)
+               m |= static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(f(v[k])))) << (16 * k);
+            return m;
+         };
+         const __m128i fold = _mm_set1_epi8(0x20);
+         b.quote            = bits([&](__m128i x) { return eq(x, '"'); });
+         b.backslash        = bits([&](__m128i x) { return eq(x, '\\'); });
+         b.op               = bits([&](__m128i x) {
+            const __m128i f = _mm_or_si128(x, fold);
+            return _mm_or_si128(_mm_or_si128(eq(f, '{'), eq(f, '}')), _mm_or_si128(eq(f, ':'), eq(f, ',')));
+         });
+         b.ws               = bits([&](__m128i x) {
+            return _mm_or_si128(_mm_or_si128(eq(x, ' '), eq(x, '\t')), _mm_or_si128(eq(x, '\n'), eq(x, '\r')));
+         });
+#else
+         b = {};
+         for (int k = 0; k < 64; ++k) {
+            const char          c   = p[k];
+            const char          f   = static_cast<char>(c | 0x20);
+            const std::uint64_t bit = std::uint64_t{1} << k;
+            b.quote |= c == '"' ? bit : 0;
+            b.backslash |= c == '\\' ? bit : 0;
+            b.op |= (f == '{' || f == '}' || f == ':' || f == ',') ? bit : 0;
+            b.ws |= is_ws(c) ? bit : 0;
+         }
+#endif
+         return b;
+      }
+
+      /**
+       * @brief Characters escaped by an odd run of backslashes, carrying a run that crosses into the next block.
+       */
+      static inline std::uint64_t find_escaped(std::uint64_t backslash, std::uint64_t& carry) noexcept {
+         constexpr std::uint64_t even_bits = 0x5555555555555555ull;
+         if (!backslash) {
+            const std::uint64_t escaped = carry;
+            carry                       = 0;
+            return escaped;
+         }
+         backslash &= ~carry;
+         const std::uint64_t follows_escape = (backslash << 1) | carry;
+         const std::uint64_t odd_starts     = backslash & ~even_bits & ~follows_escape;
+         const std::uint64_t even_runs      = odd_starts + backslash;
+         carry                              = even_runs < backslash ? 1 : 0;
+         return (even_bits ^ (even_runs << 1)) & follows_escape;
+      }
+
+      /**
+       * @brief Bit i set when an odd number of the bits up to and including i are set.
+       */
+      static inline std::uint64_t prefix_xor(std::uint64_t x) noexcept {
+#if defined(__PCLMUL__)
+         return static_cast<std::uint64_t>(
+               _mm_cvtsi128_si64(_mm_clmulepi64_si128(_mm_set_epi64x(0, static_cast<std::int64_t>(x)), _mm_set1_epi8(-1), 0)));
+#else
+         x ^= x << 1;
+         x ^= x << 2;
+         x ^= x << 4;
+         x ^= x << 8;
+         x ^= x << 16;
+         x ^= x << 32;
+         return x;
+#endif
+      }
+
+      /**
+       * @brief Offsets of every structural character and every value start outside strings.
+       *
+       * This is simdjson's stage 1: classify 64 bytes at a time, mask out escaped quotes, turn the quotes into a string
+       * mask with a prefix xor and keep operators plus the first byte of each scalar or string.
+       */
+      class structural_index {
+         public:
+            inline void build(std::string_view text) {
+               util::check(text.size() < UINT32_MAX, "json: input too large");
+               if (_capacity < text.size() + 1) {
+                  _capacity = std::max(text.size() + 1, _capacity * 2);
+                  _pos      = std::make_unique<std::uint32_t[]>(_capacity);
+               }
+               std::uint32_t* w            = _pos.get();
+               std::uint64_t  escape_carry = 0, in_string_carry = 0, scalar_carry = 0;
+               for (std::size_t at = 0; at < text.size(); at += 64) {
+                  char        tail[64];
+                  const char* p = text.data() + at;
+                  if (text.size() - at < 64) {
+                     std::memset(tail, ' ', sizeof(tail));
+                     std::memcpy(tail, p, text.size() - at);
+                     p = tail;
+                  }
+                  const block_masks   b       = classify(p);
+                  const std::uint64_t quote   = b.quote & ~find_escaped(b.backslash, escape_carry);
+                  const std::uint64_t in_str  = prefix_xor(quote) ^ in_string_carry;
+                  in_string_carry             = static_cast<std::uint64_t>(static_cast<std::int64_t>(in_str) >> 63);
+                  const std::uint64_t scalar  = ~(b.op | b.ws);
+                  const std::uint64_t plain   = scalar & ~quote;
+                  const std::uint64_t follows = (plain << 1) | scalar_carry;
+                  scalar_carry                = plain >> 63;
+                  // in_str covers opening quotes and contents, so this drops string contents and closing quotes
+                  std::uint64_t s = (b.op | (scalar & ~follows)) & ~(in_str ^ quote);
+                  while (s) {
+                     *w++ = static_cast<std::uint32_t>(at + static_cast<std::size_t>(std::countr_zero(s)));
+                     s &= s - 1;
+                  }
+               }
+               util::check(in_string_carry == 0, "json: unterminated string");
+               _count = static_cast<std::size_t>(w - _pos.get());
+            }
+
+            inline const std::uint32_t* data() const noexcept { return _pos.get(); }
+            inline std::size_t size() const noexcept { return _count; }
+
+         private:
+            std::unique_ptr<std::uint32_t[]> _pos;
+            std::size_t                      _capacity = 0;
+            std::size_t                      _count    = 0;
+      };
+
+      static inline structural_index& local_index() {
+         thread_local structural_index ix;
+         return ix;
+      }
+
+      //
+      // stage 2: parse along the index
+      //
+
+      struct parser {
+         std::string_view     text;
+         const std::uint32_t* idx;
+         std::size_t          count;
+         std::size_t          i = 0;
+         std::string          scratch = {};
+
+         inline char peek() const {
+            util::check(i < count, "json: unexpected end of input");
+            return text[idx[i]];
+         }
+
+         inline bool consume(char c) noexcept {
+            if (i < count && text[idx[i]] == c) {
+               ++i;
+               return true;
+            }
+            return false;
+         }
+
+         inline void expect(char c, const char* what) { util::check(consume(c), what); }
+
+         /**
+          * @brief The scalar starting at the current index, which ends at the next structural bar whitespace.
+          */
+         inline std::string_view atom() {
+            util::check(i < count, "json: unexpected end of input");
+            const std::size_t b = idx[i];
+            std::size_t       e = i + 1 < count ? idx[i + 1] : text.size();
+            ++i;
+            while (e > b && is_ws(text[e - 1]))
+               --e;
+            return text.substr(b, e - b);
+         }
+
+         /**
+          * @brief The raw contents of the string at the current index, escapes left in.
+          */
+         inline std::string_view raw_string() {
+            const std::string_view a = atom();
+            util::check(a.size() >= 2 && a.front() == '"' && a.back() == '"', "json: expected a string");
+            return a.substr(1, a.size() - 2);
+         }
+      };
+
+      static inline std::uint32_t hex4(std::string_view s, std::size_t at) {
+         util::check(at + 4 <= s.size(), "json: truncated \\u escape");
+         std::uint32_t v = 0;
+         for (std::size_t k = at; k < at + 4; ++k) {
+            const char    c = s[k];
+            std::uint32_t d;
+            if (c >= '0' && c <= '9')
+               d = static_cast<std::uint32_t>(c - '0');
+            else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+               d = static_cast<std::uint32_t>((c | 0x20) - 'a' + 10);
+            else
+               d = 16;
+            util::check(d < 16, "json: invalid \\u escape");
+            v = (v << 4) | d;
+         }
+         return v;
+      }
+
+      static inline void put_utf8(std::string& out, std::uint32_t cp) {
+         if (cp < 0x80)
+            out.push_back(static_cast<char>(cp));
+         else if (cp < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+         } else if (cp < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+         } else {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+         }
+      }
+
+      /**
+       * @brief Appends the unescaped contents of a raw string.
+       */
+      static inline void unescape(std::string_view s, std::string& out) {
+         for (;;) {
+            const std::size_t k = plain_prefix(s.data(), s.size());
+            out.append(s.data(), k);
+            if (k == s.size())
+               return;
+            util::check(s[k] == '\\' && k + 1 < s.size(), "json: control character in string");
+            std::size_t used = 2;
+            switch (s[k + 1]) {
+               case '"': out.push_back('"'); break;
+               case '\\': out.push_back('\\'); break;
+               case '/': out.push_back('/'); break;
+               case 'b': out.push_back('\b'); break;
+               case 'f': out.push_back('\f'); break;
+               case 'n': out.push_back('\n'); break;
+               case 'r': out.push_back('\r'); break;
+               case 't': out.push_back('\t'); break;
+               case 'u': {
+                  std::uint32_t cp = hex4(s, k + 2);
+                  used             = 6;
+                  if (cp >= 0xD800 && cp < 0xDC00) {
+                     util::check(s.substr(k + 6, 2) == "\\u", "json: unpaired surrogate");
+                     const std::uint32_t lo = hex4(s, k + 8);
+                     util::check(lo >= 0xDC00 && lo < 0xE000, "json: unpaired surrogate");
+                     cp   = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                     used = 12;
+                  } else
+                     util::check(cp < 0xDC00 || cp >= 0xE000, "json: unpaired surrogate");
+                  put_utf8(out, cp);
+                  break;
+               }
+               default: util::check(false, "json: invalid escape");
+            }
+            s.remove_prefix(k + used);
+         }
+      }
+
+      template <typename T>
+      static inline void read_string(parser& p, T& out) {
+         const std::string_view raw = p.raw_string();
+         if constexpr (std::is_same_v<T, std::string_view>) {
+            util::check(plain_prefix(raw.data(), raw.size()) == raw.size(),
+                        "json: strings with escapes cannot be borrowed into std::string_view");
+            out = raw;
+         } else {
+            out.clear();
+            unescape(raw, out);
+         }
+      }
+
+      template <number_type T>
+      static inline void parse_number(std::string_view s, T& out) {
+         if constexpr (varint_type<T> || fixed_type<T>)
+            parse_number(s, out.value);
+         else if constexpr (std::is_enum_v<T>) {
+            std::underlying_type_t<T> v;
+            parse_number(s, v);
+            out = static_cast<T>(v);
+         } else {
+            // from_chars also takes inf, nan and a leading '+', none of which are JSON
+            util::check(!s.empty() && (s[0] == '-' || (s[0] >= '0' && s[0] <= '9')), "json: expected a number");
+            const auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+            util::check(r.ec == std::errc{} && r.ptr == s.data() + s.size(), [&] {
+               throw std::runtime_error(std::string{"json: invalid "} + std::string{ct::nameof<T>()} + " '" + std::string{s} + "'");
+            });
+         }
+      }
+
+      /**
+       * @brief Skips a value of any shape, used for unknown fields.
+       */
+      static inline void skip_value(parser& p) {
+         const char c = p.peek();
+         if (c != '{' && c != '[') {
+            p.atom();
+            return;
+         }
+         std::size_t level = 0;
+         do {
+            const char s = p.peek();
+            ++p.i;
+            if (s == '{' || s == '[')
+               ++level;
+            else if (s == '}' || s == ']')
+               --level;
+         } while (level > 0);
+      }
+
+      template <typename T>
+      static inline void read_value(parser& p, T& out);
+
+      template <reflected_type T>
+      static inline void read_object(parser& p, T& out) {
+         using index     = field_index<T>;
+         using reader_fn = void (*)(parser&, T&);
+         constexpr auto readers = []<std::size_t... I>(std::index_sequence<I...>) {
+            return std::array<reader_fn, sizeof...(I)>{+[](parser& q, T& v) {
+               auto t = v.reflected_tie();
+               read_value(q, std::get<I>(t));
+            }...};
+         }(std::make_index_sequence<index::count>{});
+
+         util::check(p.consume('{'), [] {
+            throw std::runtime_error(std::string{"json: expected an object for "} + std::string{ct::nameof<T>()});
+         });
+         if (p.consume('}'))
+            return;
+         do {
+            std::string_view key = p.raw_string();
+            if (key.find('\\') != std::string_view::npos) {
+               p.scratch.clear();
+               unescape(key, p.scratch);
+               key = p.scratch;
+            }
+            p.expect(':', "json: expected ':'");
+            const std::size_t f = index::find(key);
+            if (f < index::count)
+               readers[f](p, out);
+            else
+               skip_value(p);
+         } while (p.consume(','));
+         p.expect('}', "json: expected ',' or '}'");
+      }
+
+      template <typename T>
+      static inline void read_value(parser& p, T& out) {
+         if constexpr (std::is_same_v<T, bool>) {
+            const std::string_view a = p.atom();
+            util::check(a == "true" || a == "false", "json: expected true or false");
+            out = a.size() == 4;
+         } else if constexpr (number_type<T>)
+            parse_number(p.atom(), out);
+         else if constexpr (string_type<T>)
+            read_string(p, out);
+         else if constexpr (reflected_type<T>)
+            read_object(p, out); else if constexpr (is_optional<T>::value) {
+            if (p.peek() == 'n') {
+               util::check(p.atom() == "null", "json: expected null");
+               out.reset();
+            } else
+               read_value(p, out.emplace());
+         } else if constexpr (is_pair<T>::value || is_tuple<T>::value || is_std_array<T>::value) {
+            p.expect('[', "json: expected an array");
+            std::size_t n = 0;
+            const auto  next = [&](auto& e) {
+               util::check(n == 0 || p.consume(','), "json: array too short");
+               ++n;
+               read_value(p, e);
+            };
+            if constexpr (is_std_array<T>::value) {
+               for (auto& e : out)
+                  next(e);
+            } else if constexpr (is_pair<T>::value) {
+               next(out.first);
+               next(out.second);
+            } else
+               std::apply([&](auto&... e) { (next(e), ...); }, out);
+            p.expect(']', "json: array too long");
+         } else if constexpr (map_type<T>) {
+            using key_t = std::remove_const_t<typename T::key_type>;
+            p.expect('{', "json: expected an object");
+            out.clear();
+            if (!p.consume('}')) {
+               do {
+                  key_t k{};
+                  if constexpr (string_type<key_t>)
+                     read_string(p, k);
+                  else
+                     parse_number(p.raw_string(), k);
+                  p.expect(':', "json: expected ':'");
+                  typename T::mapped_type v{};
+                  read_value(p, v);
+                  out.insert_or_assign(std::move(k), std::move(v));
+               } while (p.consume(','));
+               p.expect('}', "json: expected ',' or '}'");
+            }
+         } else {
+            p.expect('[', "json: expected an array");
+            out.clear();
+            if (!p.consume(']')) {
+               do {
+                  if constexpr (set_type<T>) {
+                     typename T::key_type k{};
+                     read_value(p, k);
+                     out.insert(std::move(k));
+                  } else
+                     read_value(p, out.emplace_back());
+               } while (p.consume(','));
+               p.expect(']', "json: expected ',' or ']'");
+            }
+         }
+      }
+   } // namespace detail::js
+
+   /**
+    * @brief JSON codec for reflected types, driven by the ASTRO_REFL member names.
+    *
+    * Reflected types are objects, sequences and sets are arrays, maps are objects (integer keys are quoted), pairs, tuples
+    * and std::array are fixed-length arrays, an empty optional is null and enums are written as their underlying integer.
+    * Floats are written in their shortest round-trip form. Decoding first indexes the structural characters with SIMD,
+    * then walks that index; keys are matched with a compile-time perfect hash and unknown keys are skipped.
+    */
+   class json {
+      public:
+         json()  = default;
+         ~json() = default;
+
+         template <detail::js::json_type T>
+         static inline std::string encode(const T& value) {
+            std::string out;
+            encode(value, out);
+            return out;
+         }
+
+         /**
+          * @brief Appends the encoding of value to out.
+          */
+         template <detail::js::json_type T>
+         static inline void encode(const T& value, std::string& out) {
+            detail::js::write_value(out, value);
+         }
+
+         /**
+          * @brief Parses a value, std::string_view members borrow from text and must not contain escapes.
+          */
+         template <detail::js::json_type T>
+         static inline T decode(std::string_view text) {
+            T v{};
+            merge(text, v);
+            return v;
+         }
+
+         /**
+          * @brief Parses into an existing value, fields missing from text keep their current value.
+          */
+         template <detail::js::json_type T>
+         static inline void merge(std::string_view text, T& value) {
+            auto& ix = detail::js::local_index();
+            ix.build(text);
+            detail::js::parser p{text, ix.data(), ix.size()};
+            detail::js::read_value(p, value);
+            util::check(p.i == p.count, "json: trailing characters");
+         }
+   };
+
+} // namespace astro::serial
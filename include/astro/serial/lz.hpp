@@ -0,0 +1,423 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "alpha.hpp"
+#include "stream.hpp"
+
+namespace astro::serial::lz {
+
+   /**
+    * LZ4 block format: each sequence is a token (literal length in the high nibble, match length - 4 in the low
+    * nibble, 15 meaning more length bytes follow), the literals, a little-endian 16-bit offset and the extra match
+    * length. The last sequence is literals only.
+    */
+   namespace detail {
+      constexpr static inline std::size_t min_match     = 4;
+      constexpr static inline std::size_t last_literals = 5;
+      constexpr static inline std::size_t mf_limit      = 12;
+      constexpr static inline std::size_t max_distance  = 65535;
+      constexpr static inline std::size_t hash_log      = 12;
+      constexpr static inline std::size_t skip_strength = 6;
+
+      constexpr static inline std::uint32_t load32(const std::uint8_t* p) noexcept {
+         std::uint32_t v;
+         std::memcpy(&v, p, sizeof(v));
+         return v;
+      }
+
+      constexpr static inline std::uint64_t load64(const std::uint8_t* p) noexcept {
+         std::uint64_t v;
+         std::memcpy(&v, p, sizeof(v));
+         return v;
+      }
+
+      constexpr static inline std::uint32_t hash(std::uint32_t v) noexcept {
+         return (v * 2654435761u) >> (32 - hash_log);
+      }
+
+      /**
+       * @brief The number of equal bytes at a and b, stopping at limit (which bounds a).
+       */
+      constexpr static inline std::size_t count(const std::uint8_t* a, const std::uint8_t* b, const std::uint8_t* limit) noexcept {
+         const std::uint8_t* start = a;
+         while (a + 8 <= limit) {
+            const std::uint64_t diff = load64(a) ^ load64(b);
+            if (diff != 0)
+               return static_cast<std::size_t>(a - start) + std::countr_zero(diff) / 8;
+            a += 8;
+            b += 8;
+         }
+         while (a < limit && *a == *b) {
+            ++a;
+            ++b;
+         }
+         return static_cast<std::size_t>(a - start);
+      }
+
+      constexpr static inline std::uint8_t* write_length(std::uint8_t* op, std::size_t n) noexcept {
+         for (; n >= 255; n -= 255)
+            *op++ = 255;
+         *op++ = static_cast<std::uint8_t>(n);
+         return op;
+      }
+
+      static inline std::uint8_t* write_sequence(std::uint8_t* op, const std::uint8_t* lit, std::size_t lit_len) noexcept {
+         std::uint8_t* token = op++;
+         if (lit_len >= 15) {
+            *token = 15 << 4;
+            op     = write_length(op, lit_len - 15);
+         } else {
+            *token = static_cast<std::uint8_t>(lit_len << 4);
+         }
+         if (lit_len != 0)
+            std::memcpy(op, lit, lit_len);
+         return op + lit_len;
+      }
+
+      static inline std::size_t read_length(const std::uint8_t*& ip, const std::uint8_t* iend) {
+         std::size_t n = 0;
+         std::uint8_t b;
+         do {
+            util::check(ip < iend, "lz: truncated length");
+            b  = *ip++;
+            n += b;
+         } while (b == 255);
+         return n;
+      }
+
+      /**
+       * @brief Copies a match that may overlap its own output, widening the copy as the repeated pattern grows.
+       */
+      static inline void copy_match(std::uint8_t* op, std::size_t off, std::size_t len, const std::uint8_t* oend) noexcept {
+         const std::uint8_t* src  = op - off;
+         const auto          room = static_cast<std::size_t>(oend - op);
+         if (off >= 16 && room >= len + 16) {
+            for (std::size_t i = 0; i < len; i += 16)
+               std::memcpy(op + i, src + i, 16);
+            return;
+         }
+         if (off >= 8 && room >= len + 8) {
+            for (std::size_t i = 0; i < len; i += 8)
+               std::memcpy(op + i, src + i, 8);
+            return;
+         }
+         // every copy doubles the span between src and op, which stays a whole number of periods
+         while (len != 0) {
+            const std::size_t n = std::min(len, static_cast<std::size_t>(op - src));
+            std::memcpy(op, src, n);
+            op  += n;
+            len -= n;
+         }
+      }
+
+      inline std::vector<std::uint8_t>& window() {
+         thread_local std::vector<std::uint8_t> w;
+         return w;
+      }
+   } // namespace detail
+
+   /**
+    * @brief The most bytes compress can produce for n input bytes.
+    */
+   constexpr static inline std::size_t max_compressed_size(std::size_t n) noexcept { return n + n / 255 + 16; }
+
+   /**
+    * @brief The most bytes n compressed bytes can expand to, every length byte adding at most 255.
+    */
+   constexpr static inline std::size_t max_decompressed_size(std::size_t n) noexcept { return n * 255 + 16; }
+
+   /**
+    * @brief Compresses in into out, which needs max_compressed_size(in.size()) bytes.
+    * @param dict Data the input is likely to repeat, e.g. a sample message, the same bytes must be given to decompress.
+    * @return The number of bytes written.
+    */
+   static inline std::size_t compress(std::span<const std::uint8_t> in, std::uint8_t* out, std::span<const std::uint8_t> dict = {}) {
+      using namespace detail;
+      util::check(in.size() <= UINT32_MAX - max_distance, "lz: input too large");
+
+      // with a dictionary, matches are found in one window holding the dictionary's tail followed by the input
+      const std::uint8_t* base  = in.data();
+      std::size_t         start = 0;
+      if (!dict.empty()) {
+         dict     = dict.last(std::min(dict.size(), max_distance));
+         auto& w  = window();
+         w.resize(dict.size() + in.size());
+         std::memcpy(w.data(), dict.data(), dict.size());
+         if (!in.empty())
+            std::memcpy(w.data() + dict.size(), in.data(), in.size());
+         base  = w.data();
+         start = dict.size();
+      }
+      const std::size_t end = start + in.size();
+
+      std::array<std::uint32_t, std::size_t{1} << hash_log> table{};
+      for (std::size_t p = 0; p + min_match <= start; ++p)
+         table[hash(load32(base + p))] = static_cast<std::uint32_t>(p);
+
+      std::uint8_t* op     = out;
+      std::size_t   anchor = start;
+      if (in.size() > mf_limit) {
+         const std::size_t limit       = end - mf_limit;
+         const std::uint8_t* match_end = base + end - last_literals;
+         std::size_t         ip        = start;
+         while (ip < limit) {
+            const std::uint32_t h   = hash(load32(base + ip));
+            std::size_t         ref = table[h];
+            table[h]                = static_cast<std::uint32_t>(ip);
+            if (ref >= ip || ip - ref > max_distance || load32(base + ref) != load32(base + ip)) {
+               ip += 1 + ((ip - anchor) >> skip_strength);
+               continue;
+            }
+
+            while (ip > anchor && ref > 0 && base[ip - 1] == base[ref - 1]) {
+               --ip;
+               --ref;
+            }
+            const std::size_t len = min_match + count(base + ip + min_match, base + ref + min_match, match_end);
+
+            std::uint8_t* token = op;
+            op                  = write_sequence(op, base + anchor, ip - anchor);
+            const auto off      = static_cast<std::uint16_t>(ip - ref);
+            std::memcpy(op, &off, sizeof(off));
+            op += sizeof(off);
+            if (len - min_match >= 15) {
+               *token |= 15;
+               op      = write_length(op, len - min_match - 15);
+            } else {
+               *token |= static_cast<std::uint8_t>(len - min_match);
+            }
+
+            ip    += len;
+            anchor = ip;
+            if (ip < limit)
+               table[hash(load32(base + ip - 2))] = static_cast<std::uint32_t>(ip - 2);
+         }
+      }
+      op = write_sequence(op, base + anchor, end - anchor);
+      return static_cast<std::size_t>(op - out);
+   }
+
+   static inline std::vector<std::uint8_t> compress(std::span<const std::uint8_t> in, std::span<const std::uint8_t> dict = {}) {
+      std::vector<std::uint8_t> out(max_compressed_size(in.size()));
+      out.resize(compress(in, out.data(), dict));
+      return out;
+   }
+
+   /**
+    * @brief Decompresses a block into out, throwing on malformed input or if it does not fit.
+    * @return The number of bytes written.
+    */
+   static inline std::size_t decompress(std::span<const std::uint8_t> in, std::span<std::uint8_t> out, std::span<const std::uint8_t> dict = {}) {
+      using namespace detail;
+      const std::uint8_t* ip   = in.data();
+      const std::uint8_t* iend = ip + in.size();
+      std::uint8_t*       op   = out.data();
+      std::uint8_t*       oend = op + out.size();
+
+      for (;;) {
+         util::check(ip < iend, "lz: truncated block");
+         const std::uint8_t token = *ip++;
+
+         std::size_t lit = token >> 4;
+         // short literals followed by a short, non-overlapping match, the common case, as fixed size copies
+         if (lit != 15 && (token & 15) != 15 && iend - ip >= 32 && oend - op >= 48) {
+            std::memcpy(op, ip, 16);
+            ip += lit;
+            op += lit;
+            std::uint16_t off;
+            std::memcpy(&off, ip, sizeof(off));
+            const auto produced = static_cast<std::size_t>(op - out.data());
+            if (off >= 16 && off <= produced) {
+               ip += sizeof(off);
+               std::memcpy(op, op - off, 16);
+               std::memcpy(op + 16, op - off + 16, 4);
+               op += (token & 15) + min_match;
+               continue;
+            }
+            ip -= lit;
+            op -= lit;
+         }
+         if (lit == 15)
+            lit += read_length(ip, iend);
+         util::check(lit <= static_cast<std::size_t>(iend - ip) && lit <= static_cast<std::size_t>(oend - op), "lz: literals out of bounds");
+         if (static_cast<std::size_t>(iend - ip) >= lit + 16 && static_cast<std::size_t>(oend - op) >= lit + 16) {
+            // the slack past the literals lets whole 16-byte copies run over the end
+            for (std::size_t i = 0; i < lit; i += 16)
+               std::memcpy(op + i, ip + i, 16);
+         } else {
+            std::memcpy(op, ip, lit);
+         }
+         ip += lit;
+         op += lit;
+         if (ip == iend)
+            break;
+
+         util::check(iend - ip >= 2, "lz: truncated offset");
+         std::uint16_t off;
+         std::memcpy(&off, ip, sizeof(off));
+         ip += sizeof(off);
+         std::size_t len = token & 15;
+         if (len == 15)
+            len += read_length(ip, iend);
+         len += min_match;
+         util::check(off != 0 && len <= static_cast<std::size_t>(oend - op), "lz: match out of bounds");
+
+         const auto produced = static_cast<std::size_t>(op - out.data());
+         if (off > produced) {
+            const std::size_t back = off - produced;
+            util::check(back <= dict.size(), "lz: offset before the start of the dictionary");
+            const std::size_t n = std::min(back, len);
+            std::memcpy(op, dict.data() + dict.size() - back, n);
+            op  += n;
+            len -= n;
+         }
+         if (len != 0)
+            copy_match(op, off, len, oend);
+         op += len;
+      }
+      return static_cast<std::size_t>(op - out.data());
+   }
+
+   /**
+    * @brief A sink adapter compressing every write as its own block, framed as uint32 raw size then uint32 stored size.
+    *
+    * A stored size equal to the raw size marks a block kept uncompressed. Stacked under a stream_writer each chunk becomes a block.
+    */
+   template <byte_sink_type Sink>
+   class compress_sink {
+      public:
+         explicit compress_sink(Sink& sink, std::span<const std::uint8_t> dict = {})
+            : _sink(sink), _dict(dict) {}
+
+         inline int32_t write(std::string_view s) {
+            const std::span<const std::uint8_t> in{reinterpret_cast<const std::uint8_t*>(s.data()), s.size()};
+            _buf.resize(max_compressed_size(in.size()));
+            std::uint32_t hdr[2] = {static_cast<std::uint32_t>(in.size()), 0};
+            const std::size_t n  = compress(in, _buf.data(), _dict);
+            const bool   stored  = n >= in.size();
+            hdr[1]               = stored ? hdr[0] : static_cast<std::uint32_t>(n);
+            const std::string_view parts[] = {{reinterpret_cast<const char*>(hdr), sizeof(hdr)},
+                                              stored ? s : std::string_view{reinterpret_cast<const char*>(_buf.data()), n}};
+            serial::detail::write_all(_sink, parts);
+            return static_cast<int32_t>(s.size());
+         }
+
+      private:
+         Sink&                         _sink;
+         std::span<const std::uint8_t> _dict;
+         std::vector<std::uint8_t>     _buf;
+   };
+
+   /**
+    * @brief The source adapter reading back what compress_sink wrote.
+    */
+   template <byte_source_type Source>
+   class decompress_source {
+      public:
+         explicit decompress_source(Source& src, std::span<const std::uint8_t> dict = {})
+            : _src(src), _dict(dict) {}
+
+         inline int64_t read_some(std::span<std::uint8_t> buf) {
+            if (_pos == _raw.size() && !next_block())
+               return 0;
+            const std::size_t n = std::min(buf.size(), _raw.size() - _pos);
+            std::memcpy(buf.data(), _raw.data() + _pos, n);
+            _pos += n;
+            return static_cast<int64_t>(n);
+         }
+
+      private:
+         inline bool read_exact(std::uint8_t* p, std::size_t n) {
+            for (std::size_t got = 0; got < n;) {
+               const int64_t r = _src.read_some({p + got, n - got});
+               util::check(r >= 0, "lz: read failed");
+               if (r == 0) {
+                  util::check(got == 0, "lz: truncated block");
+                  return false;
+               }
+               got += static_cast<std::size_t>(r);
+            }
+            return true;
+         }
+
+         inline bool next_block() {
+            std::uint32_t hdr[2];
+            if (!read_exact(reinterpret_cast<std::uint8_t*>(hdr), sizeof(hdr)))
+               return false;
+            util::check(hdr[1] <= hdr[0] && hdr[0] <= max_decompressed_size(hdr[1]), "lz: bad block header");
+            _raw.resize(hdr[0]);
+            _pos = 0;
+            if (hdr[1] == hdr[0]) {
+               util::check(hdr[0] == 0 || read_exact(_raw.data(), hdr[0]), "lz: truncated block");
+               return true;
+            }
+            _block.resize(hdr[1]);
+            util::check(read_exact(_block.data(), hdr[1]), "lz: truncated block");
+            util::check(decompress(_block, _raw, _dict) == hdr[0], "lz: block size mismatch");
+            return true;
+         }
+
+         Source&                       _src;
+         std::span<const std::uint8_t> _dict;
+         std::vector<std::uint8_t>     _block;
+         std::vector<std::uint8_t>     _raw;
+         std::size_t                   _pos = 0;
+   };
+
+} // namespace astro::serial::lz
+
+namespace astro::serial {
+
+   /**
+    * @brief Serializes the wrapped value as an LZ block, uint32 raw size and uint32 compressed size first.
+    *
+    * The value is decoded from a private buffer, so it must not hold borrowed views.
+    */
+   template <typename T>
+   struct compressed {
+      T value;
+   };
+
+   template <typename C>
+   constexpr static inline bool is_compressed_v = false;
+
+   template <typename T>
+   constexpr static inline bool is_compressed_v<compressed<T>> = true;
+
+   template <typename C>
+   concept compressed_type = is_compressed_v<C>;
+
+   template <typename T>
+   static inline void serialize(alpha& a, const compressed<T>& c) {
+      alpha raw;
+      raw.push(c.value);
+      util::check(raw.size() <= UINT32_MAX, "lz: value too large");
+      const auto          block  = lz::compress(raw.bytes());
+      const std::uint32_t hdr[2] = {static_cast<std::uint32_t>(raw.size()), static_cast<std::uint32_t>(block.size())};
+      a.write(hdr, sizeof(hdr));
+      a.write(block.data(), block.size());
+   }
+
+   template <compressed_type C>
+   static inline C deserialize(alpha& a) {
+      std::uint32_t hdr[2];
+      a.read(hdr, sizeof(hdr));
+      const auto in = a.read_view(hdr[1]);
+      util::check(hdr[0] <= lz::max_decompressed_size(hdr[1]), "lz: bad block header");
+      alpha      raw;
+      raw.resize(hdr[0]);
+      util::check(lz::decompress(in, {raw.data(), raw.size()}) == hdr[0], "lz: block size mismatch");
+      return C{raw.pop<decltype(std::declval<C>().value)>()};
+   }
+
+} // namespace astro::serial
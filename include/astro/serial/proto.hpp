@@ -1,22 +1,549 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
 #include "../utils.hpp"
+#include "reflect.hpp"
+#include "varint.hpp"
 
 namespace astro::serial {
+
+   template <reflected_type T>
+   class lazy;
+
+   namespace detail::pb {
+      template <typename T>
+      struct is_lazy : std::false_type {};
+      template <typename T>
+      struct is_lazy<lazy<T>> : std::true_type {};
+
+      enum class wire : std::uint8_t { varint = 0, fixed64 = 1, len = 2, fixed32 = 5 };
+
+      template <typename T>
+      concept bytes_type = is_basic_string<T>::value || std::is_same_v<T, std::string_view> ||
+                           std::is_same_v<T, std::vector<std::byte>>;
+
+      template <typename T>
+      concept scalar_type = std::is_arithmetic_v<T> || std::is_enum_v<T> || varint_type<T> || fixed_type<T>;
+
+      template <typename T>
+      concept message_type = reflected_type<T>;
+
+      template <typename T>
+      concept repeated_type = sequence_type<T> && !bytes_type<T>;
+
+      /**
+       * @brief Field numbers from ASTRO_REFL_TAGS, or 1..N in declaration order.
+       */
+      template <message_type T>
+      constexpr static inline auto field_numbers() noexcept {
+         constexpr std::size_t n = std::tuple_size_v<typename T::reflected_member_types>;
+         if constexpr (tagged_type<T>) {
+            return field_tags<T>();
+         } else {
+            std::array<std::uint32_t, n> tags{};
+            for (std::size_t i = 0; i < n; ++i)
+               tags[i] = static_cast<std::uint32_t>(i + 1);
+            return tags;
+         }
+      }
+
+      /**
+       * @brief Lengths of submessages and packed fields, recorded in pre-order by the size pass and replayed by the encoder.
+       */
+      struct size_cache {
+         std::vector<std::uint32_t> sizes;
+         std::size_t                next = 0;
+
+         inline std::size_t reserve() {
+            sizes.push_back(0);
+            return sizes.size() - 1;
+         }
+
+         inline void set(std::size_t slot, std::size_t sz) {
+            util::check(sz <= UINT32_MAX, "proto: message too large");
+            sizes[slot] = static_cast<std::uint32_t>(sz);
+         }
+
+         inline std::uint32_t take() noexcept { return sizes[next++]; }
+
+         inline void clear() noexcept {
+            sizes.clear();
+            next = 0;
+         }
+      };
+
+      struct reader {
+         const std::uint8_t* p;
+         const std::uint8_t* end;
+
+         inline bool done() const noexcept { return p == end; }
+
+         inline std::uint64_t varint() {
+            std::uint64_t v = 0;
+            p += decode_varint(p, static_cast<std::size_t>(end - p), v);
+            return v;
+         }
+
+         template <typename T>
+         inline T fixed() {
+            util::check(static_cast<std::size_t>(end - p) >= sizeof(T), "proto: truncated input");
+            T v;
+            std::memcpy(&v, p, sizeof(T));
+            p += sizeof(T);
+            return v;
+         }
+
+         inline std::span<const std::uint8_t> bytes() {
+            const std::uint64_t n = varint();
+            util::check(n <= static_cast<std::size_t>(end - p), "proto: truncated input");
+            const std::span<const std::uint8_t> out{p, static_cast<std::size_t>(n)};
+            p += n;
+            return out;
+         }
+
+         inline void skip(wire w) {
+            switch (w) {
+               case wire::varint:
+                  varint();
+                  break;
+               case wire::fixed64:
+                  fixed<std::uint64_t>();
+                  break;
+               case wire::len:
+                  bytes();
+                  break;
+               case wire::fixed32:
+                  fixed<std::uint32_t>();
+                  break;
+               default:
+                  util::check(false, "proto: unsupported wire type");
+            }
+         }
+      };
+
+      template <scalar_type T>
+      constexpr static inline wire wire_of() noexcept {
+         if constexpr (std::is_same_v<T, float>)
+            return wire::fixed32;
+         else if constexpr (std::is_same_v<T, double>)
+            return wire::fixed64;
+         else if constexpr (fixed_type<T>) {
+            static_assert(sizeof(T) == 4 || sizeof(T) == 8, "proto: fixed fields are 32 or 64 bits");
+            return sizeof(T) == 4 ? wire::fixed32 : wire::fixed64;
+         } else
+            return wire::varint;
+      }
+
+      template <scalar_type T>
+      constexpr static inline std::uint64_t to_varint(const T& v) noexcept {
+         if constexpr (varint_type<T>)
+            return zigzag_encode(v.value);
+         else if constexpr (std::is_enum_v<T>)
+            return static_cast<std::uint64_t>(static_cast<std::int64_t>(static_cast<std::underlying_type_t<T>>(v)));
+         else if constexpr (std::is_same_v<T, bool> || std::is_unsigned_v<T>)
+            return v;
+         else
+            // negative int32 values are sign extended to ten bytes, like protobuf
+            return static_cast<std::uint64_t>(static_cast<std::int64_t>(v));
+      }
+
+      template <scalar_type T>
+      constexpr static inline T from_varint(std::uint64_t v) noexcept {
+         if constexpr (varint_type<T>) {
+            using U = std::make_unsigned_t<typename T::value_type>;
+            return T{zigzag_decode<typename T::value_type>(static_cast<U>(v))};
+         } else if constexpr (std::is_enum_v<T>)
+            return static_cast<T>(static_cast<std::underlying_type_t<T>>(v));
+         else if constexpr (std::is_same_v<T, bool>)
+            return v != 0;
+         else
+            return static_cast<T>(v);
+      }
+
+      template <scalar_type T>
+      constexpr static inline std::size_t scalar_size(const T& v) noexcept {
+         if constexpr (wire_of<T>() == wire::varint)
+            return varint_size(to_varint(v));
+         else
+            return sizeof(T);
+      }
+
+      static inline void put_varint(std::uint8_t*& p, std::uint64_t v) noexcept { p += encode_varint(v, p); }
+
+      static inline void put_key(std::uint8_t*& p, std::uint32_t field, wire w) noexcept {
+         put_varint(p, (std::uint64_t{field} << 3) | static_cast<std::uint8_t>(w));
+      }
+
+      constexpr static inline std::size_t key_size(std::uint32_t field) noexcept { return varint_size(std::uint64_t{field} << 3); }
+
+      template <scalar_type T>
+      static inline void put_scalar(std::uint8_t*& p, const T& v) noexcept {
+         if constexpr (wire_of<T>() == wire::varint) {
+            put_varint(p, to_varint(v));
+         } else {
+            std::memcpy(p, &v, sizeof(T));
+            p += sizeof(T);
+         }
+      }
+
+      template <scalar_type T>
+      static inline T get_scalar(reader& r) {
+         if constexpr (wire_of<T>() == wire::varint)
+            return from_varint<T>(r.varint());
+         else
+            return r.fixed<T>();
+      }
+
+      /**
+       * @brief Fields holding their default are not written, as in proto3. Submessages are always written.
+       */
+      template <typename T>
+      static inline bool is_default(const T& v) noexcept {
+         if constexpr (scalar_type<T>) {
+            // bitwise, so -0.0 is still written
+            T zero{};
+            return std::memcmp(&v, &zero, sizeof(T)) == 0;
+         } else if constexpr (bytes_type<T> || repeated_type<T> || map_type<T>)
+            return v.empty();
+         else if constexpr (is_optional<T>::value)
+            return !v.has_value();
+         else
+            return false;
+      }
+
+      template <message_type T>
+      static inline std::size_t message_size(const T& m, size_cache& c);
+
+      template <message_type T>
+      static inline void encode_message(std::uint8_t*& p, const T& m, size_cache& c);
+
+      template <message_type T>
+      static inline void decode_message(reader& r, T& m);
+
+      template <typename T>
+      static inline std::size_t field_size(std::uint32_t field, const T& v, size_cache& c) {
+         if constexpr (scalar_type<T>) {
+            return key_size(field) + scalar_size(v);
+         } else if constexpr (bytes_type<T>) {
+            return key_size(field) + varint_size(v.size()) + v.size();
+         } else if constexpr (message_type<T>) {
+            const std::size_t slot = c.reserve();
+            const std::size_t sz   = message_size(v, c);
+            c.set(slot, sz);
+            return key_size(field) + varint_size(sz) + sz;
+         } else if constexpr (is_lazy<T>::value) {
+            if (!v.parsed())
+               return key_size(field) + varint_size(v.bytes().size()) + v.bytes().size();
+            return field_size(field, v.get(), c);
+         } else if constexpr (is_optional<T>::value) {
+            return v ? field_size(field, *v, c) : 0;
+         } else if constexpr (map_type<T>) {
+            std::size_t total = 0;
+            for (const auto& [k, x] : v) {
+               const std::size_t slot = c.reserve();
+               const std::size_t sz   = field_size(1, k, c) + field_size(2, x, c);
+               c.set(slot, sz);
+               total += key_size(field) + varint_size(sz) + sz;
+            }
+            return total;
+         } else if constexpr (repeated_type<T>) {
+            using E = typename T::value_type;
+            if constexpr (scalar_type<E>) {
+               // packed
+               const std::size_t slot = c.reserve();
+               std::size_t       sz   = 0;
+               if constexpr (wire_of<E>() == wire::varint)
+                  for (const auto& x : v)
+                     sz += scalar_size(x);
+               else
+                  sz = v.size() * sizeof(E);
+               c.set(slot, sz);
+               return key_size(field) + varint_size(sz) + sz;
+            } else {
+               std::size_t total = 0;
+               for (const auto& x : v)
+                  total += field_size(field, x, c);
+               return total;
+            }
+         } else {
+            static_assert(sizeof(T) == 0, "proto: unsupported field type");
+            return 0;
+         }
+      }
+
+      template <typename T>
+      static inline void encode_field(std::uint8_t*& p, std::uint32_t field, const T& v, size_cache& c) {
+         if constexpr (scalar_type<T>) {
+            put_key(p, field, wire_of<T>());
+            put_scalar(p, v);
+         } else if constexpr (bytes_type<T>) {
+            put_key(p, field, wire::len);
+            put_varint(p, v.size());
+            if (!v.empty())
+               std::memcpy(p, v.data(), v.size());
+            p += v.size();
+         } else if constexpr (message_type<T>) {
+            put_key(p, field, wire::len);
+            put_varint(p, c.take());
+            encode_message(p, v, c);
+         } else if constexpr (is_lazy<T>::value) {
+            if (v.parsed()) {
+               encode_field(p, field, v.get(), c);
+            } else {
+               // untouched submessages are copied through without a parse
+               put_key(p, field, wire::len);
+               put_varint(p, v.bytes().size());
+               if (!v.bytes().empty())
+                  std::memcpy(p, v.bytes().data(), v.bytes().size());
+               p += v.bytes().size();
+            }
+         } else if constexpr (is_optional<T>::value) {
+            if (v)
+               encode_field(p, field, *v, c);
+         } else if constexpr (map_type<T>) {
+            for (const auto& [k, x] : v) {
+               put_key(p, field, wire::len);
+               put_varint(p, c.take());
+               encode_field(p, 1, k, c);
+               encode_field(p, 2, x, c);
+            }
+         } else if constexpr (repeated_type<T>) {
+            using E = typename T::value_type;
+            if constexpr (scalar_type<E>) {
+               put_key(p, field, wire::len);
+               put_varint(p, c.take());
+               for (const auto& x : v)
+                  put_scalar(p, x);
+            } else {
+               for (const auto& x : v)
+                  encode_field(p, field, x, c);
+            }
+         }
+      }
+
+      template <typename T>
+      static inline void decode_field(reader& r, wire w, T& out) {
+         if constexpr (scalar_type<T>) {
+            util::check(w == wire_of<T>(), "proto: wire type mismatch");
+            out = get_scalar<T>(r);
+         } else if constexpr (bytes_type<T>) {
+            util::check(w == wire::len, "proto: wire type mismatch");
+            const auto b = r.bytes();
+            if constexpr (std::is_same_v<T, std::vector<std::byte>>) {
+               out.resize(b.size());
+               if (!b.empty())
+                  std::memcpy(out.data(), b.data(), b.size());
+            } else {
+               out = T(reinterpret_cast<const char*>(b.data()), b.size());
+            }
+         } else if constexpr (message_type<T>) {
+            util::check(w == wire::len, "proto: wire type mismatch");
+            const auto b = r.bytes();
+            reader     sub{b.data(), b.data() + b.size()};
+            decode_message(sub, out);
+         } else if constexpr (is_lazy<T>::value) {
+            util::check(w == wire::len, "proto: wire type mismatch");
+            out = T::from_bytes(r.bytes());
+         } else if constexpr (is_optional<T>::value) {
+            if (!out)
+               out.emplace();
+            decode_field(r, w, *out);
+         } else if constexpr (map_type<T>) {
+            util::check(w == wire::len, "proto: wire type mismatch");
+            const auto              b = r.bytes();
+            reader                  sub{b.data(), b.data() + b.size()};
+            typename T::key_type    k{};
+            typename T::mapped_type x{};
+            while (!sub.done()) {
+               const std::uint64_t key = sub.varint();
+               const auto          kw  = static_cast<wire>(key & 7);
+               if ((key >> 3) == 1)
+                  decode_field(sub, kw, k);
+               else if ((key >> 3) == 2)
+                  decode_field(sub, kw, x);
+               else
+                  sub.skip(kw);
+            }
+            out.insert_or_assign(std::move(k), std::move(x));
+         } else if constexpr (repeated_type<T>) {
+            using E = typename T::value_type;
+            if constexpr (scalar_type<E>) {
+               // parsers accept both packed and unpacked encodings
+               if (w == wire::len) {
+                  const auto b = r.bytes();
+                  reader     sub{b.data(), b.data() + b.size()};
+                  if constexpr (wire_of<E>() != wire::varint) {
+                     util::check(b.size() % sizeof(E) == 0, "proto: malformed packed field");
+                     if constexpr (requires { out.reserve(out.size()); })
+                        out.reserve(out.size() + b.size() / sizeof(E));
+                  }
+                  while (!sub.done())
+                     out.push_back(get_scalar<E>(sub));
+                  return;
+               }
+            }
+            E e{};
+            decode_field(r, w, e);
+            out.push_back(std::move(e));
+         } else {
+            static_assert(sizeof(T) == 0, "proto: unsupported field type");
+         }
+      }
+
+      template <message_type T>
+      static inline std::size_t message_size(const T& m, size_cache& c) {
+         constexpr auto tags = field_numbers<T>();
+         const auto     t    = m.reflected_tie();
+         return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            return ((is_default(std::get<I>(t)) ? std::size_t{0} : field_size(tags[I], std::get<I>(t), c)) + ... + 0);
+         }(std::make_index_sequence<tags.size()>{});
+      }
+
+      template <message_type T>
+      static inline void encode_message(std::uint8_t*& p, const T& m, size_cache& c) {
+         constexpr auto tags = field_numbers<T>();
+         const auto     t    = m.reflected_tie();
+         [&]<std::size_t... I>(std::index_sequence<I...>) {
+            ((is_default(std::get<I>(t)) ? void() : encode_field(p, tags[I], std::get<I>(t), c)), ...);
+         }(std::make_index_sequence<tags.size()>{});
+      }
+
+      template <message_type T>
+      static inline void decode_message(reader& r, T& m) {
+         constexpr auto tags = field_numbers<T>();
+         auto           t    = m.reflected_tie();
+         while (!r.done()) {
+            const std::uint64_t key   = r.varint();
+            const std::uint64_t field = key >> 3;
+            const auto          w     = static_cast<wire>(key & 7);
+            util::check(field != 0, "proto: invalid field number");
+            const bool known = [&]<std::size_t... I>(std::index_sequence<I...>) {
+               return ((field == tags[I] ? (decode_field(r, w, std::get<I>(t)), true) : false) || ...);
+            }(std::make_index_sequence<tags.size()>{});
+            if (!known)
+               r.skip(w);
+         }
+      }
+
+      static inline size_cache& local_cache() {
+         thread_local size_cache c;
+         c.clear();
+         return c;
+      }
+   } // namespace detail::pb
+
+   /**
+    * @brief Protocol Buffers wire format codec for reflected types.
+    *
+    * Field numbers come from ASTRO_REFL_TAGS, or count up from 1 in ASTRO_REFL order. Integers are int32/int64/uint32/uint64,
+    * varint<T> of a signed type is sint32/sint64, fixed<T> is (s)fixed32/64, strings and std::vector<std::byte> are
+    * string/bytes, reflected members are submessages, sequences are repeated fields (packed for scalars) and maps are map
+    * fields. Encoding sizes everything first, then writes into a single allocation.
+    */
    class proto {
       public:
-         proto() = default;
+         proto()  = default;
          ~proto() = default;
 
-         template <typename T>
-         static void serialize(T const& value, std::ostream& stream) {
-            stream << value;
+         template <detail::pb::message_type T>
+         static inline std::size_t encoded_size(const T& value) {
+            return detail::pb::message_size(value, detail::pb::local_cache());
          }
 
-         template <typename T>
-         static void deserialize(T& value, std::istream& stream) {
-            stream >> value;
+         template <detail::pb::message_type T>
+         static inline std::vector<std::uint8_t> encode(const T& value) {
+            auto&                     c = detail::pb::local_cache();
+            std::vector<std::uint8_t> out(detail::pb::message_size(value, c));
+            std::uint8_t*             p = out.data();
+            detail::pb::encode_message(p, value, c);
+            return out;
+         }
+
+         /**
+          * @brief Encodes at the archive cursor.
+          * @return The number of bytes written.
+          */
+         template <detail::pb::message_type T>
+         static inline std::size_t encode(const T& value, serializer_base& a) {
+            auto&             c  = detail::pb::local_cache();
+            const std::size_t sz = detail::pb::message_size(value, c);
+            const auto        at = static_cast<std::size_t>(a.pos());
+            a.resize(std::max(a.size(), at + sz));
+            std::uint8_t* p = a.data() + at;
+            detail::pb::encode_message(p, value, c);
+            a.fastforward(sz);
+            return sz;
+         }
+
+         /**
+          * @brief Parses a message, std::string_view members and lazy submessages borrow from bytes.
+          */
+         template <detail::pb::message_type T>
+         static inline T decode(std::span<const std::uint8_t> bytes) {
+            T v{};
+            merge(bytes, v);
+            return v;
          }
+
+         /**
+          * @brief Parses into an existing message, scalars are overwritten and repeated fields appended.
+          */
+         template <detail::pb::message_type T>
+         static inline void merge(std::span<const std::uint8_t> bytes, T& value) {
+            detail::pb::reader r{bytes.data(), bytes.data() + bytes.size()};
+            detail::pb::decode_message(r, value);
+         }
+   };
+
+   /**
+    * @brief Submessage field that keeps its encoded bytes and only parses them on first access.
+    *
+    * The bytes are borrowed from the decoded buffer. An unparsed lazy field is re-encoded by copying them through.
+    */
+   template <reflected_type T>
+   class lazy {
+      public:
+         lazy() = default;
+         lazy(T v) : _value(std::move(v)) {}
+
+         static inline lazy from_bytes(std::span<const std::uint8_t> bytes) noexcept {
+            lazy l;
+            l._bytes = bytes;
+            return l;
+         }
+
+         inline bool parsed() const noexcept { return _value.has_value(); }
+         inline std::span<const std::uint8_t> bytes() const noexcept { return _bytes; }
+
+         inline const T& get() const {
+            if (!_value)
+               _value = proto::decode<T>(_bytes);
+            return *_value;
+         }
+
+         inline T& get() {
+            std::as_const(*this).get();
+            return *_value;
+         }
+
+         inline const T* operator->() const { return &get(); }
+         inline T* operator->() { return &get(); }
+
       private:
+         std::span<const std::uint8_t> _bytes;
+         mutable std::optional<T>      _value;
    };
-};
\ No newline at end of file
+} // namespace astro::serial
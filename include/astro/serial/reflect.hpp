@@ -0,0 +1,907 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <memory>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "../compile_time/reflect.hpp"
+#include "../cryptid/uint128.hpp"
+#include "alpha.hpp"
+#include "varint.hpp"
+
+namespace astro::serial {
+
+   /**
+    * @brief Types that expose their members through ASTRO_REFL.
+    */
+   template <typename T>
+   concept reflected_type = requires(T& t, const T& ct) {
+      typename T::reflected_member_types;
+      t.reflected_tie();
+      ct.reflected_tie();
+   };
+
+   /**
+    * @brief Reflected types that number their fields with ASTRO_REFL_TAGS.
+    *
+    * alpha writes these as tagged fields inside a length-prefixed message instead of positionally, so fields can be added,
+    * removed and reordered: readers skip tags they do not know and leave fields missing from the data at their defaults.
+    * Tags of removed fields must not be reused.
+    */
+   template <typename T>
+   concept tagged_type = reflected_type<T> && requires { T::reflected_tags(); };
+
+   namespace detail {
+      using length_t = std::uint32_t;
+
+      /**
+       * @brief The ASTRO_REFL_TAGS of T, checked to be one per member, unique and in [1, 2^29).
+       */
+      template <tagged_type T>
+      constexpr static inline auto field_tags() noexcept {
+         constexpr auto tags = T::reflected_tags();
+         static_assert(tags.size() == std::tuple_size_v<typename T::reflected_member_types>, "serial: one tag per reflected member");
+         static_assert([&] {
+            for (std::size_t i = 0; i < tags.size(); ++i) {
+               if (tags[i] == 0 || tags[i] >= (1u << 29))
+                  return false;
+               for (std::size_t j = 0; j < i; ++j)
+                  if (tags[i] == tags[j])
+                     return false;
+            }
+            return true;
+         }(), "serial: tags must be unique and in [1, 2^29)");
+         return tags;
+      }
+
+      template <typename T>
+      struct is_std_array : std::false_type {};
+      template <typename T, std::size_t N>
+      struct is_std_array<std::array<T, N>> : std::true_type {};
+
+      template <typename T>
+      struct is_optional : std::false_type {};
+      template <typename T>
+      struct is_optional<std::optional<T>> : std::true_type {};
+
+      template <typename T>
+      struct is_variant : std::false_type {};
+      template <typename... Ts>
+      struct is_variant<std::variant<Ts...>> : std::true_type {};
+
+      template <typename T>
+      struct is_pair : std::false_type {};
+      template <typename A, typename B>
+      struct is_pair<std::pair<A, B>> : std::true_type {};
+
+      template <typename T>
+      struct is_tuple : std::false_type {};
+      template <typename... Ts>
+      struct is_tuple<std::tuple<Ts...>> : std::true_type {};
+
+      template <typename T>
+      struct is_basic_string : std::false_type {};
+      template <typename C, typename Tr, typename A>
+      struct is_basic_string<std::basic_string<C, Tr, A>> : std::true_type {};
+
+      /**
+       * @brief Values written as their object representation.
+       */
+      template <typename T>
+      concept raw_type = std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_same_v<T, std::byte> ||
+                         std::is_same_v<T, cryptid::uint128> || fixed_type<T>;
+
+      template <typename T>
+      concept map_type = requires(T& m) {
+         typename T::key_type;
+         typename T::mapped_type;
+         m.emplace(std::declval<typename T::key_type>(), std::declval<typename T::mapped_type>());
+      };
+
+      template <typename T>
+      concept set_type = !map_type<T> && requires(T& s) {
+         typename T::key_type;
+         s.insert(std::declval<typename T::key_type>());
+      };
+
+      template <typename T>
+      concept sequence_type = !is_basic_string<T>::value && requires(T& s) {
+         typename T::value_type;
+         s.size();
+         s.emplace_back();
+      };
+
+      template <typename T>
+      constexpr static inline bool is_supported();
+
+      template <template <typename...> class List, typename... Ts>
+      constexpr static inline bool all_supported(std::type_identity<List<Ts...>>) {
+         return (is_supported<std::remove_cvref_t<Ts>>() && ...);
+      }
+
+      template <typename T>
+      constexpr static inline bool is_supported() {
+         if constexpr (raw_type<T> || varint_type<T>)
+            return true;
+         else if constexpr (is_basic_string<T>::value || std::is_same_v<T, std::string_view>)
+            return sizeof(typename T::value_type) == 1;
+         else if constexpr (span_type<T>)
+            return std::is_const_v<typename T::element_type>;
+         else if constexpr (reflected_type<T>)
+            return all_supported(std::type_identity<typename T::reflected_member_types>{});
+         else if constexpr (is_optional<T>::value)
+            return is_supported<typename T::value_type>();
+         else if constexpr (is_variant<T>::value || is_tuple<T>::value)
+            return all_supported(std::type_identity<T>{});
+         else if constexpr (is_pair<T>::value)
+            return is_supported<std::remove_const_t<typename T::first_type>>() && is_supported<typename T::second_type>();
+         else if constexpr (is_std_array<T>::value)
+            return is_supported<typename T::value_type>();
+         else if constexpr (map_type<T>)
+            return is_supported<typename T::key_type>() && is_supported<typename T::mapped_type>();
+         else if constexpr (set_type<T>)
+            return is_supported<typename T::key_type>();
+         else if constexpr (sequence_type<T>)
+            return is_supported<typename T::value_type>();
+         else
+            return false;
+      }
+
+      template <typename T>
+      constexpr static inline bool is_dense();
+
+      /**
+       * @brief The layout a standard-layout compiler gives the reflected members, with the padding-free runs of dense fields.
+       *
+       * The simulation assumes the reflected members are all of the members in declaration order, which is confirmed against
+       * the real addresses once per type before the runs are used.
+       */
+      template <reflected_type T>
+      struct layout {
+         using types = typename T::reflected_member_types;
+
+         constexpr static inline std::size_t count = std::tuple_size_v<types>;
+
+         template <std::size_t I>
+         using field_t = std::tuple_element_t<I, types>;
+
+         struct segment {
+            std::size_t first = 0;
+            std::size_t last  = 0;
+            std::size_t bytes = 0;
+            bool        run   = false;
+         };
+
+         constexpr static inline auto sizes = []<std::size_t... I>(std::index_sequence<I...>) {
+            return std::array<std::size_t, count>{sizeof(field_t<I>)...};
+         }(std::make_index_sequence<count>{});
+
+         constexpr static inline auto dense = []<std::size_t... I>(std::index_sequence<I...>) {
+            return std::array<bool, count>{(!std::is_reference_v<field_t<I>> && is_dense<std::remove_cv_t<field_t<I>>>())...};
+         }(std::make_index_sequence<count>{});
+
+         constexpr static inline auto offsets = []<std::size_t... I>(std::index_sequence<I...>) {
+            std::array<std::size_t, count> out{};
+            std::array<std::size_t, count> aligns{alignof(std::remove_reference_t<field_t<I>>)...};
+            std::size_t                    end = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+               end     = (end + aligns[i] - 1) / aligns[i] * aligns[i];
+               out[i]  = end;
+               end    += sizes[i];
+            }
+            return out;
+         }(std::make_index_sequence<count>{});
+
+         constexpr static inline bool plausible = []<std::size_t... I>(std::index_sequence<I...>) {
+            if constexpr ((std::is_reference_v<field_t<I>> || ...))
+               return false;
+            else {
+               const std::size_t align = std::max({alignof(T), alignof(field_t<I>)...});
+               const std::size_t end   = count == 0 ? 0 : offsets[count - 1] + sizes[count - 1];
+               return std::is_standard_layout_v<T> && (end + align - 1) / align * align == sizeof(T);
+            }
+         }(std::make_index_sequence<count>{});
+
+         // fields merge into one run while they are dense and no padding sits between them
+         constexpr static inline std::size_t segment_count = [] {
+            std::size_t n = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+               const bool extends = plausible && i > 0 && dense[i] && dense[i - 1] && offsets[i] == offsets[i - 1] + sizes[i - 1];
+               n += !extends;
+            }
+            return n;
+         }();
+
+         constexpr static inline auto segments = [] {
+            std::array<segment, segment_count> out{};
+            std::size_t                        n = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+               const bool extends = plausible && i > 0 && dense[i] && dense[i - 1] && offsets[i] == offsets[i - 1] + sizes[i - 1];
+               if (extends) {
+                  out[n - 1].last   = i;
+                  out[n - 1].bytes += sizes[i];
+               } else {
+                  out[n++] = segment{i, i, sizes[i], plausible && dense[i]};
+               }
+            }
+            for (auto& s : out)
+               s.run = s.run && s.last > s.first;
+            return out;
+         }();
+
+         constexpr static inline bool fully_dense = plausible && count > 0 && segment_count == 1 && segments[0].bytes == sizeof(T);
+
+         /**
+          * @brief Checks the simulated offsets against a live object, the result is cached per type.
+          */
+         static inline bool verified(const T& v) noexcept {
+            static const bool ok = [&] {
+               if constexpr (!plausible)
+                  return false;
+               else {
+                  const auto  t    = v.reflected_tie();
+                  const auto* base = reinterpret_cast<const std::byte*>(&v);
+                  return [&]<std::size_t... I>(std::index_sequence<I...>) {
+                     return ((reinterpret_cast<const std::byte*>(&std::get<I>(t)) - base == static_cast<std::ptrdiff_t>(offsets[I])) && ...);
+                  }(std::make_index_sequence<count>{});
+               }
+            }();
+            return ok;
+         }
+      };
+
+      /**
+       * @brief Types whose object representation is their wire format.
+       */
+      template <typename T>
+      constexpr static inline bool is_dense() {
+         if constexpr (raw_type<T>)
+            return true;
+         else if constexpr (is_std_array<T>::value)
+            return is_dense<typename T::value_type>();
+         else if constexpr (reflected_type<T>)
+            return !tagged_type<T> && std::is_trivially_copyable_v<T> && layout<T>::fully_dense;
+         else
+            return false;
+      }
+
+      template <typename T, typename A>
+      static inline void write_value(A& a, const T& v);
+
+      template <typename T>
+      static inline T read_value(serializer_base& a);
+
+      template <typename A>
+      static inline void write_length(A& a, std::size_t n) {
+         util::check(n <= std::numeric_limits<length_t>::max(), "serial: length does not fit the length prefix");
+         const auto len = static_cast<length_t>(n);
+         a.write(&len, sizeof(len));
+      }
+
+      static inline std::size_t read_length(serializer_base& a, std::size_t min_elem_size) {
+         length_t len = 0;
+         a.read(&len, sizeof(len));
+         util::check(min_elem_size == 0 || len <= a.remaining() / min_elem_size, "serial: length exceeds the remaining input");
+         return len;
+      }
+
+      template <reflected_type T, typename A>
+      static inline void write_reflected(A& a, const T& v) {
+         using L      = layout<T>;
+         const auto t = v.reflected_tie();
+         if (L::verified(v)) {
+            [&]<std::size_t... S>(std::index_sequence<S...>) {
+               ([&] {
+                  constexpr auto seg = L::segments[S];
+                  if constexpr (seg.run)
+                     a.write(&std::get<seg.first>(t), seg.bytes);
+                  else
+                     write_value(a, std::get<seg.first>(t));
+               }(), ...);
+            }(std::make_index_sequence<L::segment_count>{});
+         } else {
+            std::apply([&](const auto&... f) { (write_value(a, f), ...); }, t);
+         }
+      }
+
+      template <reflected_type T>
+      static inline T read_reflected(serializer_base& a) {
+         using L = layout<T>;
+         T    v{};
+         auto t = v.reflected_tie();
+         if (L::verified(v)) {
+            [&]<std::size_t... S>(std::index_sequence<S...>) {
+               ([&] {
+                  constexpr auto seg = L::segments[S];
+                  if constexpr (seg.run)
+                     a.read(&std::get<seg.first>(t), seg.bytes);
+                  else
+                     std::get<seg.first>(t) = read_value<std::remove_cvref_t<decltype(std::get<seg.first>(t))>>(a);
+               }(), ...);
+            }(std::make_index_sequence<L::segment_count>{});
+         } else {
+            std::apply([&](auto&... f) { ((f = read_value<std::remove_cvref_t<decltype(f)>>(a)), ...); }, t);
+         }
+         return v;
+      }
+
+      template <typename T>
+      concept varint_array_type = std::ranges::contiguous_range<T> && varint_type<typename T::value_type>;
+
+      /**
+       * @brief Writes a contiguous run of varints, 32-bit values as one Stream-VByte block and wider ones as LEB128.
+       */
+      template <typename E, typename A>
+      static inline void write_varints(A& a, std::span<const E> v) {
+         using T = typename E::value_type;
+         if constexpr (sizeof(T) == 4) {
+            auto vals = std::make_unique_for_overwrite<std::uint32_t[]>(v.size());
+            for (std::size_t i = 0; i < v.size(); ++i)
+               vals[i] = zigzag_encode(v[i].value);
+            if constexpr (std::is_same_v<A, unchecked_writer>) {
+               // the exact size was measured, so encode in place
+               a.pos += stream_vbyte_encode({vals.get(), v.size()}, a.data + a.pos);
+            } else {
+               auto buf = std::make_unique_for_overwrite<std::uint8_t[]>(stream_vbyte_max_bytes(v.size()));
+               a.write(buf.get(), stream_vbyte_encode({vals.get(), v.size()}, buf.get()));
+            }
+         } else {
+            for (const auto& x : v)
+               write_varint(a, zigzag_encode(x.value));
+         }
+      }
+
+      template <typename E>
+      static inline void read_varints(serializer_base& a, std::span<E> out) {
+         using T   = typename E::value_type;
+         using U   = std::make_unsigned_t<T>;
+         auto vals = std::make_unique_for_overwrite<U[]>(out.size());
+         if constexpr (sizeof(T) == 4)
+            a.fastforward(stream_vbyte_decode({a.data() + a.pos(), a.remaining()}, std::span<std::uint32_t>{vals.get(), out.size()}));
+         else
+            a.fastforward(decode_varints({a.data() + a.pos(), a.remaining()}, std::span<U>{vals.get(), out.size()}));
+         for (std::size_t i = 0; i < out.size(); ++i)
+            out[i].value = zigzag_decode<T>(vals[i]);
+      }
+
+      /**
+       * @brief How a tagged field is framed: 1, 2, 4 or 8 bytes inline, or a uint32 length then the bytes.
+       */
+      enum class field_kind : std::uint8_t { fixed1 = 0, fixed2 = 1, fixed4 = 2, fixed8 = 3, sized = 4 };
+
+      template <typename T>
+      constexpr static inline std::size_t fixed_size();
+
+      template <typename T>
+      constexpr static inline std::size_t min_size();
+
+      template <typename F>
+      constexpr static inline field_kind kind_of() noexcept {
+         constexpr std::size_t n = fixed_size<F>();
+         return n == 1 ? field_kind::fixed1
+              : n == 2 ? field_kind::fixed2
+              : n == 4 ? field_kind::fixed4
+              : n == 8 ? field_kind::fixed8
+                       : field_kind::sized;
+      }
+
+      /**
+       * @brief The per-field metadata of a tagged type, and where each tag sits in declaration order.
+       */
+      template <tagged_type T>
+      struct tagged_fields {
+         using types = typename T::reflected_member_types;
+
+         constexpr static inline auto        tags  = field_tags<T>();
+         constexpr static inline std::size_t count = tags.size();
+
+         template <std::size_t I>
+         using field_t = std::remove_cvref_t<std::tuple_element_t<I, types>>;
+
+         constexpr static inline auto kinds = []<std::size_t... I>(std::index_sequence<I...>) {
+            return std::array<field_kind, count>{kind_of<field_t<I>>()...};
+         }(std::make_index_sequence<count>{});
+
+         // the varint key that starts each field
+         constexpr static inline auto keys = [] {
+            std::array<std::uint64_t, count> out{};
+            for (std::size_t i = 0; i < count; ++i)
+               out[i] = (std::uint64_t{tags[i]} << 3) | static_cast<std::uint8_t>(kinds[i]);
+            return out;
+         }();
+
+         constexpr static inline std::uint32_t max_tag = count == 0 ? 0 : *std::max_element(tags.begin(), tags.end());
+
+         // small tag ranges index a table directly, sparse ones binary search the sorted tags
+         constexpr static inline bool direct = max_tag <= 4 * count + 64;
+
+         constexpr static inline auto table = [] {
+            if constexpr (direct) {
+               std::array<std::uint16_t, max_tag + 1> out{};
+               out.fill(static_cast<std::uint16_t>(count));
+               for (std::size_t i = 0; i < count; ++i)
+                  out[tags[i]] = static_cast<std::uint16_t>(i);
+               return out;
+            } else {
+               std::array<std::pair<std::uint32_t, std::uint16_t>, count> out{};
+               for (std::size_t i = 0; i < count; ++i)
+                  out[i] = {tags[i], static_cast<std::uint16_t>(i)};
+               std::sort(out.begin(), out.end());
+               return out;
+            }
+         }();
+
+         /**
+          * @brief The member holding tag, or count for a tag this build does not know.
+          */
+         constexpr static inline std::size_t find(std::uint64_t tag) noexcept {
+            if constexpr (direct) {
+               return tag <= max_tag ? table[tag] : count;
+            } else {
+               const auto it = std::lower_bound(table.begin(), table.end(), tag, [](const auto& e, std::uint64_t t) { return e.first < t; });
+               return it != table.end() && it->first == tag ? it->second : count;
+            }
+         }
+      };
+
+      static inline std::size_t cursor(const serializer_base& a) noexcept { return static_cast<std::size_t>(a.pos()); }
+      static inline std::size_t cursor(const unchecked_writer& w) noexcept { return w.pos; }
+
+      /**
+       * @brief Fills in the uint32 length reserved at offset at with the bytes written since.
+       */
+      template <typename A>
+      static inline void patch_length(A& a, std::size_t at) {
+         const std::size_t n = cursor(a) - at - sizeof(length_t);
+         util::check(n <= std::numeric_limits<length_t>::max(), "serial: tagged message too large");
+         const auto len = static_cast<length_t>(n);
+         if constexpr (std::is_same_v<A, unchecked_writer>)
+            std::memcpy(a.data + at, &len, sizeof(len));
+         else
+            a.write(static_cast<serializer_base::pos_t>(at), &len, sizeof(len));
+      }
+
+      template <tagged_type T, typename A>
+      static inline void write_tagged(A& a, const T& v) {
+         using M              = tagged_fields<T>;
+         const std::size_t at = cursor(a);
+         const length_t    placeholder = 0;
+         a.write(&placeholder, sizeof(placeholder));
+         const auto t = v.reflected_tie();
+         [&]<std::size_t... I>(std::index_sequence<I...>) {
+            ([&] {
+               write_varint(a, M::keys[I]);
+               if constexpr (M::kinds[I] == field_kind::sized) {
+                  const std::size_t field_at = cursor(a);
+                  a.write(&placeholder, sizeof(placeholder));
+                  write_value(a, std::get<I>(t));
+                  patch_length(a, field_at);
+               } else {
+                  write_value(a, std::get<I>(t));
+               }
+            }(), ...);
+         }(std::make_index_sequence<M::count>{});
+         patch_length(a, at);
+      }
+
+      static inline void skip_field(serializer_base& a, std::uint64_t kind, std::size_t end) {
+         std::size_t n = 0;
+         if (kind == static_cast<std::uint8_t>(field_kind::sized)) {
+            length_t len = 0;
+            a.read(&len, sizeof(len));
+            n = len;
+         } else {
+            util::check(kind < static_cast<std::uint8_t>(field_kind::sized), "serial: unknown field kind");
+            n = std::size_t{1} << kind;
+         }
+         util::check(n <= end - cursor(a), "serial: field overruns its message");
+         a.fastforward(n);
+      }
+
+      template <tagged_type T>
+      static inline T read_tagged(serializer_base& a) {
+         using M         = tagged_fields<T>;
+         using reader_fn = void (*)(serializer_base&, T&, std::size_t);
+         constexpr auto readers = []<std::size_t... I>(std::index_sequence<I...>) {
+            return std::array<reader_fn, M::count>{+[](serializer_base& b, T& v, std::size_t end) {
+               auto t = v.reflected_tie();
+               if constexpr (M::kinds[I] == field_kind::sized) {
+                  length_t len = 0;
+                  b.read(&len, sizeof(len));
+                  util::check(len <= end - cursor(b), "serial: field overruns its message");
+                  const std::size_t field_end = cursor(b) + len;
+                  std::get<I>(t)              = read_value<typename M::template field_t<I>>(b);
+                  util::check(cursor(b) <= field_end, "serial: field overruns its length");
+                  b.pos(static_cast<serializer_base::pos_t>(field_end));
+               } else {
+                  util::check(fixed_size<typename M::template field_t<I>>() <= end - cursor(b), "serial: field overruns its message");
+                  std::get<I>(t) = read_value<typename M::template field_t<I>>(b);
+               }
+            }...};
+         }(std::make_index_sequence<M::count>{});
+
+         T        v{};
+         length_t len = 0;
+         a.read(&len, sizeof(len));
+         util::check(len <= a.remaining(), "serial: tagged message exceeds the remaining input");
+         const std::size_t end  = cursor(a) + len;
+         std::size_t       next = 0;
+         while (cursor(a) < end) {
+            const std::uint64_t key = read_varint(a);
+            // data written by the same schema hits the expected field without a lookup
+            std::size_t i = next < M::count && key == M::keys[next] ? next : M::find(key >> 3);
+            if (i == M::count) {
+               skip_field(a, key & 7, end);
+               continue;
+            }
+            util::check(key == M::keys[i], "serial: field changed its kind");
+            readers[i](a, v, end);
+            next = i + 1;
+         }
+         util::check(cursor(a) == end, "serial: tagged message overruns its length");
+         return v;
+      }
+
+      template <typename V, std::size_t I = 0>
+      static inline V read_variant(serializer_base& a, std::size_t index) {
+         if constexpr (I == std::variant_size_v<V>) {
+            util::check(false, "serial: variant index out of range");
+            return V{};
+         } else {
+            if (index == I)
+               return V{std::in_place_index<I>, read_value<std::variant_alternative_t<I, V>>(a)};
+            return read_variant<V, I + 1>(a, index);
+         }
+      }
+
+      template <typename T, typename A>
+      static inline void write_value(A& a, const T& v) {
+         if constexpr (raw_type<T>) {
+            a.write(&v, sizeof(T));
+         } else if constexpr (is_basic_string<T>::value || std::is_same_v<T, std::string_view>) {
+            write_length(a, v.size());
+            a.write(v.data(), v.size());
+         } else if constexpr (span_type<T>) {
+            write_length(a, v.size());
+            a.write_padding(alignof(typename T::element_type));
+            a.write(v.data(), v.size_bytes());
+         } else if constexpr (tagged_type<T>) {
+            write_tagged(a, v);
+         } else if constexpr (reflected_type<T>) {
+            if constexpr (is_dense<T>())
+               a.write(&v, sizeof(T));
+            else
+               write_reflected(a, v);
+         } else if constexpr (is_optional<T>::value) {
+            const std::uint8_t has = v.has_value();
+            a.write(&has, 1);
+            if (has)
+               write_value(a, *v);
+         } else if constexpr (varint_type<T>) {
+            write_varint(a, zigzag_encode(v.value));
+         } else if constexpr (is_variant<T>::value) {
+            util::check(!v.valueless_by_exception(), "serial: variant is valueless");
+            write_length(a, v.index());
+            std::visit([&](const auto& x) { write_value(a, x); }, v);
+         } else if constexpr (is_pair<T>::value) {
+            write_value(a, v.first);
+            write_value(a, v.second);
+         } else if constexpr (is_tuple<T>::value) {
+            std::apply([&](const auto&... x) { (write_value(a, x), ...); }, v);
+         } else if constexpr (is_std_array<T>::value) {
+            if constexpr (is_dense<typename T::value_type>())
+               a.write(v.data(), sizeof(T));
+            else
+               for (const auto& x : v)
+                  write_value(a, x);
+         } else if constexpr (map_type<T> || set_type<T> || sequence_type<T>) {
+            write_length(a, static_cast<std::size_t>(std::distance(v.begin(), v.end())));
+            if constexpr (varint_array_type<T>) {
+               write_varints(a, std::span<const typename T::value_type>{std::ranges::data(v), v.size()});
+            } else if constexpr (std::ranges::contiguous_range<T> && is_dense<typename T::value_type>()) {
+               // padded like a span so the elements can be borrowed back in place
+               a.write_padding(alignof(typename T::value_type));
+               if (!v.empty())
+                  a.write(std::ranges::data(v), v.size() * sizeof(typename T::value_type));
+            } else if constexpr (map_type<T>) {
+               for (const auto& [k, x] : v) {
+                  write_value(a, k);
+                  write_value(a, x);
+               }
+            } else {
+               for (const auto& x : v)
+                  write_value(a, static_cast<const typename T::value_type&>(x));
+            }
+         } else {
+            static_assert(is_supported<T>(), "type is not serializable");
+         }
+      }
+
+      template <typename T>
+      static inline T read_value(serializer_base& a) {
+         if constexpr (raw_type<T>) {
+            T v;
+            a.read(&v, sizeof(T));
+            return v;
+         } else if constexpr (is_basic_string<T>::value || std::is_same_v<T, std::string_view>) {
+            const auto bytes = a.read_view(read_length(a, 1));
+            return T(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+         } else if constexpr (span_type<T>) {
+            using E             = typename T::element_type;
+            const std::size_t n = read_length(a, sizeof(E));
+            a.skip_padding(alignof(E));
+            const auto bytes = a.read_view(n * sizeof(E));
+            util::check(reinterpret_cast<std::uintptr_t>(bytes.data()) % alignof(E) == 0, "serial: borrowed span is misaligned");
+            return T(reinterpret_cast<E*>(bytes.data()), n);
+         } else if constexpr (tagged_type<T>) {
+            return read_tagged<T>(a);
+         } else if constexpr (reflected_type<T>) {
+            if constexpr (is_dense<T>()) {
+               T v;
+               a.read(&v, sizeof(T));
+               return v;
+            } else {
+               return read_reflected<T>(a);
+            }
+         } else if constexpr (is_optional<T>::value) {
+            std::uint8_t has = 0;
+            a.read(&has, 1);
+            if (!has)
+               return T{};
+            return T{read_value<typename T::value_type>(a)};
+         } else if constexpr (varint_type<T>) {
+            return T{read_varint_as<typename T::value_type>(a)};
+         } else if constexpr (is_variant<T>::value) {
+            length_t index = 0;
+            a.read(&index, sizeof(index));
+            return read_variant<T>(a, index);
+         } else if constexpr (is_pair<T>::value) {
+            auto first = read_value<std::remove_const_t<typename T::first_type>>(a);
+            return T{std::move(first), read_value<typename T::second_type>(a)};
+         } else if constexpr (is_tuple<T>::value) {
+            return [&]<std::size_t... I>(std::index_sequence<I...>) {
+               // braced init keeps the reads in order
+               return T{read_value<std::tuple_element_t<I, T>>(a)...};
+            }(std::make_index_sequence<std::tuple_size_v<T>>{});
+         } else if constexpr (is_std_array<T>::value) {
+            T v;
+            if constexpr (is_dense<typename T::value_type>())
+               a.read(v.data(), sizeof(T));
+            else
+               for (auto& x : v)
+                  x = read_value<typename T::value_type>(a);
+            return v;
+         } else if constexpr (map_type<T>) {
+            T                 v;
+            const std::size_t n = read_length(a, min_size<std::pair<typename T::key_type, typename T::mapped_type>>());
+            for (std::size_t i = 0; i < n; ++i) {
+               auto k = read_value<typename T::key_type>(a);
+               v.emplace(std::move(k), read_value<typename T::mapped_type>(a));
+            }
+            return v;
+         } else if constexpr (set_type<T>) {
+            T                 v;
+            const std::size_t n = read_length(a, min_size<typename T::key_type>());
+            for (std::size_t i = 0; i < n; ++i)
+               v.insert(read_value<typename T::key_type>(a));
+            return v;
+         } else if constexpr (sequence_type<T>) {
+            using E             = typename T::value_type;
+            T                 v;
+            const std::size_t n = read_length(a, min_size<E>());
+            if constexpr (varint_array_type<T>) {
+               v.resize(n);
+               read_varints(a, std::span<E>{std::ranges::data(v), n});
+            } else if constexpr (std::ranges::contiguous_range<T> && is_dense<E>()) {
+               a.skip_padding(alignof(E));
+               v.resize(n);
+               if (n != 0)
+                  a.read(std::ranges::data(v), n * sizeof(E));
+            } else {
+               // elements that encode to nothing leave n unbounded, so never reserve past what the input could hold
+               if constexpr (requires { v.reserve(n); })
+                  v.reserve(std::min(n, a.remaining()));
+               for (std::size_t i = 0; i < n; ++i)
+                  v.emplace_back(read_value<E>(a));
+            }
+            return v;
+         } else {
+            static_assert(is_supported<T>(), "type is not serializable");
+            return T{};
+         }
+      }
+
+      constexpr static inline std::size_t dynamic_size = std::numeric_limits<std::size_t>::max();
+
+      template <template <typename...> class List, typename... Ts>
+      constexpr static inline std::size_t fixed_sum(std::type_identity<List<Ts...>>) {
+         constexpr std::array<std::size_t, sizeof...(Ts)> sizes{fixed_size<std::remove_cvref_t<Ts>>()...};
+         std::size_t                                        sum = 0;
+         for (const std::size_t s : sizes) {
+            if (s == dynamic_size)
+               return dynamic_size;
+            sum += s;
+         }
+         return sum;
+      }
+
+      /**
+       * @brief The encoded size shared by every value of T, or dynamic_size when it has lengths, tags or varints in it.
+       */
+      template <typename T>
+      constexpr static inline std::size_t fixed_size() {
+         if constexpr (is_dense<T>())
+            return sizeof(T);
+         else if constexpr (tagged_type<T>)
+            return dynamic_size;
+         else if constexpr (reflected_type<T>)
+            return fixed_sum(std::type_identity<typename T::reflected_member_types>{});
+         else if constexpr (is_pair<T>::value)
+            return fixed_sum(std::type_identity<std::tuple<std::remove_const_t<typename T::first_type>, typename T::second_type>>{});
+         else if constexpr (is_tuple<T>::value)
+            return fixed_sum(std::type_identity<T>{});
+         else if constexpr (is_std_array<T>::value) {
+            constexpr std::size_t e = fixed_size<typename T::value_type>();
+            return e == dynamic_size ? dynamic_size : e * std::tuple_size_v<T>;
+         } else
+            return dynamic_size;
+      }
+
+      /**
+       * @brief A lower bound on the encoded size of any T, so a length prefix can be checked against the remaining input.
+       */
+      template <typename T>
+      constexpr static inline std::size_t min_size() {
+         if constexpr (fixed_size<T>() != dynamic_size)
+            return fixed_size<T>();
+         else if constexpr (is_basic_string<T>::value || std::is_same_v<T, std::string_view> || span_type<T> || map_type<T>
+                            || set_type<T> || sequence_type<T> || is_variant<T>::value)
+            return sizeof(length_t);
+         else
+            // anything else with a dynamic size holds at least one length, tag, flag or varint byte
+            return 1;
+      }
+
+      /**
+       * @brief Where write_value(a, v) leaves the cursor if it starts at offset at, the offset places the alignment padding.
+       */
+      template <typename T>
+      static inline std::size_t measure(std::size_t at, const T& v) {
+         const auto pad = [](std::size_t pos, std::size_t align) { return pos + (align - pos % align) % align; };
+         if constexpr (fixed_size<T>() != dynamic_size) {
+            return at + fixed_size<T>();
+         } else if constexpr (is_basic_string<T>::value || std::is_same_v<T, std::string_view>) {
+            return at + sizeof(length_t) + v.size();
+         } else if constexpr (span_type<T>) {
+            return pad(at + sizeof(length_t), alignof(typename T::element_type)) + v.size_bytes();
+         } else if constexpr (tagged_type<T>) {
+            using M      = tagged_fields<T>;
+            const auto t = v.reflected_tie();
+            at          += sizeof(length_t);
+            [&]<std::size_t... I>(std::index_sequence<I...>) {
+               ((at = measure(at + varint_size(M::keys[I]) + (M::kinds[I] == field_kind::sized ? sizeof(length_t) : 0),
+                              std::get<I>(t))),
+                ...);
+            }(std::make_index_sequence<M::count>{});
+            return at;
+         } else if constexpr (reflected_type<T>) {
+            std::apply([&](const auto&... f) { ((at = measure(at, f)), ...); }, v.reflected_tie());
+            return at;
+         } else if constexpr (is_optional<T>::value) {
+            return v ? measure(at + 1, *v) : at + 1;
+         } else if constexpr (varint_type<T>) {
+            return at + varint_size(zigzag_encode(v.value));
+         } else if constexpr (is_variant<T>::value) {
+            util::check(!v.valueless_by_exception(), "serial: variant is valueless");
+            return std::visit([&](const auto& x) { return measure(at + sizeof(length_t), x); }, v);
+         } else if constexpr (is_pair<T>::value) {
+            return measure(measure(at, v.first), v.second);
+         } else if constexpr (is_tuple<T>::value) {
+            std::apply([&](const auto&... x) { ((at = measure(at, x)), ...); }, v);
+            return at;
+         } else if constexpr (is_std_array<T>::value) {
+            for (const auto& x : v)
+               at = measure(at, x);
+            return at;
+         } else if constexpr (map_type<T> || set_type<T> || sequence_type<T>) {
+            using E = typename T::value_type;
+            at     += sizeof(length_t);
+            if constexpr (varint_array_type<T>) {
+               if constexpr (sizeof(typename E::value_type) == 4) {
+                  at += (v.size() + 3) / 4;
+                  for (const auto& x : v)
+                     at += svb_length(zigzag_encode(x.value));
+               } else {
+                  for (const auto& x : v)
+                     at += varint_size(zigzag_encode(x.value));
+               }
+               return at;
+            } else if constexpr (std::ranges::contiguous_range<T> && is_dense<E>()) {
+               return pad(at, alignof(E)) + v.size() * sizeof(E);
+            } else if constexpr (map_type<T>) {
+               for (const auto& [k, x] : v)
+                  at = measure(measure(at, k), x);
+               return at;
+            } else if constexpr (fixed_size<E>() != dynamic_size) {
+               return at + static_cast<std::size_t>(std::distance(v.begin(), v.end())) * fixed_size<E>();
+            } else {
+               for (const auto& x : v)
+                  at = measure(at, static_cast<const E&>(x));
+               return at;
+            }
+         } else {
+            static_assert(is_supported<T>(), "type is not serializable");
+            return at;
+         }
+      }
+   } // namespace detail
+
+   /**
+    * @brief Types handled by the generic codec: reflected aggregates, enums, uint128 and the standard containers.
+    *
+    * Numbers, strings, spans and the integer tags keep their own overloads, the encodings match when nested. Members of type
+    * std::string_view and std::span<const T> borrow from the archive.
+    */
+   template <typename T>
+   concept generic_serializable_type = !util::numeric_type<T> && !util::string_type<T> && !span_type<T> && !varint_type<T> &&
+                                      !fixed_type<T> && detail::is_supported<T>();
+
+   template <generic_serializable_type T>
+   static inline void serialize(alpha& a, const T& v) {
+      detail::write_value(a, v);
+   }
+
+   template <generic_serializable_type T>
+   static inline T deserialize(alpha& a) {
+      return detail::read_value<T>(a);
+   }
+
+   /**
+    * @brief Types whose every value encodes to the same number of bytes, no strings, containers, optionals or varints.
+    */
+   template <typename T>
+   concept fixed_size_type = detail::is_supported<T>() && detail::fixed_size<T>() != detail::dynamic_size;
+
+   template <fixed_size_type T>
+   constexpr static inline std::size_t serialized_size() noexcept {
+      return detail::fixed_size<T>();
+   }
+
+   /**
+    * @brief The number of bytes serializing v writes when the cursor is at offset at.
+    *
+    * The offset only matters to spans and dense sequences, which pad their elements to alignment.
+    */
+   template <typename T>
+   requires(detail::is_supported<T>())
+   static inline std::size_t serialized_size(const T& v, std::size_t at = 0) {
+      return detail::measure(at, v) - at;
+   }
+
+   /**
+    * @brief Serializes v with a single reservation, sized by serialized_size and written with unchecked stores.
+    */
+   template <typename T>
+   requires(detail::is_supported<T>())
+   static inline void serialize_sized(alpha& a, const T& v) {
+      const auto        at = static_cast<std::size_t>(a.pos());
+      const std::size_t n  = serialized_size(v, at);
+      a.claim(n);
+      unchecked_writer w{a.data(), at};
+      detail::write_value(w, v);
+   }
+} // namespace astro::serial
@@ -1,12 +1,29 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <memory>
+#include <span>
+#include <utility>
+
 #include "../utils.hpp"
 
 namespace astro::serial {
 
+   /**
+    * @brief Byte buffer with a cursor, shared by the serializers.
+    *
+    * The buffer tracks its size and capacity separately and grows geometrically, writes inside the current size overwrite in
+    * place. It can also wrap caller-owned memory, in which case it never reallocates and writes past the end throw.
+    */
    struct serializer_base {
       constexpr static inline bool is_serial = true;
 
+      constexpr static inline std::size_t min_capacity = 64;
+
       using byte_t           = std::uint8_t;
       using pos_t            = std::int64_t;
       using iterator_t       = byte_t*;
@@ -14,49 +31,238 @@ namespace astro::serial {
 
       serializer_base() = default;
 
-      inline serializer_base(std::size_t sz) 
-         : _pos(0), _data(sz) {}
+      /**
+       * @brief Creates an empty buffer with room for sz bytes.
+       */
+      inline explicit serializer_base(std::size_t sz) { reserve(sz); }
+
+      /**
+       * @brief Writes into caller-owned memory, the buffer cannot grow past it.
+       * @param buf The memory to write into.
+       * @param sz The number of bytes already valid in buf.
+       */
+      inline explicit serializer_base(std::span<byte_t> buf, std::size_t sz = 0)
+         : _data(buf.data()), _size(std::min(sz, buf.size())), _capacity(buf.size()), _external(true) {}
+
+      /**
+       * @brief Reads from caller-owned memory without copying it, writes throw.
+       */
+      inline explicit serializer_base(std::span<const byte_t> buf)
+         : _data(const_cast<byte_t*>(buf.data())), _size(buf.size()), _capacity(buf.size()), _external(true), _readonly(true) {}
 
-      inline std::size_t size() const noexcept { return _data.size(); }
-      inline pos_t pos() const noexcept { return _pos; }
-      inline void pos(pos_t pos) noexcept { _pos = pos; }
+      inline serializer_base(const serializer_base& other) { *this = other; }
+
+      inline serializer_base(serializer_base&& other) noexcept { *this = std::move(other); }
+
+      inline serializer_base& operator=(const serializer_base& other) {
+         if (this == &other)
+            return *this;
+         // copies always own their bytes, even when the source wraps external memory
+         _owned.reset();
+         _data     = nullptr;
+         _size     = 0;
+         _capacity = 0;
+         _external = false;
+         _readonly = false;
+         reserve(other._size);
+         if (other._size != 0)
+            std::memcpy(_data, other._data, other._size);
+         _size = other._size;
+         _pos  = other._pos;
+         return *this;
+      }
+
+      inline serializer_base& operator=(serializer_base&& other) noexcept {
+         if (this == &other)
+            return *this;
+         _owned    = std::move(other._owned);
+         _data     = std::exchange(other._data, nullptr);
+         _size     = std::exchange(other._size, 0);
+         _capacity = std::exchange(other._capacity, 0);
+         _pos      = std::exchange(other._pos, 0);
+         _external = std::exchange(other._external, false);
+         _readonly = std::exchange(other._readonly, false);
+         return *this;
+      }
 
-      inline iterator_t begin() noexcept { return _data.data(); }
-      inline const_iterator_t begin() const noexcept { return _data.data(); }
-      inline const_iterator_t cbegin() const noexcept { return _data.data(); }
-      inline iterator_t end() noexcept { return _data.data() + _data.size(); }
-      inline const_iterator_t end() const noexcept { return _data.data() + _data.size(); }
-      inline const_iterator_t cend() const noexcept { return _data.data() + _data.size(); }
+      ~serializer_base() = default;
+
+      inline std::size_t size() const noexcept { return _size; }
+      inline std::size_t capacity() const noexcept { return _capacity; }
+      inline std::size_t remaining() const noexcept { return _size - std::min(_size, _pos); }
+      inline bool is_external() const noexcept { return _external; }
+      inline pos_t pos() const noexcept { return static_cast<pos_t>(_pos); }
+      inline void pos(pos_t pos) noexcept { _pos = static_cast<std::size_t>(pos); }
+
+      inline byte_t* data() noexcept { return _data; }
+      inline const byte_t* data() const noexcept { return _data; }
+      inline std::span<const byte_t> bytes() const noexcept ASTRO_LIFETIMEBOUND { return {_data, _size}; }
+
+      inline iterator_t begin() noexcept { return _data; }
+      inline const_iterator_t begin() const noexcept { return _data; }
+      inline const_iterator_t cbegin() const noexcept { return _data; }
+      inline iterator_t end() noexcept { return _data + _size; }
+      inline const_iterator_t end() const noexcept { return _data + _size; }
+      inline const_iterator_t cend() const noexcept { return _data + _size; }
+
+      /**
+       * @brief Ensures room for at least sz bytes without further reallocation.
+       */
+      inline void reserve(std::size_t sz) {
+         if (sz <= _capacity)
+            return;
+         util::check(!_external, "serializer: write past the end of an external buffer");
+         auto buf = std::make_unique_for_overwrite<byte_t[]>(sz);
+         if (_size != 0)
+            std::memcpy(buf.get(), _data, _size);
+         _owned    = std::move(buf);
+         _data     = _owned.get();
+         _capacity = sz;
+      }
+
+      /**
+       * @brief Sets the size, new bytes are zeroed.
+       */
+      inline void resize(std::size_t sz) {
+         grow(sz);
+         if (sz > _size)
+            std::memset(_data + _size, 0, sz - _size);
+         _size = sz;
+      }
+
+      /**
+       * @brief Drops the contents and rewinds, keeping the capacity.
+       */
+      inline void clear() noexcept {
+         _size = 0;
+         _pos  = 0;
+      }
 
       inline void write(pos_t pos, const void* val, std::size_t sz) {
-         _data.resize(_data.size() + sz);
-         std::memcpy(_data.data() + pos, val, sz);
+         if (sz == 0)
+            return;
+         util::check(!_readonly, "serializer: write to a read-only buffer");
+         const auto at  = static_cast<std::size_t>(pos);
+         const auto end = at + sz;
+         grow(end);
+         if (at > _size)
+            std::memset(_data + _size, 0, at - _size);
+         std::memcpy(_data + at, val, sz);
+         _size = std::max(_size, end);
       }
 
       inline void write(const void* val, std::size_t sz) {
-         write(_pos, val, sz);
+         write(static_cast<pos_t>(_pos), val, sz);
          _pos += sz;
       }
 
+      /**
+       * @brief Makes the next sz bytes part of the buffer in one step and moves the cursor past them.
+       * @return Where the bytes start, they hold whatever was there before.
+       */
+      inline byte_t* claim(std::size_t sz) {
+         util::check(!_readonly, "serializer: write to a read-only buffer");
+         const std::size_t end = _pos + sz;
+         grow(end);
+         if (_pos > _size)
+            std::memset(_data + _size, 0, _pos - _size);
+         byte_t* const p = _data + _pos;
+         _size           = std::max(_size, end);
+         _pos            = end;
+         return p;
+      }
+
       inline void read(pos_t pos, void* val, std::size_t sz) const {
-         std::memcpy(val, _data.data() + pos, sz);
+         if (sz == 0)
+            return;
+         const auto at = static_cast<std::size_t>(pos);
+         util::check(at <= _size && sz <= _size - at, "serializer: read past the end of the buffer");
+         std::memcpy(val, _data + at, sz);
       }
 
       inline void read(void* val, std::size_t sz) {
-         read(_pos, val, sz);
+         read(static_cast<pos_t>(_pos), val, sz);
+         _pos += sz;
+      }
+
+      /**
+       * @brief Borrows the next sz bytes without copying them, the view lives as long as the underlying memory.
+       */
+      inline std::span<const byte_t> read_view(std::size_t sz) ASTRO_LIFETIMEBOUND {
+         util::check(sz <= remaining(), "serializer: read past the end of the buffer");
+         const std::span<const byte_t> out{_data + _pos, sz};
          _pos += sz;
+         return out;
       }
 
+      /**
+       * @brief The number of bytes from the cursor to the next multiple of align.
+       */
+      inline std::size_t padding_for(std::size_t align) const noexcept { return (align - _pos % align) % align; }
+
+      /**
+       * @brief Zero-fills up to the next multiple of align, so a borrowed array can start aligned.
+       */
+      inline void write_padding(std::size_t align) {
+         constexpr static byte_t zeros[16] = {};
+         for (std::size_t pad = padding_for(align); pad != 0;) {
+            const std::size_t n = std::min(pad, sizeof(zeros));
+            write(zeros, n);
+            pad -= n;
+         }
+      }
+
+      inline void skip_padding(std::size_t align) { _pos += padding_for(align); }
+
       inline void fastforward(std::size_t sz) { _pos += sz; }
       inline void rewind(std::size_t sz) { _pos -= sz; }
       inline void reset() { _pos = 0; }
 
-      std::size_t               _pos  = 0;
-      std::vector<std::uint8_t> _data = {};
+      private:
+         inline void grow(std::size_t sz) {
+            if (sz <= _capacity)
+               return;
+            util::check(!_external, "serializer: write past the end of an external buffer");
+            reserve(std::max({sz, _capacity * 2, min_capacity}));
+         }
+
+         std::unique_ptr<byte_t[]> _owned    = nullptr;
+         byte_t*                   _data     = nullptr;
+         std::size_t               _size     = 0;
+         std::size_t               _capacity = 0;
+         std::size_t               _pos      = 0;
+         bool                      _external = false;
+         bool                      _readonly = false;
+   };
+
+   /**
+    * @brief Writes into memory already sized for what goes in it, without bounds checks or growth.
+    *
+    * alpha::pack measures a value with serialized_size, reserves once and then encodes through this. pos is the offset from
+    * data, so padding lines up the same as in the serializer_base it writes into.
+    */
+   struct unchecked_writer {
+      using byte_t = serializer_base::byte_t;
+
+      byte_t*     data = nullptr;
+      std::size_t pos  = 0;
+
+      inline void write(const void* val, std::size_t sz) noexcept {
+         std::memcpy(data + pos, val, sz);
+         pos += sz;
+      }
+
+      inline std::size_t padding_for(std::size_t align) const noexcept { return (align - pos % align) % align; }
+
+      inline void write_padding(std::size_t align) noexcept {
+         const std::size_t pad = padding_for(align);
+         std::memset(data + pos, 0, pad);
+         pos += pad;
+      }
    };
 
    template <typename S>
    concept serial_type = requires {
       std::is_same_v<decltype(S::is_serial), bool>;
    };
-} // namespace astro::serial
\ No newline at end of file
+} // namespace astro::serial
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <concepts>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "alpha.hpp"
+
+namespace astro::serial {
+
+   /**
+    * @brief Anything with write(std::string_view) returning the bytes written or -1, io::sink and fs::file_sink included.
+    */
+   template <typename S>
+   concept byte_sink_type = requires(S& s, std::string_view v) {
+      { s.write(v) } -> std::convertible_to<std::int64_t>;
+   };
+
+   /**
+    * @brief Anything with read_some(std::span<std::uint8_t>) returning the bytes read, 0 at the end or -1 on error.
+    */
+   template <typename S>
+   concept byte_source_type = requires(S& s, std::span<std::uint8_t> b) {
+      { s.read_some(b) } -> std::convertible_to<std::int64_t>;
+   };
+
+   /**
+    * @brief A source over memory that is already loaded, e.g. a memory::mapped_file.
+    *
+    * stream_reader hands out frames straight from this memory instead of copying them into its own buffer.
+    */
+   struct bytes_source {
+      bytes_source(std::span<const std::uint8_t> b) noexcept
+         : data(b) {}
+
+      inline int64_t read_some(std::span<std::uint8_t> buf) noexcept {
+         const std::size_t n = std::min(buf.size(), data.size() - pos);
+         if (n != 0)
+            std::memcpy(buf.data(), data.data() + pos, n);
+         pos += n;
+         return static_cast<int64_t>(n);
+      }
+
+      std::span<const std::uint8_t> data;
+      std::size_t                   pos = 0;
+   };
+
+   struct stream_options {
+      /** @brief Records are batched until this many bytes are buffered, larger records bypass the buffer. */
+      std::size_t chunk_size = 64 * 1024;
+      /** @brief Hand full chunks to a flusher thread so encoding overlaps with the writes. */
+      bool background = false;
+   };
+
+   namespace detail {
+      constexpr static inline std::size_t max_write_part = std::size_t{1} << 30;
+
+      /**
+       * @brief Writes every part in order, looping on short writes.
+       */
+      template <byte_sink_type Sink>
+      inline void write_all(Sink& sink, std::span<const std::string_view> in) {
+         // the sinks return int32, so big parts are split
+         std::vector<std::string_view> parts;
+         parts.reserve(in.size());
+         for (auto p : in) {
+            for (; p.size() > max_write_part; p.remove_prefix(max_write_part))
+               parts.push_back(p.substr(0, max_write_part));
+            if (!p.empty())
+               parts.push_back(p);
+         }
+
+         std::size_t i = 0;
+         while (i < parts.size()) {
+            int64_t n = 0;
+            if constexpr (requires(std::span<const std::string_view> s) { sink.writev(s); }) {
+               n = sink.writev(std::span<const std::string_view>{parts}.subspan(i));
+            } else {
+               n = sink.write(parts[i]);
+            }
+            util::check(n > 0, "stream: write failed");
+            for (auto left = static_cast<std::size_t>(n); left != 0;) {
+               const std::size_t k = std::min(left, parts[i].size());
+               parts[i].remove_prefix(k);
+               left -= k;
+               if (parts[i].empty())
+                  ++i;
+            }
+         }
+      }
+
+      inline std::string_view as_chars(std::span<const std::uint8_t> b) noexcept {
+         return {reinterpret_cast<const char*>(b.data()), b.size()};
+      }
+   } // namespace detail
+
+   /**
+    * @brief Serializes records into fixed size chunks and writes each chunk to a sink when it fills.
+    *
+    * Each record is framed as a uint32 length followed by its alpha encoding, so a reader can pull them back
+    * one at a time without holding the whole stream. The sink is borrowed and must outlive the writer.
+    */
+   template <byte_sink_type Sink>
+   class stream_writer {
+      public:
+         explicit stream_writer(Sink& sink, stream_options opts = {})
+            : _sink(sink), _opts(opts) {
+            util::check(_opts.chunk_size >= sizeof(std::uint32_t), "stream: chunk size too small");
+            _chunk.reserve(_opts.chunk_size);
+            if (_opts.background) {
+               _back.reserve(_opts.chunk_size);
+               _flusher = std::thread([this] { run_flusher(); });
+            }
+         }
+
+         stream_writer(const stream_writer&)            = delete;
+         stream_writer& operator=(const stream_writer&) = delete;
+
+         /**
+          * @brief Flushes what is left, errors are dropped, call close() to see them.
+          */
+         ~stream_writer() {
+            try {
+               close();
+            } catch (...) {
+            }
+         }
+
+         template <typename T>
+         inline void push(T&& v) {
+            _record.clear();
+            serialize(_record, std::forward<T>(v));
+            push_bytes(_record.bytes());
+         }
+
+         /**
+          * @brief Writes an already encoded record, large ones go to the sink without being copied.
+          */
+         inline void push_bytes(std::span<const std::uint8_t> payload) {
+            util::check(!_closed, "stream: push after close");
+            util::check(payload.size() <= UINT32_MAX, "stream: record too long");
+            const auto len = static_cast<std::uint32_t>(payload.size());
+
+            if (_chunk.size() + sizeof(len) + payload.size() > _opts.chunk_size) {
+               if (payload.size() >= _opts.chunk_size) {
+                  // gather the buffered records, the header and the payload into one call
+                  wait_idle();
+                  _chunk.write(&len, sizeof(len));
+                  const std::string_view parts[] = {detail::as_chars(_chunk.bytes()), detail::as_chars(payload)};
+                  detail::write_all(_sink, parts);
+                  _written += _chunk.size() + payload.size();
+                  _chunk.clear();
+                  return;
+               }
+               flush_chunk();
+            }
+            _chunk.write(&len, sizeof(len));
+            _chunk.write(payload.data(), payload.size());
+         }
+
+         /**
+          * @brief Writes everything buffered so far and waits for it to reach the sink.
+          */
+         inline void flush() {
+            flush_chunk();
+            wait_idle();
+         }
+
+         /**
+          * @brief Flushes and stops the flusher thread, later pushes throw.
+          */
+         inline void close() {
+            if (_closed)
+               return;
+            std::exception_ptr err;
+            try {
+               flush();
+            } catch (...) {
+               err = std::current_exception();
+            }
+            _closed = true;
+            if (_flusher.joinable()) {
+               {
+                  std::lock_guard lock(_mtx);
+                  _stop = true;
+               }
+               _cv.notify_all();
+               _flusher.join();
+            }
+            if (err)
+               std::rethrow_exception(err);
+         }
+
+         /**
+          * @brief Bytes handed to the sink so far, frame headers included.
+          */
+         inline std::size_t bytes_written() const noexcept {
+            std::lock_guard lock(_mtx);
+            return _written;
+         }
+
+      private:
+         inline void flush_chunk() {
+            if (_chunk.size() == 0)
+               return;
+            if (!_opts.background) {
+               const std::string_view part = detail::as_chars(_chunk.bytes());
+               detail::write_all(_sink, {&part, 1});
+               _written += _chunk.size();
+               _chunk.clear();
+               return;
+            }
+            std::unique_lock lock(_mtx);
+            _cv.wait(lock, [this] { return !_pending; });
+            rethrow_locked();
+            std::swap(_chunk, _back);
+            _chunk.clear();
+            _pending = true;
+            lock.unlock();
+            _cv.notify_all();
+         }
+
+         inline void wait_idle() {
+            if (!_opts.background)
+               return;
+            std::unique_lock lock(_mtx);
+            _cv.wait(lock, [this] { return !_pending; });
+            rethrow_locked();
+         }
+
+         inline void rethrow_locked() {
+            if (_error)
+               std::rethrow_exception(std::exchange(_error, nullptr));
+         }
+
+         inline void run_flusher() {
+            std::unique_lock lock(_mtx);
+            for (;;) {
+               _cv.wait(lock, [this] { return _pending || _stop; });
+               if (!_pending)
+                  return;
+               lock.unlock();
+               std::exception_ptr err;
+               try {
+                  const std::string_view part = detail::as_chars(_back.bytes());
+                  detail::write_all(_sink, {&part, 1});
+               } catch (...) {
+                  err = std::current_exception();
+               }
+               lock.lock();
+               if (err)
+                  _error = err;
+               else
+                  _written += _back.size();
+               _pending = false;
+               _cv.notify_all();
+            }
+         }
+
+         Sink&                   _sink;
+         stream_options          _opts;
+         alpha                   _record;
+         alpha                   _chunk;
+         alpha                   _back;
+         std::size_t             _written = 0;
+         bool                    _closed  = false;
+         std::thread             _flusher;
+         mutable std::mutex      _mtx;
+         std::condition_variable _cv;
+         bool                    _pending = false;
+         bool                    _stop    = false;
+         std::exception_ptr      _error   = nullptr;
+   };
+
+   /**
+    * @brief Reads back the records of a stream_writer, refilling a buffer from the source as frames are consumed.
+    */
+   template <byte_source_type Source>
+   class stream_reader {
+      public:
+         explicit stream_reader(Source& src, std::size_t chunk_size = 64 * 1024)
+            : _src(src), _buf(std::max<std::size_t>(chunk_size, sizeof(std::uint32_t))) {}
+
+         stream_reader(const stream_reader&)            = delete;
+         stream_reader& operator=(const stream_reader&) = delete;
+
+         /**
+          * @brief Whether every record has been read, throws if the stream ends inside a frame.
+          */
+         inline bool done() {
+            if (available() == 0)
+               fill(1);
+            if (available() == 0)
+               return true;
+            return false;
+         }
+
+         template <typename T>
+         inline T pop() {
+            alpha a{pop_bytes()};
+            T     v = a.pop<T>();
+            util::check(a.remaining() == 0, "stream: record not fully consumed");
+            return v;
+         }
+
+         /**
+          * @brief The next record's encoded bytes, valid until the next call on this reader.
+          */
+         inline std::span<const std::uint8_t> pop_bytes() {
+            std::uint32_t len = 0;
+            util::check(fill(sizeof(len)), "stream: truncated frame header");
+            std::memcpy(&len, head(), sizeof(len));
+            util::check(fill(sizeof(len) + len), "stream: truncated record");
+            const std::span<const std::uint8_t> out{head() + sizeof(len), len};
+            consume(sizeof(len) + len);
+            return out;
+         }
+
+      private:
+         constexpr static inline bool is_memory = std::same_as<std::remove_cv_t<Source>, bytes_source>;
+
+         inline const std::uint8_t* head() const noexcept {
+            if constexpr (is_memory)
+               return _src.data.data() + _src.pos;
+            else
+               return _buf.data() + _begin;
+         }
+
+         inline std::size_t available() const noexcept {
+            if constexpr (is_memory)
+               return _src.data.size() - _src.pos;
+            else
+               return _end - _begin;
+         }
+
+         inline void consume(std::size_t n) noexcept {
+            if constexpr (is_memory)
+               _src.pos += n;
+            else
+               _begin += n;
+         }
+
+         /**
+          * @brief Makes at least n bytes available, false if the source ends first.
+          */
+         inline bool fill(std::size_t n) {
+            if constexpr (is_memory) {
+               return available() >= n;
+            } else {
+               if (available() >= n)
+                  return true;
+               // compact, then grow for records larger than the buffer
+               if (_begin != 0) {
+                  std::memmove(_buf.data(), _buf.data() + _begin, available());
+                  _end -= _begin;
+                  _begin = 0;
+               }
+               while (_end < n) {
+                  // grow only as bytes arrive, so a corrupt length cannot allocate ahead of the data backing it
+                  if (_end == _buf.size())
+                     _buf.resize(std::min(n, _buf.size() * 2));
+                  const int64_t r = _src.read_some(std::span<std::uint8_t>{_buf}.subspan(_end));
+                  util::check(r >= 0, "stream: read failed");
+                  if (r == 0)
+                     return false;
+                  _end += static_cast<std::size_t>(r);
+               }
+               return true;
+            }
+         }
+
+         Source&                   _src;
+         std::vector<std::uint8_t> _buf;
+         std::size_t               _begin = 0;
+         std::size_t               _end   = 0;
+   };
+
+} // namespace astro::serial
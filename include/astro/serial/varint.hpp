@@ -0,0 +1,319 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <span>
+#include <type_traits>
+
+#if defined(__BMI2__)
+   #include <immintrin.h>
+#elif defined(__SSSE3__)
+   #include <tmmintrin.h>
+#endif
+
+#include "alpha.hpp"
+
+namespace astro::serial {
+
+   /**
+    * @brief Field tag that serializes an integer as a LEB128 varint, signed values are zigzag encoded first.
+    */
+   template <std::integral T>
+   struct varint {
+      using value_type = T;
+
+      constexpr varint() = default;
+      constexpr varint(T v) noexcept : value(v) {}
+
+      constexpr inline operator T() const noexcept { return value; }
+
+      T value = 0;
+   };
+
+   /**
+    * @brief Field tag that serializes an integer at its full width.
+    */
+   template <std::integral T>
+   struct fixed {
+      using value_type = T;
+
+      constexpr fixed() = default;
+      constexpr fixed(T v) noexcept : value(v) {}
+
+      constexpr inline operator T() const noexcept { return value; }
+
+      T value = 0;
+   };
+
+   template <typename T>
+   constexpr static inline bool is_varint_v = false;
+
+   template <typename T>
+   constexpr static inline bool is_varint_v<varint<T>> = true;
+
+   template <typename T>
+   concept varint_type = is_varint_v<T>;
+
+   template <typename T>
+   constexpr static inline bool is_fixed_v = false;
+
+   template <typename T>
+   constexpr static inline bool is_fixed_v<fixed<T>> = true;
+
+   template <typename T>
+   concept fixed_type = is_fixed_v<T>;
+
+   constexpr static inline std::size_t max_varint_bytes = 10;
+
+   template <std::integral T>
+   constexpr static inline std::make_unsigned_t<T> zigzag_encode(T v) noexcept {
+      using U = std::make_unsigned_t<T>;
+      if constexpr (std::is_signed_v<T>)
+         return (static_cast<U>(v) << 1) ^ static_cast<U>(v >> (sizeof(T) * 8 - 1));
+      else
+         return v;
+   }
+
+   template <std::integral T>
+   constexpr static inline T zigzag_decode(std::make_unsigned_t<T> v) noexcept {
+      if constexpr (std::is_signed_v<T>)
+         return static_cast<T>((v >> 1) ^ (~(v & 1) + 1));
+      else
+         return v;
+   }
+
+   /**
+    * @brief The number of bytes the LEB128 encoding of v takes.
+    */
+   constexpr static inline std::size_t varint_size(std::uint64_t v) noexcept {
+      return (70 - std::countl_zero(v | 1)) / 7;
+   }
+
+   /**
+    * @brief Writes v as LEB128, out must have room for max_varint_bytes.
+    * @return The number of bytes written.
+    */
+   constexpr static inline std::size_t encode_varint(std::uint64_t v, std::uint8_t* out) noexcept {
+      std::size_t n = 0;
+      while (v >= 0x80) {
+         out[n++]   = static_cast<std::uint8_t>(v | 0x80);
+         v        >>= 7;
+      }
+      out[n++] = static_cast<std::uint8_t>(v);
+      return n;
+   }
+
+   /**
+    * @brief Reads one LEB128 value.
+    * @return The number of bytes consumed.
+    */
+   constexpr static inline std::size_t decode_varint(const std::uint8_t* in, std::size_t len, std::uint64_t& v) {
+      if (!std::is_constant_evaluated() && len >= 8) {
+         // one load finds the terminator of any value up to 56 bits
+         std::uint64_t word;
+         std::memcpy(&word, in, sizeof(word));
+         if constexpr (std::endian::native == std::endian::little) {
+            const std::uint64_t stops = ~word & 0x8080808080808080ull;
+            if (stops != 0) {
+               const std::size_t n = static_cast<std::size_t>(std::countr_zero(stops)) / 8 + 1;
+               word &= n == 8 ? ~0ull : (1ull << (n * 8)) - 1;
+#if defined(__BMI2__)
+               v = _pext_u64(word, 0x7f7f7f7f7f7f7f7full);
+#else
+               word = (word & 0x007f007f007f007full) | ((word & 0x7f007f007f007f00ull) >> 1);
+               word = (word & 0x00003fff00003fffull) | ((word & 0x3fff00003fff0000ull) >> 2);
+               v    = (word & 0x000000000fffffffull) | ((word & 0x0fffffff00000000ull) >> 4);
+#endif
+               return n;
+            }
+         }
+      }
+      std::uint64_t r = 0;
+      for (std::size_t i = 0; i < max_varint_bytes; ++i) {
+         util::check(i < len, "varint: truncated input");
+         const std::uint64_t b = in[i];
+         util::check(i < 9 || b <= 1, "varint: value overflows 64 bits");
+         r |= (b & 0x7f) << (7 * i);
+         if (b < 0x80) {
+            v = r;
+            return i + 1;
+         }
+      }
+      util::check(false, "varint: value overflows 64 bits");
+      return 0;
+   }
+
+   /**
+    * @brief Decodes a run of LEB128 values, taking eight single-byte values per step while they last.
+    * @return The number of bytes consumed.
+    */
+   template <std::integral T>
+   static inline std::size_t decode_varints(std::span<const std::uint8_t> in, std::span<T> out) {
+      using U       = std::make_unsigned_t<T>;
+      std::size_t p = 0;
+      std::size_t i = 0;
+      while (i < out.size()) {
+         if (i + 8 <= out.size() && p + 8 <= in.size()) {
+            std::uint64_t word;
+            std::memcpy(&word, in.data() + p, sizeof(word));
+            if ((word & 0x8080808080808080ull) == 0) {
+               for (std::size_t j = 0; j < 8; ++j)
+                  out[i + j] = zigzag_decode<T>(static_cast<U>(in[p + j]));
+               i += 8;
+               p += 8;
+               continue;
+            }
+         }
+         std::uint64_t v = 0;
+         p              += decode_varint(in.data() + p, in.size() - p, v);
+         util::check(v <= static_cast<U>(~U{0}), "varint: value overflows the target type");
+         out[i++] = zigzag_decode<T>(static_cast<U>(v));
+      }
+      return p;
+   }
+
+   namespace detail {
+      constexpr static inline std::size_t svb_length(std::uint32_t v) noexcept {
+         return v < (1u << 8) ? 1 : v < (1u << 16) ? 2 : v < (1u << 24) ? 3 : 4;
+      }
+
+      constexpr static inline auto svb_lengths = [] {
+         std::array<std::uint8_t, 256> out{};
+         for (std::size_t c = 0; c < 256; ++c)
+            out[c] = static_cast<std::uint8_t>(4 + (c & 3) + ((c >> 2) & 3) + ((c >> 4) & 3) + ((c >> 6) & 3));
+         return out;
+      }();
+
+      // pshufb masks that spread the data bytes of one control byte into four little-endian lanes
+      constexpr static inline auto svb_shuffles = [] {
+         std::array<std::array<std::int8_t, 16>, 256> out{};
+         for (std::size_t c = 0; c < 256; ++c) {
+            std::int8_t src = 0;
+            for (std::size_t lane = 0; lane < 4; ++lane) {
+               const std::size_t len = ((c >> (lane * 2)) & 3) + 1;
+               for (std::size_t b = 0; b < 4; ++b)
+                  out[c][lane * 4 + b] = b < len ? src++ : -1;
+            }
+         }
+         return out;
+      }();
+   } // namespace detail
+
+   /**
+    * @brief The worst-case size of a Stream-VByte block holding n values.
+    */
+   constexpr static inline std::size_t stream_vbyte_max_bytes(std::size_t n) noexcept { return (n + 3) / 4 + n * 4; }
+
+   /**
+    * @brief Encodes 32-bit values as Stream-VByte: one control byte per four values holding their byte lengths, then the
+    * packed value bytes.
+    * @param out Room for stream_vbyte_max_bytes(in.size()) bytes.
+    * @return The number of bytes written.
+    */
+   static inline std::size_t stream_vbyte_encode(std::span<const std::uint32_t> in, std::uint8_t* out) noexcept {
+      std::uint8_t* ctrl = out;
+      std::uint8_t* data = out + (in.size() + 3) / 4;
+      for (std::size_t i = 0; i < in.size(); i += 4) {
+         std::uint8_t c = 0;
+         for (std::size_t j = 0; j < 4 && i + j < in.size(); ++j) {
+            const std::uint32_t v   = in[i + j];
+            const std::size_t   len = detail::svb_length(v);
+            c |= static_cast<std::uint8_t>((len - 1) << (j * 2));
+            for (std::size_t b = 0; b < len; ++b)
+               *data++ = static_cast<std::uint8_t>(v >> (b * 8));
+         }
+         *ctrl++ = c;
+      }
+      return static_cast<std::size_t>(data - out);
+   }
+
+   /**
+    * @brief Decodes a Stream-VByte block of out.size() values, four at a time with a byte shuffle when SSSE3 is available.
+    * @return The number of bytes consumed.
+    */
+   static inline std::size_t stream_vbyte_decode(std::span<const std::uint8_t> in, std::span<std::uint32_t> out) {
+      const std::size_t nctrl = (out.size() + 3) / 4;
+      util::check(nctrl <= in.size(), "stream_vbyte: truncated input");
+      const std::uint8_t* ctrl = in.data();
+      const std::uint8_t* data = in.data() + nctrl;
+      const std::uint8_t* end  = in.data() + in.size();
+      std::size_t         i    = 0;
+#if defined(__SSSE3__)
+      // full groups only, and only while a 16-byte load stays in bounds
+      for (; i + 4 <= out.size() && end - data >= 16; i += 4) {
+         const std::uint8_t c     = ctrl[i / 4];
+         const __m128i      bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+         const __m128i      mask  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(detail::svb_shuffles[c].data()));
+         _mm_storeu_si128(reinterpret_cast<__m128i*>(out.data() + i), _mm_shuffle_epi8(bytes, mask));
+         data += detail::svb_lengths[c];
+      }
+#endif
+      for (; i < out.size(); ++i) {
+         const std::size_t len = ((ctrl[i / 4] >> ((i % 4) * 2)) & 3) + 1;
+         util::check(static_cast<std::size_t>(end - data) >= len, "stream_vbyte: truncated input");
+         std::uint32_t v = 0;
+         for (std::size_t b = 0; b < len; ++b)
+            v |= static_cast<std::uint32_t>(data[b]) << (b * 8);
+         out[i]  = v;
+         data   += len;
+      }
+      return static_cast<std::size_t>(data - in.data());
+   }
+
+   /**
+    * @brief Appends v to the archive as LEB128.
+    */
+   static inline void write_varint(serializer_base& a, std::uint64_t v) {
+      std::uint8_t buf[max_varint_bytes];
+      a.write(buf, encode_varint(v, buf));
+   }
+
+   static inline void write_varint(unchecked_writer& w, std::uint64_t v) noexcept { w.pos += encode_varint(v, w.data + w.pos); }
+
+   /**
+    * @brief Reads one LEB128 value from the archive.
+    */
+   static inline std::uint64_t read_varint(serializer_base& a) {
+      std::uint64_t v = 0;
+      a.fastforward(decode_varint(a.data() + a.pos(), a.remaining(), v));
+      return v;
+   }
+
+   /**
+    * @brief Reads one LEB128 value into T, undoing the zigzag encoding for signed types.
+    */
+   template <std::integral T>
+   static inline T read_varint_as(serializer_base& a) {
+      using U      = std::make_unsigned_t<T>;
+      const auto v = read_varint(a);
+      util::check(v <= static_cast<U>(~U{0}), "varint: value overflows the target type");
+      return zigzag_decode<T>(static_cast<U>(v));
+   }
+
+   template <varint_type V>
+   static inline void serialize(alpha& a, V v) {
+      write_varint(a, zigzag_encode(v.value));
+   }
+
+   template <varint_type V>
+   static inline V deserialize(alpha& a) {
+      return V{read_varint_as<typename V::value_type>(a)};
+   }
+
+   template <fixed_type F>
+   static inline void serialize(alpha& a, F v) {
+      a.write(&v.value, sizeof(v.value));
+   }
+
+   template <fixed_type F>
+   static inline F deserialize(alpha& a) {
+      F v;
+      a.read(&v.value, sizeof(v.value));
+      return v;
+   }
+} // namespace astro::serial
@@ -1,11 +1,25 @@
 #pragma once
 #include <cstdint>
 #if (ASTRO_COMPILER & ASTRO_MSVC_BUILD) == ASTRO_MSVC_BUILD
+   #include <xmmintrin.h>
    #define ASTRO_PRETTY_FUNCTION __FUNCSIG__
    #define ASTRO_ALWAYS_INLINE __forceinline
+   #define ASTRO_PREFETCH(addr) _mm_prefetch(reinterpret_cast<const char*>(addr), _MM_HINT_T0)
 #else
    #define ASTRO_PRETTY_FUNCTION __PRETTY_FUNCTION__
    #define ASTRO_ALWAYS_INLINE __attribute__((always_inline))
+   #define ASTRO_PREFETCH(addr) __builtin_prefetch(addr)
+#endif
+
+#if defined(__has_cpp_attribute)
+   #if __has_cpp_attribute(clang::lifetimebound)
+      #define ASTRO_LIFETIMEBOUND [[clang::lifetimebound]]
+   #elif __has_cpp_attribute(msvc::lifetimebound)
+      #define ASTRO_LIFETIMEBOUND [[msvc::lifetimebound]]
+   #endif
+#endif
+#if !defined(ASTRO_LIFETIMEBOUND)
+   #define ASTRO_LIFETIMEBOUND
 #endif
 
 #if defined(ASTRO_COMPILE_TIME_CONSTEVAL)
@@ -22,9 +22,9 @@ TEST_CASE("Async Tests", "[async_tests]") {
       auto v2 = exec(24, "Call from operator()(...)");
       auto v3 = exec.exec_sync(12, "Call from exec_sync(...)");
 
-      CHECK(std::is_same_v<decltype(v1), std::future<uint32_t>>);
-      CHECK(std::is_same_v<decltype(v2), std::future<uint32_t>>);
-      CHECK(std::is_same_v<decltype(v3), uint32_t>);
+      CHECK(std::is_same_v<decltype(v1), future<std::size_t>>);
+      CHECK(std::is_same_v<decltype(v2), future<std::size_t>>);
+      CHECK(std::is_same_v<decltype(v3), std::size_t>);
 
       try {
          CHECK(v1.get() == 401);
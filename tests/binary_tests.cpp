@@ -0,0 +1,180 @@
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#define CATCH_CONFIG_WINDOWS_SEH
+#include <catch2/catch_all.hpp>
+
+#include <astro/binary.hpp>
+
+using namespace astro::encode;
+
+namespace {
+   std::span<const std::uint8_t> bytes_of(std::string_view s) {
+      return {reinterpret_cast<const std::uint8_t*>(s.data()), s.size()};
+   }
+
+   std::string string_of(const std::vector<std::uint8_t>& v) { return {v.begin(), v.end()}; }
+
+   std::vector<std::uint8_t> noise(std::size_t n, std::uint64_t seed = 88172645463325252ull) {
+      std::vector<std::uint8_t> v(n);
+      for (auto& b : v) {
+         seed ^= seed << 13;
+         seed ^= seed >> 7;
+         seed ^= seed << 17;
+         b = static_cast<std::uint8_t>(seed);
+      }
+      return v;
+   }
+
+   template <codec_type C>
+   void check_round_trips(const C& c, std::size_t step = 1) {
+      for (std::size_t n = 0; n < 300; n += step) {
+         const auto in  = noise(n, n + 1);
+         const auto txt = encode_all(c, in);
+         CHECK(decode_all(c, txt) == in);
+      }
+   }
+
+   template <codec_type C>
+   void check_streaming(const C& c, std::span<const std::uint8_t> in) {
+      const std::string expected = encode_all(c, in);
+      for (std::size_t piece : {1, 3, 7, 50}) {
+         stream_encoder<C> enc{c};
+         std::string       txt;
+         for (std::size_t i = 0; i < in.size(); i += piece)
+            enc.update(in.subspan(i, std::min(piece, in.size() - i)), txt);
+         enc.finish(txt);
+         CHECK(txt == expected);
+
+         stream_decoder<C>         dec{c};
+         std::vector<std::uint8_t> out;
+         for (std::size_t i = 0; i < txt.size(); i += piece)
+            dec.update(std::string_view{txt}.substr(i, piece), out);
+         dec.finish(out);
+         CHECK(std::equal(out.begin(), out.end(), in.begin(), in.end()));
+      }
+   }
+} // namespace
+
+TEST_CASE("Base64 Tests", "[binary_tests]") {
+   SECTION("Check RFC 4648 vectors") {
+      CHECK(to_base64(bytes_of("")) == "");
+      CHECK(to_base64(bytes_of("f")) == "Zg==");
+      CHECK(to_base64(bytes_of("fo")) == "Zm8=");
+      CHECK(to_base64(bytes_of("foo")) == "Zm9v");
+      CHECK(to_base64(bytes_of("foob")) == "Zm9vYg==");
+      CHECK(to_base64(bytes_of("fooba")) == "Zm9vYmE=");
+      CHECK(to_base64(bytes_of("foobar")) == "Zm9vYmFy");
+      CHECK(string_of(from_base64("Zm9vYmE=")) == "fooba");
+      CHECK(string_of(from_base64("Zm9vYmE")) == "fooba");
+   }
+
+   SECTION("Check both alphabets") {
+      const std::uint8_t in[] = {0xFB, 0xFF, 0xBF};
+      CHECK(to_base64(in) == "+/+/");
+      CHECK(to_base64(in, base64_alphabet::url) == "-_-_");
+      CHECK(from_base64("-_-_", base64_alphabet::url) == std::vector<std::uint8_t>(std::begin(in), std::end(in)));
+      CHECK_THROWS(from_base64("-_-_"));
+
+      check_round_trips(base64{});
+      check_round_trips(base64{base64_alphabet::url, false});
+   }
+
+   SECTION("Check the vector kernels against the scalar path") {
+      const auto        in  = noise(1000);
+      const std::string txt = to_base64(in);
+      const auto        chars = base64{}.chars();
+      for (std::size_t i = 0; i + 3 <= in.size(); i += 3) {
+         const std::uint32_t v = (std::uint32_t{in[i]} << 16) | (std::uint32_t{in[i + 1]} << 8) | in[i + 2];
+         const std::string   group{chars[v >> 18], chars[(v >> 12) & 63], chars[(v >> 6) & 63], chars[v & 63]};
+         REQUIRE(txt.substr(i / 3 * 4, 4) == group);
+      }
+   }
+
+   SECTION("Check invalid input") {
+      CHECK_THROWS(from_base64("Zm9v!mFy"));
+      CHECK_THROWS(from_base64("Zm9vY"));
+      CHECK_THROWS(from_base64("Zm=vYmFy"));
+      CHECK_THROWS(from_base64("Zh=="));
+      CHECK_THROWS(from_base64("Zm9=="));
+
+      // a bad character deep inside the part the vector kernels handle
+      std::string txt = to_base64(noise(600));
+      txt[317]        = '*';
+      CHECK_THROWS(from_base64(txt));
+      txt[317] = static_cast<char>(0xC3);
+      CHECK_THROWS(from_base64(txt));
+   }
+
+   SECTION("Check streaming") {
+      check_streaming(base64{}, noise(257));
+      check_streaming(base64{base64_alphabet::url, false}, noise(100));
+   }
+}
+
+TEST_CASE("Hex Tests", "[binary_tests]") {
+   SECTION("Check basics") {
+      const std::uint8_t in[] = {0x00, 0x1F, 0xA0, 0xFF};
+      CHECK(to_hex(in) == "001fa0ff");
+      CHECK(to_hex(in, true) == "001FA0FF");
+      CHECK(from_hex("001fA0Ff") == std::vector<std::uint8_t>(std::begin(in), std::end(in)));
+      check_round_trips(hex{});
+      check_round_trips(hex{true});
+   }
+
+   SECTION("Check invalid input") {
+      CHECK_THROWS(from_hex("abc"));
+      CHECK_THROWS(from_hex("0g"));
+      std::string txt = to_hex(noise(100));
+      for (std::size_t at : {5, 40, 150}) {
+         std::string bad = txt;
+         bad[at]         = 'G';
+         CHECK_THROWS(from_hex(bad));
+         bad[at] = ':';
+         CHECK_THROWS(from_hex(bad));
+      }
+   }
+
+   SECTION("Check streaming") {
+      check_streaming(hex{}, noise(131));
+   }
+}
+
+TEST_CASE("Base85 Tests", "[binary_tests]") {
+   SECTION("Check Z85") {
+      const std::uint8_t in[] = {0x86, 0x4F, 0xD2, 0x6F, 0xB5, 0x59, 0xF7, 0x5B};
+      CHECK(to_z85(in) == "HelloWorld");
+      CHECK(from_z85("HelloWorld") == std::vector<std::uint8_t>(std::begin(in), std::end(in)));
+      check_round_trips(z85{}, 4);
+      check_streaming(z85{}, noise(256));
+
+      CHECK_THROWS(to_z85(bytes_of("abc")));
+      CHECK_THROWS(from_z85("Hello"
+                            "Worl"));
+      CHECK_THROWS(from_z85("Hello~orld"));
+      CHECK_THROWS(from_z85("%%%%%"));
+   }
+
+   SECTION("Check Ascii85") {
+      CHECK(to_ascii85(bytes_of("Man ")) == "9jqo^");
+      CHECK(to_ascii85(bytes_of("sure.")) == "F*2M7/c");
+      CHECK(string_of(from_ascii85("F*2M7/c")) == "sure.");
+
+      const std::uint8_t zeros[8] = {};
+      CHECK(to_ascii85(zeros) == "zz");
+      CHECK(from_ascii85("zz") == std::vector<std::uint8_t>(8, 0));
+      const std::uint8_t short_zeros[2] = {};
+      CHECK(to_ascii85(short_zeros) == "!!!");
+
+      check_round_trips(ascii85{});
+      auto data = noise(300);
+      std::fill(data.begin() + 40, data.begin() + 80, 0);
+      check_streaming(ascii85{}, data);
+
+      CHECK_THROWS(from_ascii85("9jqo^F"));
+      CHECK_THROWS(from_ascii85("9jqo~"));
+      CHECK_THROWS(from_ascii85("uuuuu"));
+   }
+}
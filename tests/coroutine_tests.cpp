@@ -0,0 +1,205 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#define CATCH_CONFIG_WINDOWS_SEH
+#include <catch2/catch_all.hpp>
+
+#include <astro/info.hpp>
+#include <astro/async/generator.hpp>
+#include <astro/async/io_wait.hpp>
+#include <astro/async/task.hpp>
+#include <astro/memory/arena.hpp>
+
+#if ASTRO_OS != ASTRO_WINDOWS_BUILD
+   #include <unistd.h>
+#endif
+
+using namespace astro::async;
+using astro::memory::arena;
+
+namespace {
+   task<int> add(int a, int b) { co_return a + b; }
+
+   task<int> add_twice(int a, int b) {
+      const int x = co_await add(a, b);
+      const int y = co_await add(x, b);
+      co_return y;
+   }
+
+   task<std::string> fails() {
+      throw std::runtime_error("task failed");
+      co_return "";
+   }
+
+   task<std::size_t> depth(std::size_t n) {
+      if (n == 0)
+         co_return 0;
+      co_return 1 + co_await depth(n - 1);
+   }
+
+   task<std::thread::id> hop(thread_pool& pool) {
+      co_await schedule_on(pool);
+      co_return std::this_thread::get_id();
+   }
+
+   task<int> hop_and_add(thread_pool& pool, int v) {
+      co_await schedule_on(pool);
+      co_return v + 1;
+   }
+
+   generator<int> iota(int n) {
+      for (int i = 0; i < n; ++i)
+         co_yield i;
+   }
+
+   generator<std::string> words() {
+      std::string w = "alpha";
+      co_yield w;
+      co_yield std::string{"beta"};
+      throw std::runtime_error("generator failed");
+   }
+} // namespace
+
+TEST_CASE("Task Tests", "[coroutine_tests]") {
+   SECTION("Check results, nesting and exceptions") {
+      CHECK(sync_wait(add(1, 2)) == 3);
+      CHECK(sync_wait(add_twice(1, 2)) == 5);
+      CHECK_THROWS_AS(sync_wait(fails()), std::runtime_error);
+      CHECK(sync_wait(depth(1000)) == 1000);
+
+      bool ran = false;
+      sync_wait([&]() -> task<void> {
+         ran = true;
+         co_return;
+      }());
+      CHECK(ran);
+   }
+
+   SECTION("Check frames come from an arena") {
+      arena a;
+      CHECK(a.reserved() == 0);
+      {
+         frame_scope scope{a};
+         CHECK(sync_wait(add(20, 22)) == 42);
+      }
+      const std::size_t first = a.reserved();
+      CHECK(first > 0);
+
+      {
+         frame_scope scope{a};
+         for (int i = 0; i < 10000; ++i)
+            REQUIRE(sync_wait(add_twice(i, 1)) == i + 2);
+      }
+      // freed frames are recycled, so the arena never needs a second block
+      CHECK(a.reserved() == first);
+   }
+
+   SECTION("Check resuming on a pool and joining") {
+      thread_pool pool{2};
+      CHECK(sync_wait(hop(pool)) != std::this_thread::get_id());
+
+      auto [x, s] = sync_wait(when_all(hop_and_add(pool, 1), add(2, 3)));
+      CHECK(x == 2);
+      CHECK(s == 5);
+
+      std::vector<task<int>> many;
+      for (int i = 0; i < 200; ++i)
+         many.push_back(hop_and_add(pool, i));
+      const auto all = sync_wait(when_all(std::move(many)));
+      REQUIRE(all.size() == 200);
+      bool ordered = true;
+      for (int i = 0; i < 200; ++i)
+         ordered &= all[i] == i + 1;
+      CHECK(ordered);
+
+      CHECK_THROWS_AS(sync_wait(when_all(add(1, 1), fails())), std::runtime_error);
+   }
+
+   SECTION("Check spawn") {
+      thread_pool      pool{2};
+      std::atomic<int> count = 0;
+      for (int i = 0; i < 100; ++i) {
+         spawn([](thread_pool& p, std::atomic<int>& c) -> task<void> {
+            co_await schedule_on(p);
+            c.fetch_add(1);
+         }(pool, count));
+      }
+      while (count.load() != 100)
+         std::this_thread::yield();
+      CHECK(count == 100);
+   }
+}
+
+TEST_CASE("IO Wait Tests", "[coroutine_tests]") {
+   SECTION("Check sleep") {
+      const auto start = std::chrono::steady_clock::now();
+      sync_wait([]() -> task<void> {
+         co_await sleep_for(std::chrono::milliseconds(20));
+         co_await sleep_for(std::chrono::milliseconds(-5));
+      }());
+      CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20));
+
+      // timers fire in deadline order whatever order they were set in
+      std::vector<task<int>> sleepers;
+      for (int ms : {30, 10, 20})
+         sleepers.push_back([](int ms) -> task<int> {
+            co_await sleep_for(std::chrono::milliseconds(ms));
+            co_return ms;
+         }(ms));
+      CHECK(sync_wait(when_all(std::move(sleepers))) == std::vector<int>{30, 10, 20});
+   }
+
+#if ASTRO_OS != ASTRO_WINDOWS_BUILD
+   SECTION("Check fd readiness") {
+      int fds[2];
+      REQUIRE(::pipe(fds) == 0);
+      std::thread writer([&] {
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+         [[maybe_unused]] auto n = ::write(fds[1], "x", 1);
+      });
+      const char got = sync_wait([](int fd) -> task<char> {
+         co_await readable(fd);
+         char c = 0;
+         [[maybe_unused]] auto n = ::read(fd, &c, 1);
+         co_return c;
+      }(fds[0]));
+      writer.join();
+      CHECK(got == 'x');
+      sync_wait([](int fd) -> task<void> { co_await writable(fd); }(fds[1]));
+      ::close(fds[0]);
+      ::close(fds[1]);
+   }
+#endif
+}
+
+TEST_CASE("Generator Tests", "[coroutine_tests]") {
+   SECTION("Check iteration") {
+      std::vector<int> out;
+      for (int v : iota(5))
+         out.push_back(v);
+      CHECK(out == std::vector<int>{0, 1, 2, 3, 4});
+
+      std::size_t n = 0;
+      for ([[maybe_unused]] int v : iota(0))
+         ++n;
+      CHECK(n == 0);
+   }
+
+   SECTION("Check exceptions surface from the iterator") {
+      std::vector<std::string> out;
+      auto                     g = words();
+      CHECK_THROWS_AS(
+            [&] {
+               for (const auto& w : g)
+                  out.push_back(w);
+            }(),
+            std::runtime_error);
+      CHECK(out == std::vector<std::string>{"alpha", "beta"});
+   }
+}
@@ -1,10 +1,24 @@
 #define CATCH_CONFIG_WINDOWS_SEH
 #include <catch2/catch_all.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
 
 #include <astro/compile_time.hpp>
+#include <astro/cryptid/blake3.hpp>
+#include <astro/cryptid/bloom_filter.hpp>
+#include <astro/cryptid/city_hash.hpp>
+#include <astro/cryptid/consistent_hash.hpp>
+#include <astro/cryptid/count_min.hpp>
+#include <astro/cryptid/cuckoo_filter.hpp>
+#include <astro/cryptid/hyperloglog.hpp>
 #include <astro/cryptid/uint128.hpp>
 
 using namespace astro;
@@ -84,6 +98,21 @@ struct foo : public reflectable<foo> {
 struct bar : public reflectable<bar, foo> {
 };
 
+template <std::size_t N>
+static std::string to_hex(const std::array<std::uint8_t, N>& bytes) {
+   std::ostringstream oss;
+   for (auto b : bytes)
+      oss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(b);
+   return oss.str();
+}
+
+static std::vector<std::uint8_t> test_input(std::size_t n) {
+   std::vector<std::uint8_t> v(n);
+   for (std::size_t i = 0; i < n; ++i)
+      v[i] = static_cast<std::uint8_t>(i % 251);
+   return v;
+}
+
 TEST_CASE("Cryptid UINT128 Tests", "[cryptid_uint128_tests]") {
    SECTION("Check uint128_t") {
       uint128_t il = low_value{54};
@@ -143,4 +172,554 @@ TEST_CASE("Cryptid UINT128 Tests", "[cryptid_uint128_tests]") {
 
       //CHECK(i5.high() == 0);
    }
-}
\ No newline at end of file
+
+   SECTION("Check uint128_t arithmetic") {
+      using namespace astro::literals;
+      const uint128_t a = 0x0123456789abcdeffedcba9876543210_ui128;
+      const uint128_t b = 0x00000000000000010000000000000003_ui128;
+
+      CHECK(a * b == 0x02468acf13579bdffc962fc962fc9630_ui128);
+      CHECK(a * std::uint64_t{10} == 0x0b60b60b60b60b5ff49f49f49f49f4a0_ui128);
+      CHECK((a / b) * b + (a % b) == a);
+      CHECK(a / b == 0x0123456789abcdef_ui128);
+      CHECK(a % uint128_t{10, 0} == uint128_t{0, 0});
+      CHECK(uint128_t{0, 1} / uint128_t{2, 0} == uint128_t{0x8000000000000000ull, 0});
+      CHECK((uint128_t{1, 0} << 100) >> 100 == uint128_t{1, 0});
+      CHECK(uint128_t{0, 1} > uint128_t{~0ull, 0});
+      CHECK(uint128_t{5, 0} < uint128_t{0, 1});
+      CHECK_THROWS(a / uint128_t{0, 0});
+
+      constexpr uint128_t c = 340282366920938463463374607431768211455_ui128;
+      static_assert(c == uint128_t{0xffffffffffffffffull, 0xffffffffffffffffull});
+      CHECK(0_ui128 == uint128_t{0, 0});
+      CHECK(0x1_ui128 == uint128_t{1, 0});
+      CHECK(18'446'744'073'709'551'616_ui128 == uint128_t{0, 1});
+   }
+
+   SECTION("Check uint128_t to_chars and from_chars") {
+      using namespace astro::literals;
+      auto dec = [](const uint128_t& v, int base = 10) {
+         char buf[40];
+         auto res = to_chars(buf, buf + sizeof(buf), v, base);
+         return std::string(buf, res.ptr);
+      };
+
+      CHECK(dec(0_ui128) == "0");
+      CHECK(dec(12345_ui128) == "12345");
+      CHECK(dec(uint128_t{0, 1}) == "18446744073709551616");
+      CHECK(dec(10000000000000000000_ui128) == "10000000000000000000");
+      CHECK(dec(uint128_t{~0ull, ~0ull}) == "340282366920938463463374607431768211455");
+      CHECK(dec(100000000000000000000000000000000000000_ui128) == "100000000000000000000000000000000000000");
+      CHECK(dec(uint128_t{~0ull, ~0ull}, 16) == "ffffffffffffffffffffffffffffffff");
+      CHECK(dec(0x1000_ui128, 16) == "1000");
+      CHECK(dec(0_ui128, 16) == "0");
+
+      char small[4];
+      CHECK(to_chars(small, small + 4, 12345_ui128).ec == std::errc::value_too_large);
+      CHECK(to_chars(small, small + 4, 12345_ui128, 8).ec == std::errc::invalid_argument);
+
+      uint128_t v;
+      std::string_view s = "340282366920938463463374607431768211455 rest";
+      auto res = from_chars(s.data(), s.data() + s.size(), v);
+      CHECK(res.ec == std::errc{});
+      CHECK(res.ptr == s.data() + 39);
+      CHECK(v == uint128_t{~0ull, ~0ull});
+
+      s   = "340282366920938463463374607431768211456";
+      v   = uint128_t{7, 0};
+      res = from_chars(s.data(), s.data() + s.size(), v);
+      CHECK(res.ec == std::errc::result_out_of_range);
+      CHECK(res.ptr == s.data() + s.size());
+      CHECK(v == uint128_t{7, 0});
+
+      s   = "000000000000000000000000000000000000DeadBeef";
+      res = from_chars(s.data(), s.data() + s.size(), v, 16);
+      CHECK(res.ec == std::errc{});
+      CHECK(v == uint128_t{0xdeadbeef, 0});
+
+      s   = "1ffffffffffffffffffffffffffffffff";
+      CHECK(from_chars(s.data(), s.data() + s.size(), v, 16).ec == std::errc::result_out_of_range);
+      s   = "xyz";
+      CHECK(from_chars(s.data(), s.data() + s.size(), v).ec == std::errc::invalid_argument);
+
+      for (std::uint64_t i = 0; i < 1000; ++i) {
+         const uint128_t r{city_hash::hash64(i), city_hash::hash64(i + 1000) >> (i % 64)};
+         const auto      d = dec(r);
+         uint128_t       back;
+         from_chars(d.data(), d.data() + d.size(), back);
+         CHECK(back == r);
+      }
+   }
+}
+
+TEST_CASE("Cryptid BLAKE3 Tests", "[cryptid_blake3_tests]") {
+   const std::vector<std::pair<std::size_t, std::string_view>> vectors = {
+      {0,       "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262"},
+      {1,       "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213"},
+      {1023,    "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11"},
+      {1024,    "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7"},
+      {1025,    "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444"},
+      {2049,    "5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b6879522563030"},
+      {3073,    "7124b49501012f81cc7f11ca069ec9226cecb8a2c850cfe644e327d22d3e1cd3"},
+      {8193,    "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b"},
+      {31744,   "62b6960e1a44bcc1eb1a611a8d6235b6b4b78f32e7abc4fb4c6cdcce94895c47"},
+      {102400,  "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085"},
+      {1 << 20, "74cb441fd087764ca9c3694da742ebe30cbeb3060a17009ca81825c7a8d10343"}
+   };
+
+   SECTION("Check one shot hashing") {
+      CHECK(to_hex(blake3::hash(std::string_view{"abc"})) == "6437b3ac38465133ffb63b75273a8db548c558465d79db03fd359c6cd5bd9d85");
+      for (const auto& [n, expected] : vectors) {
+         auto input = test_input(n);
+         CHECK(to_hex(blake3::hash(input)) == expected);
+      }
+   }
+
+   SECTION("Check incremental hashing") {
+      for (const auto& [n, expected] : vectors) {
+         auto input = test_input(n);
+         for (std::size_t step : {1ull, 63ull, 64ull, 1000ull, 4096ull, 65537ull}) {
+            blake3 h;
+            for (std::size_t off = 0; off < n; off += step)
+               h.update(input.data() + off, std::min(step, n - off));
+            CHECK(to_hex(h.finalize()) == expected);
+         }
+      }
+   }
+
+   SECTION("Check parallel hashing") {
+      for (const auto& [n, expected] : vectors) {
+         auto input = test_input(n);
+         CHECK(to_hex(blake3::hash_parallel(input, 4)) == expected);
+      }
+
+      auto input = test_input(3 << 20);
+      CHECK(blake3::hash_parallel(input, 3) == blake3::hash(input));
+
+      blake3 h;
+      h.update(input.data(), 777);
+      h.update_parallel(std::span{input}.subspan(777), 4);
+      CHECK(h.finalize() == blake3::hash(input));
+
+      // subtrees nest inside each other's tasks, a pool smaller than the split still finishes
+      astro::async::thread_pool pool{2};
+      CHECK(blake3::hash_parallel(input, 8, pool) == blake3::hash(input));
+   }
+
+   SECTION("Check keyed, derive key and extended output") {
+      auto input = test_input(1025);
+
+      blake3::key_t key;
+      std::string_view key_str = "whats the Elvish word for friend";
+      std::copy(key_str.begin(), key_str.end(), key.begin());
+      CHECK(to_hex(blake3{key}.update(input).finalize()) == "357dc55de0c7e382c900fd6e320acc04146be01db6a8ce7210b7189bd664ea69");
+
+      auto dk = blake3::derive_key("BLAKE3 2019-12-27 16:29:52 test vectors context");
+      CHECK(to_hex(dk.update(input).finalize()) == "effaa245f065fbf82ac186839a249707c3bddf6d3fdda22d1b95a3c970379bcb");
+
+      blake3 h;
+      h.update(input);
+      std::array<std::uint8_t, 64> xof;
+      h.finalize(xof, 100);
+      CHECK(to_hex(xof) == "c98e1d5f9565a9194cad0c4285f93700062d9595adb992ae68ff12800ab67afea516f221cf7d1f8434fc36d8f6fbdf38d445c44d96ba3bb1d4a2e2ae9a53fd46");
+
+      h.reset();
+      CHECK(to_hex(h.finalize()) == "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262");
+   }
+}
+
+TEST_CASE("Cryptid CityHash Tests", "[cryptid_city_hash_tests]") {
+   using namespace astro::cryptid;
+
+   SECTION("Check empty input") {
+      CHECK(city_hash::hash64("", 0) == city_hash::k2);
+      CHECK(city_hash::hash64(std::string_view{}) == city_hash::k2);
+   }
+
+   SECTION("Check all length buckets") {
+      const auto                 data = test_input(256);
+      std::vector<std::uint64_t> hs;
+      for (std::size_t n = 0; n <= data.size(); ++n)
+         hs.push_back(city_hash::hash64(data.data(), n));
+      std::sort(hs.begin(), hs.end());
+      CHECK(std::adjacent_find(hs.begin(), hs.end()) == hs.end());
+      CHECK(city_hash::hash64(data.data(), 200) == city_hash::hash64(std::span<const std::uint8_t>{data.data(), 200}));
+   }
+
+   SECTION("Check seeds and keys") {
+      CHECK(city_hash::hash64("astro", 5, 1) != city_hash::hash64("astro", 5, 2));
+      CHECK(hash_key<city_hash>(std::string{"astro"}) == city_hash::hash64("astro", 5));
+      CHECK(hash_key<city_hash>(std::uint64_t{42}) == hash_key<city_hash>(std::uint64_t{42}));
+      CHECK(fast_range32(0xffffffffu, 10) == 9);
+      CHECK(fast_range64(0xffffffffffffffffull, 10) == 9);
+   }
+}
+
+TEST_CASE("Cryptid Filter Tests", "[cryptid_filter_tests]") {
+   using namespace astro::cryptid;
+
+   std::vector<std::uint64_t> keys(10000);
+   for (std::size_t i = 0; i < keys.size(); ++i)
+      keys[i] = i * 7919 + 1;
+   std::vector<std::uint64_t> absent(100000);
+   for (std::size_t i = 0; i < absent.size(); ++i)
+      absent[i] = (i + 1) * 7919 + 2;
+
+   SECTION("Check blocked bloom filter") {
+      blocked_bloom_filter<> f{keys.size(), 0.01};
+      for (auto k : keys)
+         f.insert(k);
+
+      bool all = true;
+      for (auto k : keys)
+         all &= f.contains(k);
+      CHECK(all);
+
+      std::size_t fp = 0;
+      for (auto k : absent)
+         fp += f.contains(k);
+      CHECK(fp < absent.size() / 50);
+
+      auto res = std::make_unique<bool[]>(absent.size());
+      CHECK(f.contains_n(std::span<const std::uint64_t>{absent}, std::span<bool>{res.get(), absent.size()}) == fp);
+      bool same = true;
+      for (std::size_t i = 0; i < absent.size(); ++i)
+         same &= res[i] == f.contains(absent[i]);
+      CHECK(same);
+
+      CHECK(f.contains(std::string{"missing"}) == f.contains(std::string_view{"missing"}));
+   }
+
+   SECTION("Check blocked bloom filter serialization") {
+      blocked_bloom_filter<> f{1000};
+      for (std::size_t i = 0; i < 1000; ++i)
+         f.insert(keys[i]);
+
+      astro::serial::alpha a;
+      a.pack(f);
+      a.reset();
+      auto g = a.pop<blocked_bloom_filter<>>();
+      CHECK(g.block_count() == f.block_count());
+      CHECK(std::memcmp(g.blocks().data(), f.blocks().data(), f.size_bytes()) == 0);
+      CHECK(g.contains(keys[10]));
+   }
+
+   SECTION("Check cuckoo filter") {
+      cuckoo_filter<> f{keys.size()};
+      bool ok = true;
+      for (auto k : keys)
+         ok &= f.insert(k);
+      CHECK(ok);
+      CHECK(f.size() == keys.size());
+
+      bool all = true;
+      for (auto k : keys)
+         all &= f.contains(k);
+      CHECK(all);
+
+      std::size_t fp = 0;
+      for (auto k : absent)
+         fp += f.contains(k);
+      CHECK(fp < absent.size() / 100);
+
+      auto res = std::make_unique<bool[]>(keys.size());
+      CHECK(f.contains_n(std::span<const std::uint64_t>{keys}, std::span<bool>{res.get(), keys.size()}) == keys.size());
+
+      for (std::size_t i = 0; i < keys.size(); i += 2)
+         CHECK(f.erase(keys[i]));
+      CHECK(f.size() == keys.size() / 2);
+      all = true;
+      for (std::size_t i = 1; i < keys.size(); i += 2)
+         all &= f.contains(keys[i]);
+      CHECK(all);
+   }
+
+   SECTION("Check cuckoo filter overflow and serialization") {
+      auto f = cuckoo_filter<>::with_buckets(16);
+      std::vector<std::uint64_t> stored;
+      std::size_t                rejected = 0;
+      for (auto k : keys) {
+         if (f.insert(k))
+            stored.push_back(k);
+         else
+            ++rejected;
+      }
+      CHECK(rejected > 0);
+      CHECK(f.size() == stored.size());
+      // every insert reported as successful stays visible, however full the filter got afterwards
+      bool all = true;
+      for (auto k : stored)
+         all &= f.contains(k);
+      CHECK(all);
+
+      astro::serial::alpha a;
+      a.pack(f);
+      a.reset();
+      auto g = a.pop<cuckoo_filter<>>();
+      CHECK(g.size() == f.size());
+      CHECK(std::equal(g.buckets().begin(), g.buckets().end(), f.buckets().begin()));
+      CHECK(g.contains(stored.back()));
+   }
+}
+
+TEST_CASE("Cryptid Sketch Tests", "[cryptid_sketch_tests]") {
+   using namespace astro::cryptid;
+
+   auto within = [](double est, double actual, double tol) { return std::abs(est - actual) <= actual * tol; };
+
+   SECTION("Check hyperloglog sparse and dense") {
+      hyperloglog<> h{14};
+      CHECK(h.count() == 0);
+      for (std::uint64_t i = 0; i < 500; ++i) {
+         h.insert(i);
+         h.insert(i);
+      }
+      CHECK(h.is_sparse());
+      CHECK(within(h.estimate(), 500, 0.01));
+
+      for (std::uint64_t i = 500; i < 200000; ++i)
+         h.insert(i);
+      CHECK(!h.is_sparse());
+      CHECK(h.size_bytes() == (1u << 14));
+      CHECK(within(h.estimate(), 200000, 0.03));
+   }
+
+   SECTION("Check hyperloglog merge") {
+      hyperloglog<> a{12}, b{12}, c{12}, all{12};
+      for (std::uint64_t i = 0; i < 100000; ++i) {
+         (i % 2 ? a : b).insert(i);
+         all.insert(i);
+      }
+      for (std::uint64_t i = 0; i < 100; ++i)
+         c.insert(i + 1000000);
+
+      a.merge(b);
+      CHECK(std::equal(a.registers().begin(), a.registers().end(), all.registers().begin()));
+      CHECK(within(a.estimate(), 100000, 0.05));
+
+      a.merge(c);
+      c.merge(all);
+      CHECK(!c.is_sparse());
+      CHECK(std::equal(a.registers().begin(), a.registers().end(), c.registers().begin()));
+
+      hyperloglog<> d{12};
+      CHECK_THROWS(d.merge(hyperloglog<>{14}));
+   }
+
+   SECTION("Check hyperloglog at small precision") {
+      // the insert buffer is larger than the dense threshold here, so flushing switches representation
+      hyperloglog<> s{6};
+      for (std::uint64_t i = 0; i < 40; ++i)
+         s.insert(i);
+      const hyperloglog<>& view = s;
+      CHECK(within(view.estimate(), 40, 0.01));
+      CHECK(s.is_sparse());
+
+      hyperloglog<> big{6}, all{6};
+      for (std::uint64_t i = 0; i < 200; ++i)
+         big.insert(i + 1000);
+      for (std::uint64_t i = 0; i < 40; ++i)
+         all.insert(i);
+      for (std::uint64_t i = 0; i < 200; ++i)
+         all.insert(i + 1000);
+      big.merge(s);
+      CHECK(std::equal(big.registers().begin(), big.registers().end(), all.registers().begin()));
+      CHECK(within(big.estimate(), 240, 0.3));
+
+      hyperloglog<> fresh{6};
+      fresh.merge(s);
+      CHECK(within(fresh.estimate(), 40, 0.3));
+      CHECK(within(s.estimate(), 40, 0.01));
+   }
+
+   SECTION("Check hyperloglog sparse to dense equivalence") {
+      hyperloglog<> s{10}, d{10};
+      for (std::uint64_t i = 0; i < 200; ++i)
+         s.insert(i);
+      for (std::uint64_t i = 0; i < 50000; ++i)
+         d.insert(i + 7);
+      hyperloglog<> e{10};
+      e.merge(d);
+      for (std::uint64_t i = 0; i < 200; ++i)
+         e.insert(i);
+      d.merge(s);
+      CHECK(std::equal(d.registers().begin(), d.registers().end(), e.registers().begin()));
+   }
+
+   SECTION("Check hyperloglog serialization") {
+      hyperloglog<> s{14}, d{14};
+      for (std::uint64_t i = 0; i < 100; ++i)
+         s.insert(i);
+      for (std::uint64_t i = 0; i < 100000; ++i)
+         d.insert(i);
+
+      astro::serial::alpha a;
+      a.pack(s);
+      a.pack(d);
+      a.reset();
+      auto s2 = a.pop<hyperloglog<>>();
+      auto d2 = a.pop<hyperloglog<>>();
+      CHECK(s2.is_sparse());
+      CHECK(s2.count() == s.count());
+      CHECK(d2.count() == d.count());
+   }
+
+   SECTION("Check count-min sketch") {
+      count_min_sketch<> cms{0.001, 0.01};
+      CHECK(cms.width() == 2719);
+      CHECK(cms.depth() == 5);
+      for (std::uint64_t i = 0; i < 1000; ++i)
+         cms.insert(i, static_cast<std::uint32_t>(i % 10 + 1));
+      cms.insert(std::string{"hot"}, 5000);
+
+      bool never_under = true;
+      for (std::uint64_t i = 0; i < 1000; ++i)
+         never_under &= cms.estimate(i) >= i % 10 + 1;
+      CHECK(never_under);
+      CHECK(cms.estimate(std::string{"hot"}) >= 5000);
+      CHECK(cms.estimate(std::string{"hot"}) <= 5000 + cms.total() / 100);
+
+      count_min_sketch<> other{0.001, 0.01};
+      other.insert(std::string{"hot"}, 10);
+      cms.merge(other);
+      CHECK(cms.estimate(std::string{"hot"}) >= 5010);
+      CHECK(cms.total() == other.total() + 5000 + 5500);
+
+      auto cons = count_min_sketch<>::with_dimensions(64, 4);
+      for (std::uint64_t i = 0; i < 1000; ++i)
+         cons.insert_conservative(i);
+      auto plain = count_min_sketch<>::with_dimensions(64, 4);
+      for (std::uint64_t i = 0; i < 1000; ++i)
+         plain.insert(i);
+      CHECK(cons.estimate(std::uint64_t{3}) <= plain.estimate(std::uint64_t{3}));
+      CHECK(cons.estimate(std::uint64_t{3}) >= 1);
+
+      astro::serial::alpha a;
+      a.pack(cms);
+      a.reset();
+      auto c2 = a.pop<count_min_sketch<>>();
+      CHECK(c2.total() == cms.total());
+      CHECK(std::equal(c2.counters().begin(), c2.counters().end(), cms.counters().begin()));
+   }
+}
+
+TEST_CASE("Cryptid Consistent Hash Tests", "[cryptid_consistent_hash_tests]") {
+   using namespace astro::cryptid;
+
+   SECTION("Check jump hash") {
+      CHECK(jump_hash(0, 1) == 0);
+      static_assert(jump_hash(12345, 1) == 0);
+
+      bool in_range = true, minimal = true;
+      std::vector<std::size_t> counts(10);
+      for (std::uint64_t k = 0; k < 10000; ++k) {
+         const auto h = city_hash::hash64(k);
+         const auto a = jump_hash(h, 10);
+         const auto b = jump_hash(h, 11);
+         in_range &= a >= 0 && a < 10;
+         minimal  &= b == a || b == 10;
+         ++counts[static_cast<std::size_t>(a)];
+      }
+      CHECK(in_range);
+      CHECK(minimal);
+      CHECK(*std::min_element(counts.begin(), counts.end()) > 800);
+      CHECK(*std::max_element(counts.begin(), counts.end()) < 1200);
+      CHECK(jump_hash_key(std::string{"shard"}, 1000) == jump_hash(city_hash::hash64("shard", 5), 1000));
+   }
+
+   SECTION("Check rendezvous hash") {
+      std::vector<uint128> nodes;
+      for (std::uint64_t i = 0; i < 37; ++i)
+         nodes.emplace_back(i * 31 + 7, i);
+      rendezvous_hash<> r{nodes};
+      CHECK(r.size() == 37);
+
+      bool same = true;
+      for (std::uint64_t k = 0; k < 2000; ++k) {
+         const auto    h    = city_hash::hash64(k);
+         std::size_t   best = 0;
+         std::uint64_t top  = 0;
+         for (std::size_t i = 0; i < nodes.size(); ++i) {
+            const auto sc = detail::mix64(city_hash::hash64(nodes[i]) ^ h);
+            if (i == 0 || sc > top) {
+               best = i;
+               top  = sc;
+            }
+         }
+         same &= r.route_index(h) == best;
+      }
+      CHECK(same);
+
+      std::vector<uint128> before(2000);
+      for (std::uint64_t k = 0; k < 2000; ++k)
+         before[k] = r.route(k);
+      const uint128 added{999, 999};
+      r.add(added);
+      bool minimal = true;
+      for (std::uint64_t k = 0; k < 2000; ++k)
+         minimal &= r.route(k) == before[k] || r.route(k) == added;
+      CHECK(minimal);
+
+      CHECK(r.remove(nodes[3]));
+      CHECK(!r.remove(nodes[3]));
+      for (std::uint64_t k = 0; k < 2000; ++k)
+         minimal &= before[k] == nodes[3] || r.route(k) == before[k] || r.route(k) == added;
+      CHECK(minimal);
+
+      std::array<std::size_t, 3> top3{};
+      r.rank(std::uint64_t{42}, top3);
+      CHECK(top3[0] == r.route_index(city_hash::hash64(std::uint64_t{42})));
+      CHECK(top3[0] != top3[1]);
+   }
+
+   SECTION("Check bounded load ring") {
+      bounded_load_ring<> ring{0.25, 64};
+      for (std::uint64_t i = 0; i < 8; ++i)
+         ring.add(uint128{i, 0});
+      CHECK_THROWS(ring.add(uint128{0, 0}));
+
+      std::vector<std::size_t> owners;
+      for (std::uint64_t k = 0; k < 8000; ++k)
+         owners.push_back(ring.assign(k));
+      CHECK(ring.total_load() == 8000);
+      CHECK(*std::max_element(ring.loads().begin(), ring.loads().end()) <= 1250);
+
+      ring.release(owners[0]);
+      CHECK(ring.total_load() == 7999);
+
+      std::vector<uint128> before;
+      for (std::uint64_t k = 0; k < 4000; ++k)
+         before.push_back(ring.lookup(k));
+      ring.add(uint128{100, 0});
+      std::size_t moved = 0;
+      bool        only_new = true;
+      for (std::uint64_t k = 0; k < 4000; ++k) {
+         if (ring.lookup(k) != before[k]) {
+            ++moved;
+            only_new &= ring.lookup(k) == uint128{100, 0};
+         }
+      }
+      CHECK(only_new);
+      CHECK(moved < 4000 / 4);
+
+      // indices handed out before a removal keep naming the same node
+      const std::size_t   victim   = owners[1];
+      const std::size_t   survivor = owners[1] == owners[2] ? owners[3] : owners[2];
+      const std::uint64_t load     = ring.loads()[survivor];
+      const uint128       node     = ring.nodes()[survivor];
+      REQUIRE(victim != survivor);
+      CHECK(ring.remove(ring.nodes()[victim]));
+      CHECK_FALSE(ring.alive(victim));
+      CHECK(ring.size() == 8);
+      CHECK(ring.nodes()[survivor] == node);
+      ring.release(survivor);
+      CHECK(ring.loads()[survivor] == load - 1);
+      const std::uint64_t total = ring.total_load();
+      ring.release(victim);
+      CHECK(ring.total_load() == total);
+      bool live_only = true;
+      for (std::uint64_t k = 0; k < 1000; ++k)
+         live_only &= ring.alive(ring.assign(k + 100000));
+      CHECK(live_only);
+   }
+}
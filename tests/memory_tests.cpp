@@ -2,11 +2,14 @@
 #define CATCH_CONFIG_WINDOWS_SEH
 #include <catch2/catch_all.hpp>
 #include <iostream>
+#include <filesystem>
 #include <fstream>
+#include <thread>
 
 #include <astro/info.hpp>
 #include <astro/utils.hpp>
 #include <astro/memory.hpp>
+#include <astro/utils/temp_file.hpp>
 
 using namespace astro::memory;
 
@@ -103,6 +106,43 @@ TEST_CASE("Mapper Tests", "[mapper_tests]") {
 
       //CHECK(global_value == 1);
    }
+
+   SECTION("Check mapped_file") {
+      const auto fn = astro::util::generate_temp_file_name("astro_mapped_%%%%%%%%.bin");
+      {
+         std::ofstream out{fn, std::ios::binary};
+         out << "mapped bytes";
+      }
+
+      mapped_file rf{fn};
+      CHECK(rf.is_open());
+      CHECK(!rf.is_writable());
+      CHECK(rf.size() == 12);
+      CHECK(std::string(reinterpret_cast<const char*>(rf.data()), rf.size()) == "mapped bytes");
+      CHECK_THROWS(rf.writable_bytes());
+
+      {
+         mapped_file wf{fn, access_mode::read_write};
+         wf.writable_bytes()[0] = 'M';
+         wf.sync();
+      }
+      CHECK(rf.data()[0] == 'M');
+
+      mapped_file moved = std::move(rf);
+      CHECK(!rf.is_open());
+      CHECK(moved.bytes().size() == 12);
+      moved.close();
+      CHECK(moved.empty());
+
+      std::ofstream{fn, std::ios::trunc};
+      mapped_file ef{fn};
+      CHECK(ef.is_open());
+      CHECK(ef.empty());
+      ef.close();
+
+      std::filesystem::remove(fn);
+      CHECK_THROWS(mapped_file{fn});
+   }
 }
 
 TEST_CASE("Allocator Tests", "[allocator_tests]") {
@@ -123,6 +163,38 @@ TEST_CASE("Allocator Tests", "[allocator_tests]") {
       CHECK(ta.check_ptr(ptr2 + 5) == false);
       CHECK_THROWS_MATCHES(ta.allocate<int>(1), std::runtime_error, Catch::Matchers::Message("Out of memory"));
    }
+
+   SECTION("Check arena") {
+      arena a{4096};
+      CHECK(a.reserved() == 0);
+
+      void* p = a.allocate_bytes(40);
+      void* q = a.allocate_bytes(48);
+      CHECK(reinterpret_cast<std::uintptr_t>(p) % arena::granule == 0);
+      CHECK(static_cast<std::byte*>(q) - static_cast<std::byte*>(p) == 48);
+      const std::size_t held = a.reserved();
+      CHECK(held > 4096);
+
+      // a freed allocation is reused by the next one of the same size class
+      a.deallocate_bytes(p, 40);
+      CHECK(a.allocate_bytes(33) == p);
+
+      // large allocations bypass the blocks
+      void* big = a.allocate_bytes(arena::max_recycled + 1);
+      CHECK(a.reserved() == held);
+      a.deallocate_bytes(big, arena::max_recycled + 1);
+
+      // frees from another thread are picked up by the owner
+      std::thread([&] { a.deallocate_bytes(q, 48); }).join();
+      CHECK(a.allocate_bytes(48) == q);
+
+      auto ints = a.allocate<int>(3000);
+      ints[2999] = 7;
+      CHECK(a.reserved() > held);
+
+      a.reset();
+      CHECK(a.reserved() == 0);
+   }
 }
 
 TEST_CASE("discriminant Tests", "[discriminant_tests]") {
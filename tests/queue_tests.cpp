@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+#define CATCH_CONFIG_WINDOWS_SEH
+#include <catch2/catch_all.hpp>
+
+#include <astro/async/mpmc_queue.hpp>
+#include <astro/async/spsc_ring.hpp>
+
+using namespace astro::async;
+
+TEST_CASE("MPMC Queue Tests", "[queue_tests]") {
+   SECTION("Check single threaded behavior") {
+      CHECK_THROWS(mpmc_queue<int>{0});
+
+      mpmc_queue<std::string> q{3};
+      CHECK(q.capacity() == 4);
+      CHECK(q.empty());
+
+      std::string s = "kept";
+      CHECK(q.try_push("a"));
+      CHECK(q.try_emplace(3, 'b'));
+      CHECK(q.try_push(std::string{"c"}));
+      CHECK(q.try_push("d"));
+      CHECK_FALSE(q.try_push(std::move(s)));
+      CHECK(s == "kept");
+      CHECK(q.size_approx() == 4);
+
+      std::string out;
+      REQUIRE(q.try_pop(out));
+      CHECK(out == "a");
+      REQUIRE(q.try_pop(out));
+      CHECK(out == "bbb");
+      CHECK(q.try_push("e"));
+
+      std::vector<std::string> rest;
+      CHECK(q.pop_n(std::back_inserter(rest), 10) == 3);
+      CHECK(rest == std::vector<std::string>{"c", "d", "e"});
+      CHECK_FALSE(q.try_pop(out));
+
+      // elements still queued are destroyed with the queue
+      auto tracked = std::make_shared<int>(0);
+      {
+         mpmc_queue<std::shared_ptr<int>> held{4};
+         held.try_push(tracked);
+         held.try_push(tracked);
+         CHECK(tracked.use_count() == 3);
+      }
+      CHECK(tracked.use_count() == 1);
+   }
+
+   SECTION("Check bulk push wraps around") {
+      mpmc_queue<int>  q{8};
+      std::vector<int> in(20);
+      for (int i = 0; i < 20; ++i)
+         in[i] = i;
+
+      std::vector<int> out;
+      std::size_t      at = 0;
+      while (at < in.size()) {
+         at += q.push_n(in.begin() + at, std::min<std::size_t>(5, in.size() - at));
+         q.pop_n(std::back_inserter(out), 3);
+      }
+      while (q.pop_n(std::back_inserter(out), 8) != 0) {}
+      CHECK(out == in);
+      CHECK(q.push_n(in.begin(), 20) == 8);
+      CHECK(q.push_n(in.begin(), 1) == 0);
+   }
+
+   SECTION("Check close") {
+      mpmc_queue<int> q{4};
+      CHECK(q.push(1));
+      q.close();
+      CHECK(q.closed());
+      CHECK_FALSE(q.push(2));
+      CHECK_FALSE(q.try_push(2));
+      CHECK(q.pop() == 1);
+      CHECK(q.pop() == std::nullopt);
+
+      // a consumer blocked on an empty queue is released by close()
+      mpmc_queue<int> idle{4};
+      std::optional<int> got = 0;
+      std::thread        t([&] { got = idle.pop(); });
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      idle.close();
+      t.join();
+      CHECK(got == std::nullopt);
+   }
+
+   SECTION("Check every element arrives exactly once with blocking producers and consumers") {
+      constexpr std::size_t producers = 3, consumers = 3, per = 50000;
+      mpmc_queue<std::uint64_t> q{64};
+      std::vector<std::vector<std::uint64_t>> got(consumers);
+
+      std::vector<std::thread> threads;
+      for (std::size_t c = 0; c < consumers; ++c) {
+         threads.emplace_back([&, c] {
+            std::vector<std::uint64_t> batch;
+            for (;;) {
+               if (c == 0) {
+                  batch.clear();
+                  if (q.pop_n(std::back_inserter(batch), 16) != 0) {
+                     got[c].insert(got[c].end(), batch.begin(), batch.end());
+                     continue;
+                  }
+               }
+               auto v = q.pop();
+               if (!v)
+                  break;
+               got[c].push_back(*v);
+            }
+         });
+      }
+
+      std::atomic<std::size_t> refused = 0;
+      std::vector<std::thread> writers;
+      for (std::size_t p = 0; p < producers; ++p) {
+         writers.emplace_back([&, p] {
+            std::vector<std::uint64_t> chunk;
+            for (std::uint64_t i = 0; i < per;) {
+               const std::uint64_t v = p * per + i;
+               if (p == 0 && i + 8 <= per) {
+                  chunk.clear();
+                  for (std::uint64_t j = 0; j < 8; ++j)
+                     chunk.push_back(v + j);
+                  const std::size_t n = q.push_n(chunk.begin(), chunk.size());
+                  i += n;
+                  if (n != 0)
+                     continue;
+               }
+               refused += !q.push(v);
+               ++i;
+            }
+         });
+      }
+      for (auto& t : writers)
+         t.join();
+      q.close();
+      for (auto& t : threads)
+         t.join();
+
+      std::vector<std::uint8_t> seen(producers * per, 0);
+      std::size_t               total = 0;
+      bool                      twice = false;
+      for (const auto& vs : got) {
+         total += vs.size();
+         for (auto v : vs)
+            twice |= seen[v]++ != 0;
+      }
+      CHECK(refused == 0);
+      CHECK_FALSE(twice);
+      CHECK(total == producers * per);
+   }
+}
+
+TEST_CASE("SPSC Ring Tests", "[queue_tests]") {
+   SECTION("Check reserve and commit hand out contiguous spans") {
+      spsc_ring<int> r{6};
+      CHECK(r.capacity() == 8);
+
+      auto w = r.reserve(5);
+      REQUIRE(w.size() == 5);
+      std::iota(w.begin(), w.end(), 0);
+      r.commit(5);
+
+      auto p = r.peek();
+      REQUIRE(p.size() == 5);
+      CHECK(p[4] == 4);
+      r.consume(3);
+
+      // the free space wraps, so the first span stops at the end of the buffer
+      w = r.reserve(6);
+      CHECK(w.size() == 3);
+      std::iota(w.begin(), w.end(), 5);
+      r.commit(3);
+      w = r.reserve(6);
+      CHECK(w.size() == 3);
+      std::iota(w.begin(), w.end(), 8);
+      r.commit(3);
+      CHECK(r.reserve(1).empty());
+
+      std::vector<int> out(16);
+      CHECK(r.pop_n(out) == 8);
+      out.resize(8);
+      CHECK(out == std::vector<int>{3, 4, 5, 6, 7, 8, 9, 10});
+      CHECK(r.empty());
+   }
+
+   SECTION("Check batched publish") {
+      spsc_ring<int> r{16, 4};
+      int            v = 0;
+      CHECK(r.try_push(1));
+      CHECK(r.try_push(2));
+      CHECK(r.try_push(3));
+      CHECK_FALSE(r.try_pop(v));
+      CHECK(r.try_push(4));
+      CHECK(r.try_pop(v));
+      CHECK(v == 1);
+
+      CHECK(r.try_push(5));
+      CHECK_FALSE(r.peek().size() == 4);
+      r.flush();
+      CHECK(r.peek().size() == 4);
+
+      // a full ring publishes what it holds rather than wait for the batch
+      spsc_ring<int> small{4, 100};
+      const int      in[] = {1, 2, 3};
+      CHECK(small.push_n(in) == 3);
+      CHECK(small.try_push(4));
+      CHECK(small.peek().empty());
+      CHECK_FALSE(small.try_push(5));
+      CHECK(small.peek().size() == 4);
+   }
+
+   SECTION("Check ordered hand-off between two threads") {
+      constexpr std::uint64_t n = 1000000;
+      spsc_ring<std::uint64_t> r{1024, 32};
+
+      std::thread producer([&] {
+         std::uint64_t next = 0;
+         while (next < n) {
+            auto s = r.reserve(n - next);
+            for (auto& x : s)
+               x = next++;
+            r.commit(s.size());
+         }
+         r.flush();
+      });
+
+      std::uint64_t expected = 0;
+      bool          ordered  = true;
+      while (expected < n) {
+         auto s = r.peek();
+         for (auto x : s)
+            ordered &= x == expected++;
+         r.consume(s.size());
+      }
+      producer.join();
+      CHECK(ordered);
+      CHECK(r.empty());
+   }
+   SECTION("Check size_approx while both sides run") {
+      constexpr int    n = 200000;
+      spsc_ring<int>   r{4};
+      std::atomic<int> popped = 0;
+
+      std::thread producer([&] {
+         for (int i = 0; i < n;) {
+            if (r.try_push(i))
+               ++i;
+            else
+               std::this_thread::yield();
+         }
+      });
+      std::thread consumer([&] {
+         int v;
+         while (popped.load(std::memory_order_relaxed) < n)
+            if (r.try_pop(v))
+               popped.fetch_add(1, std::memory_order_relaxed);
+            else
+               std::this_thread::yield();
+      });
+
+      // a third thread sees both indices move between its two loads
+      bool bounded = true;
+      while (popped.load(std::memory_order_relaxed) < n) {
+         bounded &= r.size_approx() <= r.capacity();
+         std::this_thread::yield();
+      }
+      producer.join();
+      consumer.join();
+      CHECK(bounded);
+      CHECK(r.empty());
+   }
+}
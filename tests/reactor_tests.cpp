@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cerrno>
+#include <cstdlib>
+#include <string_view>
+#include <thread>
+#include <vector>
+#define CATCH_CONFIG_WINDOWS_SEH
+#include <catch2/catch_all.hpp>
+
+#include <astro/info.hpp>
+#include <astro/async/reactor.hpp>
+
+#if ASTRO_OS != ASTRO_WINDOWS_BUILD
+   #include <fcntl.h>
+   #include <unistd.h>
+
+using namespace astro::async;
+
+namespace {
+   struct pipe_fds {
+         pipe_fds() { REQUIRE(::pipe(fds) == 0); }
+         ~pipe_fds() {
+            ::close(fds[0]);
+            ::close(fds[1]);
+         }
+         int fds[2];
+   };
+
+   // runs the loop on its own thread for the lifetime of the scope
+   struct loop_thread {
+         explicit loop_thread(reactor& r) : r(r), thread([&r] { r.run(); }) {}
+         ~loop_thread() {
+            r.stop();
+            thread.join();
+         }
+         reactor&    r;
+         std::thread thread;
+   };
+
+   task<std::int64_t> send(reactor& r, io_handle& h, std::size_t total) {
+      std::vector<std::uint8_t> buf(4096);
+      std::size_t               sent = 0;
+      while (sent < total) {
+         for (std::size_t i = 0; i < buf.size(); ++i)
+            buf[i] = static_cast<std::uint8_t>(sent + i);
+         const std::size_t  n = std::min(buf.size(), total - sent);
+         const std::int64_t w = co_await r.write_some(h, {buf.data(), n});
+         if (w < 0)
+            co_return -1;
+         sent += static_cast<std::size_t>(w);
+      }
+      ::close(h.fd());
+      co_return static_cast<std::int64_t>(sent);
+   }
+
+   task<std::int64_t> receive(reactor& r, io_handle& h, bool& intact) {
+      std::vector<std::uint8_t> buf(1000);
+      std::size_t               got = 0;
+      intact                        = true;
+      for (;;) {
+         const std::int64_t n = co_await r.read_some(h, buf);
+         if (n <= 0)
+            co_return n < 0 ? -1 : static_cast<std::int64_t>(got);
+         for (std::int64_t i = 0; i < n; ++i)
+            intact &= buf[i] == static_cast<std::uint8_t>(got + i);
+         got += static_cast<std::size_t>(n);
+      }
+   }
+
+   void check_file_ops(reactor_backend backend) {
+      char      path[] = "/tmp/astro_reactor_XXXXXX";
+      const int fd     = ::mkstemp(path);
+      REQUIRE(fd >= 0);
+      ::unlink(path);
+
+      reactor         r{nullptr, 64, backend};
+      loop_thread     loop{r};
+      if (backend == reactor_backend::epoll)
+         CHECK_FALSE(r.uses_uring());
+      astro::fs::file f{fd};
+      auto            h = r.add(f);
+      pipe_fds        p;
+      auto            pin  = r.add(p.fds[0]);
+      auto            pout = r.add(p.fds[1]);
+
+      std::vector<std::uint8_t> data(8192);
+      for (std::size_t i = 0; i < data.size(); ++i)
+         data[i] = static_cast<std::uint8_t>(i * 7);
+      const std::span<std::uint8_t> pinned[] = {data};
+      io_handle* const              files[]  = {&h, &pout};
+      CHECK(r.register_buffers(pinned) == r.uses_uring());
+      CHECK(r.register_files(files) == r.uses_uring());
+
+      CHECK(sync_wait(r.write_at(h, data, 0)) == 8192);
+      CHECK(sync_wait(r.write_at(h, std::span<const std::uint8_t>{data.data(), 10}, 8192)) == 10);
+      CHECK(sync_wait(r.fsync(h)) == 0);
+      CHECK(sync_wait(r.fsync(h, true)) == 0);
+
+      std::vector<std::uint8_t> back(8202);
+      CHECK(sync_wait(r.read_at(h, back, 0)) == 8202);
+      CHECK(std::equal(data.begin(), data.end(), back.begin()));
+      CHECK(sync_wait(r.read_at(h, back, 8202)) == 0);
+      // errno belongs to the thread the awaiting coroutine continues on
+      const int error = sync_wait([](reactor& r, io_handle& h, std::span<std::uint8_t> buf) -> task<int> {
+         errno = 0;
+         co_return co_await r.read_at(h, buf, 0) == -1 ? errno : 0;
+      }(r, pout, back));
+      CHECK(error != 0);
+
+      // many reads in flight at once share submissions, more than the completion ring holds wait for room
+      std::vector<task<std::int64_t>>         reads;
+      std::vector<std::vector<std::uint8_t>> chunks(2000, std::vector<std::uint8_t>(128));
+      for (std::size_t i = 0; i < chunks.size(); ++i)
+         reads.push_back(r.read_at(h, chunks[i], i % 64 * 128));
+      const auto sizes = sync_wait(when_all(std::move(reads)));
+      bool       whole = true;
+      for (std::size_t i = 0; i < chunks.size(); ++i)
+         whole &= sizes[i] == 128 && std::equal(chunks[i].begin(), chunks[i].end(), data.begin() + i % 64 * 128);
+      CHECK(whole);
+
+      // file to pipe, then pipe to pipe with the source still empty
+      CHECK(sync_wait(r.splice(h, pout, 8202)) == 8202);
+      CHECK(sync_wait(r.read_some(pin, back)) == 8202);
+      CHECK(std::equal(data.begin(), data.end(), back.begin()));
+
+      pipe_fds    q;
+      auto        qin = r.add(q.fds[0]);
+      std::thread writer([&] {
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+         [[maybe_unused]] auto n = ::write(q.fds[1], "spliced", 7);
+      });
+      const std::int64_t moved = sync_wait(r.splice(qin, pout, 64));
+      writer.join();
+      CHECK(moved == 7);
+      CHECK(sync_wait(r.read_some(pin, back)) == 7);
+      CHECK(std::string_view(reinterpret_cast<char*>(back.data()), 7) == "spliced");
+
+      r.unregister_files();
+      r.unregister_buffers();
+      CHECK(sync_wait(r.read_at(h, back, 8192)) == 10);
+   }
+} // namespace
+
+TEST_CASE("Reactor Tests", "[reactor_tests]") {
+   SECTION("Check reading a pipe") {
+      reactor     r;
+      pipe_fds    p;
+      auto        in = r.add(p.fds[0]);
+      loop_thread loop{r};
+      CHECK(in.pollable());
+
+      std::thread writer([&] {
+         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+         [[maybe_unused]] auto n = ::write(p.fds[1], "hello", 5);
+      });
+      std::uint8_t       buf[16];
+      const std::int64_t n = sync_wait(r.read_some(in, buf));
+      writer.join();
+      REQUIRE(n == 5);
+      CHECK(std::string_view(reinterpret_cast<char*>(buf), 5) == "hello");
+   }
+
+   SECTION("Check a transfer larger than the pipe buffer") {
+      reactor     r;
+      int         fds[2];
+      REQUIRE(::pipe(fds) == 0);
+      auto        in  = r.add(fds[0]);
+      auto        out = r.add(fds[1]);
+      loop_thread loop{r};
+
+      constexpr std::size_t total  = 1 << 20;
+      bool                  intact = false;
+      const auto [sent, got]       = sync_wait(when_all(send(r, out, total), receive(r, in, intact)));
+      CHECK(sent == total);
+      CHECK(got == total);
+      CHECK(intact);
+      ::close(fds[0]);
+   }
+
+   SECTION("Check posting and timers") {
+      reactor     r;
+      loop_thread loop{r};
+
+      std::atomic<int> count = 0;
+      std::thread      other([&] {
+         for (int i = 0; i < 100; ++i)
+            r.post([&count] { count.fetch_add(1); });
+      });
+      other.join();
+      while (count.load() != 100)
+         std::this_thread::yield();
+      CHECK(count == 100);
+
+      // every timer resumes on the loop thread, so order needs no lock
+      std::vector<int>       order;
+      std::vector<task<int>> sleepers;
+      for (int ms : {30, 10, 20})
+         sleepers.push_back([](reactor& r, std::vector<int>& order, int ms) -> task<int> {
+            co_await r.sleep_for(std::chrono::milliseconds(ms));
+            order.push_back(ms);
+            co_return ms;
+         }(r, order, ms));
+      const auto start = std::chrono::steady_clock::now();
+      CHECK(sync_wait(when_all(std::move(sleepers))) == std::vector<int>{30, 10, 20});
+      CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(30));
+      CHECK(order == std::vector<int>{10, 20, 30});
+
+      const auto id = sync_wait([](reactor& r) -> task<std::thread::id> {
+         co_await r.schedule();
+         co_return std::this_thread::get_id();
+      }(r));
+      CHECK(id == loop.thread.get_id());
+   }
+
+   SECTION("Check resuming on a pool") {
+      thread_pool pool{2};
+      reactor     r{&pool};
+      loop_thread loop{r};
+
+      const auto id = sync_wait([](reactor& r) -> task<std::thread::id> {
+         co_await r.sleep_for(std::chrono::milliseconds(1));
+         co_return std::this_thread::get_id();
+      }(r));
+      CHECK(id != loop.thread.get_id());
+      CHECK(id != std::this_thread::get_id());
+   }
+
+   SECTION("Check regular files are always ready") {
+      char      path[] = "/tmp/astro_reactor_XXXXXX";
+      const int fd     = ::mkstemp(path);
+      REQUIRE(fd >= 0);
+      ::unlink(path);
+
+      reactor         r;
+      astro::fs::file f{fd};
+      auto            h = r.add(f);
+      CHECK_FALSE(h.pollable());
+
+      const std::uint8_t data[] = {1, 2, 3, 4};
+      CHECK(sync_wait(r.write_some(h, data)) == 4);
+      REQUIRE(::lseek(fd, 0, SEEK_SET) == 0);
+      std::uint8_t back[4] = {};
+      CHECK(sync_wait(r.read_some(h, back)) == 4);
+      CHECK(back[3] == 4);
+      CHECK(sync_wait(r.read_some(h, back)) == 0);
+   }
+
+   SECTION("Check file operations through io_uring when available") {
+      check_file_ops(reactor_backend::automatic);
+   }
+
+   SECTION("Check file operations through plain syscalls") {
+      check_file_ops(reactor_backend::epoll);
+   }
+}
+#endif
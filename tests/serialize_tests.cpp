@@ -1,12 +1,203 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <optional>
+#include <set>
+#include <span>
 #include <string>
+#include <variant>
+#include <vector>
 #define CATCH_CONFIG_WINDOWS_SEH
 #include <catch2/catch_all.hpp>
 
+#include <astro/fs.hpp>
+#include <astro/memory.hpp>
 #include <astro/serial.hpp>
+#include <astro/utils/temp_file.hpp>
 
 using namespace astro::util;
 using namespace astro::serial;
 
+namespace {
+   struct point : astro::ct::reflectable<point> {
+      std::int32_t x = 0;
+      std::int32_t y = 0;
+      double       w = 0;
+      ASTRO_REFL(x, y, w)
+   };
+
+   enum class color : std::uint8_t { red, green, blue };
+
+   struct shape : astro::ct::reflectable<shape> {
+      std::string                          name;
+      color                                tint = color::red;
+      std::vector<point>                   points;
+      std::optional<std::uint16_t>         layer;
+      std::variant<std::int64_t, std::string> tag;
+      std::map<std::string, std::uint32_t> attrs;
+      astro::cryptid::uint128              id;
+      ASTRO_REFL(name, tint, points, layer, tag, attrs, id)
+   };
+
+   struct sample : astro::ct::reflectable<sample> {
+      varint<std::int64_t>               delta;
+      fixed<std::uint32_t>               stamp;
+      std::vector<varint<std::uint32_t>> counts;
+      std::vector<varint<std::int64_t>>  offsets;
+      ASTRO_REFL(delta, stamp, counts, offsets)
+   };
+
+   struct message : astro::ct::reflectable<message> {
+      std::uint16_t                 kind = 0;
+      std::string_view              topic;
+      std::span<const std::int64_t> payload;
+      ASTRO_REFL(kind, topic, payload)
+   };
+
+   struct trade : astro::ct::reflectable<trade> {
+      std::int64_t               ts    = 0;
+      std::uint32_t              venue = 0;
+      double                     price = 0;
+      color                      side  = color::red;
+      std::string                sym;
+      std::vector<std::uint16_t> legs;
+      varint<std::int32_t>       qty;
+      ASTRO_REFL(ts, venue, price, side, sym, legs, qty)
+   };
+
+   struct pb_test1 : astro::ct::reflectable<pb_test1> {
+      std::int32_t a = 0;
+      ASTRO_REFL(a)
+   };
+
+   struct pb_test2 : astro::ct::reflectable<pb_test2> {
+      std::string b;
+      ASTRO_REFL(b)
+      ASTRO_REFL_TAGS(2)
+   };
+
+   struct pb_test3 : astro::ct::reflectable<pb_test3> {
+      pb_test1 c;
+      ASTRO_REFL(c)
+      ASTRO_REFL_TAGS(3)
+   };
+
+   struct pb_test4 : astro::ct::reflectable<pb_test4> {
+      std::vector<std::int32_t> d;
+      ASTRO_REFL(d)
+      ASTRO_REFL_TAGS(4)
+   };
+
+   struct pb_order : astro::ct::reflectable<pb_order> {
+      std::uint64_t                        id = 0;
+      std::string_view                     symbol;
+      varint<std::int32_t>                 qty;
+      double                               price = 0;
+      color                                side  = color::red;
+      std::optional<std::uint32_t>         limit;
+      std::vector<pb_test1>                fills;
+      std::vector<fixed<std::uint32_t>>    stamps;
+      std::map<std::string, std::int64_t>  tags;
+      lazy<pb_test3>                       detail;
+      std::vector<std::byte>               blob;
+      ASTRO_REFL(id, symbol, qty, price, side, limit, fills, stamps, tags, detail, blob)
+      ASTRO_REFL_TAGS(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 1000)
+   };
+
+   struct js_book : astro::ct::reflectable<js_book> {
+      std::string                          name;
+      std::vector<trade>                   trades;
+      std::optional<double>                mark;
+      std::map<std::string, point>         levels;
+      std::map<std::uint32_t, bool>        flags;
+      std::pair<std::int32_t, std::string> range;
+      std::array<float, 3>                 weights{};
+      bool                                 open = false;
+      ASTRO_REFL(name, trades, mark, levels, flags, range, weights, open)
+   };
+
+   struct order_v1 : astro::ct::reflectable<order_v1> {
+      std::uint64_t id = 0;
+      std::string   sym;
+      double        px = 0;
+      ASTRO_REFL(id, sym, px)
+      ASTRO_REFL_TAGS(1, 2, 3)
+   };
+
+   // sym retired, fields added and moved around
+   struct order_v2 : astro::ct::reflectable<order_v2> {
+      double                    px    = 0;
+      std::string               venue = "XNAS";
+      std::uint64_t             id    = 0;
+      std::vector<std::int32_t> fills;
+      std::optional<point>      hint;
+      ASTRO_REFL(px, venue, id, fills, hint)
+      ASTRO_REFL_TAGS(3, 4, 1, 5, 9)
+   };
+
+   struct book_v1 : astro::ct::reflectable<book_v1> {
+      std::vector<order_v1> orders;
+      std::uint16_t         depth = 0;
+      ASTRO_REFL(orders, depth)
+      ASTRO_REFL_TAGS(1, 2)
+   };
+
+   struct book_v2 : astro::ct::reflectable<book_v2> {
+      std::uint16_t                   depth = 0;
+      std::vector<order_v2>           orders;
+      std::map<std::string, order_v2> by_venue;
+      ASTRO_REFL(depth, orders, by_venue)
+      ASTRO_REFL_TAGS(2, 1, 700000)
+   };
+
+   // order_v2's px (tag 3) written as a string instead of a double
+   struct px_as_text : astro::ct::reflectable<px_as_text> {
+      std::string px;
+      ASTRO_REFL(px)
+      ASTRO_REFL_TAGS(3)
+   };
+
+   struct memory_sink {
+      int32_t write(std::string_view s) {
+         out.append(s);
+         return static_cast<int32_t>(s.size());
+      }
+
+      int64_t writev(std::span<const std::string_view> parts) {
+         ++gathers;
+         // accept at most 3 bytes of the last part to exercise short writes
+         int64_t n = 0;
+         for (std::size_t i = 0; i < parts.size(); ++i) {
+            const auto p = i + 1 == parts.size() && parts.size() > 1 ? parts[i].substr(0, 3) : parts[i];
+            out.append(p);
+            n += p.size();
+         }
+         return n;
+      }
+
+      std::string out;
+      std::size_t gathers = 0;
+   };
+
+   struct trickle_source {
+      int64_t read_some(std::span<std::uint8_t> buf) {
+         const std::size_t n = std::min({buf.size(), data.size() - pos, std::size_t{7}});
+         std::memcpy(buf.data(), data.data() + pos, n);
+         pos += n;
+         return static_cast<int64_t>(n);
+      }
+
+      std::string_view data;
+      std::size_t      pos = 0;
+   };
+} // namespace
+
 TEST_CASE("Serial Tests", "[serial_tests]") {
    SECTION("Check basics") {
       alpha a{10};
@@ -46,6 +237,1184 @@ TEST_CASE("Serial Tests", "[serial_tests]") {
       std::string str = "Hello, World!";
       a.push(str);
 
-      CHECK(static_cast<std::size_t>(a.pos()) == sizeof(f)+sizeof(d)+str.size());
+      CHECK(static_cast<std::size_t>(a.pos()) == sizeof(f)+sizeof(d)+sizeof(std::uint32_t)+str.size());
+      a.push(std::string{});
+      a.reset();
+      a.fastforward(sizeof(f)+sizeof(d));
+      CHECK(a.pop<std::string>() == str);
+      CHECK(a.pop<std::string>().empty());
+   }
+
+   SECTION("Check capacity and in-place overwrite") {
+      alpha a{10};
+      CHECK(a.size() == 0);
+      CHECK(a.capacity() == 10);
+
+      std::size_t reallocs = 0;
+      auto*       last     = a.data();
+      for (int i = 0; i < 256; ++i) {
+         a.push(i);
+         if (a.data() != last) {
+            ++reallocs;
+            last = a.data();
+         }
+      }
+      CHECK(a.size() == 256 * sizeof(int));
+      CHECK(reallocs <= 6);
+
+      a.reset();
+      for (int i = 0; i < 16; ++i)
+         a.push(-i);
+      CHECK(a.size() == 256 * sizeof(int));
+      a.reset();
+      CHECK(a.pop<int>() == 0);
+      CHECK(a.pop<int>() == -1);
+      a.pos(static_cast<alpha::pos_t>(16 * sizeof(int)));
+      CHECK(a.pop<int>() == 16);
+
+      const auto cap = a.capacity();
+      a.clear();
+      CHECK(a.size() == 0);
+      CHECK(a.capacity() == cap);
+
+      a.reserve(4096);
+      CHECK(a.capacity() >= 4096);
+      a.resize(8);
+      CHECK(a.size() == 8);
+      CHECK(a.pop<std::uint64_t>() == 0);
+      CHECK_THROWS(a.pop<int>());
+   }
+
+   SECTION("Check external buffers") {
+      std::uint8_t buf[8] = {};
+      alpha        a{std::span<std::uint8_t>{buf}};
+      CHECK(a.is_external());
+      a.push(std::uint32_t{0x01020304});
+      a.push(std::uint32_t{0x05060708});
+      CHECK(a.data() == buf);
+      CHECK_THROWS(a.push(std::uint8_t{1}));
+
+      alpha b{std::span<const std::uint8_t>{buf}};
+      CHECK(b.size() == 8);
+      CHECK(b.pop<std::uint32_t>() == 0x01020304);
+      CHECK(b.remaining() == 4);
+      CHECK_THROWS(b.push(std::uint8_t{1}));
+
+      alpha c = b;
+      CHECK(!c.is_external());
+      CHECK(c.size() == 8);
+      c.push(std::uint8_t{9});
+      CHECK(c.size() == 8);
+      CHECK(buf[4] == 0x08);
+   }
+
+   SECTION("Check reflected types") {
+      alpha a{16};
+      point p;
+      p.x = -3;
+      p.y = 7;
+      p.w = 2.5;
+      a.push(p);
+      CHECK(a.size() == sizeof(std::int32_t) * 2 + sizeof(double));
+      a.reset();
+      const auto q = a.pop<point>();
+      CHECK(q.x == -3);
+      CHECK(q.y == 7);
+      CHECK(q.w == 2.5);
+
+      shape s;
+      s.name   = "poly";
+      s.tint   = color::blue;
+      s.points = {p, q, point{}};
+      s.layer  = 4;
+      s.tag    = std::string{"outline"};
+      s.attrs  = {{"a", 1}, {"bb", 22}};
+      s.id     = astro::cryptid::uint128{0x1234, 0x5678};
+
+      alpha b{8};
+      b.push(s);
+      b.push(std::uint8_t{0xee});
+      b.reset();
+      const auto t = b.pop<shape>();
+      CHECK(t.name == "poly");
+      CHECK(t.tint == color::blue);
+      CHECK(t.points.size() == 3);
+      CHECK(t.points[1].y == 7);
+      CHECK(t.layer == std::optional<std::uint16_t>{4});
+      CHECK(std::get<std::string>(t.tag) == "outline");
+      CHECK(t.attrs.at("bb") == 22);
+      CHECK(t.id == s.id);
+      CHECK(b.pop<std::uint8_t>() == 0xee);
+      CHECK(b.remaining() == 0);
+
+      shape e;
+      alpha c;
+      c.push(e);
+      c.reset();
+      const auto u = c.pop<shape>();
+      CHECK(u.name.empty());
+      CHECK(!u.layer);
+      CHECK(std::get<std::int64_t>(u.tag) == 0);
+
+      alpha d;
+      d.push(std::vector<std::uint32_t>{1, 2, 3});
+      CHECK(d.size() == sizeof(std::uint32_t) * 4);
+      d.resize(d.size() - 1);
+      d.reset();
+      CHECK_THROWS(d.pop<std::vector<std::uint32_t>>());
+
+      // a hostile count must fail on the remaining input rather than reserving for it
+      const std::uint8_t hostile[] = {0xff, 0xff, 0xff, 0x0f};
+      alpha              h{std::span<const std::uint8_t>{hostile}};
+      CHECK_THROWS_AS(h.pop<std::vector<std::string>>(), std::runtime_error);
+      h.reset();
+      CHECK_THROWS_AS((h.pop<std::map<std::string, int>>()), std::runtime_error);
+      h.reset();
+      CHECK_THROWS_AS(h.pop<std::set<std::uint64_t>>(), std::runtime_error);
+   }
+
+   SECTION("Check varints") {
+      CHECK(zigzag_encode(std::int32_t{0}) == 0);
+      CHECK(zigzag_encode(std::int32_t{-1}) == 1);
+      CHECK(zigzag_encode(std::int32_t{1}) == 2);
+      CHECK(zigzag_encode(std::int64_t{INT64_MIN}) == UINT64_MAX);
+      CHECK(zigzag_decode<std::int64_t>(UINT64_MAX) == INT64_MIN);
+      CHECK(zigzag_decode<std::int32_t>(3u) == -2);
+
+      CHECK(varint_size(0) == 1);
+      CHECK(varint_size(127) == 1);
+      CHECK(varint_size(128) == 2);
+      CHECK(varint_size(UINT64_MAX) == max_varint_bytes);
+
+      const std::uint64_t values[] = {0, 1, 127, 128, 300, 16383, 16384, 1ull << 35, (1ull << 56) - 1, 1ull << 56, UINT64_MAX};
+      for (const auto v : values) {
+         std::uint8_t buf[16] = {};
+         const auto   n       = encode_varint(v, buf);
+         CHECK(n == varint_size(v));
+         std::uint64_t out = 0;
+         CHECK(decode_varint(buf, n, out) == n);
+         CHECK(out == v);
+         // the full-width load must stop at the terminator too
+         out = 0;
+         CHECK(decode_varint(buf, sizeof(buf), out) == n);
+         CHECK(out == v);
+      }
+
+      const std::uint8_t truncated[] = {0x80, 0x80};
+      std::uint64_t      out         = 0;
+      CHECK_THROWS(decode_varint(truncated, sizeof(truncated), out));
+      const std::uint8_t overflow[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x02};
+      CHECK_THROWS(decode_varint(overflow, sizeof(overflow), out));
+
+      std::vector<std::int32_t> ints;
+      for (std::int32_t i = -40; i < 40; ++i)
+         ints.push_back(i * i * i * (i % 3 == 0 ? 1000 : 1));
+      std::vector<std::uint8_t> enc(ints.size() * max_varint_bytes);
+      std::size_t               p = 0;
+      for (const auto i : ints)
+         p += encode_varint(zigzag_encode(i), enc.data() + p);
+      std::vector<std::int32_t> dec(ints.size());
+      CHECK(decode_varints(std::span<const std::uint8_t>{enc.data(), p}, std::span<std::int32_t>{dec}) == p);
+      CHECK(dec == ints);
+   }
+
+   SECTION("Check stream vbyte") {
+      std::vector<std::uint32_t> vals;
+      for (std::uint32_t i = 0; i < 103; ++i)
+         vals.push_back(i % 4 == 0 ? i : i % 4 == 1 ? i << 9 : i % 4 == 2 ? i << 17 : 0xffffffffu - i);
+      std::vector<std::uint8_t> buf(stream_vbyte_max_bytes(vals.size()));
+      const auto                n = stream_vbyte_encode(vals, buf.data());
+      CHECK(n < buf.size());
+      std::vector<std::uint32_t> out(vals.size());
+      CHECK(stream_vbyte_decode(std::span<const std::uint8_t>{buf.data(), n}, out) == n);
+      CHECK(out == vals);
+      CHECK_THROWS(stream_vbyte_decode(std::span<const std::uint8_t>{buf.data(), n - 1}, out));
+
+      sample s;
+      s.delta = -5;
+      s.stamp = 0xdeadbeef;
+      for (std::uint32_t i = 0; i < 50; ++i) {
+         s.counts.emplace_back(i * 37);
+         s.offsets.emplace_back(static_cast<std::int64_t>(i) * -1000);
+      }
+      alpha a;
+      a.push(s);
+      a.push(varint<std::uint16_t>{300});
+      a.push(fixed<std::uint16_t>{300});
+      a.reset();
+      const auto t = a.pop<sample>();
+      CHECK(t.delta == -5);
+      CHECK(t.stamp == 0xdeadbeef);
+      CHECK(t.counts == s.counts);
+      CHECK(t.offsets == s.offsets);
+      CHECK(a.pop<varint<std::uint16_t>>() == 300);
+      CHECK(a.pop<fixed<std::uint16_t>>() == 300);
+      CHECK(a.remaining() == 0);
+
+      alpha b;
+      b.push(varint<std::uint32_t>{70000});
+      b.reset();
+      CHECK_THROWS(b.pop<varint<std::uint16_t>>());
+   }
+
+   SECTION("Check borrowed views") {
+      const std::vector<double> samples = {1.5, -2.25, 3.0, 1e9};
+      alpha                     a;
+      a.push(std::uint8_t{7});
+      a.push(std::string{"payload"});
+      a.push(samples);
+      a.push(std::span<const double>{samples});
+
+      alpha b{a.bytes()};
+      CHECK(b.pop<std::uint8_t>() == 7);
+      const auto str = b.borrow<std::string_view>();
+      CHECK(str == "payload");
+      CHECK(reinterpret_cast<const std::uint8_t*>(str.data()) > a.data());
+      CHECK(reinterpret_cast<const std::uint8_t*>(str.data()) < a.data() + a.size());
+      const auto first = b.borrow<std::span<const double>>();
+      CHECK(std::vector<double>(first.begin(), first.end()) == samples);
+      CHECK(reinterpret_cast<std::uintptr_t>(first.data()) % alignof(double) == 0);
+      const auto second = b.pop<std::vector<double>>();
+      CHECK(second == samples);
+      CHECK(b.remaining() == 0);
+
+      // the same offsets one byte into the buffer can no longer be borrowed in place
+      std::vector<std::uint8_t> shifted(a.size() + 1);
+      std::copy(a.begin(), a.end(), shifted.begin() + 1);
+      alpha c{std::span<const std::uint8_t>{shifted.data() + 1, a.size()}};
+      c.fastforward(1);
+      c.pop<std::string>();
+      CHECK_THROWS(c.borrow<std::span<const double>>());
+
+      const std::vector<std::int64_t> values = {5, -6, 7};
+      message m;
+      m.kind    = 3;
+      m.topic   = "ticks";
+      m.payload = values;
+
+      alpha d;
+      d.push(m);
+      const auto fn = astro::util::generate_temp_file_name("astro_serial_%%%%%%%%.bin");
+      {
+         std::ofstream out{fn, std::ios::binary};
+         out.write(reinterpret_cast<const char*>(d.data()), static_cast<std::streamsize>(d.size()));
+      }
+      {
+         astro::memory::mapped_file file{fn};
+         CHECK(file.is_open());
+         CHECK(file.size() == d.size());
+         alpha      e{file.bytes()};
+         const auto n = e.borrow<message>();
+         CHECK(n.kind == 3);
+         CHECK(n.topic == "ticks");
+         CHECK(std::vector<std::int64_t>(n.payload.begin(), n.payload.end()) == values);
+         CHECK(reinterpret_cast<const std::uint8_t*>(n.topic.data()) >= file.data());
+         CHECK(reinterpret_cast<const std::uint8_t*>(n.payload.data()) < file.data() + file.size());
+      }
+      std::filesystem::remove(fn);
+   }
+
+   SECTION("Check serialized_size and pack") {
+      static_assert(serialized_size<point>() == 16);
+      static_assert(serialized_size<std::pair<std::uint8_t, double>>() == 9);
+      static_assert(serialized_size<std::array<std::tuple<point, fixed<std::uint16_t>>, 3>>() == 54);
+      static_assert(fixed_size_type<color>);
+      static_assert(!fixed_size_type<std::string>);
+      static_assert(!fixed_size_type<sample>);
+      static_assert(!fixed_size_type<std::optional<int>>);
+
+      shape s;
+      s.name = "hex";
+      s.points.resize(6);
+      s.layer = 4;
+      s.tag   = std::string{"tagged"};
+      s.attrs = {{"a", 1}, {"bb", 2}};
+
+      sample smp;
+      smp.delta   = -300;
+      smp.counts  = {1, 300, 70000, 1u << 30, 5};
+      smp.offsets = {-1, 1ll << 40};
+
+      const std::vector<std::int64_t> values = {1, 2, 3};
+      message                         m;
+      m.topic   = "t";
+      m.payload = values;
+
+      const std::vector<std::vector<std::string>> nested = {{"x", "yy"}, {}, {"zzz"}};
+      const auto check_one = [](const auto& v) {
+         // an odd start offset moves the alignment padding
+         for (std::size_t lead : {0, 1, 3}) {
+            alpha pushed;
+            alpha packed;
+            for (std::size_t i = 0; i < lead; ++i) {
+               pushed.push(std::uint8_t{7});
+               packed.push(std::uint8_t{7});
+            }
+            pushed.push(v);
+            packed.pack(v);
+            CHECK(serialized_size(v, lead) == pushed.size() - lead);
+            CHECK(static_cast<std::size_t>(packed.pos()) == packed.size());
+            CHECK(std::equal(pushed.begin(), pushed.end(), packed.begin(), packed.end()));
+         }
+      };
+      check_one(s);
+      check_one(smp);
+      check_one(m);
+      check_one(nested);
+      check_one(std::string{"plain"});
+      check_one(3.5);
+      check_one(std::optional<point>{});
+      check_one(std::variant<int, std::string>{"v"});
+
+      alpha a;
+      a.pack(s);
+      a.pack(smp);
+      a.reset();
+      CHECK(a.pop<shape>().attrs.at("bb") == 2);
+      CHECK(a.pop<sample>().counts[3] == 1u << 30);
+
+      // overwriting in the middle keeps the bytes after the value
+      alpha b;
+      b.push(std::uint32_t{1});
+      b.push(std::uint32_t{2});
+      b.reset();
+      b.pack(std::uint32_t{9});
+      CHECK(b.size() == 8);
+      b.reset();
+      CHECK(b.pop<std::uint32_t>() == 9);
+      CHECK(b.pop<std::uint32_t>() == 2);
+   }
+}
+
+TEST_CASE("Schema Evolution Tests", "[schema_tests]") {
+   const auto encode = [](const auto& v) {
+      alpha a;
+      a.push(v);
+      return a;
+   };
+
+   SECTION("Check new readers of old data") {
+      order_v1 o;
+      o.id  = 42;
+      o.sym = "MSFT";
+      o.px  = 101.5;
+      alpha a = encode(o);
+      a.reset();
+      const auto n = a.pop<order_v2>();
+      CHECK(n.id == 42);
+      CHECK(n.px == 101.5);
+      CHECK(n.venue == "XNAS");
+      CHECK(n.fills.empty());
+      CHECK(!n.hint);
+      CHECK(a.remaining() == 0);
+   }
+
+   SECTION("Check old readers of new data") {
+      order_v2 o;
+      o.id    = 7;
+      o.px    = 3.25;
+      o.venue = "ARCX";
+      o.fills = {1, -2, 3};
+      o.hint  = point{};
+      alpha a = encode(o);
+      a.push(std::uint32_t{0xABCD});
+      a.reset();
+      const auto old = a.pop<order_v1>();
+      CHECK(old.id == 7);
+      CHECK(old.px == 3.25);
+      CHECK(old.sym.empty());
+      CHECK(a.pop<std::uint32_t>() == 0xABCD);
+   }
+
+   SECTION("Check nested messages, containers and sparse tags") {
+      book_v2 b;
+      b.depth = 5;
+      for (std::uint64_t i = 0; i < 20; ++i) {
+         order_v2 o;
+         o.id = i;
+         o.px = 0.5 * static_cast<double>(i);
+         o.fills.assign(i % 4, static_cast<std::int32_t>(i));
+         b.orders.push_back(o);
+      }
+      b.by_venue["XNYS"] = b.orders[3];
+
+      alpha a = encode(b);
+      a.reset();
+      const auto same = a.pop<book_v2>();
+      REQUIRE(same.orders.size() == 20);
+      CHECK(same.orders[19].fills == std::vector<std::int32_t>(3, 19));
+      CHECK(same.by_venue.at("XNYS").id == 3);
+
+      a.reset();
+      const auto old = a.pop<book_v1>();
+      CHECK(old.depth == 5);
+      REQUIRE(old.orders.size() == 20);
+      CHECK(old.orders[11].px == 5.5);
+
+      CHECK(serialized_size(b) == a.size());
+      alpha packed;
+      packed.pack(b);
+      CHECK(std::equal(a.begin(), a.end(), packed.begin(), packed.end()));
+   }
+
+   SECTION("Check malformed input") {
+      order_v2 o;
+      o.venue = "BATS";
+      const alpha a = encode(o);
+      for (std::size_t cut = 0; cut < a.size(); ++cut) {
+         alpha b{a.bytes().first(cut)};
+         CHECK_THROWS(b.pop<order_v2>());
+      }
+
+      // px (tag 3) stored as a string where a double is expected
+      px_as_text t;
+      t.px = "1.5";
+      alpha c = encode(t);
+      c.reset();
+      CHECK_THROWS(c.pop<order_v2>());
+   }
+}
+
+TEST_CASE("Columnar Tests", "[columnar_tests]") {
+   std::vector<trade> rows(1000);
+   for (std::size_t i = 0; i < rows.size(); ++i) {
+      rows[i].ts    = 1'700'000'000'000'000 + static_cast<std::int64_t>(i) * 1000 + static_cast<std::int64_t>(i % 7);
+      rows[i].venue = static_cast<std::uint32_t>(i * 2654435761u);
+      rows[i].price = 100.0 + static_cast<double>(i) / 8;
+      rows[i].side  = static_cast<color>(i % 3);
+      rows[i].sym   = i % 2 ? "ABC" : "LONGER_SYMBOL";
+      rows[i].legs.assign(i % 4, static_cast<std::uint16_t>(i));
+      rows[i].qty   = static_cast<std::int32_t>(i % 50) - 25;
+   }
+
+   SECTION("Check round trip") {
+      alpha a;
+      a.push(std::uint8_t{1});
+      write_columns<trade>(a, rows);
+      a.push(std::uint32_t{0xabcdef});
+
+      alpha r;
+      for (const auto& row : rows)
+         r.push(row);
+      // monotonic timestamps and small integers pack far below the row encoding
+      CHECK(a.size() * 4 < r.size() * 3);
+
+      a.reset();
+      CHECK(a.pop<std::uint8_t>() == 1);
+      const auto back = read_columns<trade>(a);
+      CHECK(a.pop<std::uint32_t>() == 0xabcdef);
+      REQUIRE(back.size() == rows.size());
+      for (std::size_t i = 0; i < rows.size(); ++i) {
+         CHECK(back[i].ts == rows[i].ts);
+         CHECK(back[i].venue == rows[i].venue);
+         CHECK(back[i].price == rows[i].price);
+         CHECK(back[i].side == rows[i].side);
+         CHECK(back[i].sym == rows[i].sym);
+         CHECK(back[i].legs == rows[i].legs);
+         CHECK(back[i].qty == rows[i].qty);
+      }
+   }
+
+   SECTION("Check projection") {
+      alpha a;
+      a.push(columnar<trade>{rows});
+      a.push(std::uint8_t{2});
+
+      a.reset();
+      const auto part = read_columns<trade>(a, {"ts", "sym"});
+      CHECK(a.pop<std::uint8_t>() == 2);
+      CHECK(part[999].ts == rows[999].ts);
+      CHECK(part[999].sym == rows[999].sym);
+      CHECK(part[999].price == 0);
+      CHECK(part[999].legs.empty());
+
+      a.reset();
+      const auto ts = read_column<trade, 0>(a);
+      CHECK(ts.size() == rows.size());
+      CHECK(ts[500] == rows[500].ts);
+      a.reset();
+      const auto qty = read_column<trade, 6>(a);
+      CHECK(qty[3] == rows[3].qty);
+
+      a.reset();
+      CHECK_THROWS(read_columns<trade>(a, {"nope"}));
+
+      // a row count the column bytes cannot hold fails before the rows are allocated
+      alpha h{a.bytes()};
+      const std::uint32_t huge = 0xffffffff;
+      std::memcpy(h.data(), &huge, sizeof(huge));
+      h.reset();
+      CHECK_THROWS_AS(read_columns<trade>(h), std::runtime_error);
+      h.reset();
+      CHECK_THROWS_AS((read_column<trade, 6>(h)), std::runtime_error);
+
+      alpha e;
+      e.push(columnar<trade>{});
+      e.reset();
+      CHECK(e.pop<columnar<trade>>().rows.empty());
+   }
+}
+
+TEST_CASE("Proto Tests", "[proto_tests]") {
+   using bytes_t = std::vector<std::uint8_t>;
+
+   SECTION("Check wire format") {
+      pb_test1 t1;
+      t1.a = 150;
+      CHECK(proto::encode(t1) == bytes_t{0x08, 0x96, 0x01});
+      CHECK(proto::encoded_size(t1) == 3);
+
+      pb_test2 t2;
+      t2.b = "testing";
+      CHECK(proto::encode(t2) == bytes_t{0x12, 0x07, 't', 'e', 's', 't', 'i', 'n', 'g'});
+
+      pb_test3 t3;
+      t3.c = t1;
+      CHECK(proto::encode(t3) == bytes_t{0x1a, 0x03, 0x08, 0x96, 0x01});
+
+      pb_test4 t4;
+      t4.d = {3, 270, 86942};
+      CHECK(proto::encode(t4) == bytes_t{0x22, 0x06, 0x03, 0x8e, 0x02, 0x9e, 0xa7, 0x05});
+
+      // unpacked repeated input is accepted as well
+      const bytes_t unpacked = {0x20, 0x03, 0x20, 0x8e, 0x02};
+      CHECK(proto::decode<pb_test4>(unpacked).d == std::vector<std::int32_t>{3, 270});
+
+      t1.a = -1;
+      CHECK(proto::encode(t1) == bytes_t{0x08, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01});
+      CHECK(proto::decode<pb_test1>(proto::encode(t1)).a == -1);
+
+      t1.a = 0;
+      CHECK(proto::encode(t1).empty());
+
+      CHECK_THROWS(proto::decode<pb_test1>(bytes_t{0x08, 0x96}));
+      CHECK_THROWS(proto::decode<pb_test2>(bytes_t{0x12, 0x07, 't'}));
+      CHECK_THROWS(proto::decode<pb_test1>(bytes_t{0x0d, 0x00, 0x00, 0x00, 0x00}));
+   }
+
+   SECTION("Check round trip") {
+      pb_order o;
+      o.id     = 1ull << 40;
+      o.symbol = "ASTR";
+      o.qty    = -25;
+      o.price  = 101.25;
+      o.side   = color::green;
+      o.limit  = 0;
+      o.fills.resize(3);
+      o.fills[1].a = 7;
+      o.stamps     = {1, 0xffffffffu};
+      o.tags       = {{"desk", 4}, {"", -9}};
+      pb_test3 inner;
+      inner.c.a = 42;
+      o.detail  = inner;
+      o.blob    = {std::byte{1}, std::byte{0}, std::byte{0xff}};
+
+      const auto enc = proto::encode(o);
+      CHECK(enc.size() == proto::encoded_size(o));
+
+      alpha a;
+      a.push(std::uint8_t{9});
+      CHECK(proto::encode(o, a) == enc.size());
+      CHECK(std::equal(enc.begin(), enc.end(), a.data() + 1));
+
+      const auto d = proto::decode<pb_order>(enc);
+      CHECK(d.id == o.id);
+      CHECK(d.symbol == "ASTR");
+      CHECK(reinterpret_cast<const std::uint8_t*>(d.symbol.data()) >= enc.data());
+      CHECK(d.qty == -25);
+      CHECK(d.price == 101.25);
+      CHECK(d.side == color::green);
+      CHECK(d.limit == std::optional<std::uint32_t>{0});
+      CHECK(d.fills.size() == 3);
+      CHECK(d.fills[1].a == 7);
+      CHECK(d.stamps.size() == 2);
+      CHECK(d.stamps[1] == 0xffffffffu);
+      CHECK(d.tags == o.tags);
+      CHECK(d.blob == o.blob);
+
+      CHECK(!d.detail.parsed());
+      CHECK(proto::encode(d) == enc);
+      CHECK(d.detail->c.a == 42);
+      CHECK(d.detail.parsed());
+      CHECK(proto::encode(d) == enc);
+
+      // fields the reader does not know are skipped
+      const auto t1 = proto::decode<pb_test1>(enc);
+      CHECK(t1.a == static_cast<std::int32_t>(o.id));
+   }
+}
+
+TEST_CASE("Stream Tests", "[stream_tests]") {
+   const auto make_shape = [](std::size_t i) {
+      point p;
+      p.x = static_cast<std::int32_t>(i);
+      p.w = 0.5;
+      shape s;
+      s.name   = "shape" + std::to_string(i);
+      s.points = std::vector<point>(i % 5, p);
+      s.layer  = static_cast<std::uint16_t>(i);
+      s.tag    = std::string(i % 3, 'x');
+      return s;
+   };
+
+   SECTION("Check round trip across chunks") {
+      memory_sink sink;
+      {
+         stream_writer w{sink, {.chunk_size = 256}};
+         for (std::size_t i = 0; i < 500; ++i)
+            w.push(make_shape(i));
+         w.close();
+         CHECK(w.bytes_written() == sink.out.size());
+         CHECK_THROWS(w.push(1));
+      }
+
+      trickle_source src{sink.out};
+      stream_reader  r{src, 16};
+      for (std::size_t i = 0; i < 500; ++i) {
+         REQUIRE(!r.done());
+         const auto s = r.pop<shape>();
+         CHECK(s.name == "shape" + std::to_string(i));
+         CHECK(s.points.size() == i % 5);
+         CHECK(s.layer == i);
+      }
+      CHECK(r.done());
+   }
+
+   SECTION("Check large records bypass the buffer") {
+      memory_sink sink;
+      std::vector<std::uint8_t> big(10000);
+      for (std::size_t i = 0; i < big.size(); ++i)
+         big[i] = static_cast<std::uint8_t>(i * 7);
+      {
+         stream_writer w{sink, {.chunk_size = 1024}};
+         w.push(std::string{"head"});
+         w.push_bytes(big);
+         w.push(std::uint64_t{42});
+      }
+      CHECK(sink.gathers != 0);
+
+      bytes_source src{{reinterpret_cast<const std::uint8_t*>(sink.out.data()), sink.out.size()}};
+      stream_reader r{src};
+      CHECK(r.pop<std::string>() == "head");
+      const auto b = r.pop_bytes();
+      CHECK(std::equal(b.begin(), b.end(), big.begin(), big.end()));
+      CHECK(b.data() == src.data.data() + 8 + 4 + 4);
+      CHECK(r.pop<std::uint64_t>() == 42);
+      CHECK(r.done());
+   }
+
+   SECTION("Check background flush") {
+      memory_sink sink;
+      {
+         stream_writer w{sink, {.chunk_size = 128, .background = true}};
+         for (std::size_t i = 0; i < 2000; ++i)
+            w.push(static_cast<std::uint32_t>(i));
+         w.flush();
+         CHECK(sink.out.size() == 2000 * 8);
+         w.push_bytes(std::vector<std::uint8_t>(300, 1));
+      }
+      CHECK(sink.out.size() == 2000 * 8 + 304);
+
+      trickle_source src{sink.out};
+      stream_reader  r{src};
+      for (std::uint32_t i = 0; i < 2000; ++i)
+         CHECK(r.pop<std::uint32_t>() == i);
+      CHECK(r.pop_bytes().size() == 300);
+      CHECK(r.done());
+   }
+
+   SECTION("Check truncated streams") {
+      memory_sink sink;
+      {
+         stream_writer w{sink};
+         w.push(std::string(100, 'a'));
+      }
+      trickle_source src{std::string_view{sink.out}.substr(0, 50)};
+      stream_reader  r{src};
+      CHECK(!r.done());
+      CHECK_THROWS(r.pop<std::string>());
+
+      trickle_source partial{std::string_view{sink.out}.substr(0, 2)};
+      stream_reader  r2{partial};
+      CHECK_THROWS(r2.done() ? 0 : r2.pop<std::string>().size());
+
+      // a corrupt 4 GiB length fails on the missing bytes instead of allocating for them up front
+      trickle_source hostile{std::string_view{"\xff\xff\xff\xff" "abcdefgh", 12}};
+      stream_reader  r3{hostile, 64};
+      CHECK_THROWS_AS(r3.pop_bytes(), std::runtime_error);
+   }
+
+   SECTION("Check file round trip") {
+      const auto fn = astro::util::generate_temp_file_name("astro_stream_%%%%%%%%.bin");
+      {
+         FILE* f = std::fopen(fn.c_str(), "wb");
+         REQUIRE(f != nullptr);
+         astro::fs::file_sink sink{f};
+         stream_writer        w{sink, {.chunk_size = 4096}};
+         for (std::size_t i = 0; i < 300; ++i)
+            w.push(make_shape(i));
+         w.close();
+         std::fclose(f);
+      }
+      {
+         astro::memory::mapped_file file{fn};
+         bytes_source               src{file.bytes()};
+         stream_reader              r{src};
+         std::size_t                n = 0;
+         for (; !r.done(); ++n)
+            CHECK(r.pop<shape>().layer == n);
+         CHECK(n == 300);
+      }
+      std::filesystem::remove(fn);
+   }
+}
+
+TEST_CASE("Archive Tests", "[archive_tests]") {
+   const auto event = [](std::size_t i) { return "event " + std::to_string(i) + std::string(i % 40, '.'); };
+
+   const auto build = [&](std::size_t n, bool keyed, archive_options opts) {
+      memory_sink sink;
+      {
+         archive_writer w{sink, opts};
+         for (std::size_t i = 0; i < n; ++i) {
+            if (keyed)
+               CHECK(w.push(1000 + 7 * i, event(i)) == i);
+            else
+               w.push(event(i));
+         }
+         w.close();
+         CHECK(w.bytes_written() == sink.out.size());
+         CHECK_THROWS(w.push(1));
+      }
+      return std::vector<std::uint8_t>(sink.out.begin(), sink.out.end());
+   };
+
+   SECTION("Check random access") {
+      const auto     bytes = build(5000, true, {.sync_interval = 100, .chunk_size = 4096});
+      archive_reader r{bytes};
+      CHECK(r.indexed());
+      CHECK(r.has_keys());
+      REQUIRE(r.size() == 5000);
+      for (std::size_t i : {0, 1, 99, 100, 2500, 4999})
+         CHECK(r.get<std::string>(i) == event(i));
+      CHECK(r.find(1000 + 7 * 4321) == 4321);
+      CHECK(r.lookup<std::string>(1000) == event(0));
+      CHECK(!r.find(1001));
+      CHECK(!r.lookup<std::string>(999));
+      CHECK_THROWS(r.bytes(5000));
+      for (std::size_t i = 0; i < r.size(); i += 37)
+         CHECK(reinterpret_cast<std::uintptr_t>(r.bytes(i).data()) % 8 == 0);
+
+      archive_reader plain{build(10, false, {})};
+      CHECK(!plain.has_keys());
+      CHECK_THROWS(plain.find(0));
+      CHECK(plain.get<std::string>(9) == event(9));
+
+      archive_reader none{build(0, false, {})};
+      CHECK(none.indexed());
+      CHECK(none.size() == 0);
+
+      // footers pointing at a misaligned index or past the end are rejected
+      using astro::serial::detail::arc::footer;
+      const auto with_footer = [&](auto edit) {
+         auto   b = build(10, false, {});
+         footer f;
+         std::memcpy(&f, b.data() + b.size() - sizeof(f), sizeof(f));
+         edit(f);
+         std::memcpy(b.data() + b.size() - sizeof(f), &f, sizeof(f));
+         return b;
+      };
+      CHECK_THROWS(archive_reader{with_footer([](footer& f) {
+         f.index_offset += 4;
+         f.count         = (f.count * 8 - 4) / 8;
+      })});
+      CHECK_THROWS(archive_reader{with_footer([](footer& f) {
+         f.hash_slots  = 2;
+         f.hash_offset = UINT64_MAX - 8;
+      })});
+      const auto unkeyed = with_footer([](footer& f) { f.hash_offset = UINT64_MAX; });
+      archive_reader u{unkeyed};
+      CHECK(!u.has_keys());
+      CHECK(u.get<std::string>(9) == event(9));
+   }
+
+   SECTION("Check large records and repeated keys") {
+      memory_sink sink;
+      std::string big(100000, 'b');
+      {
+         archive_writer w{sink, {.chunk_size = 1024}};
+         w.push(1, std::string{"first"});
+         w.push(2, big);
+         w.push(1, std::string{"second"});
+      }
+      const std::vector<std::uint8_t> bytes(sink.out.begin(), sink.out.end());
+      archive_reader                  r{bytes};
+      CHECK(r.get<std::string>(1) == big);
+      CHECK(r.lookup<std::string>(1) == "second");
+      CHECK(r.find(2) == 1);
+   }
+
+   SECTION("Check recovery without a footer") {
+      const auto full = build(1000, true, {.sync_interval = 64});
+
+      // a writer that died inside record 1000 never wrote the indexes
+      archive_reader indexed{full};
+      const auto     cut_at = static_cast<std::size_t>(indexed.bytes(999).data() - full.data()) + 5;
+      const std::vector<std::uint8_t> cut(full.begin(), full.begin() + static_cast<std::ptrdiff_t>(cut_at));
+      archive_reader                  r{cut};
+      CHECK(!r.indexed());
+      CHECK(!r.has_keys());
+      CHECK(r.size() == 999);
+      CHECK(r.get<std::string>(998) == event(998));
+
+      // damage in record 100 loses it and the rest of its sync interval
+      std::vector<std::uint8_t> bad = cut;
+      const auto at = static_cast<std::size_t>(indexed.bytes(100).data() - full.data()) - 8;
+      bad[at + 4] ^= 0xFF;
+      archive_reader d{bad};
+      CHECK(d.size() == 999);
+      CHECK(d.get<std::string>(99) == event(99));
+      CHECK_THROWS(d.bytes(100));
+      CHECK_THROWS(d.bytes(127));
+      CHECK(d.get<std::string>(128) == event(128));
+
+      // a marker claiming more lost records than the damaged bytes could hold is not trusted
+      std::vector<std::uint8_t> far = bad;
+      const std::uint32_t       big = 0xfffffff0;
+      // record 128 follows its interval's sync marker, whose next field sits 4 bytes in
+      const auto                mk  = static_cast<std::size_t>(indexed.bytes(128).data() - full.data()) - 8 - 16;
+      REQUIRE(far[mk] == 0xff);
+      std::memcpy(far.data() + mk + 4, &big, sizeof(big));
+      archive_reader f{far};
+      CHECK(f.size() == 999);
+      CHECK_THROWS(f.bytes(191));
+      CHECK(f.get<std::string>(192) == event(192));
+
+      const std::vector<std::uint8_t> junk(64, 0x42);
+      CHECK_THROWS(archive_reader{junk});
+   }
+
+   SECTION("Check file round trip") {
+      const auto fn = astro::util::generate_temp_file_name("astro_archive_%%%%%%%%.bin");
+      {
+         FILE* f = std::fopen(fn.c_str(), "wb");
+         REQUIRE(f != nullptr);
+         astro::fs::file_sink sink{f};
+         archive_writer       w{sink};
+         for (std::size_t i = 0; i < 3000; ++i)
+            w.push(i * i, event(i));
+         w.close();
+         std::fclose(f);
+      }
+      {
+         archive_reader r{fn};
+         CHECK(r.indexed());
+         CHECK(r.size() == 3000);
+         CHECK(r.lookup<std::string>(1234 * 1234) == event(1234));
+         archive_reader moved = std::move(r);
+         CHECK(moved.get<std::string>(2999) == event(2999));
+      }
+      std::filesystem::remove(fn);
+   }
+}
+
+TEST_CASE("LZ Tests", "[lz_tests]") {
+   const auto round_trip = [](std::span<const std::uint8_t> in, std::span<const std::uint8_t> dict = {}) {
+      const auto                block = lz::compress(in, dict);
+      std::vector<std::uint8_t> out(in.size());
+      CHECK(lz::decompress(block, out, dict) == in.size());
+      CHECK(std::equal(out.begin(), out.end(), in.begin(), in.end()));
+      return block.size();
+   };
+
+   SECTION("Check small and incompressible inputs") {
+      round_trip({});
+      const std::uint8_t tiny[] = {1, 2, 3};
+      round_trip(tiny);
+
+      std::vector<std::uint8_t> noise(5000);
+      std::uint64_t             x = 88172645463325252ull;
+      for (auto& b : noise) {
+         x ^= x << 13;
+         x ^= x >> 7;
+         x ^= x << 17;
+         b = static_cast<std::uint8_t>(x);
+      }
+      CHECK(round_trip(noise) <= lz::max_compressed_size(noise.size()));
+   }
+
+   SECTION("Check repetitive inputs") {
+      std::vector<std::uint8_t> runs(100000, 'a');
+      CHECK(round_trip(runs) < 1000);
+
+      std::string text;
+      for (int i = 0; i < 2000; ++i)
+         text += "row " + std::to_string(i % 37) + ": the quick brown fox, ";
+      const std::span<const std::uint8_t> bytes{reinterpret_cast<const std::uint8_t*>(text.data()), text.size()};
+      CHECK(round_trip(bytes) * 5 < text.size());
+
+      // short periods overlap their own output
+      for (std::size_t period = 1; period < 12; ++period) {
+         std::vector<std::uint8_t> v(300);
+         for (std::size_t i = 0; i < v.size(); ++i)
+            v[i] = static_cast<std::uint8_t>(i % period);
+         round_trip(v);
+      }
+   }
+
+   SECTION("Check dictionaries") {
+      const std::string dict_s = R"({"user":"","action":"login","ok":true,"region":"eu-west-1"})";
+      const std::string msg_s  = R"({"user":"ann","action":"login","ok":true,"region":"eu-west-1"})";
+      const std::span<const std::uint8_t> dict{reinterpret_cast<const std::uint8_t*>(dict_s.data()), dict_s.size()};
+      const std::span<const std::uint8_t> msg{reinterpret_cast<const std::uint8_t*>(msg_s.data()), msg_s.size()};
+      CHECK(round_trip(msg, dict) * 2 < round_trip(msg));
+
+      std::vector<std::uint8_t> out(msg.size());
+      CHECK_THROWS(lz::decompress(lz::compress(msg, dict), out));
+   }
+
+   SECTION("Check malformed blocks") {
+      std::vector<std::uint8_t> out(64);
+      const std::uint8_t bad_offset[] = {0x14, 'a', 9, 0, 0x10, 'b'};
+      CHECK_THROWS(lz::decompress(bad_offset, out));
+      const std::uint8_t long_literals[] = {0xF0, 200, 'a'};
+      CHECK_THROWS(lz::decompress(long_literals, out));
+      CHECK_THROWS(lz::decompress({}, out));
+      std::vector<std::uint8_t> small(4);
+      std::vector<std::uint8_t> runs(100, 'z');
+      CHECK_THROWS(lz::decompress(lz::compress(runs), small));
+   }
+
+   SECTION("Check compressed values") {
+      std::vector<std::string> names(500, "instrument");
+      alpha                    a;
+      a.push(compressed<std::vector<std::string>>{names});
+      CHECK(a.size() < 200);
+      a.reset();
+      CHECK(a.pop<compressed<std::vector<std::string>>>().value == names);
+
+      // a raw size the compressed bytes cannot expand to is rejected before the buffer is sized
+      const std::uint32_t hostile[] = {0xffffffff, 4, 0};
+      alpha               h{std::span<const std::uint8_t>{reinterpret_cast<const std::uint8_t*>(hostile), sizeof(hostile)}};
+      CHECK_THROWS_AS(h.pop<compressed<std::vector<std::string>>>(), std::runtime_error);
+   }
+
+   SECTION("Check compressed streams") {
+      memory_sink sink;
+      {
+         lz::compress_sink z{sink};
+         stream_writer     w{z, {.chunk_size = 4096}};
+         for (std::uint32_t i = 0; i < 5000; ++i)
+            w.push(std::string{"event-"} + std::to_string(i % 10));
+      }
+      CHECK(sink.out.size() < 5000 * 11 / 4);
+
+      trickle_source        src{sink.out};
+      lz::decompress_source z{src};
+      stream_reader         r{z};
+      for (std::uint32_t i = 0; i < 5000; ++i)
+         CHECK(r.pop<std::string>() == std::string{"event-"} + std::to_string(i % 10));
+      CHECK(r.done());
+
+      const std::uint32_t   hostile[] = {0xffffffff, 4, 0};
+      trickle_source        bad{{reinterpret_cast<const char*>(hostile), sizeof(hostile)}};
+      lz::decompress_source zb{bad};
+      std::uint8_t          buf[16];
+      CHECK_THROWS_AS(zb.read_some(buf), std::runtime_error);
+   }
+}
+
+TEST_CASE("Intpack Tests", "[intpack_tests]") {
+   constexpr int_codec codecs[] = {int_codec::bitpack, int_codec::frame_of_reference, int_codec::delta, int_codec::delta_of_delta};
+
+   const auto round_trip = [&]<typename T>(const std::vector<T>& vals) {
+      for (const auto c : codecs) {
+         alpha a;
+         a.push(std::uint8_t{7});
+         write_ints<T>(a, vals, c);
+         a.push(std::uint8_t{9});
+         a.reset();
+         CHECK(a.pop<std::uint8_t>() == 7);
+         const auto view = packed_ints<T>::read(a);
+         CHECK(a.pop<std::uint8_t>() == 9);
+         CHECK(view.size() == vals.size());
+         CHECK(view.codec() == c);
+         CHECK(view.decode() == vals);
+         for (std::size_t i = 0; i < vals.size(); i += 37)
+            CHECK(view[i] == vals[i]);
+      }
+   };
+
+   SECTION("Check round trips") {
+      std::uint64_t x = 88172645463325252ull;
+      const auto    next = [&] {
+         x ^= x << 13;
+         x ^= x >> 7;
+         x ^= x << 17;
+         return x;
+      };
+      for (std::size_t n : {0, 1, 127, 128, 129, 1000}) {
+         std::vector<std::int8_t>   i8(n);
+         std::vector<std::uint16_t> u16(n);
+         std::vector<std::int32_t>  i32(n);
+         std::vector<std::uint32_t> u32(n);
+         std::vector<std::int64_t>  i64(n);
+         std::vector<std::uint64_t> u64(n);
+         for (std::size_t i = 0; i < n; ++i) {
+            i8[i]  = static_cast<std::int8_t>(next());
+            u16[i] = static_cast<std::uint16_t>(i * 3);
+            i32[i] = static_cast<std::int32_t>(next() % 2000) - 1000;
+            u32[i] = static_cast<std::uint32_t>(next());
+            i64[i] = static_cast<std::int64_t>(next());
+            u64[i] = (std::uint64_t{1} << 40) + i * 1000 + next() % 3;
+         }
+         round_trip(i8);
+         round_trip(u16);
+         round_trip(i32);
+         round_trip(u32);
+         round_trip(i64);
+         round_trip(u64);
+      }
+      round_trip(std::vector<std::int64_t>{INT64_MIN, INT64_MAX, 0, -1, INT64_MIN});
+      round_trip(std::vector<std::uint32_t>(300, UINT32_MAX));
+   }
+
+   SECTION("Check compression") {
+      std::vector<std::int64_t> stamps(10000);
+      for (std::size_t i = 0; i < stamps.size(); ++i)
+         stamps[i] = 1'700'000'000'000'000 + static_cast<std::int64_t>(i) * 1'000'000 + static_cast<std::int64_t>(i % 7);
+
+      alpha dod, delta;
+      write_ints<std::int64_t>(dod, stamps, int_codec::delta_of_delta);
+      write_ints<std::int64_t>(delta, stamps, int_codec::delta);
+      CHECK(dod.size() * 10 < stamps.size() * sizeof(std::int64_t));
+      CHECK(dod.size() < delta.size());
+
+      std::vector<std::uint32_t> ids(10000);
+      for (std::size_t i = 0; i < ids.size(); ++i)
+         ids[i] = 5'000'000 + static_cast<std::uint32_t>(i % 512);
+      alpha ref;
+      write_ints<std::uint32_t>(ref, ids, int_codec::frame_of_reference);
+      CHECK(ref.size() * 3 < ids.size() * sizeof(std::uint32_t));
+   }
+
+   SECTION("Check block access") {
+      std::vector<std::uint32_t> vals(300);
+      for (std::size_t i = 0; i < vals.size(); ++i)
+         vals[i] = static_cast<std::uint32_t>(i * i);
+      alpha a;
+      write_ints<std::uint32_t>(a, vals, int_codec::delta);
+      packed_ints<std::uint32_t> view{a.bytes()};
+      CHECK(view.block_count() == 3);
+
+      std::vector<std::uint32_t> block(128);
+      view.decode_block(2, block);
+      CHECK(std::equal(block.begin(), block.begin() + 44, vals.begin() + 256));
+      CHECK_THROWS(view.decode_block(3, block));
+      CHECK_THROWS(view[300]);
+      std::vector<std::uint32_t> small(10);
+      CHECK_THROWS(view.decode(small));
+
+      CHECK_THROWS(packed_ints<std::uint64_t>{a.bytes()});
+      CHECK_THROWS(packed_ints<std::uint32_t>{a.bytes().first(40)});
+   }
+}
+
+TEST_CASE("JSON Tests", "[json_tests]") {
+   SECTION("Check encoding") {
+      point p;
+      p.x = 1;
+      p.y = -2;
+      p.w = 0.1;
+      CHECK(json::encode(p) == R"({"x":1,"y":-2,"w":0.1})");
+
+      js_book b;
+      b.name = "a\"b\\c\n\x01";
+      b.flags[7] = true;
+      b.range = {3, "z"};
+      b.weights = {1.5f, 0, -2};
+      CHECK(json::encode(b) == R"({"name":"a\"b\\c\n\u0001","trades":[],"mark":null,"levels":{},"flags":{"7":true},)"
+                               R"("range":[3,"z"],"weights":[1.5,0,-2],"open":false})");
+
+      p.w = std::numeric_limits<double>::infinity();
+      CHECK_THROWS(json::encode(p));
+   }
+
+   SECTION("Check round trips") {
+      js_book b;
+      b.name = std::string(100, 'q') + "\\\"\t" + std::string(70, '\\') + "\"";
+      for (int i = 0; i < 40; ++i) {
+         trade t;
+         t.ts    = 1'700'000'000'000'000'000 + i;
+         t.venue = static_cast<std::uint32_t>(i);
+         t.price = 100.0 / (i + 3);
+         t.side  = static_cast<color>(i % 3);
+         t.sym   = "SYM" + std::to_string(i);
+         t.legs  = {static_cast<std::uint16_t>(i), 65535};
+         t.qty   = -i;
+         b.trades.push_back(t);
+      }
+      b.mark           = 1e-300;
+      b.levels["bid"].w = 3.25;
+      b.levels["ask"].x = -7;
+      b.flags[0]        = false;
+      b.range           = {-1, "\xe2\x82\xac"};
+      b.weights         = {0.1f, 1e30f, -0.0f};
+      b.open            = true;
+
+      const std::string txt = json::encode(b);
+      const auto        r   = json::decode<js_book>(txt);
+      CHECK(r.name == b.name);
+      CHECK(r.trades.size() == 40);
+      CHECK(r.trades[39].price == b.trades[39].price);
+      CHECK(r.trades[39].qty == -39);
+      CHECK(r.trades[2].side == color::blue);
+      CHECK(r.mark == 1e-300);
+      CHECK(r.weights == b.weights);
+      CHECK(json::encode(r) == txt);
+
+      const auto v = json::decode<std::vector<std::map<std::string, std::int64_t>>>(R"([{"a":1},{},{"b":-2,"c":3}])");
+      REQUIRE(v.size() == 3);
+      CHECK(v[2].at("b") == -2);
+   }
+
+   SECTION("Check parsing") {
+      const auto p = json::decode<point>(" {\n\t\"w\" : 2.5e3 , \"unknown\": {\"a\":[1,{\"b\":[]}],\"c\":\"}\"}, \"x\":42}\r\n");
+      CHECK(p.x == 42);
+      CHECK(p.y == 0);
+      CHECK(p.w == 2500);
+
+      CHECK(json::decode<std::string>(R"("\u00e9\ud83d\ude00\/")") == "\xc3\xa9\xf0\x9f\x98\x80/");
+      CHECK(json::decode<std::string_view>(R"("plain")") == "plain");
+      CHECK_THROWS(json::decode<std::string_view>(R"("esc\n")"));
+      CHECK(json::decode<js_book>(R"({"na\u006de":"x"})").name == "x");
+
+      point q;
+      q.y = 9;
+      json::merge(R"({"x":1})", q);
+      CHECK(q.x == 1);
+      CHECK(q.y == 9);
+   }
+
+   SECTION("Check invalid input") {
+      CHECK_THROWS(json::decode<point>(""));
+      CHECK_THROWS(json::decode<point>("{"));
+      CHECK_THROWS(json::decode<point>(R"({"x":1,})"));
+      CHECK_THROWS(json::decode<point>(R"({"x":1} 2)"));
+      CHECK_THROWS(json::decode<point>(R"({"x":"1"})"));
+      CHECK_THROWS(json::decode<point>(R"({"x":1.5})"));
+      CHECK_THROWS(json::decode<point>(R"({"x":12a})"));
+      CHECK_THROWS(json::decode<point>(R"({"x" 1})"));
+      CHECK_THROWS(json::decode<point>(R"({"x":1)"));
+      CHECK_THROWS(json::decode<point>(R"({"x:1})"));
+      CHECK_THROWS(json::decode<std::uint8_t>("256"));
+      CHECK_THROWS(json::decode<double>("nan"));
+      CHECK_THROWS(json::decode<bool>("tru"));
+      CHECK_THROWS(json::decode<std::string>(R"("\ud83d")"));
+      CHECK_THROWS(json::decode<std::string>("\"a\x01\""));
+      CHECK_THROWS(json::decode<std::array<int, 2>>("[1]"));
+      CHECK_THROWS(json::decode<std::array<int, 2>>("[1,2,3]"));
+      CHECK_THROWS(json::decode<std::vector<int>>("[1,2"));
+      CHECK_THROWS(json::decode<std::vector<int>>("[[1]]"));
    }
-}
\ No newline at end of file
+}
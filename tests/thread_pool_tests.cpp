@@ -0,0 +1,159 @@
+#include <atomic>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#define CATCH_CONFIG_WINDOWS_SEH
+#include <catch2/catch_all.hpp>
+
+#include <astro/async/executor.hpp>
+#include <astro/async/thread_pool.hpp>
+#include <astro/async/work_deque.hpp>
+
+using namespace astro::async;
+
+namespace {
+   std::uint64_t fib(thread_pool& pool, std::uint64_t n) {
+      if (n < 2)
+         return n;
+      auto a = pool.submit([&pool, n] { return fib(pool, n - 1); });
+      auto b = fib(pool, n - 2);
+      return a.get() + b;
+   }
+} // namespace
+
+TEST_CASE("Work Deque Tests", "[thread_pool_tests]") {
+   SECTION("Check owner order and growth") {
+      work_deque<std::intptr_t> d{2};
+      for (std::intptr_t i = 1; i <= 100; ++i)
+         d.push(i);
+      CHECK(d.size() == 100);
+
+      std::intptr_t v = 0;
+      REQUIRE(d.steal(v));
+      CHECK(v == 1);
+      REQUIRE(d.pop(v));
+      CHECK(v == 100);
+      for (std::intptr_t i = 99; i >= 2; --i) {
+         REQUIRE(d.pop(v));
+         CHECK(v == i);
+      }
+      CHECK_FALSE(d.pop(v));
+      CHECK_FALSE(d.steal(v));
+   }
+
+   SECTION("Check every value is taken exactly once under contention") {
+      constexpr std::intptr_t   n = 200000;
+      work_deque<std::intptr_t> d{8};
+      std::atomic<bool>         done = false;
+      std::vector<std::uint8_t> seen(n + 1, 0);
+      std::atomic<std::int64_t> stolen = 0;
+
+      std::vector<std::thread> thieves;
+      std::vector<std::vector<std::intptr_t>> taken(3);
+      for (std::size_t t = 0; t < taken.size(); ++t) {
+         thieves.emplace_back([&, t] {
+            std::intptr_t v;
+            while (!done.load(std::memory_order_acquire) || !d.empty()) {
+               if (d.steal(v))
+                  taken[t].push_back(v);
+            }
+         });
+      }
+
+      std::vector<std::intptr_t> mine;
+      for (std::intptr_t i = 1; i <= n; ++i) {
+         d.push(i);
+         std::intptr_t v;
+         if (i % 3 == 0 && d.pop(v))
+            mine.push_back(v);
+      }
+      std::intptr_t v;
+      while (d.pop(v))
+         mine.push_back(v);
+      done.store(true, std::memory_order_release);
+      for (auto& t : thieves)
+         t.join();
+
+      taken.push_back(std::move(mine));
+      std::size_t total = 0;
+      bool        twice = false;
+      for (const auto& vs : taken) {
+         total += vs.size();
+         for (auto x : vs)
+            twice |= seen[x]++ != 0;
+      }
+      CHECK_FALSE(twice);
+      CHECK(total == n);
+   }
+}
+
+TEST_CASE("Thread Pool Tests", "[thread_pool_tests]") {
+   SECTION("Check submit and get") {
+      thread_pool pool{4};
+      CHECK(pool.size() == 4);
+
+      auto f = pool.submit([](int a, const std::string& b) { return a + static_cast<int>(b.size()); }, 40, std::string{"ab"});
+      CHECK(f.get() == 42);
+      CHECK_FALSE(f.valid());
+
+      std::atomic<int> hits = 0;
+      auto             g    = pool.submit([&hits] { ++hits; });
+      g.get();
+      CHECK(hits == 1);
+
+      auto h = pool.submit([]() -> int { throw std::runtime_error("boom"); });
+      CHECK_THROWS_AS(h.get(), std::runtime_error);
+      CHECK_THROWS(h.get());
+   }
+
+   SECTION("Check many small tasks from outside the pool") {
+      thread_pool                    pool{3};
+      std::vector<future<std::size_t>> fs;
+      for (std::size_t i = 0; i < 10000; ++i)
+         fs.push_back(pool.submit([i] { return i * i; }));
+      std::size_t sum = 0;
+      for (auto& f : fs)
+         sum += f.get();
+      std::size_t expected = 0;
+      for (std::size_t i = 0; i < 10000; ++i)
+         expected += i * i;
+      CHECK(sum == expected);
+   }
+
+   SECTION("Check nested fan-out does not deadlock a small pool") {
+      thread_pool pool{2};
+      CHECK(fib(pool, 20) == 6765);
+   }
+
+   SECTION("Check dropped futures and queued work at shutdown") {
+      std::atomic<int> ran = 0;
+      {
+         thread_pool pool{2};
+         for (int i = 0; i < 1000; ++i)
+            pool.submit([&ran] { ran.fetch_add(1, std::memory_order_relaxed); });
+      }
+      CHECK(ran == 1000);
+   }
+
+   SECTION("Check parked workers wake up") {
+      thread_pool pool{2};
+      for (int round = 0; round < 20; ++round) {
+         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+         CHECK(pool.submit([round] { return round; }).get() == round);
+      }
+   }
+
+   SECTION("Check executor runs on the pool") {
+      thread_pool pool{2};
+      executor    exec{[](int x, const std::string& y) -> std::size_t { return x + y.size(); }, pool};
+      auto        v1 = exec.exec(42, "abc");
+      auto        v2 = exec(1, "");
+      CHECK(std::is_same_v<decltype(v1), future<std::size_t>>);
+      CHECK(v1.get() == 45);
+      CHECK(v2.get() == 1);
+      CHECK(exec.exec_sync(2, "xy") == 4);
+   }
+}